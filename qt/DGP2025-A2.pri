@@ -26,6 +26,7 @@ SOURCES += \
 	$$SOURCEDIR/core/PolygonMeshTest.cpp \
 #
 	$$SOURCEDIR/gui/GuiAboutDialog.cpp \
+	$$SOURCEDIR/gui/GuiGLBatch.cpp \
 	$$SOURCEDIR/gui/GuiGLBuffer.cpp \
 	$$SOURCEDIR/gui/GuiGLHandles.cpp \
 	$$SOURCEDIR/gui/GuiGLShader.cpp \
@@ -41,12 +42,21 @@ SOURCES += \
 	$$SOURCEDIR/io/LoaderPly.cpp \
 	$$SOURCEDIR/io/LoaderStl.cpp \
 	$$SOURCEDIR/io/LoaderWrl.cpp \
+	$$SOURCEDIR/io/LoaderWrb.cpp \
+	$$SOURCEDIR/io/LoaderEbm.cpp \
 	$$SOURCEDIR/io/SaverPly.cpp \
 	$$SOURCEDIR/io/SaverStl.cpp \
 	$$SOURCEDIR/io/SaverWrl.cpp \
+	$$SOURCEDIR/io/SaverWrb.cpp \
+	$$SOURCEDIR/io/SaverEbm.cpp \
 	$$SOURCEDIR/io/Tokenizer.cpp \
 	$$SOURCEDIR/io/TokenizerFile.cpp \
 	$$SOURCEDIR/io/TokenizerString.cpp \
+	$$SOURCEDIR/io/TokenizerBuffer.cpp \
+	$$SOURCEDIR/io/TextWriter.cpp \
+	$$SOURCEDIR/io/BinaryWriter.cpp \
+	$$SOURCEDIR/io/RangeCoder.cpp \
+	$$SOURCEDIR/io/InputFile.cpp \
 #
 	$$SOURCEDIR/util/BBox.cpp \
 	$$SOURCEDIR/util/Endian.cpp \
@@ -59,11 +69,15 @@ SOURCES += \
 	$$SOURCEDIR/wrl/IndexedLineSet.cpp \
 	$$SOURCEDIR/wrl/IndexedFaceSet.cpp \
 	$$SOURCEDIR/wrl/IndexedFaceSetPly.cpp \
+	$$SOURCEDIR/wrl/Inline.cpp \
 	$$SOURCEDIR/wrl/Material.cpp \
 	$$SOURCEDIR/wrl/Node.cpp \
 	$$SOURCEDIR/wrl/PixelTexture.cpp \
 	$$SOURCEDIR/wrl/Rotation.cpp \
 	$$SOURCEDIR/wrl/SceneGraph.cpp \
+	$$SOURCEDIR/wrl/SceneGraphBvh.cpp \
+	$$SOURCEDIR/wrl/SceneGraphIndex.cpp \
+	$$SOURCEDIR/wrl/OutOfCoreProcessor.cpp \
 	$$SOURCEDIR/wrl/SceneGraphProcessor.cpp \
 	$$SOURCEDIR/wrl/SceneGraphTraversal.cpp \
 	$$SOURCEDIR/wrl/Shape.cpp \
@@ -81,6 +95,7 @@ HEADERS += \
 	$$SOURCEDIR/core/PolygonMeshTest.hpp \
 #
 	$$SOURCEDIR/gui/GuiAboutDialog.hpp \
+	$$SOURCEDIR/gui/GuiGLBatch.hpp \
 	$$SOURCEDIR/gui/GuiGLBuffer.hpp \
 	$$SOURCEDIR/gui/GuiGLHandles.hpp \
 	$$SOURCEDIR/gui/GuiGLShader.hpp \
@@ -97,14 +112,23 @@ HEADERS += \
 	$$SOURCEDIR/io/LoaderPly.hpp \
 	$$SOURCEDIR/io/LoaderStl.hpp \
 	$$SOURCEDIR/io/LoaderWrl.hpp \
+	$$SOURCEDIR/io/LoaderWrb.hpp \
+	$$SOURCEDIR/io/LoaderEbm.hpp \
 	$$SOURCEDIR/io/Saver.hpp \
 	$$SOURCEDIR/io/SaverPly.hpp \
 	$$SOURCEDIR/io/SaverStl.hpp \
 	$$SOURCEDIR/io/SaverWrl.hpp \
+	$$SOURCEDIR/io/SaverWrb.hpp \
+	$$SOURCEDIR/io/SaverEbm.hpp \
 	$$SOURCEDIR/io/StrException.hpp \
 	$$SOURCEDIR/io/Tokenizer.hpp \
 	$$SOURCEDIR/io/TokenizerFile.hpp \
 	$$SOURCEDIR/io/TokenizerString.hpp \
+	$$SOURCEDIR/io/TokenizerBuffer.hpp \
+	$$SOURCEDIR/io/TextWriter.hpp \
+	$$SOURCEDIR/io/BinaryWriter.hpp \
+	$$SOURCEDIR/io/RangeCoder.hpp \
+	$$SOURCEDIR/io/InputFile.hpp \
 #
 	$$SOURCEDIR/util/CastMacros.hpp \
 	$$SOURCEDIR/util/BBox.hpp \
@@ -118,11 +142,15 @@ HEADERS += \
 	$$SOURCEDIR/wrl/IndexedLineSet.hpp \
 	$$SOURCEDIR/wrl/IndexedFaceSet.hpp \
 	$$SOURCEDIR/wrl/IndexedFaceSetPly.hpp \
+	$$SOURCEDIR/wrl/Inline.hpp \
 	$$SOURCEDIR/wrl/Material.hpp \
 	$$SOURCEDIR/wrl/Node.hpp \
 	$$SOURCEDIR/wrl/PixelTexture.hpp \
 	$$SOURCEDIR/wrl/Rotation.hpp \
 	$$SOURCEDIR/wrl/SceneGraph.hpp \
+	$$SOURCEDIR/wrl/SceneGraphBvh.hpp \
+	$$SOURCEDIR/wrl/SceneGraphIndex.hpp \
+	$$SOURCEDIR/wrl/OutOfCoreProcessor.hpp \
 	$$SOURCEDIR/wrl/SceneGraphProcessor.hpp \
 	$$SOURCEDIR/wrl/SceneGraphTraversal.hpp \
 	$$SOURCEDIR/wrl/Shape.hpp \
@@ -38,6 +38,12 @@ win32 {
     DSHOW_LIBS = -lStrmiids -lVfw32 -lOle32 -lOleAut32 -lopengl32
 }
 
+unix {
+    # used by io/InputFile to read .gz files and .zip archives
+    DEFINES += HAVE_ZLIB
+    LIBS += -lz
+}
+
 unix:!macx {
     QMAKE_LFLAGS += -Wl
     # QMAKE_CXXFLAGS += -g
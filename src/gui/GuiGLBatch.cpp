@@ -0,0 +1,361 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-14 09:12:05 taubin>
+//------------------------------------------------------------------------
+//
+// GuiGLBatch.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <string.h>
+#include <map>
+#include <QOpenGLShaderProgram>
+
+#include "GuiGLBatch.hpp"
+#include "GuiGLShader.hpp"
+
+#include "wrl/SceneGraphIndex.hpp"
+
+#define _BATCH_STR(x) #x
+#define BATCH_STR(x) _BATCH_STR(x)
+
+// as GuiGLShader::s_vsMaterial and GuiGLShader::s_vsMaterialNormal,
+// but the color of each vertex is selected from an array of material
+// colors by the index of its instance within the draw call
+
+const char *GuiGLBatch::s_vsBatchMaterial =
+  "attribute highp vec4 vertex;\n"
+  "attribute mediump float drawid;\n"
+  "uniform mediump float pointsize;\n"
+  "uniform mediump mat4 mvpmatrix;\n"
+  "uniform mediump vec4 matcolor[" BATCH_STR(BATCH_DRAWS) "];\n"
+  "varying mediump vec4 color;\n"
+  "void main(void) {\n"
+  "  color = matcolor[int(drawid)];\n"
+  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_PointSize = pointsize;\n"
+  "}\n";
+
+const char *GuiGLBatch::s_vsBatchMaterialNormal =
+  "attribute highp vec4 vertex;\n"
+  "attribute mediump vec3 vnormal;\n"
+  "attribute mediump float drawid;\n"
+  "uniform mediump float pointsize;\n"
+  "uniform mediump mat4 mvpmatrix;\n"
+  "uniform mediump vec4 matcolor[" BATCH_STR(BATCH_DRAWS) "];\n"
+  "uniform mediump vec3 lightsource;\n"
+  "varying mediump vec4 color;\n"
+  "void main(void) {\n"
+  "  vec3 toLight = normalize(lightsource);\n"
+  "  float angle = max(dot(vnormal, toLight), 0.0);\n"
+  "  vec3 col = vec3(matcolor[int(drawid)]);\n"
+  "  color = vec4(col * 0.2 + col * 0.8 * angle, 1.0);\n"
+  "  color = clamp(color, 0.0, 1.0);\n"
+  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_PointSize = pointsize;\n"
+  "}\n";
+
+// as GuiGLShader::s_vsMaterialFlat, with the colors selected as above
+const char *GuiGLBatch::s_vsBatchMaterialFlat =
+  "attribute highp vec4 vertex;\n"
+  "attribute mediump float drawid;\n"
+  "uniform mediump float pointsize;\n"
+  "uniform mediump mat4 mvpmatrix;\n"
+  "uniform mediump vec4 matcolor[" BATCH_STR(BATCH_DRAWS) "];\n"
+  "varying mediump vec4 color;\n"
+  "varying vec3 position;\n"
+  "void main(void) {\n"
+  "  color = matcolor[int(drawid)];\n"
+  "  position = vertex.xyz;\n"
+  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_PointSize = pointsize;\n"
+  "}\n";
+
+// the vertex data of one geometry node, shared by its instances
+class BatchGeometry {
+public:
+  GuiGLBuffer      _buffer; // only used for the type and counts
+  QVector<GLfloat> _data;
+};
+
+//////////////////////////////////////////////////////////////////////
+GuiGLBatch::GuiGLBatch():
+  _multiDrawArrays((MultiDrawArrays)0),
+  _wrl((SceneGraph*)0),
+  _valid(false),
+  _structureVersion(0),
+  _transformVersion(0) {
+}
+
+//////////////////////////////////////////////////////////////////////
+// the owner must call clear() with the OpenGL context current
+GuiGLBatch::~GuiGLBatch() {
+  for(_Variant* v : _variant)
+    delete v;
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBatch::setMultiDrawArrays(MultiDrawArrays multiDrawArrays) {
+  _multiDrawArrays = multiDrawArrays;
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBatch::invalidate() {
+  _valid = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBatch::clear() {
+  for(_Variant* v : _variant) {
+    if(v->_buffer.isCreated())
+      v->_buffer.destroy();
+    delete v;
+  }
+  _variant.clear();
+  _wrl   = (SceneGraph*)0;
+  _valid = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBatch::_build(SceneGraph* wrl) {
+
+  clear();
+
+  const vector<SceneGraphIndex::Instance>& instance =
+    wrl->getIndex().getInstances();
+
+  _wrl              = wrl;
+  _valid            = true;
+  _structureVersion = Node::getStructureVersion();
+  _transformVersion = Node::getTransformVersion();
+
+  // the vertex data of each geometry node is computed once, and
+  // copied into the variant buffer once per instance
+  map<Node*,BatchGeometry*> geometryMap;
+  map<int,_Variant*>        variantMap;
+
+  for(const SceneGraphIndex::Instance& i : instance) {
+    if(i._show==false || i._geometry==(Node*)0) continue;
+
+    BatchGeometry*& g = geometryMap[i._geometry];
+    if(g==(BatchGeometry*)0) {
+      g = new BatchGeometry();
+      if(IndexedFaceSet* ifs = dynamic_cast<IndexedFaceSet*>(i._geometry))
+        g->_buffer.setData(ifs,g->_data);
+      else if(IndexedLineSet* ils = dynamic_cast<IndexedLineSet*>(i._geometry))
+        g->_buffer.setData(ils,g->_data);
+    }
+    GuiGLBuffer& b  = g->_buffer;
+    int          nV = static_cast<int>(b.getNumberOfVertices());
+    if(nV==0) continue;
+
+    GuiGLBuffer::Type type = b.getType();
+    GLenum mode =
+      (b.hasFaces())?GL_TRIANGLES:(b.hasPolylines())?GL_LINES:GL_POINTS;
+    bool material =
+      (type==GuiGLBuffer::MATERIAL || type==GuiGLBuffer::MATERIAL_NORMAL);
+
+    int key = 3*static_cast<int>(type)+
+      ((mode==GL_TRIANGLES)?0:(mode==GL_LINES)?1:2);
+    _Variant*& v = variantMap[key];
+    if(v==(_Variant*)0) {
+      v = new _Variant();
+      v->_type   = type;
+      v->_mode   = mode;
+      // one more float per vertex for the drawid
+      v->_stride = static_cast<int>(b.getStride())+((material)?1:0);
+      _variant.push_back(v);
+    }
+
+    // same default as GuiGLWidget::setSceneGraph()
+    QVector4D color(255.0f/255.0f,150.0f/255.0f,90.0f/255.0f,1.0f);
+    if(i._material!=(Material*)0) {
+      Color& diffuseColor = i._material->getDiffuseColor();
+      color = QVector4D(diffuseColor.r,diffuseColor.g,diffuseColor.b,1.0f);
+    }
+
+    int iDraw  = static_cast<int>(v->_first.size());
+    int first  = static_cast<int>(v->_data.size())/v->_stride;
+    v->_first.push_back(first);
+    v->_count.push_back(nV);
+    v->_color.push_back(color);
+
+    // append the vertices transformed to world coordinates
+    QMatrix4x4 M(i._matrix); // row-major
+    QMatrix3x3 N        = M.normalMatrix();
+    bool       identity = M.isIdentity();
+    bool       normal   = (b.getNumberOfNormals()>0);
+    int        stride   = static_cast<int>(b.getStride());
+    GLfloat    drawId   = static_cast<GLfloat>(iDraw%BATCH_DRAWS);
+
+    size_t n0 = v->_data.size();
+    v->_data.resize(n0+static_cast<size_t>(nV)*v->_stride);
+    const GLfloat* src = g->_data.constData();
+    GLfloat*       dst = v->_data.data()+n0;
+    for(int iV=0;iV<nV;iV++,src+=stride,dst+=v->_stride) {
+      memcpy(dst,src,stride*sizeof(GLfloat));
+      if(identity==false) {
+        QVector3D x = M.map(QVector3D(src[0],src[1],src[2]));
+        dst[0] = x.x(); dst[1] = x.y(); dst[2] = x.z();
+        if(normal) {
+          QVector3D n
+            (N(0,0)*src[3]+N(0,1)*src[4]+N(0,2)*src[5],
+             N(1,0)*src[3]+N(1,1)*src[4]+N(1,2)*src[5],
+             N(2,0)*src[3]+N(2,1)*src[4]+N(2,2)*src[5]);
+          n.normalize();
+          dst[3] = n.x(); dst[4] = n.y(); dst[5] = n.z();
+        }
+      }
+      if(material)
+        dst[stride] = drawId;
+    }
+  }
+
+  map<Node*,BatchGeometry*>::iterator j;
+  for(j=geometryMap.begin();j!=geometryMap.end();j++)
+    delete j->second;
+
+  // upload the vertex data
+  for(_Variant* v : _variant) {
+    v->_buffer.create();
+    v->_buffer.bind();
+    v->_buffer.allocate(v->_data.data(),
+                        static_cast<int>(v->_data.size()*sizeof(GLfloat)));
+    v->_buffer.release();
+    vector<GLfloat>().swap(v->_data);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBatch::paint
+(QOpenGLFunctions& f, SceneGraph* wrl,
+ const QMatrix4x4& mvp, const QVector3D& lightSource) {
+
+  if(wrl==(SceneGraph*)0 || wrl->getShow()==false) return;
+
+  if(_valid==false || wrl!=_wrl ||
+     _structureVersion!=Node::getStructureVersion() ||
+     _transformVersion!=Node::getTransformVersion())
+    _build(wrl);
+
+  for(_Variant* v : _variant)
+    _paint(f,*v,mvp,lightSource);
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBatch::_paint
+(QOpenGLFunctions& f, _Variant& v,
+ const QMatrix4x4& mvp, const QVector3D& lightSource) {
+
+  bool material =
+    (v._type==GuiGLBuffer::MATERIAL || v._type==GuiGLBuffer::MATERIAL_NORMAL);
+  bool normal   =
+    (v._type==GuiGLBuffer::MATERIAL_NORMAL ||
+     v._type==GuiGLBuffer::COLOR_NORMAL);
+  // faces without normals, see GuiGLShader::setFlatNormals()
+  bool flat     =
+    (normal==false && v._mode==GL_TRIANGLES && GuiGLShader::getFlatNormals());
+
+  QOpenGLShaderProgram* program =
+    (v._type==GuiGLBuffer::MATERIAL)?
+    ((flat)?
+     GuiGLShader::getProgram(s_vsBatchMaterialFlat,true):
+     GuiGLShader::getProgram(s_vsBatchMaterial)):
+    (v._type==GuiGLBuffer::MATERIAL_NORMAL)?
+    GuiGLShader::getProgram(s_vsBatchMaterialNormal):
+    GuiGLShader::getProgram(v._type,flat);
+  if(program==(QOpenGLShaderProgram*)0 || program->isLinked()==false)
+    return;
+
+  int vertexAttr   = program->attributeLocation("vertex");
+  int normalAttr   = (normal)?program->attributeLocation("vnormal"):-1;
+  int colorAttr    = (material)?-1:program->attributeLocation("vcolor");
+  int drawIdAttr   = (material)?program->attributeLocation("drawid"):-1;
+  int instanceAttr = (material)?-1:program->attributeLocation("instance");
+  int materialAttr = (material)?program->uniformLocation("matcolor"):-1;
+
+  program->bind();
+
+  program->setUniformValue("mvpmatrix", mvp);
+  program->setUniformValue("pointsize", 4.0f);
+  if(normal || flat)
+    program->setUniformValue("lightsource", lightSource);
+
+  int stride = v._stride*sizeof(GLfloat);
+  int offset = 3;
+  v._buffer.bind();
+  program->enableAttributeArray(vertexAttr);
+  program->setAttributeBuffer(vertexAttr, GL_FLOAT, 0, 3, stride);
+  if(normalAttr>=0) {
+    program->enableAttributeArray(normalAttr);
+    program->setAttributeBuffer
+      (normalAttr, GL_FLOAT, offset*sizeof(GLfloat), 3, stride);
+    offset += 3;
+  }
+  if(colorAttr>=0) {
+    program->enableAttributeArray(colorAttr);
+    program->setAttributeBuffer
+      (colorAttr, GL_FLOAT, offset*sizeof(GLfloat), 3, stride);
+    offset += 3;
+  }
+  if(drawIdAttr>=0) {
+    program->enableAttributeArray(drawIdAttr);
+    program->setAttributeBuffer
+      (drawIdAttr, GL_FLOAT, offset*sizeof(GLfloat), 1, stride);
+  }
+  v._buffer.release();
+
+  if(instanceAttr>=0) {
+    // the vertices are already in world coordinates
+    QMatrix4x4 identity;
+    program->setAttributeValue(instanceAttr, identity.constData(), 4, 4);
+  }
+
+  // the material colors of at most BATCH_DRAWS instances fit in the
+  // uniform array
+  int nDraws = static_cast<int>(v._first.size());
+  int nGroup = (material)?BATCH_DRAWS:nDraws;
+  for(int d0=0;d0<nDraws;d0+=nGroup) {
+    int n = (nDraws-d0<nGroup)?nDraws-d0:nGroup;
+    if(materialAttr>=0)
+      program->setUniformValueArray(materialAttr, v._color.data()+d0, n);
+    if(_multiDrawArrays!=(MultiDrawArrays)0) {
+      _multiDrawArrays(v._mode, v._first.data()+d0, v._count.data()+d0, n);
+    } else {
+      for(int d=d0;d<d0+n;d++)
+        f.glDrawArrays(v._mode, v._first[d], v._count[d]);
+    }
+  }
+
+  program->disableAttributeArray(vertexAttr);
+  if(normalAttr>=0) program->disableAttributeArray(normalAttr);
+  if(colorAttr >=0) program->disableAttributeArray(colorAttr);
+  if(drawIdAttr>=0) program->disableAttributeArray(drawIdAttr);
+
+  program->release();
+}
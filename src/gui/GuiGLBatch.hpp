@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-14 09:12:05 taubin>
+//------------------------------------------------------------------------
+//
+// GuiGLBatch.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _GUI_GL_BATCH_HPP_
+#define _GUI_GL_BATCH_HPP_
+
+#include <vector>
+#include <QVector3D>
+#include <QVector4D>
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include "wrl/SceneGraph.hpp"
+#include "GuiGLBuffer.hpp"
+
+// Paints all the shape instances of a SceneGraph with a few draw
+// calls. The vertex data of the instances, transformed to world
+// coordinates, is packed into one vertex buffer per variant, i.e., per
+// GuiGLBuffer::Type and primitive, and each variant is drawn with one
+// glMultiDrawArrays() call. For the MATERIAL variants the material
+// colors of the instances are loaded into a uniform array, and one
+// call is issued per group of BATCH_DRAWS instances. The shader
+// programs are shared with GuiGLShader, and only compiled once.
+//
+// The buffers are rebuilt by paint() after the structure of the scene
+// graph or the fields of a Transform node change, and after
+// invalidate() is called.
+
+#define BATCH_DRAWS 64
+
+class GuiGLBatch {
+
+private:
+
+  static const char *s_vsBatchMaterial;
+  static const char *s_vsBatchMaterialNormal;
+  static const char *s_vsBatchMaterialFlat;
+
+public:
+
+  typedef void (QOPENGLF_APIENTRYP MultiDrawArrays)
+    (GLenum mode, const GLint* first, const GLsizei* count, GLsizei n);
+
+  GuiGLBatch();
+  ~GuiGLBatch();
+
+  // null to issue one glDrawArrays() per instance
+  void     setMultiDrawArrays(MultiDrawArrays multiDrawArrays);
+
+  // clear() deletes the vertex buffers, and paint() may rebuild them;
+  // both must be called with the OpenGL context current
+  void     invalidate();
+  void     clear();
+  void     paint(QOpenGLFunctions& f, SceneGraph* wrl,
+                 const QMatrix4x4& mvp, const QVector3D& lightSource);
+
+private:
+
+  class _Variant {
+  public:
+    GuiGLBuffer::Type _type;
+    GLenum            _mode;
+    int               _stride;  // floats per vertex
+    vector<GLfloat>   _data;    // released after the upload
+    vector<GLint>     _first;   // one per instance
+    vector<GLsizei>   _count;
+    vector<QVector4D> _color;
+    QOpenGLBuffer     _buffer;
+  };
+
+  void     _build(SceneGraph* wrl);
+  void     _paint(QOpenGLFunctions& f, _Variant& variant,
+                  const QMatrix4x4& mvp, const QVector3D& lightSource);
+
+  vector<_Variant*> _variant;
+  MultiDrawArrays   _multiDrawArrays;
+  SceneGraph*       _wrl;
+  bool              _valid;
+  unsigned          _structureVersion;
+  unsigned          _transformVersion;
+
+};
+
+#endif // _GUI_GL_BATCH_HPP_
@@ -34,7 +34,9 @@
 
 #include <iostream>
 #include <math.h>
+#include <string.h>
 #include "GuiGLBuffer.hpp"
+#include "core/Graph.hpp"
 
 //////////////////////////////////////////////////////////////////////
 GuiGLBuffer::GuiGLBuffer():
@@ -46,33 +48,76 @@ GuiGLBuffer::GuiGLBuffer():
   _hasFaces(false),
   _hasPolylines(false),
   _hasColor(false),
-  _hasNormal(false) {
+  _hasNormal(false),
+  _coordType(GL_FLOAT),
+  _colorType(GL_FLOAT),
+  _edgeBuffer(QOpenGLBuffer::IndexBuffer),
+  _nEdgeIndices(0) {
 }
 
 //////////////////////////////////////////////////////////////////////
 GuiGLBuffer::GuiGLBuffer(IndexedFaceSet* pIfs, QColor& materialColor):
   QOpenGLBuffer(),
+  _type(MATERIAL),
   _nVertices(0),
   _nNormals(0),
   _nColors(0),
   _hasFaces(false),
   _hasPolylines(false),
   _hasColor(false),
-  _hasNormal(false) {
+  _hasNormal(false),
+  _coordType(GL_FLOAT),
+  _colorType(GL_FLOAT),
+  _edgeBuffer(QOpenGLBuffer::IndexBuffer),
+  _nEdgeIndices(0) {
 
   // std::cout << "GuiGLBuffer::GuiGLBuffer(IndexedFaceSet) {\n";
 
-  QVector<QVector3D> m_vertices;
-  QVector<QVector3D> m_normals;
-  QVector<QVector3D> m_colors;
+  (void)materialColor;
+  if(pIfs==(IndexedFaceSet*)0) return;
+
+  // Use a vertex buffer object.
+
+  if(pIfs->hasCompactCoord() || pIfs->hasCompactColor()) {
+    QByteArray buf;
+    setCompactData(pIfs,buf);
+    this->create();
+    this->bind();
+    this->allocate(buf.constData(), buf.size());
+    this->release();
+  } else {
+    QVector<GLfloat> buf;
+    setData(pIfs,buf);
+    this->create();
+    this->bind();
+    this->allocate(buf.constData(), buf.count() * sizeof(GLfloat));
+    this->release();
+  }
+
+  // std::cout << "}\n";
+}
+
+//////////////////////////////////////////////////////////////////////
+// the coord, normal, and color indices of each vertex of this buffer,
+// three per vertex, with -1 for the missing properties
+void GuiGLBuffer::_setVertexIndices
+(IndexedFaceSet* pIfs, vector<int>& index) {
+
+  _type         = MATERIAL;
+  _nVertices    = 0;
+  _nNormals     = 0;
+  _nColors      = 0;
+  _hasFaces     = false;
+  _hasPolylines = false;
+  _hasColor     = false;
+  _hasNormal    = false;
+  index.clear();
 
   if(pIfs==(IndexedFaceSet*)0) return;
 
-  vector<float>& coord       = pIfs->getCoord();
   vector<int>&   coordIndex  = pIfs->getCoordIndex();
 
   bool           colorPerVertex = pIfs->getColorPerVertex();
-  vector<float>& color       = pIfs->getColor();
   vector<int>&   colorIndex  = pIfs->getColorIndex();
   // IndexedFaceSet::Binding   cBinding    = pIfs->getColorBinding();
 
@@ -84,83 +129,65 @@ GuiGLBuffer::GuiGLBuffer(IndexedFaceSet* pIfs, QColor& materialColor):
   // int         nV          = pIfs->getNumberOfCoord();
   int            nF          = pIfs->getNumberOfFaces();
 
-  // material color values in [0.0:1.0] range
-  float /*qreal*/ matR,matG,matB,matA;
-  materialColor.getRgbF(&matR,&matG,&matB,&matA);
-  QVector3D matColor(matR,matG,matB);
-
+  // the number of colors does not decode the compact colors
   _hasFaces  = (nF>0);
   _hasNormal = (normal.size()>0); // (nBinding!=IndexedFaceSet::Binding::PB_NONE);
-  _hasColor  = (color.size()>0);  // cBinding!=IndexedFaceSet::Binding::PB_NONE);
+  _hasColor  = (pIfs->getNumberOfColor()>0);  // cBinding!=IndexedFaceSet::Binding::PB_NONE);
 
   _type =
     (_hasColor)?
     ((_hasNormal)?COLOR_NORMAL:COLOR):((_hasNormal)?MATERIAL_NORMAL:MATERIAL);
 
-  m_vertices.clear();
-  m_normals.clear();
-  m_colors.clear();
-
   if(_hasFaces) {
     // polygon mesh
 
-    float x[3][3];
-    float n[3][3];
-    float c[3][3];
-    int   j[3];
+    int n[3];
+    int c[3];
+    int j[3];
 
-    int iN,iC,iV,k,h,i0,i1,iF;
+    int iN,iC,iV,k,i0,i1,iF;
     for(iF=i0=i1=0;i1<(int)coordIndex.size();i1++) {
       if(coordIndex[i1]<0) {
         // number of triangles in this face
         // nTrianglesFace = i1-i0-2;
 
+        n[0] = n[1] = n[2] = -1;
+        c[0] = c[1] = c[2] = -1;
+
         if(_hasNormal && normalPerVertex==false) {
           // NORMAL_PER_FACE_INDEXED or NORMAL_PER_FACE
           iN = (normalIndex.size()>0)?normalIndex[iF]:iF;
-          for(h=0;h<3;h++)
-            n[0][h] = n[1][h] = n[2][h] = normal[3*iN+h];
+          n[0] = n[1] = n[2] = iN;
         }
 
         if(_hasColor && colorPerVertex==false) {
           // COLOR_PER_FACE_INDEXED or COLOR_PER_FACE
           iC = (colorIndex.size()>0)?colorIndex[iF]:iF;
-          for(h=0;h<3;h++)
-            c[0][h] = c[1][h] = c[2][h] = color[3*iC+h];
+          c[0] = c[1] = c[2] = iC;
         }
 
         // triangulate face [i0:i1) on the fly and add triangles to current mesh
         for(j[0]=i0,j[1]=i0+1,j[2]=i0+2;j[2]<i1;j[1]=j[2]++) {
           // triangle [j0,j1,j2]
           for(k=0;k<3;k++) {
-            // get vertex coordinates
             iV = coordIndex[j[k]];
-            for(h=0;h<3;h++)
-              x[k][h] = coord[3*iV+h];
 
             if(_hasNormal && normalPerVertex==true) {
               // NORMAL_PER_CORNER or NORNAL_PER_VERTEX
-              iN = (normalIndex.size()>0)?normalIndex[j[k]]:iV;
-              for(h=0;h<3;h++)
-                n[k][h] = normal[3*iN+h];
+              n[k] = (normalIndex.size()>0)?normalIndex[j[k]]:iV;
             }
 
             if(_hasColor && colorPerVertex==true) {
               // COLOR_PER_CORNER or COLOR_PER_VERTEX
-              iC = (colorIndex.size()>0)?colorIndex[j[k]]:iV;
-              for(h=0;h<3;h++)
-                c[k][h] = color[3*iC+h];
+              c[k] = (colorIndex.size()>0)?colorIndex[j[k]]:iV;
             }
-
           }
 
-          // push values into buffers
+          // push indices into buffer
           for(k=2;k>=0;k--) {
-            m_vertices.append(QVector3D(x[k][0],x[k][1],x[k][2]));
-            if(_hasNormal)
-              m_normals.append(QVector3D(n[k][0],n[k][1],n[k][2]));
-            if(_hasColor)
-              m_colors.append(QVector3D(c[k][0],c[k][1],c[k][2]));
+            index.push_back(coordIndex[j[k]]);
+            index.push_back(n[k]);
+            index.push_back(c[k]);
           }
         }
 
@@ -181,61 +208,56 @@ GuiGLBuffer::GuiGLBuffer(IndexedFaceSet* pIfs, QColor& materialColor):
     // assert(colorIndex.size()==0);
     // assert(color.size()==0 || color.size()==coord.size());
 
-    unsigned iV,nVertices;
+    int iV,nVertices;
     nVertices = pIfs->getNumberOfCoord();
-    float x[3],n[3],c[3];
     for(iV=0;iV<nVertices;iV++) {
-      x[0] = coord[3*iV  ];
-      x[1] = coord[3*iV+1];
-      x[2] = coord[3*iV+2];
-      m_vertices.append(QVector3D(x[0],x[1],x[2]));
-      if(_hasNormal) {
-        n[0] = normal[3*iV  ];
-        n[1] = normal[3*iV+1];
-        n[2] = normal[3*iV+2];
-        m_normals.append(QVector3D(n[0],n[1],n[2]));
-      }
-      if(_hasColor) {
-        c[0] = color[3*iV  ];
-        c[1] = color[3*iV+1];
-        c[2] = color[3*iV+2];
-        m_colors.append(QVector3D(c[0],c[1],c[2]));
-      }
+      index.push_back(iV);
+      index.push_back((_hasNormal)?iV:-1);
+      index.push_back((_hasColor)?iV:-1);
     }
   }
 
-  _nVertices = m_vertices.count();
-  _nNormals  = m_normals.count();
-  _nColors   = m_colors.count();
+  _nVertices = static_cast<unsigned>(index.size()/3);
+  _nNormals  = (_hasNormal)?_nVertices:0;
+  _nColors   = (_hasColor)?_nVertices:0;
+}
 
-  // Use a vertex buffer object.
+//////////////////////////////////////////////////////////////////////
+void GuiGLBuffer::setData(IndexedFaceSet* pIfs, QVector<GLfloat>& buf) {
 
-  this->create();
-  this->bind();
-  QVector<GLfloat> buf;
+  _coordType = GL_FLOAT;
+  _colorType = GL_FLOAT;
+  _coordMatrix.setToIdentity();
+  buf.clear();
+
+  vector<int> index;
+  _setVertexIndices(pIfs,index);
+  if(_nVertices==0) return;
+
+  // the compact coordinates and colors are decoded one at a time
+  vector<float>& normal = pIfs->getNormal();
+
+  // interleaved vertex data
   buf.resize(3*_nVertices+3*_nNormals+3*_nColors);
 
   GLfloat *p = buf.data();
   for (unsigned i = 0; i < _nVertices; ++i) {
     // vertex coordinates
-    *p++ = m_vertices[i].x();
-    *p++ = m_vertices[i].y();
-    *p++ = m_vertices[i].z();
+    pIfs->getCoordValue(index[3*i],p);
+    p += 3;
     // vertex normals
     if(_nNormals>0) {
-      *p++ = m_normals[i].x();
-      *p++ = m_normals[i].y();
-      *p++ = m_normals[i].z();
+      const float* n = &normal[3*index[3*i+1]];
+      *p++ = n[0];
+      *p++ = n[1];
+      *p++ = n[2];
     }
     // vertex colors
     if(_nColors>0) {
-      *p++ = m_colors[i].x();
-      *p++ = m_colors[i].y();
-      *p++ = m_colors[i].z();
+      pIfs->getColorValue(index[3*i+2],p);
+      p += 3;
     }
   }
-  this->allocate(buf.constData(), buf.count() * sizeof(GLfloat));
-  this->release();
 
   // std::cout << "  _nVertices    = " << _nVertices << "\n";
   // std::cout << "  _nNormals     = " << _nNormals << "\n";
@@ -244,27 +266,139 @@ GuiGLBuffer::GuiGLBuffer(IndexedFaceSet* pIfs, QColor& materialColor):
   // std::cout << "  _hasPolylines = " << _hasPolylines << "\n";
   // std::cout << "  _hasColor     = " << _hasColor << "\n";
   // std::cout << "  _hasNormal    = " << _hasNormal << "\n";
+}
 
-  // std::cout << "}\n";
+//////////////////////////////////////////////////////////////////////
+void GuiGLBuffer::setCompactData(IndexedFaceSet* pIfs, QByteArray& buf) {
+
+  buf.clear();
+
+  vector<int> index;
+  _setVertexIndices(pIfs,index);
+  if(_nVertices==0) return;
+
+  bool compactCoord = pIfs->hasCompactCoord();
+  bool compactColor = pIfs->hasCompactColor();
+
+  // the normalized positions in [0,1] are mapped back onto the
+  // quantization box
+  _coordType = (compactCoord)?GL_UNSIGNED_SHORT:GL_FLOAT;
+  _colorType = (compactColor)?GL_UNSIGNED_BYTE:GL_FLOAT;
+  _coordMatrix.setToIdentity();
+  if(compactCoord) {
+    float* min = pIfs->getCoordMin();
+    float* max = pIfs->getCoordMax();
+    _coordMatrix.translate(min[0],min[1],min[2]);
+    _coordMatrix.scale(max[0]-min[0],max[1]-min[1],max[2]-min[2]);
+  }
+
+  vector<unsigned short>& coordQ16   = pIfs->getCoordQ16();
+  vector<unsigned char>&  colorRGBA8 = pIfs->getColorRGBA8();
+  vector<float>&          normal     = pIfs->getNormal();
+
+  int vertexSize   = getVertexSize();
+  int normalOffset = getNormalOffset();
+  int colorOffset  = getColorOffset();
+  buf.resize(vertexSize*static_cast<int>(_nVertices));
+
+  char* p = buf.data();
+  for (unsigned i = 0; i < _nVertices; ++i, p += vertexSize) {
+    int iV = index[3*i], iN = index[3*i+1], iC = index[3*i+2];
+    // vertex coordinates, padded to four bytes
+    if(compactCoord) {
+      unsigned short q[4] =
+        { coordQ16[3*iV], coordQ16[3*iV+1], coordQ16[3*iV+2], 0 };
+      memcpy(p,q,sizeof(q));
+    } else {
+      GLfloat x[3];
+      pIfs->getCoordValue(iV,x);
+      memcpy(p,x,sizeof(x));
+    }
+    // vertex normals
+    if(_nNormals>0)
+      memcpy(p+normalOffset,&normal[3*iN],3*sizeof(GLfloat));
+    // vertex colors
+    if(_nColors>0 && compactColor) {
+      memcpy(p+colorOffset,&colorRGBA8[4*iC],4);
+    } else if(_nColors>0) {
+      GLfloat c[3];
+      pIfs->getColorValue(iC,c);
+      memcpy(p+colorOffset,c,sizeof(c));
+    }
+  }
 }
-
+
+//////////////////////////////////////////////////////////////////////
+int GuiGLBuffer::getVertexSize() const {
+  return getColorOffset()+
+    ((_nColors==0)?0:(_colorType==GL_UNSIGNED_BYTE)?4:3*sizeof(GLfloat));
+}
+
+//////////////////////////////////////////////////////////////////////
+int GuiGLBuffer::getNormalOffset() const {
+  return (_coordType==GL_UNSIGNED_SHORT)?
+    4*sizeof(unsigned short):3*sizeof(GLfloat);
+}
+
+//////////////////////////////////////////////////////////////////////
+int GuiGLBuffer::getColorOffset() const {
+  return getNormalOffset()+((_nNormals>0)?3*sizeof(GLfloat):0);
+}
+
 //////////////////////////////////////////////////////////////////////
 GuiGLBuffer::GuiGLBuffer(IndexedLineSet* pIls, QColor& materialColor):
   QOpenGLBuffer(),
+  _type(MATERIAL),
   _nVertices(0),
   _nNormals(0),
   _nColors(0),
   _hasFaces(false),
   _hasPolylines(false),
   _hasColor(false),
-  _hasNormal(false) {
+  _hasNormal(false),
+  _coordType(GL_FLOAT),
+  _colorType(GL_FLOAT),
+  _edgeBuffer(QOpenGLBuffer::IndexBuffer),
+  _nEdgeIndices(0) {
 
   // std::cout << "GuiGLBuffer::GuiGLBuffer(IndexedLineSet) {\n";
 
+  (void)materialColor;
+  if(pIls==(IndexedLineSet*)0) return;
+
+  QVector<GLfloat> buf;
+  setData(pIls,buf);
+
+  // Use a vertex buffer object.
+
+  this->create();
+  this->bind();
+  this->allocate(buf.constData(), buf.count() * sizeof(GLfloat));
+  this->release();
+
+  // std::cout << "}\n";
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBuffer::setData(IndexedLineSet* pIls, QVector<GLfloat>& buf) {
+
   QVector<QVector3D> m_vertices;
   QVector<QVector3D> m_normals;
   QVector<QVector3D> m_colors;
 
+  _type         = MATERIAL;
+  _nVertices    = 0;
+  _nNormals     = 0;
+  _nColors      = 0;
+  _hasFaces     = false;
+  _hasPolylines = false;
+  _hasColor     = false;
+  _hasNormal    = false;
+  _coordType    = GL_FLOAT;
+  _colorType    = GL_FLOAT;
+  _coordMatrix.setToIdentity();
+  buf.clear();
+
   if(pIls==(IndexedLineSet*)0) return;
 
   vector<float>& coord          = pIls->getCoord();
@@ -275,11 +409,6 @@ GuiGLBuffer::GuiGLBuffer(IndexedLineSet* pIls, QColor& materialColor):
   // int         nV             = pIls->getNumberOfCoord();
   int            nP             = pIls->getNumberOfPolylines();
 
-  // material color values in [0.0:1.0] range
-  float /*qreal*/ matR,matG,matB,matA;
-  materialColor.getRgbF(&matR,&matG,&matB,&matA);
-  QVector3D matColor(matR,matG,matB);
-
   _hasPolylines = (nP>0);
   _hasColor     = (color.size()>0);
 
@@ -361,11 +490,7 @@ GuiGLBuffer::GuiGLBuffer(IndexedLineSet* pIls, QColor& materialColor):
   _nVertices = m_vertices.count();
   _nColors   = m_colors.count();
 
-  // Use a vertex buffer object.
-
-  this->create();
-  this->bind();
-  QVector<GLfloat> buf;
+  // interleaved vertex data
   buf.resize(3*_nVertices+3*_nColors);
 
   GLfloat *p = buf.data();
@@ -381,8 +506,6 @@ GuiGLBuffer::GuiGLBuffer(IndexedLineSet* pIls, QColor& materialColor):
       *p++ = m_colors[i].z();
     }
   }
-  this->allocate(buf.constData(), buf.count() * sizeof(GLfloat));
-  this->release();
 
   // std::cout << "  _nVertices    = " << _nVertices << "\n";
   // std::cout << "  _nNormals     = " << _nNormals << "\n";
@@ -391,6 +514,67 @@ GuiGLBuffer::GuiGLBuffer(IndexedLineSet* pIls, QColor& materialColor):
   // std::cout << "  _hasPolylines = " << _hasPolylines << "\n";
   // std::cout << "  _hasColor     = " << _hasColor << "\n";
   // std::cout << "  _hasNormal    = " << _hasNormal << "\n";
+}
 
-  // std::cout << "}\n";
+//////////////////////////////////////////////////////////////////////
+void GuiGLBuffer::setEdges(IndexedFaceSet* pIfs) {
+
+  clearEdges();
+  if(pIfs==(IndexedFaceSet*)0 || _hasFaces==false) return;
+
+  vector<int>& coordIndex = pIfs->getCoordIndex();
+  int          nV         = pIfs->getNumberOfCoord();
+  int          nCorners   = static_cast<int>(coordIndex.size());
+
+  // the vertex of this buffer corresponding to each corner; setData()
+  // triangulates each face [i0:i1) as a fan, and pushes the corners
+  // (j0,j1,j2) of each triangle in reverse order
+  vector<int> cornerVertex(nCorners,-1);
+  int i0,i1,m,nC,iT;
+  for(iT=i0=i1=0;i1<nCorners;i1++) {
+    if(coordIndex[i1]<0) {
+      if((nC=i1-i0)>=3) {
+        cornerVertex[i0  ] = 3*iT+2;
+        cornerVertex[i0+1] = 3*iT+1;
+        for(m=2;m<nC;m++)
+          cornerVertex[i0+m] = 3*(iT+m-2);
+        iT += nC-2;
+      }
+      i0 = i1+1;
+    }
+  }
+
+  // each edge shared by several faces is only drawn once
+  Graph           graph(nV);
+  QVector<GLuint> index;
+  int i,iC0,iC1,iE,nE;
+  for(nE=i0=i1=0;i1<nCorners;i1++) {
+    if(coordIndex[i1]<0) {
+      for(iC0=i1-1,i=i0;i<i1;iC0=i++) {
+        iC1 = i;
+        iE  = graph.insertEdge(coordIndex[iC0],coordIndex[iC1]);
+        if(iE<nE) continue; // invalid, or already drawn
+        nE++;
+        if(cornerVertex[iC0]<0 || cornerVertex[iC1]<0) continue;
+        index.append(static_cast<GLuint>(cornerVertex[iC0]));
+        index.append(static_cast<GLuint>(cornerVertex[iC1]));
+      }
+      i0 = i1+1;
+    }
+  }
+
+  _nEdgeIndices = index.count();
+  if(_nEdgeIndices==0) return;
+
+  _edgeBuffer.create();
+  _edgeBuffer.bind();
+  _edgeBuffer.allocate(index.constData(), index.count() * sizeof(GLuint));
+  _edgeBuffer.release();
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLBuffer::clearEdges() {
+  if(_edgeBuffer.isCreated())
+    _edgeBuffer.destroy();
+  _nEdgeIndices = 0;
 }
@@ -38,6 +38,8 @@
 #include <QColor>
 #include <QVector>
 #include <QVector3D>
+#include <QMatrix4x4>
+#include <QByteArray>
 #include <QOpenGLBuffer>
 #include "wrl/IndexedFaceSet.hpp"
 #include "wrl/IndexedLineSet.hpp"
@@ -54,10 +56,43 @@ public:
   GuiGLBuffer(IndexedFaceSet* pIfs, QColor& materialColor);
   GuiGLBuffer(IndexedLineSet* pIls, QColor& materialColor);
 
+  // fill buf with the interleaved vertex data of the geometry, and
+  // set the type and counts of this buffer, without creating the
+  // OpenGL buffer object; buf holds getStride() floats per vertex
+  void     setData(IndexedFaceSet* pIfs, QVector<GLfloat>& buf);
+  void     setData(IndexedLineSet* pIls, QVector<GLfloat>& buf);
+
+  // as setData, but keeping the compact storage of the IndexedFaceSet:
+  // quantized coordinates as four unsigned shorts (the last one
+  // unused), normals as three floats, and RGBA8 colors as four
+  // unsigned bytes per vertex; OpenGL normalizes the compact
+  // attributes to [0,1], and getCoordMatrix() maps the positions back
+  void     setCompactData(IndexedFaceSet* pIfs, QByteArray& buf);
+
   Type     getType() const             { return                       _type; } 
   unsigned getNumberOfVertices() const { return                  _nVertices; }
   unsigned getNumberOfNormals()  const { return                   _nNormals; }
   unsigned getNumberOfColors()   const { return                    _nColors; }
+  unsigned getStride()           const
+  { return 3+((_nNormals>0)?3:0)+((_nColors>0)?3:0); }
+
+  // layout of the vertex data in bytes, valid for both setData and
+  // setCompactData
+  GLenum   getCoordType()        const { return                  _coordType; }
+  GLenum   getColorType()        const { return                  _colorType; }
+  int      getVertexSize()       const;
+  int      getNormalOffset()     const;
+  int      getColorOffset()      const;
+  const QMatrix4x4& getCoordMatrix() const { return            _coordMatrix; }
+
+  // index buffer of the unique edges of the faces of an IndexedFaceSet,
+  // drawn as GL_LINES over the vertices of this buffer; the diagonals
+  // of the triangulated faces are not included; pIfs must be the
+  // IndexedFaceSet passed to the constructor
+  void           setEdges(IndexedFaceSet* pIfs);
+  void           clearEdges();
+  QOpenGLBuffer& getEdgeBuffer()               { return _edgeBuffer; }
+  unsigned       getNumberOfEdgeIndices() const { return _nEdgeIndices; }
 
   bool     hasFaces()            const { return                   _hasFaces; }
   bool     hasPolylines()        const { return               _hasPolylines; }
@@ -67,6 +102,8 @@ public:
 
 protected:
 
+  void     _setVertexIndices(IndexedFaceSet* pIfs, vector<int>& index);
+
   Type     _type;
   unsigned _nVertices;
   unsigned _nNormals;
@@ -75,6 +112,12 @@ protected:
   bool     _hasPolylines;
   bool     _hasColor;
   bool     _hasNormal;
+  GLenum   _coordType;
+  GLenum   _colorType;
+  QMatrix4x4 _coordMatrix;
+
+  QOpenGLBuffer _edgeBuffer;
+  unsigned      _nEdgeIndices;
 
 };
 
@@ -33,10 +33,12 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <iostream>
+#include <string.h>
 #include "GuiGLShader.hpp"
 
 const char *GuiGLShader::s_vsMaterial =
   "attribute highp vec4 vertex;\n"
+  "attribute highp mat4 instance;\n"
   "uniform  mediump float pointsize;\n"
   "uniform  mediump float linewidth;\n"
   "uniform mediump mat4 mvpmatrix;\n"
@@ -44,13 +46,14 @@ const char *GuiGLShader::s_vsMaterial =
   "varying mediump vec4 color;\n"
   "void main(void) {\n"
   "  color = matcolor;\n"
-  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_Position = mvpmatrix * instance * vertex;\n"
   "  gl_PointSize = pointsize;\n"
   // "  gl_LineWidth = linewidth;\n"
   "}\n";
 
 const char *GuiGLShader::s_vsMaterialNormal =
   "attribute highp vec4 vertex;\n"
+  "attribute highp mat4 instance;\n"
   "attribute mediump vec3 vnormal;\n"
   "uniform mediump float pointsize;\n"
   "uniform mediump float linewidth;\n"
@@ -64,13 +67,14 @@ const char *GuiGLShader::s_vsMaterialNormal =
   "  vec3 col = vec3(matcolor);\n"
   "  color = vec4(col * 0.2 + col * 0.8 * angle, 1.0);\n"
   "  color = clamp(color, 0.0, 1.0);\n"
-  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_Position = mvpmatrix * instance * vertex;\n"
   "  gl_PointSize = pointsize;\n"
   // "  gl_LineWidth = linewidth;\n"
   "}\n";
 
 const char *GuiGLShader::s_vsColor =
   "attribute highp vec4 vertex;\n"
+  "attribute highp mat4 instance;\n"
   "attribute mediump vec4 vcolor;\n"
   "uniform mediump float pointsize;\n"
   "uniform mediump float linewidth;\n"
@@ -78,13 +82,14 @@ const char *GuiGLShader::s_vsColor =
   "varying mediump vec4 color;\n"
   "void main(void) {\n"
   "  color = vcolor;\n"
-  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_Position = mvpmatrix * instance * vertex;\n"
   "  gl_PointSize = pointsize;\n"
   // "  gl_LineWidth = linewidth;\n"
   "}\n";
 
 const char *GuiGLShader::s_vsColorNormal =
   "attribute highp vec4 vertex;\n"
+  "attribute highp mat4 instance;\n"
   "attribute mediump vec3 vnormal;\n"
   "attribute mediump vec4 vcolor;\n"
   "uniform mediump float pointsize;\n"
@@ -98,11 +103,46 @@ const char *GuiGLShader::s_vsColorNormal =
   "  vec3 col = vec3(vcolor);\n"
   "  color = vec4(col * 0.2 + col * 0.8 * angle, 1.0);\n"
   "  color = clamp(color, 0.0, 1.0);\n"
-  "  gl_Position = mvpmatrix * vertex;\n"
+  "  gl_Position = mvpmatrix * instance * vertex;\n"
   "  gl_PointSize = pointsize;\n"
   // "  gl_LineWidth = linewidth;\n"
   "}\n";
 
+// as s_vsMaterial and s_vsColor, but the position after the instance
+// matrix is passed to s_fsFlat, which computes the normals
+
+const char *GuiGLShader::s_vsMaterialFlat =
+  "attribute highp vec4 vertex;\n"
+  "attribute highp mat4 instance;\n"
+  "uniform mediump float pointsize;\n"
+  "uniform mediump mat4 mvpmatrix;\n"
+  "uniform mediump vec4 matcolor;\n"
+  "varying mediump vec4 color;\n"
+  "varying vec3 position;\n"
+  "void main(void) {\n"
+  "  vec4 p = instance * vertex;\n"
+  "  color = matcolor;\n"
+  "  position = p.xyz;\n"
+  "  gl_Position = mvpmatrix * p;\n"
+  "  gl_PointSize = pointsize;\n"
+  "}\n";
+
+const char *GuiGLShader::s_vsColorFlat =
+  "attribute highp vec4 vertex;\n"
+  "attribute highp mat4 instance;\n"
+  "attribute mediump vec4 vcolor;\n"
+  "uniform mediump float pointsize;\n"
+  "uniform mediump mat4 mvpmatrix;\n"
+  "varying mediump vec4 color;\n"
+  "varying vec3 position;\n"
+  "void main(void) {\n"
+  "  vec4 p = instance * vertex;\n"
+  "  color = vcolor;\n"
+  "  position = p.xyz;\n"
+  "  gl_Position = mvpmatrix * p;\n"
+  "  gl_PointSize = pointsize;\n"
+  "}\n";
+
 //////////////////////////////////////////////////////////////////////
 const char *GuiGLShader::s_fsColor =
   "varying mediump vec4 color;\n"
@@ -110,10 +150,91 @@ const char *GuiGLShader::s_fsColor =
   "  gl_FragColor = color;\n"
   "}\n";
 
+// the derivatives of the position along the window axes span the
+// plane of the triangle, and their cross product points to the viewer
+const char *GuiGLShader::s_fsFlat =
+  "#ifdef GL_ES\n"
+  "#extension GL_OES_standard_derivatives : enable\n"
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+  "precision highp float;\n"
+  "#else\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "#endif\n"
+  "uniform mediump vec3 lightsource;\n"
+  "varying mediump vec4 color;\n"
+  "varying vec3 position;\n"
+  "void main(void) {\n"
+  "  vec3 normal = normalize(cross(dFdx(position), dFdy(position)));\n"
+  "  vec3 toLight = normalize(lightsource);\n"
+  "  float angle = max(dot(normal, toLight), 0.0);\n"
+  "  vec3 col = vec3(color);\n"
+  "  gl_FragColor = clamp(vec4(col * 0.2 + col * 0.8 * angle, 1.0), 0.0, 1.0);\n"
+  "}\n";
+
+//////////////////////////////////////////////////////////////////////
+map<const char*,QOpenGLShaderProgram*> GuiGLShader::s_program;
+bool                                   GuiGLShader::s_flatNormals = true;
+
+//////////////////////////////////////////////////////////////////////
+// static
+void GuiGLShader::setFlatNormals(bool value) {
+  s_flatNormals = value;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool GuiGLShader::getFlatNormals() {
+  return s_flatNormals;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+// flat only applies to the types without normals
+QOpenGLShaderProgram* GuiGLShader::getProgram
+(GuiGLBuffer::Type type, bool flat) {
+  switch(type) {
+  case GuiGLBuffer::Type::MATERIAL:
+    return (flat)?getProgram(s_vsMaterialFlat,true):getProgram(s_vsMaterial);
+  case GuiGLBuffer::Type::MATERIAL_NORMAL:
+    return getProgram(s_vsMaterialNormal);
+  case GuiGLBuffer::Type::COLOR:
+    return (flat)?getProgram(s_vsColorFlat,true):getProgram(s_vsColor);
+  case GuiGLBuffer::Type::COLOR_NORMAL:
+    return getProgram(s_vsColorNormal);
+  }
+  return (QOpenGLShaderProgram*)0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+// each vertex shader is always linked with the same fragment shader,
+// s_fsFlat if flat is true, and s_fsColor otherwise
+QOpenGLShaderProgram* GuiGLShader::getProgram
+(const char* vsSource, bool flat) {
+  QOpenGLShaderProgram*& program = s_program[vsSource];
+  if(program==(QOpenGLShaderProgram*)0) {
+    // the program owns the shaders it creates
+    program = new QOpenGLShaderProgram;
+    program->addShaderFromSourceCode(QOpenGLShader::Vertex, vsSource);
+    program->addShaderFromSourceCode
+      (QOpenGLShader::Fragment, (flat)?s_fsFlat:s_fsColor);
+    program->link();
+  }
+  return program;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+void GuiGLShader::deletePrograms() {
+  map<const char*,QOpenGLShaderProgram*>::iterator i;
+  for(i=s_program.begin();i!=s_program.end();i++)
+    delete i->second;
+  s_program.clear();
+}
+
 //////////////////////////////////////////////////////////////////////
 GuiGLShader::GuiGLShader(QColor& materialColor, QVector3D* lightSource):
-  _vshader((QOpenGLShader*)0),
-  _fshader((QOpenGLShader*)0),
   _program((QOpenGLShaderProgram*)0),
   _pointSizeAttr(-1),
   _lineWidthAttr(-1),
@@ -123,6 +244,7 @@ GuiGLShader::GuiGLShader(QColor& materialColor, QVector3D* lightSource):
   _mvpMatrixAttr(-1),
   _materialAttr(-1),
   _lightSourceAttr(-1),
+  _instanceAttr(-1),
   _vertexBuffer((GuiGLBuffer*)0),
   _materialColor(materialColor),
   _lightSource(lightSource),
@@ -132,14 +254,12 @@ GuiGLShader::GuiGLShader(QColor& materialColor, QVector3D* lightSource):
 }
 
 //////////////////////////////////////////////////////////////////////
+// neither the vertex buffer, which may be shared by the shaders of
+// several shapes with the same geometry, nor the program are owned by
+// the shader
 GuiGLShader::~GuiGLShader() {
-  delete _program;
-  delete _vshader;
-  delete _fshader;
-  if(_vertexBuffer==(GuiGLBuffer*)0) return;
-  _vertexBuffer->destroy();
-  delete _vertexBuffer;
-  _vertexBuffer = (GuiGLBuffer*)0;
+  if(_instanceBuffer.isCreated())
+    _instanceBuffer.destroy();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -175,6 +295,8 @@ GuiGLBuffer* GuiGLShader::getVertexBuffer() const {
 //////////////////////////////////////////////////////////////////////
 void GuiGLShader::setVertexBuffer(GuiGLBuffer* vb) {
 
+  _program = (QOpenGLShaderProgram*)0;
+
   _vertexBuffer = vb;
   if(_vertexBuffer==(GuiGLBuffer*)0) return;
 
@@ -184,32 +306,13 @@ void GuiGLShader::setVertexBuffer(GuiGLBuffer* vb) {
   // int nNormals  =  _vertexBuffer->getNumberOfNormals();
   // int nColors   =  _vertexBuffer->getNumberOfColors();
 
-  // create the vertex shader
-  _vshader = new QOpenGLShader(QOpenGLShader::Vertex);
-  switch(type) {
-  case GuiGLBuffer::Type::MATERIAL:
-    _vshader->compileSourceCode(s_vsMaterial);
-    break;
-  case GuiGLBuffer::Type::MATERIAL_NORMAL:
-    _vshader->compileSourceCode(s_vsMaterialNormal);
-    break;
-  case GuiGLBuffer::Type::COLOR:
-    _vshader->compileSourceCode(s_vsColor);
-    break;
-  case GuiGLBuffer::Type::COLOR_NORMAL:
-    _vshader->compileSourceCode(s_vsColorNormal);
-    break;
-  }
-
-  // create the fragment shader
-  _fshader = new QOpenGLShader(QOpenGLShader::Fragment);
-  _fshader->compileSourceCode(s_fsColor);
-
-  // create the shader program
-  _program = new QOpenGLShaderProgram;
-  _program->addShader(_vshader);
-  _program->addShader(_fshader);
-  _program->link();
+  // the program of this variant is only compiled and linked once;
+  // the faces without normals are lit with flat normals computed by
+  // the fragment shader, and the lines and points are not lit
+  bool flat =
+    s_flatNormals && _lightSource!=(QVector3D*)0 &&
+    _vertexBuffer->hasFaces() && _vertexBuffer->hasNormal()==false;
+  _program = getProgram(type,flat);
 
   _pointSizeAttr       = -1;
   _lineWidthAttr       = -1;
@@ -219,10 +322,12 @@ void GuiGLShader::setVertexBuffer(GuiGLBuffer* vb) {
   _mvpMatrixAttr       = -1;
   _materialAttr        = -1;
   _lightSourceAttr     = -1;
+  _instanceAttr        = -1;
 
   _pointSizeAttr         = _program->uniformLocation("pointsize");
   _lineWidthAttr         = _program->uniformLocation("linewidth");
   _vertexAttr            = _program->attributeLocation("vertex");
+  _instanceAttr          = _program->attributeLocation("instance");
   switch(type) {
   case GuiGLBuffer::Type::MATERIAL:
     _materialAttr        = _program->uniformLocation("matcolor");
@@ -244,16 +349,15 @@ void GuiGLShader::setVertexBuffer(GuiGLBuffer* vb) {
 }
 
 //////////////////////////////////////////////////////////////////////
-void GuiGLShader::paint(QOpenGLFunctions& f) {
-
-  if(_vertexBuffer==(GuiGLBuffer*)0) return;
+void GuiGLShader::_enable() {
 
   GuiGLBuffer::Type type = _vertexBuffer->getType();
 
   _program->bind();
 
   _program->setUniformValue(_mvpMatrixAttr, _mvpMatrix);
-  _program->setUniformValue(_lightSourceAttr, *_lightSource);
+  if(_lightSource!=(QVector3D*)0)
+    _program->setUniformValue(_lightSourceAttr, *_lightSource);
 
   _program->setUniformValue(_pointSizeAttr, _pointSize);
   _program->setUniformValue(_lineWidthAttr, _lineWidth);
@@ -275,47 +379,55 @@ void GuiGLShader::paint(QOpenGLFunctions& f) {
     break;
   }
   
+  // the layout of the vertex data depends on the type of the buffer,
+  // and on whether it keeps the compact coordinates and colors
+  GLenum coordType    = _vertexBuffer->getCoordType();
+  GLenum colorType    = _vertexBuffer->getColorType();
+  int    stride       = _vertexBuffer->getVertexSize();
+  int    normalOffset = _vertexBuffer->getNormalOffset();
+  int    colorOffset  = _vertexBuffer->getColorOffset();
+
   _vertexBuffer->bind();
 
+  _program->setAttributeBuffer
+    (_vertexAttr, coordType,              0, 3, stride);
   switch(type) {
   case GuiGLBuffer::Type::MATERIAL:
-    _program->setAttributeBuffer
-      (_vertexAttr, GL_FLOAT,                 0, 3, 3*sizeof(GLfloat));
     break;
   case GuiGLBuffer::Type::MATERIAL_NORMAL:
     _program->setAttributeBuffer
-      (_vertexAttr, GL_FLOAT,                 0, 3, 6*sizeof(GLfloat));
-    _program->setAttributeBuffer
-      (_normalAttr, GL_FLOAT, 3*sizeof(GLfloat), 3, 6*sizeof(GLfloat));
+      (_normalAttr,  GL_FLOAT, normalOffset, 3, stride);
     break;
   case GuiGLBuffer::Type::COLOR:
     _program->setAttributeBuffer
-      (_vertexAttr, GL_FLOAT,                 0, 3, 6*sizeof(GLfloat));
-    _program->setAttributeBuffer
-      ( _colorAttr, GL_FLOAT, 3*sizeof(GLfloat), 3, 6*sizeof(GLfloat));
+      ( _colorAttr, colorType,  colorOffset, 3, stride);
     break;
   case GuiGLBuffer::Type::COLOR_NORMAL:
     _program->setAttributeBuffer
-      (_vertexAttr, GL_FLOAT,                 0, 3, 9*sizeof(GLfloat));
+      (_normalAttr,  GL_FLOAT, normalOffset, 3, stride);
     _program->setAttributeBuffer
-      (_normalAttr, GL_FLOAT, 3*sizeof(GLfloat), 3, 9*sizeof(GLfloat));
-    _program->setAttributeBuffer
-      ( _colorAttr, GL_FLOAT, 6*sizeof(GLfloat), 3, 9*sizeof(GLfloat));
+      ( _colorAttr, colorType,  colorOffset, 3, stride);
     break;
   }
 
   _vertexBuffer->release();
-
-  int nVertices =  getNumberOfVertices();
-  if(_vertexBuffer->hasFaces()) {
-    f.glDrawArrays(GL_TRIANGLES, 0, nVertices);
-  } else if(_vertexBuffer->hasPolylines()) {
-    // TODO : move lineWidth to the vertex shader
-    // glLineWidth(_lineWidth);
-    f.glDrawArrays(GL_LINES, 0, nVertices);
-  } else {
-    f.glDrawArrays(GL_POINTS, 0, nVertices);
-  }
+}
+
+//////////////////////////////////////////////////////////////////////
+GLenum GuiGLShader::_mode() const {
+  if(_vertexBuffer->hasFaces())
+    return GL_TRIANGLES;
+  // TODO : move lineWidth to the vertex shader
+  // glLineWidth(_lineWidth);
+  if(_vertexBuffer->hasPolylines())
+    return GL_LINES;
+  return GL_POINTS;
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLShader::_disable() {
+
+  GuiGLBuffer::Type type = _vertexBuffer->getType();
 
   _program->disableAttributeArray(_vertexAttr);
   switch(type) {
@@ -335,3 +447,107 @@ void GuiGLShader::paint(QOpenGLFunctions& f) {
 
   _program->release();
 }
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLShader::paint(QOpenGLFunctions& f) {
+
+  if(_vertexBuffer==(GuiGLBuffer*)0) return;
+
+  _enable();
+
+  // a single instance; the instance matrix is the identity, unless
+  // the buffer keeps quantized coordinates
+  const QMatrix4x4& coordMatrix = _vertexBuffer->getCoordMatrix();
+  _program->setAttributeValue(_instanceAttr, coordMatrix.constData(), 4, 4);
+
+  f.glDrawArrays(_mode(), 0, getNumberOfVertices());
+
+  _disable();
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLShader::paint
+(QOpenGLExtraFunctions& f, const vector<QMatrix4x4>& instance) {
+
+  if(_vertexBuffer==(GuiGLBuffer*)0 || _instanceAttr<0 ||
+     instance.size()==0) return;
+
+  // upload the instance matrices, one column per attribute location
+  // composed with the decoding of the quantized coordinates, if any
+  const QMatrix4x4& coordMatrix = _vertexBuffer->getCoordMatrix();
+  bool decode = !coordMatrix.isIdentity();
+  int nInstances = static_cast<int>(instance.size());
+  QVector<GLfloat> buf;
+  buf.resize(16*nInstances);
+  for(int i=0;i<nInstances;i++) {
+    if(decode) {
+      QMatrix4x4 M = instance[i]*coordMatrix;
+      memcpy(buf.data()+16*i,M.constData(),16*sizeof(GLfloat));
+    } else {
+      memcpy(buf.data()+16*i,instance[i].constData(),16*sizeof(GLfloat));
+    }
+  }
+  if(_instanceBuffer.isCreated()==false) {
+    _instanceBuffer.create();
+    _instanceBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  }
+  _instanceBuffer.bind();
+  _instanceBuffer.allocate(buf.constData(), buf.count() * sizeof(GLfloat));
+
+  _enable();
+
+  _instanceBuffer.bind();
+  for(int c=0;c<4;c++) {
+    _program->enableAttributeArray(_instanceAttr+c);
+    _program->setAttributeBuffer
+      (_instanceAttr+c, GL_FLOAT, 4*c*sizeof(GLfloat), 4, 16*sizeof(GLfloat));
+    f.glVertexAttribDivisor(_instanceAttr+c, 1);
+  }
+  _instanceBuffer.release();
+
+  f.glDrawArraysInstanced(_mode(), 0, getNumberOfVertices(), nInstances);
+
+  for(int c=0;c<4;c++) {
+    f.glVertexAttribDivisor(_instanceAttr+c, 0);
+    _program->disableAttributeArray(_instanceAttr+c);
+  }
+
+  _disable();
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLShader::paintEdges(QOpenGLFunctions& f, const QColor& edgeColor) {
+
+  if(_vertexBuffer==(GuiGLBuffer*)0 ||
+     _vertexBuffer->getNumberOfEdgeIndices()==0) return;
+
+  // the positions are at the start of every vertex, whatever the type
+  // of the buffer, so the MATERIAL program draws them
+  QOpenGLShaderProgram* program = getProgram(GuiGLBuffer::Type::MATERIAL);
+  int vertexAttr   = program->attributeLocation("vertex");
+  int instanceAttr = program->attributeLocation("instance");
+
+  program->bind();
+  program->setUniformValue("mvpmatrix", _mvpMatrix);
+  program->setUniformValue("matcolor", edgeColor);
+  program->setUniformValue("pointsize", _pointSize);
+
+  _vertexBuffer->bind();
+  program->enableAttributeArray(vertexAttr);
+  program->setAttributeBuffer
+    (vertexAttr, _vertexBuffer->getCoordType(), 0, 3,
+     _vertexBuffer->getVertexSize());
+  _vertexBuffer->release();
+
+  const QMatrix4x4& coordMatrix = _vertexBuffer->getCoordMatrix();
+  program->setAttributeValue(instanceAttr, coordMatrix.constData(), 4, 4);
+
+  QOpenGLBuffer& edgeBuffer = _vertexBuffer->getEdgeBuffer();
+  edgeBuffer.bind();
+  f.glDrawElements(GL_LINES, _vertexBuffer->getNumberOfEdgeIndices(),
+                   GL_UNSIGNED_INT, (const void*)0);
+  edgeBuffer.release();
+
+  program->disableAttributeArray(vertexAttr);
+  program->release();
+}
@@ -41,6 +41,8 @@
 #include <QOpenGLShader>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
+#include <map>
 #include "GuiGLBuffer.hpp"
 
 class GuiGLShader {
@@ -51,10 +53,36 @@ private:
   static const char *s_vsMaterialNormal;
   static const char *s_vsColor;
   static const char *s_vsColorNormal;
+  static const char *s_vsMaterialFlat;
+  static const char *s_vsColorFlat;
   static const char *s_fsColor;
+  static const char *s_fsFlat;
+
+  static map<const char*,QOpenGLShaderProgram*> s_program;
+  static bool                                   s_flatNormals;
 
 public:
 
+  // the shader programs are compiled and linked once per vertex
+  // shader variant, the first time they are requested, and shared by
+  // all the shaders which use them; they belong to the OpenGL context
+  // current at that time, and deletePrograms() must be called with the
+  // same context current
+
+  static QOpenGLShaderProgram* getProgram(GuiGLBuffer::Type type,
+                                          bool flat=false);
+  static QOpenGLShaderProgram* getProgram(const char* vsSource,
+                                          bool flat=false);
+  static void                  deletePrograms();
+
+  // the faces without normals are lit with flat normals computed in
+  // the fragment shader from the screen-space derivatives of the
+  // position, which a flat vertex shader passes in the varying
+  // "position"; requires OpenGL ES GL_OES_standard_derivatives, and is
+  // enabled by default
+  static void                  setFlatNormals(bool value);
+  static bool                  getFlatNormals();
+
   // constructor for IndexedFaceSet : lightSource!=(QVector3D*)0
   // constructor for IndexedLineSet : lightSource==(QVector3D*)0
 
@@ -73,11 +101,24 @@ public:
 
   void           paint(QOpenGLFunctions& f);
 
+  // draws one instance per matrix with glDrawArraysInstanced(); the
+  // MVP matrix is applied after the instance matrix
+  void           paint(QOpenGLExtraFunctions& f,
+                       const vector<QMatrix4x4>& instance);
+
+  // draws the edges of the vertex buffer, see GuiGLBuffer::setEdges(),
+  // with a single color and no lighting
+  void           paintEdges(QOpenGLFunctions& f, const QColor& edgeColor);
+
+private:
+
+  void           _enable();
+  GLenum         _mode() const;
+  void           _disable();
+
 private:
 
-  QOpenGLShader        *_vshader;
-  QOpenGLShader        *_fshader;
-  QOpenGLShaderProgram *_program;
+  QOpenGLShaderProgram *_program; // shared; not owned by the shader
 
   int                   _pointSizeAttr;
   int                   _lineWidthAttr;
@@ -87,8 +128,10 @@ private:
   int                   _mvpMatrixAttr ;
   int                   _materialAttr;
   int                   _lightSourceAttr;
+  int                   _instanceAttr;
 
   GuiGLBuffer          *_vertexBuffer;
+  QOpenGLBuffer         _instanceBuffer;
   QColor                _materialColor;
   QVector3D*            _lightSource;
   QMatrix4x4            _mvpMatrix; // viewport * projection * modelView
@@ -40,13 +40,15 @@
 #include <QPaintEngine>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
 #include <QCoreApplication>
 
 #include "GuiMainWindow.hpp"
 #include "GuiQtLogo.hpp"
 #include "GuiGLBuffer.hpp"
 
-#include "wrl/SceneGraphTraversal.hpp"
+#include "wrl/SceneGraphIndex.hpp"
 
 #ifdef near
 # undef near
@@ -91,11 +93,19 @@ GuiGLWidget::GuiGLWidget(QWidget* parent):
   // _buttons(0x0),
   _prevMouseX(0),
   _prevMouseY(0),
+  _pressMouseX(-1),
+  _pressMouseY(-1),
   _zone4enabled(true),
   _translateStep(0.010f),
   _cameraTranslation(0,0,0),
   _animationOn(true),
   _fAngle(0),
+  _bvhValid(false),
+  _instancing(false),
+  _batching(false),
+  _wireframe(false),
+  _edgesValid(false),
+  _edgeColor(255,128,0),
   _background(qRgb(200,200,200)),
   _material(qRgb(225,150,75)),
   _lightSource(0.0, 0.3, -1.0) {
@@ -120,6 +130,9 @@ GuiGLWidget::~GuiGLWidget() {
     delete shader;
   }
   _shaderMap.clear();
+  _clearBuffers();
+  _batch.clear();
+  GuiGLShader::deletePrograms();
   delete _handles;
   doneCurrent();
 }
@@ -151,87 +164,93 @@ void GuiGLWidget::setSceneGraph(SceneGraph* pWrl, bool resetHomeView) {
     delete shader;
   }
   _shaderMap.clear();
+  _clearBuffers();
 
   // cout << "  _shaderMap.size() = "<< _shaderMap.size() <<"\n";
 
   _data.setSceneGraph(pWrl);
+  _bvh.clear();
+  _bvhValid = false;
+  _batch.invalidate();
+  _edgesValid = false;
   if(pWrl!=(SceneGraph*)0) {
 
     // cout << "  creating new shaders ... \n";
 
-    SceneGraphTraversal sgt(*pWrl);
-    sgt.start();
+    const vector<Shape*>& shapes = pWrl->getIndex().getShapes();
     Node* node=(Node*)0;
-    while((node=sgt.next())!=(Node*)0) {
-      if(Shape* shape = dynamic_cast<Shape*>(node)) {
+    for(Shape* shape : shapes) {
 
-        // cout << "    found Shape \"" << shape->getName() << "\"\n";
-        
-        QColor materialColor(255,150,90);
+      // cout << "    found Shape \"" << shape->getName() << "\"\n";
+      
+      QColor materialColor(255,150,90);
 
-        // cout << "      default materialColor = ("
-        //      << materialColor.red()   << ","
-        //      << materialColor.green() << ","
-        //      << materialColor.blue()  << ")\n";
+      // cout << "      default materialColor = ("
+      //      << materialColor.red()   << ","
+      //      << materialColor.green() << ","
+      //      << materialColor.blue()  << ")\n";
+
+      node = shape->getAppearance();
+      if(Appearance* appearance = dynamic_cast<Appearance*>(node)) {
+        
+        // cout << "      has Appearance\n";
 
-        node = shape->getAppearance();
-        if(Appearance* appearance = dynamic_cast<Appearance*>(node)) {
+        node = appearance->getMaterial();
+        if(Material* material = dynamic_cast<Material*>(node)) {
           
-          // cout << "      has Appearance\n";
-
-          node = appearance->getMaterial();
-          if(Material* material = dynamic_cast<Material*>(node)) {
-            
-            // cout << "        has Material\n";
-
-            Color& diffuseColor = material->getDiffuseColor();
-            materialColor.setRedF(diffuseColor.r);
-            materialColor.setGreenF(diffuseColor.g);
-            materialColor.setBlueF(diffuseColor.b);
-
-            // cout << "          diffuseColor = ("
-            //      << materialColor.red()   << ","
-            //      << materialColor.green() << ","
-            //      << materialColor.blue()  << ")\n";
-          }
-        }
-
-        node = shape->getGeometry();
-        if(IndexedFaceSet* pIfs = dynamic_cast<IndexedFaceSet*>(node)) {
-
-          // cout << "      has geometry IndexedFaceSet\n";
-          // cout << "      creating shader ... \n";
-          // cout << "      lightSource = ( "
-          //      << _lightSource.x() << " , "
-          //      << _lightSource.y() << " , "
-          //      << _lightSource.z() <<" )\n";
-          // cout << "      materialColor = ( "
-          //      << materialColor.red() << " , "
-          //      << materialColor.green() << " , "
-          //      << materialColor.blue() <<" )\n";
-
-          GuiGLBuffer* ifsb   = new GuiGLBuffer(pIfs, materialColor);
-          GuiGLShader* shader = new GuiGLShader(materialColor,&_lightSource);
-          shader->setVertexBuffer(ifsb);
-          _shaderMap[shape] = shader;
-
-        } else if(IndexedLineSet* pIls = dynamic_cast<IndexedLineSet*>(node)) {
-
-          // cout << "      has geometry IndexedLineSet\n";
-          // cout << "      creating shader ... \n";
-          // cout << "      materialColor = ( "
-          //      << materialColor.red() << " , "
-          //      << materialColor.green() << " , "
-          //      << materialColor.blue() <<" )\n";
-
-          GuiGLBuffer* ifsb   = new GuiGLBuffer(pIls, materialColor);
-          GuiGLShader* shader = new GuiGLShader(materialColor);
-          shader->setVertexBuffer(ifsb);
-          _shaderMap[shape] = shader;
+          // cout << "        has Material\n";
 
+          Color& diffuseColor = material->getDiffuseColor();
+          materialColor.setRedF(diffuseColor.r);
+          materialColor.setGreenF(diffuseColor.g);
+          materialColor.setBlueF(diffuseColor.b);
+
+          // cout << "          diffuseColor = ("
+          //      << materialColor.red()   << ","
+          //      << materialColor.green() << ","
+          //      << materialColor.blue()  << ")\n";
         }
+      }
+
+      node = shape->getGeometry();
+      if(IndexedFaceSet* pIfs = dynamic_cast<IndexedFaceSet*>(node)) {
+
+        // cout << "      has geometry IndexedFaceSet\n";
+        // cout << "      creating shader ... \n";
+        // cout << "      lightSource = ( "
+        //      << _lightSource.x() << " , "
+        //      << _lightSource.y() << " , "
+        //      << _lightSource.z() <<" )\n";
+        // cout << "      materialColor = ( "
+        //      << materialColor.red() << " , "
+        //      << materialColor.green() << " , "
+        //      << materialColor.blue() <<" )\n";
+
+        GuiGLBuffer*& ifsb  = _bufferMap[pIfs];
+        if(ifsb==(GuiGLBuffer*)0)
+          ifsb = new GuiGLBuffer(pIfs, materialColor);
+        GuiGLShader* shader = new GuiGLShader(materialColor,&_lightSource);
+        shader->setVertexBuffer(ifsb);
+        _shaderMap[shape] = shader;
+
+      } else if(IndexedLineSet* pIls = dynamic_cast<IndexedLineSet*>(node)) {
+
+        // cout << "      has geometry IndexedLineSet\n";
+        // cout << "      creating shader ... \n";
+        // cout << "      materialColor = ( "
+        //      << materialColor.red() << " , "
+        //      << materialColor.green() << " , "
+        //      << materialColor.blue() <<" )\n";
+
+        GuiGLBuffer*& ifsb  = _bufferMap[pIls];
+        if(ifsb==(GuiGLBuffer*)0)
+          ifsb = new GuiGLBuffer(pIls, materialColor);
+        GuiGLShader* shader = new GuiGLShader(materialColor);
+        shader->setVertexBuffer(ifsb);
+        _shaderMap[shape] = shader;
 
       }
+
     }
 
     // cout << "  _shaderMap.size() = "<< _shaderMap.size() <<"\n";
@@ -273,19 +292,19 @@ void GuiGLWidget::setSceneGraph(SceneGraph* pWrl, bool resetHomeView) {
 void GuiGLWidget::setQtLogo() {
   SceneGraph* wrl = new GuiQtLogo();
   _data.setSceneGraph(wrl);
+  _bvhValid = false;
   _mainWindow->updateState();
 }
 
 //////////////////////////////////////////////////////////////////////
 void GuiGLWidget::invertNormal() {
 
-  map<Shape*,GuiGLShader*>::iterator i;
-  for(i=_shaderMap.begin();i!=_shaderMap.end();i++) {
-    Shape*         shape    = i->first;
-    GuiGLShader*   shader   = i->second;
-    GuiGLBuffer*   vbo      = shader->getVertexBuffer();
+  // each geometry is inverted once, even if shared by several shapes
+  map<Node*,GuiGLBuffer*>::iterator i;
+  for(i=_bufferMap.begin();i!=_bufferMap.end();i++) {
+    GuiGLBuffer*   vbo      = i->second;
 
-    Node* geometry = shape->getGeometry();
+    Node* geometry = i->first;
     if(IndexedFaceSet* ifs=dynamic_cast<IndexedFaceSet*>(geometry)) {
 
       vector<float> &normal = ifs->getNormal();    
@@ -295,25 +314,35 @@ void GuiGLWidget::invertNormal() {
         normal[i+0] = -n0; normal[i+1] = -n1; normal[i+2] = -n2;
       }
 
+      // the buffer does not depend on the material color
       QColor materialColor(255,150,90);
-      if(Appearance* appearance =
-         dynamic_cast<Appearance*>(shape->getAppearance())) {
-        if(Material* material =
-           dynamic_cast<Material*>(appearance->getMaterial())) {
-          Color& diffuseColor = material->getDiffuseColor();
-          materialColor.setRedF(diffuseColor.r);
-          materialColor.setGreenF(diffuseColor.g);
-          materialColor.setBlueF(diffuseColor.b);
-        }
-      }
-
       GuiGLBuffer* ifsb = new GuiGLBuffer(ifs, materialColor);
-      shader->setVertexBuffer(ifsb);
-      if(vbo) { vbo->destroy(); delete vbo; }
+      map<Shape*,GuiGLShader*>::iterator j;
+      for(j=_shaderMap.begin();j!=_shaderMap.end();j++)
+        if(j->second->getVertexBuffer()==vbo)
+          j->second->setVertexBuffer(ifsb);
+      i->second = ifsb;
+      if(vbo) { vbo->clearEdges(); vbo->destroy(); delete vbo; }
     }
   }
+  _batch.invalidate();
+  _edgesValid = false;
 }
 
+//////////////////////////////////////////////////////////////////////
+void GuiGLWidget::_clearBuffers() {
+  map<Node*,GuiGLBuffer*>::iterator i;
+  for(i=_bufferMap.begin();i!=_bufferMap.end();i++) {
+    GuiGLBuffer* vbo = i->second;
+    i->second = (GuiGLBuffer*)0;
+    vbo->clearEdges();
+    vbo->destroy();
+    delete vbo;
+  }
+  _bufferMap.clear();
+  _instanceMap.clear();
+}
+
 //////////////////////////////////////////////////////////////////////
 void GuiGLWidget::initializeGL() {
 
@@ -333,6 +362,31 @@ void GuiGLWidget::initializeGL() {
   c.u = glGetString(GL_VERSION);
   std::string version(c.s);
   
+  // instanced rendering needs OpenGL 3.3 or OpenGL ES 3.0
+  QOpenGLContext* ctx = context();
+  QSurfaceFormat format = ctx->format();
+  _instancing =
+    (ctx->isOpenGLES())?
+    (format.majorVersion()>=3):
+    (format.version()>=qMakePair(3,3));
+
+  // glMultiDrawArrays() is not in QOpenGLFunctions; it is part of
+  // OpenGL 1.4, and of the GL_EXT_multi_draw_arrays extension of
+  // OpenGL ES; otherwise the batches are painted with glDrawArrays()
+  QFunctionPointer multiDrawArrays = (QFunctionPointer)0;
+  if(ctx->isOpenGLES()==false)
+    multiDrawArrays = ctx->getProcAddress("glMultiDrawArrays");
+  else if(ctx->hasExtension("GL_EXT_multi_draw_arrays"))
+    multiDrawArrays = ctx->getProcAddress("glMultiDrawArraysEXT");
+  _batch.setMultiDrawArrays
+    (reinterpret_cast<GuiGLBatch::MultiDrawArrays>(multiDrawArrays));
+
+  // the flat normals are computed with dFdx() and dFdy(), which the
+  // GLSL ES 1.00 shaders only have with an extension
+  GuiGLShader::setFlatNormals
+    (ctx->isOpenGLES()==false ||
+     ctx->hasExtension("GL_OES_standard_derivatives"));
+
   // cout << "  [OpenGL] vendor  : " << vendor   << "\n";
   // cout << "  [OpenGL] renderer: " << renderer << "\n";
   // cout << "  [OpenGL] version : " << version  << "\n";
@@ -356,67 +410,74 @@ void GuiGLWidget::initializeGL() {
 }
 
 //////////////////////////////////////////////////////////////////////
-void GuiGLWidget::paintShape(QMatrix4x4& mvp, Shape* shape) {
-  if(shape==(Shape*)0 || shape->getShow()==false) return;
-  if(dynamic_cast<IndexedFaceSet*>(shape->getGeometry()) ||
-     dynamic_cast<IndexedLineSet*>(shape->getGeometry())) {
-    if(GuiGLShader* shader = _shaderMap[shape]) {
-      shader->setMVPMatrix(mvp);
-      shader->paint(*this);
-    }
+void GuiGLWidget::paintSceneGraph(SceneGraph* wrl) {
+  if(wrl==(SceneGraph*)0 || wrl->getShow()==false) return;
+  // the world matrices are cached by the index, and only recomputed
+  // after the Transform nodes change
+  const vector<SceneGraphIndex::Instance>& instance =
+    wrl->getIndex().getInstances();
+  for(const SceneGraphIndex::Instance& i : instance) {
+    if(i._show==false || i._geometry==(Node*)0) continue;
+    if(i._geometry->isIndexedFaceSet() || i._geometry->isIndexedLineSet())
+      // the matrix is stored in row-major order
+      _instanceMap[i._shape].push_back(QMatrix4x4(i._matrix));
   }
 }
 
 //////////////////////////////////////////////////////////////////////
-void GuiGLWidget::paintGroup(QMatrix4x4& mvp, Group* group) {
-  if(group==(Group*)0 || group->getShow()==false) return;
-  unsigned nChildren = group->getNumberOfChildren();
-  for(unsigned i=0;i<nChildren;i++) {
-    Node* node = (*group)[i];
-    if(Shape* s = dynamic_cast<Shape*>(node)) {
-      paintShape(mvp, s);
-    } else if(Transform* t = dynamic_cast<Transform*>(node)) {
-      paintTransform(mvp, t);
-    } else if(Group* g = dynamic_cast<Group*>(node)) {
-      paintGroup(mvp, g);
+void GuiGLWidget::paintInstances(QMatrix4x4& mvp) {
+  QOpenGLExtraFunctions* f =
+    (_instancing)?context()->extraFunctions():(QOpenGLExtraFunctions*)0;
+  map<Shape*,vector<QMatrix4x4>>::iterator i;
+  for(i=_instanceMap.begin();i!=_instanceMap.end();i++) {
+    vector<QMatrix4x4>& instance = i->second;
+    GuiGLShader* shader = _shaderMap[i->first];
+    if(shader==(GuiGLShader*)0 || instance.size()==0) continue;
+    if(instance.size()>1 && f!=(QOpenGLExtraFunctions*)0) {
+      // one draw call for all the instances
+      shader->setMVPMatrix(mvp);
+      shader->paint(*f, instance);
+    } else {
+      for(QMatrix4x4& model : instance) {
+        shader->setMVPMatrix(mvp*model);
+        shader->paint(*this);
+      }
+    }
+    if(_wireframe) {
+      for(QMatrix4x4& model : instance) {
+        shader->setMVPMatrix(mvp*model);
+        shader->paintEdges(*this, _edgeColor);
+      }
     }
+    // keep the capacity for the next frame
+    instance.clear();
   }
 }
 
-//////////////////////////////////////////////////////////////////////
-void GuiGLWidget::paintTransform(QMatrix4x4& mvp, Transform* transform) {
-  if(transform==(Transform*)0 || transform->getShow()==false) return;
-
-  float T[16] = {
-    1.0f, 0.0f, 0.0f, 0.0f,
-    0.0f, 1.0f, 0.0f, 0.0f,
-    0.0f, 0.0f, 1.0f, 0.0f,
-    0.0f, 0.0f, 0.0f, 1.0f
-  };
-
-  transform->getMatrix(T);
-
-  // mvpt = mvp * T
-  QMatrix4x4 mvpt =
-    mvp *
-    QMatrix4x4(T[ 0],T[ 1],T[ 2],T[ 3],
-               T[ 4],T[ 5],T[ 6],T[ 7],
-               T[ 8],T[ 9],T[10],T[11],
-               T[12],T[13],T[14],T[15]);
-
-  paintGroup(mvpt, transform);
-}
-
-//////////////////////////////////////////////////////////////////////
-void GuiGLWidget::paintSceneGraph(QMatrix4x4& mvp, SceneGraph* wrl) {
-  if(wrl==(SceneGraph*)0 || wrl->getShow()==false) return;
-  paintGroup(mvp,wrl);
-}
-
 //////////////////////////////////////////////////////////////////////
 void GuiGLWidget::paintData(QMatrix4x4& mvp) {
   SceneGraph* wrl = _data.getSceneGraph();
-  if(wrl!=(SceneGraph*)0) paintSceneGraph(mvp,wrl);
+  if(wrl==(SceneGraph*)0) return;
+  if(_batching) {
+    _batch.paint(*this, wrl, mvp, _lightSource);
+  } else if(_wireframe) {
+    if(_edgesValid==false) {
+      map<Node*,GuiGLBuffer*>::iterator i;
+      for(i=_bufferMap.begin();i!=_bufferMap.end();i++)
+        if(IndexedFaceSet* ifs=dynamic_cast<IndexedFaceSet*>(i->first))
+          i->second->setEdges(ifs);
+      _edgesValid = true;
+    }
+    // push the faces back, so that their edges are not hidden
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0f,1.0f);
+    paintSceneGraph(wrl);
+    paintInstances(mvp);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+  } else {
+    paintSceneGraph(wrl);
+    paintInstances(mvp);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -440,32 +501,7 @@ void GuiGLWidget::paintGL() {
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
 
-  // QMatrix4x4& mvp = _shader->getMVPMatrix();
-  QMatrix4x4 mvp;
-  mvp.setToIdentity();
-
-  QMatrix4x4 cameraTranslationMatrix;
-  cameraTranslationMatrix.setToIdentity();
-  cameraTranslationMatrix.translate(_cameraTranslation);
-
-  // void QMatrix4x4::lookAt
-  //   (const QVector3D & eye, const QVector3D & center, const QVector3D & up);
-  //
-  // Multiplies this matrix by a viewing matrix derived from an eye
-  // point. The center value indicates the center of the view that the
-  // eye is looking at. The up value indicates which direction should
-  // be considered up with respect to the eye.
-
-  QMatrix4x4 viewMatrix;
-  viewMatrix = cameraTranslationMatrix;
-  viewMatrix.lookAt(_eye,_center,_up);
-
-  mvp = _projectionMatrix * viewMatrix;
-
-  mvp.translate(_center.x(),_center.y(),_center.z());
-  mvp.rotate(    _fAngle, 0.0f, 1.0f, 0.0f);
-  mvp *= _viewRotation;
-  mvp.translate(-_center.x(),-_center.y(),-_center.z());
+  QMatrix4x4 mvp = _getMVPMatrix();
 
   paintData(mvp);
 
@@ -547,6 +583,38 @@ void GuiGLWidget::setMaterialColor(const QColor& materialColor) {
   _material = materialColor;
 }
 
+//////////////////////////////////////////////////////////////////////
+bool GuiGLWidget::getBatching() const {
+  return _batching;
+}
+
+//////////////////////////////////////////////////////////////////////
+bool GuiGLWidget::getWireframe() const {
+  return _wireframe;
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLWidget::setWireframe(bool value) {
+  _wireframe = value;
+  update();
+}
+
+//////////////////////////////////////////////////////////////////////
+void GuiGLWidget::setBatching(bool value) {
+  if(value==_batching) return;
+  _batching = value;
+  // release the buffers of the batches when they are not painted
+  if(_batching==false) {
+    makeCurrent();
+    _batch.clear();
+    doneCurrent();
+  }
+  // the wireframe overlay can only be shown without batching
+  if(_mainWindow!=(GuiMainWindow*)0)
+    _mainWindow->updateState();
+  update();
+}
+
 //////////////////////////////////////////////////////////////////////
 void GuiGLWidget::enterEvent(QEnterEvent* /*event*/) {
   _mouseInside = true;
@@ -564,8 +632,8 @@ void GuiGLWidget::mousePressEvent(QMouseEvent * event) {
   _mousePressed = true;
   _mainWindow->timerStop();
   _buttons = event->buttons();
-  int x       = event->x(); _prevMouseX = x;
-  int y       = event->y(); _prevMouseY = y;
+  int x       = event->x(); _prevMouseX = x; _pressMouseX = x;
+  int y       = event->y(); _prevMouseY = y; _pressMouseY = y;
   int codeX   = (x<_borderLeft)?0:(x>=width() -_borderRight)?2:1;
   int codeY   = (y<_borderUp  )?0:(y>=height()-_borderDown )?2:1;
   _mouseZone = codeX+3*codeY;
@@ -615,7 +683,22 @@ void GuiGLWidget::mousePressEvent(QMouseEvent * event) {
 }
 
 //////////////////////////////////////////////////////////////////////
-void GuiGLWidget::mouseReleaseEvent(QMouseEvent* /*event*/) {
+void GuiGLWidget::mouseReleaseEvent(QMouseEvent* event) {
+  // a left click on the center region without dragging picks the
+  // surface under the mouse
+  bool picked = false;
+  if(_mouseZone==4 && event->button()==Qt::LeftButton &&
+     event->x()==_pressMouseX && event->y()==_pressMouseY) {
+    SceneGraphBvh::Hit hit;
+    if(_pick(event->x(),event->y(),hit)) {
+      char str[256];
+      snprintf(str,256,"Shape \"%s\" | face %d | point (%g, %g, %g)",
+               hit._shape->getName().c_str(),hit._iF,
+               hit._point.x,hit._point.y,hit._point.z);
+      _mainWindow->showStatusBarMessage(QString(str));
+      picked = true;
+    }
+  }
   switch(_mouseZone) {
   case 0:
     _setHomeView(false);
@@ -636,7 +719,8 @@ void GuiGLWidget::mouseReleaseEvent(QMouseEvent* /*event*/) {
   default:
     break;
   }
-  _mainWindow->showStatusBarMessage("");
+  if(picked==false)
+    _mainWindow->showStatusBarMessage("");
   _mousePressed = false;
   _mainWindow->timerStart();
   // _buttons = 0x0;
@@ -817,6 +901,66 @@ void GuiGLWidget::_zoom(const float value) {
   }
 }
 
+//////////////////////////////////////////////////////////////////////
+QMatrix4x4 GuiGLWidget::_getMVPMatrix() {
+
+  QMatrix4x4 mvp;
+  mvp.setToIdentity();
+
+  QMatrix4x4 cameraTranslationMatrix;
+  cameraTranslationMatrix.setToIdentity();
+  cameraTranslationMatrix.translate(_cameraTranslation);
+
+  // void QMatrix4x4::lookAt
+  //   (const QVector3D & eye, const QVector3D & center, const QVector3D & up);
+  //
+  // Multiplies this matrix by a viewing matrix derived from an eye
+  // point. The center value indicates the center of the view that the
+  // eye is looking at. The up value indicates which direction should
+  // be considered up with respect to the eye.
+
+  QMatrix4x4 viewMatrix;
+  viewMatrix = cameraTranslationMatrix;
+  viewMatrix.lookAt(_eye,_center,_up);
+
+  mvp = _projectionMatrix * viewMatrix;
+
+  mvp.translate(_center.x(),_center.y(),_center.z());
+  mvp.rotate(    _fAngle, 0.0f, 1.0f, 0.0f);
+  mvp *= _viewRotation;
+  mvp.translate(-_center.x(),-_center.y(),-_center.z());
+
+  return mvp;
+}
+
+//////////////////////////////////////////////////////////////////////
+bool GuiGLWidget::_pick(const int x, const int y, SceneGraphBvh::Hit& hit) {
+  SceneGraph* wrl = _data.getSceneGraph();
+  if(wrl==(SceneGraph*)0) return false;
+
+  if(_bvhValid==false) {
+    _bvh.build(*wrl);
+    _bvhValid = true;
+  }
+  if(_bvh.isEmpty()) return false;
+
+  // unproject the mouse position onto the near and far planes; the
+  // BVH triangles are in the same world coordinates that the mvp
+  // matrix is applied to in paintSceneGraph()
+  bool invertible = false;
+  QMatrix4x4 mvpInv = _getMVPMatrix().inverted(&invertible);
+  if(invertible==false) return false;
+
+  float ndcX =  2.0f*((float)x+0.5f)/(float)width() -1.0f;
+  float ndcY = -2.0f*((float)y+0.5f)/(float)height()+1.0f;
+  QVector3D pNear = mvpInv.map(QVector3D(ndcX,ndcY,-1.0f));
+  QVector3D pFar  = mvpInv.map(QVector3D(ndcX,ndcY, 1.0f));
+
+  Vec3f origin(pNear.x(),pNear.y(),pNear.z());
+  Vec3f direction(pFar.x()-pNear.x(),pFar.y()-pNear.y(),pFar.z()-pNear.z());
+  return _bvh.rayCast(origin,direction,hit,1.0f);
+}
+
 //////////////////////////////////////////////////////////////////////
 void GuiGLWidget::_setHomeView(const bool identity) {
 
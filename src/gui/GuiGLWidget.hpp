@@ -53,9 +53,11 @@
 #include "wrl/IndexedFaceSet.hpp"
 #include "wrl/Appearance.hpp"
 #include "wrl/Material.hpp"
+#include "wrl/SceneGraphBvh.hpp"
 
 #include "GuiViewerData.hpp"
 #include "GuiGLShader.hpp"
+#include "GuiGLBatch.hpp"
 #include "GuiGLHandles.hpp"
 
 class GuiMainWindow;
@@ -84,6 +86,9 @@ public:
 
   GuiViewerData& getData() const;
 
+  bool getBatching() const;
+  bool getWireframe() const;
+
 public slots:
 
   void setQtLogo();
@@ -92,6 +97,16 @@ public slots:
   void setBackgroundColor(const QColor& backgroundColor);
   void setMaterialColor(const QColor& materialColor);
 
+  // paint all the shapes with a few glMultiDrawArrays() calls, see
+  // GuiGLBatch, instead of one draw call per shape
+  void setBatching(bool value);
+
+  // overlay the edges of the faces, drawn from the vertex buffers of
+  // the faces with one index buffer each, see GuiGLBuffer::setEdges();
+  // not painted in batching mode, where GuiToolsWidget disables the
+  // button which shows it
+  void setWireframe(bool value);
+
 protected:
 
   void initializeGL()         Q_DECL_OVERRIDE;
@@ -99,11 +114,13 @@ protected:
 
   // virtual void resizeEvent(QResizeEvent * event) Q_DECL_OVERRIDE;
 
+  // paintSceneGraph() collects the model matrices of the shape
+  // instances from the SceneGraphIndex, which are then painted by
+  // paintInstances()
+
   void paintData(QMatrix4x4& mvp);
-  void paintGroup(QMatrix4x4& mvp, Group* group);
-  void paintTransform(QMatrix4x4& mvp, Transform* transform);
-  void paintSceneGraph(QMatrix4x4& mvp, SceneGraph* wrl);
-  void paintShape(QMatrix4x4& mvp, Shape* shape);
+  void paintSceneGraph(SceneGraph* wrl);
+  void paintInstances(QMatrix4x4& mvp);
 
   virtual void	enterEvent(QEnterEvent * event)                 Q_DECL_OVERRIDE;
   virtual void	leaveEvent(QEvent * event)                 Q_DECL_OVERRIDE;
@@ -114,9 +131,12 @@ protected:
 
 private:
 
+  void _clearBuffers();
   void _setHomeView(const bool identity);
   void _setProjectionMatrix();
   void _zoom(const float value);
+  QMatrix4x4 _getMVPMatrix();
+  bool _pick(const int x, const int y, SceneGraphBvh::Hit& hit);
 
 private:
 
@@ -135,6 +155,8 @@ private:
   Qt::MouseButtons      _buttons;
   int                   _prevMouseX;
   int                   _prevMouseY;
+  int                   _pressMouseX;
+  int                   _pressMouseY;
   bool                  _zone4enabled;
   float                 _translateStep;
 
@@ -147,8 +169,31 @@ private:
 
   map<Shape*,GuiGLShader*> _shaderMap;
 
+  // one vertex buffer per geometry node, shared by the shaders of the
+  // shapes which USE the same geometry
+  map<Node*,GuiGLBuffer*>  _bufferMap;
+
+  // the model matrices of the instances of each shape; a shape USEd
+  // under several transforms is drawn with instanced rendering
+  map<Shape*,vector<QMatrix4x4>> _instanceMap;
+
   GuiGLHandles*         _handles;
 
+  // built on demand by _pick(); invalidated by setSceneGraph()
+  SceneGraphBvh         _bvh;
+  bool                  _bvhValid;
+
+  // OpenGL 3.3 or OpenGL ES 3.0; set by initializeGL()
+  bool                  _instancing;
+
+  GuiGLBatch            _batch;
+  bool                  _batching;
+
+  // the edge buffers are built on demand by paintData()
+  bool                  _wireframe;
+  bool                  _edgesValid;
+  QColor                _edgeColor;
+
   QColor                _background;
   QColor                _material;
   QVector3D             _lightSource;
@@ -44,12 +44,19 @@
 #include <QGroupBox>
 #include <QStatusBar>
 #include <QFileDialog>
+#include <QStandardPaths>
+#include <QDir>
 #include <QRect>
 #include <QMargins>
 
 #include "io/LoaderWrl.hpp"
 #include "io/SaverWrl.hpp"
 
+#include "io/LoaderWrb.hpp"
+#include "io/SaverWrb.hpp"
+#include "io/LoaderEbm.hpp"
+#include "io/SaverEbm.hpp"
+
 #include "io/LoaderStl.hpp"
 #include "io/SaverStl.hpp"
 
@@ -72,6 +79,22 @@ GuiMainWindow::GuiMainWindow(QWidget* parent):
   SaverWrl* wrlSaver = new SaverWrl();
   _saver.registerSaver(wrlSaver);
 
+  _wrbLoader = new LoaderWrb();
+  _loader.registerLoader(_wrbLoader);
+  _wrbSaver = new SaverWrb();
+  _saver.registerSaver(_wrbSaver);
+  // the binary cache of the parsed VRML files is kept in the user's
+  // cache directory, rather than next to the files
+  QString cacheDir =
+    QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if(cacheDir.isEmpty()==false && QDir().mkpath(cacheDir))
+    LoaderWrb::setCacheDirectory(cacheDir.toStdString());
+
+  LoaderEbm* ebmLoader = new LoaderEbm();
+  _loader.registerLoader(ebmLoader);
+  SaverEbm* ebmSaver = new SaverEbm();
+  _saver.registerSaver(ebmSaver);
+
   LoaderStl* stlLoader = new LoaderStl();
   _loader.registerLoader(stlLoader);
   SaverStl* stlSaver = new SaverStl();
@@ -125,8 +148,19 @@ SceneGraph* GuiMainWindow::loadSceneGraph(const char* fname) {
   snprintf(str,1024,"Trying to load \"%s\" ...",fname);
   showStatusBarMessage(QString(str));
   SceneGraph* pWrl = new SceneGraph();
-  if(_loader.load(fname,*pWrl)) { // if success
-    snprintf(str,1024,"Loaded \"%s\"",fname);
+  // VRML files are parsed once, and reloaded from the binary cache
+  // while the file does not change
+  string f(fname);
+  bool cacheable =
+    (f.size()>4 && f.substr(f.size()-4)==".wrl" &&
+     LoaderWrb::getCacheDirectory()!="");
+  bool cached    = false;
+  if(cacheable && LoaderWrb::isCacheValid(fname))
+    cached = _wrbLoader->loadCache(fname,*pWrl);
+  if(cached || _loader.load(fname,*pWrl)) { // if success
+    // failing to write the cache is not an error
+    if(cacheable && cached==false) _wrbSaver->saveCache(fname,*pWrl);
+    snprintf(str,1024,"Loaded \"%s\"%s",fname,(cached)?" from cache":"");
     pWrl->updateBBox();
     glWidget->setSceneGraph(pWrl,true);
     toolsWidget->updateState();
@@ -150,7 +184,7 @@ void GuiMainWindow::on_fileLoadAction_triggered() {
   QFileDialog fileDialog(this);
   fileDialog.setFileMode(QFileDialog::ExistingFile); // allowed to select only one 
   fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
-  fileDialog.setNameFilter(tr("3D Files (*.wrl *.ply *.stl)"));
+  fileDialog.setNameFilter(tr("3D Files (*.wrl *.wrb *.ply *.stl *.ebm *.gz)"));
   QStringList fileNames;
   if(fileDialog.exec()) {
     fileNames = fileDialog.selectedFiles();
@@ -183,7 +217,7 @@ void GuiMainWindow::on_fileSaveAction_triggered() {
   // TODO Sat Sep 10 22:18:57 2016
   // get list of file extensions from registered Savers
 
-  fileDialog.setNameFilter(tr("3D Files (*.wrl *.ply *.stl)"));
+  fileDialog.setNameFilter(tr("3D Files (*.wrl *.wrb *.ply *.stl *.ebm)"));
   QStringList fileNames;
   if(fileDialog.exec()) {
     fileNames = fileDialog.selectedFiles();
@@ -271,3 +305,15 @@ void GuiMainWindow::updateState() {
 void GuiMainWindow::refresh() {
   glWidget->update();
 }
+
+bool GuiMainWindow::getBatching() const {
+  return glWidget->getBatching();
+}
+
+bool GuiMainWindow::getWireframe() const {
+  return glWidget->getWireframe();
+}
+
+void GuiMainWindow::setWireframe(bool value) {
+  glWidget->setWireframe(value);
+}
@@ -43,6 +43,8 @@
 // #include <QGridLayout>
 #include <io/AppLoader.hpp>
 #include <io/AppSaver.hpp>
+#include <io/LoaderWrb.hpp>
+#include <io/SaverWrb.hpp>
 // #include "GuiGLWidget.hpp"
 // #include "GuiToolsWidget.hpp"
 #include <string>
@@ -73,6 +75,10 @@ public:
   void updateState();
   void refresh();
 
+  bool getBatching() const;
+  bool getWireframe() const;
+  void setWireframe(bool value);
+
   static void setLogicalDotsPerInch(int lDPI) {         _lDPI = lDPI; }
   static void setPlatformName(QString& name)  { _platformName = name; }
 
@@ -93,6 +99,9 @@ private:
 
   AppLoader       _loader;
   AppSaver        _saver;
+  // read and write the binary cache of the parsed VRML files
+  LoaderWrb*      _wrbLoader;
+  SaverWrb*       _wrbSaver;
   QTimer         *_timer;
 
   static int      _timerInterval;
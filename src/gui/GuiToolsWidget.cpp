@@ -198,10 +198,13 @@ void GuiToolsWidget::updateState() {
       pushButtonSceneGraphEdgesShow->setEnabled(!show);
       pushButtonSceneGraphEdgesHide->setEnabled(show);
     } else {
+      // without an EDGES Shape, show and hide the wireframe overlay,
+      // which is not painted in batching mode
       pushButtonSceneGraphEdgesAdd->setEnabled(true);
       pushButtonSceneGraphEdgesRemove->setEnabled(false);
-      pushButtonSceneGraphEdgesShow->setEnabled(false);
-      pushButtonSceneGraphEdgesHide->setEnabled(false);
+      bool show = _mainWindow->getWireframe();
+      pushButtonSceneGraphEdgesShow->setEnabled(!show && !_mainWindow->getBatching());
+      pushButtonSceneGraphEdgesHide->setEnabled(show);
     }
 
     Node* surface    = wrl->find("SURFACE"); // should be a Shape node
@@ -391,7 +394,12 @@ void GuiToolsWidget::on_pushButtonSceneGraphEdgesShow_clicked() {
   SceneGraph*    pWrl = data.getSceneGraph();
   if(pWrl==(SceneGraph*)0) return;
   Node* node = pWrl->find("EDGES");
-  if(node==(Node*)0) return;
+  if(node==(Node*)0) {
+    // no geometry to rebuild
+    _mainWindow->setWireframe(true);
+    updateState();
+    return;
+  }
   node->setShow(true);
   _mainWindow->setSceneGraph(pWrl,false);
   _mainWindow->refresh();
@@ -403,7 +411,11 @@ void GuiToolsWidget::on_pushButtonSceneGraphEdgesHide_clicked() {
   SceneGraph*    pWrl = data.getSceneGraph();
   if(pWrl==(SceneGraph*)0) return;
   Node* node = pWrl->find("EDGES");
-  if(node==(Node*)0) return;
+  if(node==(Node*)0) {
+    _mainWindow->setWireframe(false);
+    updateState();
+    return;
+  }
   node->setShow(false);
   _mainWindow->setSceneGraph(pWrl,false);
   _mainWindow->refresh();
@@ -33,19 +33,21 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "AppLoader.hpp"
+#include "InputFile.hpp"
 
 bool AppLoader::load(const char* filename, SceneGraph& wrl) {
   bool success = false;
   if(filename!=(const char*)0) {
     // int n = (int)strlen(filename);
-    string f(filename);
+    // the extension of "name.ply.gz" is "ply"
+    string f = InputFile::uncompressedName(filename);
     int n = static_cast<int>(f.size());
     int i;
     for(i=n-1;i>=0;i--)
-      if(filename[i]=='.')
+      if(f[i]=='.')
         break;
     if(i>=0) {
-      string ext(filename+i+1);
+      string ext(f.substr(i+1));
       Loader* loader = _registry[ext];
       if(loader!=(Loader*)0)
         success = loader->load(filename,wrl);
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-07 10:12:44 taubin>
+//------------------------------------------------------------------------
+//
+// BinaryWriter.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "BinaryWriter.hpp"
+#include <util/Endian.hpp>
+
+BinaryWriter::BinaryWriter
+(FILE* fp, const bool swapBytes, const size_t bufferSize):
+  _fp(fp),
+  _swapBytes(swapBytes),
+  _buffer((bufferSize<64)?64:bufferSize),
+  _size(0),
+  _failed(fp==(FILE*)0) {
+}
+
+BinaryWriter::~BinaryWriter() {
+  flush();
+}
+
+void BinaryWriter::_flush() {
+  if(_size>0 && _failed==false)
+    _failed = (fwrite(&_buffer[0],1,_size,_fp)!=_size);
+  _size = 0;
+}
+
+bool BinaryWriter::flush() {
+  _flush();
+  if(_failed==false && _fp!=(FILE*)0)
+    _failed = (fflush(_fp)!=0);
+  return (_failed==false);
+}
+
+void BinaryWriter::putBytes(const void* bytes, const size_t nBytes) {
+  if(_size+nBytes>_buffer.size()) {
+    _flush();
+    if(nBytes>_buffer.size()) {
+      // too long to be buffered
+      if(_failed==false)
+        _failed = (fwrite(bytes,1,nBytes,_fp)!=nBytes);
+      return;
+    }
+  }
+  memcpy(&_buffer[_size],bytes,nBytes);
+  _size += nBytes;
+}
+
+void BinaryWriter::putArray
+(const void* values, const size_t nValues, const size_t valueSize) {
+  if(_swapBytes==false || valueSize<2) {
+    putBytes(values,nValues*valueSize);
+    return;
+  }
+  // copy and swap as many whole values as fit in the buffer
+  const char* src = static_cast<const char*>(values);
+  size_t nLeft = nValues;
+  while(nLeft>0) {
+    size_t n = (_buffer.size()-_size)/valueSize;
+    if(n==0) { _flush(); continue; }
+    if(n>nLeft) n = nLeft;
+    Endian::swap(&_buffer[_size],src,n,valueSize);
+    _size += n*valueSize;
+    src   += n*valueSize;
+    nLeft -= n;
+  }
+}
@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-07 10:12:44 taubin>
+//------------------------------------------------------------------------
+//
+// BinaryWriter.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BINARY_WRITER_HPP
+#define BINARY_WRITER_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// buffered binary output used by the binary savers
+//
+// - values are assembled into a large memory buffer, which is
+//   written to the file with a single fwrite() call when full, and
+//   when the BinaryWriter is flushed or destroyed
+// - if swapBytes is true, every multi-byte value is written with
+//   its bytes in reverse order; arrays are swapped while they are
+//   copied into the buffer, one block at a time
+// - the FILE* should not be written to directly until flush() is
+//   called
+// - errors are sticky, and reported by flush() and hasFailed()
+
+class BinaryWriter {
+
+public:
+
+  BinaryWriter
+  (FILE* fp, const bool swapBytes=false, const size_t bufferSize=(1<<20));
+  ~BinaryWriter();
+
+  void putChar(const char value) {
+    if(_size+1>_buffer.size()) _flush();
+    _buffer[_size++] = value;
+  }
+  void putUChar(const unsigned char value) {
+    putChar(static_cast<char>(value));
+  }
+  void putShort(const short value) {
+    _put(&value,2);
+  }
+  void putUShort(const unsigned short value) {
+    _put(&value,2);
+  }
+  void putInt(const int value) {
+    _put(&value,4);
+  }
+  void putUInt(const unsigned int value) {
+    _put(&value,4);
+  }
+  void putFloat(const float value) {
+    _put(&value,4);
+  }
+  void putDouble(const double value) {
+    _put(&value,8);
+  }
+
+  // nValues contiguous values of valueSize = 1, 2, 4, or 8 bytes each
+  void putArray(const void* values, const size_t nValues, const size_t valueSize);
+
+  // nBytes written as they are, never swapped
+  void putBytes(const void* bytes, const size_t nBytes);
+
+  bool flush();
+  bool hasFailed() const { return _failed; }
+
+private:
+
+  FILE*        _fp;
+  bool         _swapBytes;
+  vector<char> _buffer;
+  size_t       _size;
+  bool         _failed;
+
+  void _put(const void* value, const size_t valueSize) {
+    if(_size+valueSize>_buffer.size()) _flush();
+    char* p = &_buffer[_size];
+    if(_swapBytes) {
+      const char* q = static_cast<const char*>(value)+valueSize;
+      for(size_t i=0;i<valueSize;i++) p[i] = *(--q);
+    } else {
+      memcpy(p,value,valueSize);
+    }
+    _size += valueSize;
+  }
+
+  void _flush();
+
+};
+
+#endif // BINARY_WRITER_HPP
@@ -0,0 +1,533 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-10 09:42:17 taubin>
+//------------------------------------------------------------------------
+//
+// InputFile.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "InputFile.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool InputFile::hasZlib() {
+#ifdef HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+// returns the position of the '/' which follows the ".zip" suffix of
+// the archive name, or string::npos
+static size_t _zipSeparator(const string& name) {
+  for(size_t i=0;i+5<name.size();i++) {
+    if(name[i]!='.' || name[i+4]!='/') continue;
+    string ext = name.substr(i+1,3);
+    for(size_t j=0;j<ext.size();j++)
+      ext[j] = static_cast<char>(tolower(ext[j]));
+    if(ext=="zip") return i+4;
+  }
+  return string::npos;
+}
+
+static bool _hasGzSuffix(const string& name) {
+  size_t n = name.size();
+  return (n>3 && name[n-3]=='.' &&
+          tolower(name[n-2])=='g' && tolower(name[n-1])=='z');
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool InputFile::isCompressed(const char* filename) {
+  if(filename==nullptr) return false;
+  string name(filename);
+  return _hasGzSuffix(name) || _zipSeparator(name)!=string::npos;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+string InputFile::uncompressedName(const char* filename) {
+  if(filename==nullptr) return string("");
+  string name(filename);
+  if(_hasGzSuffix(name)) name.resize(name.size()-3);
+  return name;
+}
+
+#ifndef HAVE_ZLIB
+
+//////////////////////////////////////////////////////////////////////
+// static
+FILE* InputFile::open(const char* filename, const char* mode) {
+  if(filename==nullptr || isCompressed(filename)) return nullptr;
+  return fopen(filename,mode);
+}
+
+#else /* HAVE_ZLIB */
+
+static bool _seek(FILE* fp, const int64_t offset) {
+#ifdef _WIN32
+  return _fseeki64(fp,offset,SEEK_SET)==0;
+#else
+  return fseeko(fp,(off_t)offset,SEEK_SET)==0;
+#endif
+}
+
+static uint32_t _uint16(const unsigned char* p) {
+  return static_cast<uint32_t>(p[0])|(static_cast<uint32_t>(p[1])<<8);
+}
+
+static uint32_t _uint32(const unsigned char* p) {
+  return _uint16(p)|(_uint16(p+2)<<16);
+}
+
+// decompresses the data of the source file on a separate thread into
+// a short queue of large buffers, which are consumed by read()
+class InflateStream {
+
+public:
+
+  enum Format {
+    GZIP = 0, // gzip or zlib stream, possibly several concatenated
+    RAW,      // raw deflate stream of a zip archive member
+    STORED    // not compressed zip archive member
+  };
+
+  InflateStream(FILE* src, const Format format, const uint64_t size);
+  ~InflateStream();
+
+  // returns the number of bytes read, 0 at the end of the data, and
+  // -1 if the compressed data is corrupted
+  int64_t  read(char* buffer, const size_t n);
+  bool     skip(uint64_t n);
+  uint64_t position() const { return _position; }
+
+private:
+
+  static const size_t BUFFER_SIZE = (1<<22);
+  static const size_t INPUT_SIZE  = (1<<20);
+  static const size_t QUEUE_SIZE  = 2;
+
+  void     _run();
+  bool     _push(vector<char>& buffer);
+
+  FILE*                _src;
+  Format               _format;
+  uint64_t             _remaining; // compressed bytes not yet read
+  thread               _thread;
+  mutex                _mutex;
+  condition_variable   _cv;
+  deque< vector<char> > _queue;
+  bool                 _done;
+  bool                 _failed;
+  bool                 _stop;
+  vector<char>         _current;
+  size_t               _next;
+  uint64_t             _position;
+};
+
+InflateStream::InflateStream
+(FILE* src, const Format format, const uint64_t size):
+  _src(src),
+  _format(format),
+  _remaining(size),
+  _done(false),
+  _failed(false),
+  _stop(false),
+  _next(0),
+  _position(0) {
+  _thread = thread(&InflateStream::_run,this);
+}
+
+InflateStream::~InflateStream() {
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  _thread.join();
+  fclose(_src);
+}
+
+bool InflateStream::_push(vector<char>& buffer) {
+  unique_lock<mutex> lock(_mutex);
+  _cv.wait(lock,[this]{ return _stop || _queue.size()<QUEUE_SIZE; });
+  if(_stop) return false;
+  _queue.push_back(vector<char>());
+  _queue.back().swap(buffer);
+  _cv.notify_all();
+  return true;
+}
+
+void InflateStream::_run() {
+  z_stream zs;
+  memset(&zs,0,sizeof(zs));
+  bool ok = true;
+  if(_format!=STORED)
+    ok = (inflateInit2(&zs,(_format==RAW)?-MAX_WBITS:MAX_WBITS+32)==Z_OK);
+
+  vector<unsigned char> input(INPUT_SIZE);
+  vector<char>          output(BUFFER_SIZE);
+  size_t                nOutput   = 0;
+  bool                  end       = false;
+  bool                  memberEnd = false;
+  while(ok && end==false) {
+    if(zs.avail_in==0) {
+      size_t nInput = (_remaining<INPUT_SIZE)?(size_t)_remaining:INPUT_SIZE;
+      nInput = (nInput>0)?fread(&input[0],1,nInput,_src):0;
+      _remaining -= nInput;
+      if(nInput==0) {
+        // a gzip file may only end after a complete member
+        end = (_format==STORED || memberEnd);
+        ok  = end;
+        break;
+      }
+      zs.next_in  = &input[0];
+      zs.avail_in = static_cast<uInt>(nInput);
+    }
+    if(_format==STORED) {
+      size_t n = BUFFER_SIZE-nOutput;
+      if(n>zs.avail_in) n = zs.avail_in;
+      memcpy(&output[nOutput],zs.next_in,n);
+      zs.next_in  += n;
+      zs.avail_in -= static_cast<uInt>(n);
+      nOutput     += n;
+    } else {
+      zs.next_out  = reinterpret_cast<Bytef*>(&output[nOutput]);
+      zs.avail_out = static_cast<uInt>(BUFFER_SIZE-nOutput);
+      int status   = inflate(&zs,Z_NO_FLUSH);
+      nOutput      = BUFFER_SIZE-zs.avail_out;
+      memberEnd    = (status==Z_STREAM_END);
+      if(memberEnd) {
+        // a zip member ends with its deflate stream; a gzip file may
+        // continue with another member
+        if(_format==RAW) end = true;
+        else ok = (inflateReset(&zs)==Z_OK);
+      } else if(status!=Z_OK && status!=Z_BUF_ERROR) {
+        ok = false;
+      }
+    }
+    if(nOutput==BUFFER_SIZE) {
+      if(_push(output)==false) break;
+      output.resize(BUFFER_SIZE);
+      nOutput = 0;
+    }
+  }
+  // the data decoded before an error is passed to the reader as well
+  if(nOutput>0) {
+    output.resize(nOutput);
+    _push(output);
+  }
+  if(_format!=STORED)
+    inflateEnd(&zs);
+
+  lock_guard<mutex> lock(_mutex);
+  _done   = true;
+  _failed = (ok==false);
+  _cv.notify_all();
+}
+
+int64_t InflateStream::read(char* buffer, const size_t n) {
+  size_t nRead = 0;
+  while(nRead<n) {
+    if(_next==_current.size()) {
+      unique_lock<mutex> lock(_mutex);
+      _cv.wait(lock,[this]{ return _queue.empty()==false || _done; });
+      if(_queue.empty()) {
+        if(_failed && nRead==0) return -1;
+        break;
+      }
+      _current.swap(_queue.front());
+      _queue.pop_front();
+      _next = 0;
+      _cv.notify_all();
+    }
+    size_t m = _current.size()-_next;
+    if(m>n-nRead) m = n-nRead;
+    memcpy(buffer+nRead,&_current[_next],m);
+    _next += m;
+    nRead += m;
+  }
+  _position += nRead;
+  return static_cast<int64_t>(nRead);
+}
+
+bool InflateStream::skip(uint64_t n) {
+  char buffer[1<<14];
+  while(n>0) {
+    size_t m = (n<sizeof(buffer))?(size_t)n:sizeof(buffer);
+    int64_t nRead = read(buffer,m);
+    if(nRead<=0) return false;
+    n -= static_cast<uint64_t>(nRead);
+  }
+  return true;
+}
+
+// opens the source file and finds the data of the zip archive member
+static InflateStream* _openZipMember(const string& archive, const string& member) {
+  FILE* fp = fopen(archive.c_str(),"rb");
+  if(fp==nullptr) return nullptr;
+  InflateStream* stream = nullptr;
+  unsigned char h[46];
+  vector<unsigned char> tail;
+  try {
+    // the end of central directory record is within the last 64KB
+    if(fseek(fp,0,SEEK_END)!=0) throw 0;
+    int64_t size = ftell(fp);
+    int64_t nTail = (size<65557)?size:65557;
+    if(nTail<22 || _seek(fp,size-nTail)==false) throw 0;
+    tail.resize(static_cast<size_t>(nTail));
+    if(fread(&tail[0],1,tail.size(),fp)!=tail.size()) throw 0;
+    int64_t i;
+    for(i=nTail-22;i>=0 && _uint32(&tail[i])!=0x06054b50;i--);
+    if(i<0) throw 0;
+    uint32_t nEntries = _uint16(&tail[i+10]);
+    int64_t  offset   = _uint32(&tail[i+16]);
+
+    // look for the member in the central directory
+    string name;
+    for(uint32_t iEntry=0;iEntry<nEntries;iEntry++) {
+      if(_seek(fp,offset)==false || fread(h,1,46,fp)!=46 ||
+         _uint32(h)!=0x02014b50) throw 0;
+      uint32_t method = _uint16(h+10);
+      uint64_t nData  = _uint32(h+20);
+      uint32_t nName  = _uint16(h+28);
+      name.resize(nName);
+      if(nName>0 && fread(&name[0],1,nName,fp)!=nName) throw 0;
+      offset += 46+nName+_uint16(h+30)+_uint16(h+32);
+      if(name!=member) continue;
+      if(method!=0 && method!=8) throw 0;
+
+      // the data follows the local header
+      int64_t local = _uint32(h+42);
+      if(_seek(fp,local)==false || fread(h,1,30,fp)!=30 ||
+         _uint32(h)!=0x04034b50) throw 0;
+      if(_seek(fp,local+30+_uint16(h+26)+_uint16(h+28))==false) throw 0;
+      stream = new InflateStream
+        (fp,(method==0)?InflateStream::STORED:InflateStream::RAW,nData);
+      break;
+    }
+  } catch(int) {
+  }
+  if(stream==nullptr) fclose(fp);
+  return stream;
+}
+
+#if defined(__GLIBC__)
+
+static ssize_t _cookieRead(void* cookie, char* buffer, size_t n) {
+  return static_cast<ssize_t>(static_cast<InflateStream*>(cookie)->read(buffer,n));
+}
+
+static int _cookieSeek(void* cookie, off64_t* offset, int whence) {
+  InflateStream* stream = static_cast<InflateStream*>(cookie);
+  int64_t target =
+    (whence==SEEK_SET)?*offset:
+    (whence==SEEK_CUR)?static_cast<int64_t>(stream->position())+*offset:-1;
+  if(target<static_cast<int64_t>(stream->position())) return -1;
+  if(stream->skip(target-stream->position())==false) return -1;
+  *offset = static_cast<off64_t>(stream->position());
+  return 0;
+}
+
+static int _cookieClose(void* cookie) {
+  delete static_cast<InflateStream*>(cookie);
+  return 0;
+}
+
+static FILE* _openStream(InflateStream* stream) {
+  cookie_io_functions_t functions;
+  functions.read  = _cookieRead;
+  functions.write = nullptr;
+  functions.seek  = _cookieSeek;
+  functions.close = _cookieClose;
+  FILE* fp = fopencookie(stream,"r",functions);
+  if(fp==nullptr) delete stream;
+  return fp;
+}
+
+#elif defined(__APPLE__)
+
+static int _cookieRead(void* cookie, char* buffer, int n) {
+  return static_cast<int>(static_cast<InflateStream*>(cookie)->read(buffer,n));
+}
+
+static fpos_t _cookieSeek(void* cookie, fpos_t offset, int whence) {
+  InflateStream* stream = static_cast<InflateStream*>(cookie);
+  int64_t target =
+    (whence==SEEK_SET)?offset:
+    (whence==SEEK_CUR)?static_cast<int64_t>(stream->position())+offset:-1;
+  if(target<static_cast<int64_t>(stream->position())) return -1;
+  if(stream->skip(target-stream->position())==false) return -1;
+  return static_cast<fpos_t>(stream->position());
+}
+
+static int _cookieClose(void* cookie) {
+  delete static_cast<InflateStream*>(cookie);
+  return 0;
+}
+
+static FILE* _openStream(InflateStream* stream) {
+  FILE* fp = funopen(stream,_cookieRead,nullptr,_cookieSeek,_cookieClose);
+  if(fp==nullptr) delete stream;
+  return fp;
+}
+
+#else
+
+// without stdio cookies, the data is inflated into a temporary file
+static FILE* _openStream(InflateStream* stream) {
+  FILE* fp = tmpfile();
+  vector<char> buffer(1<<20);
+  int64_t n;
+  while(fp!=nullptr && (n=stream->read(&buffer[0],buffer.size()))!=0) {
+    if(n<0 || fwrite(&buffer[0],1,(size_t)n,fp)!=(size_t)n) {
+      fclose(fp);
+      fp = nullptr;
+    }
+  }
+  delete stream;
+  if(fp!=nullptr) rewind(fp);
+  return fp;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// static
+FILE* InputFile::open(const char* filename, const char* mode) {
+  if(filename==nullptr) return nullptr;
+  string name(filename);
+  InflateStream* stream = nullptr;
+  size_t iZip = _zipSeparator(name);
+  if(iZip!=string::npos) {
+    stream = _openZipMember(name.substr(0,iZip),name.substr(iZip+1));
+  } else if(_hasGzSuffix(name)) {
+    FILE* fp = fopen(filename,"rb");
+    if(fp!=nullptr)
+      stream = new InflateStream(fp,InflateStream::GZIP,UINT64_MAX);
+  } else {
+    return fopen(filename,mode);
+  }
+  if(stream==nullptr) return nullptr;
+  FILE* fp = _openStream(stream);
+  // large stdio buffer, so that getc() rarely calls the cookie functions
+  if(fp!=nullptr) setvbuf(fp,nullptr,_IOFBF,1<<16);
+  return fp;
+}
+
+#endif /* HAVE_ZLIB */
+
+//////////////////////////////////////////////////////////////////////
+InputData::InputData(FILE* fp):
+  _data(nullptr),
+  _size(0),
+  _map(nullptr),
+  _mapSize(0) {
+  long offset = ftell(fp);
+#if defined(__unix__) || defined(__APPLE__)
+  struct stat st;
+  int fd = fileno(fp);
+  if(offset>=0 && fd>=0 && fstat(fd,&st)==0 && S_ISREG(st.st_mode) &&
+     st.st_size>static_cast<off_t>(offset)) {
+    void* map = mmap(nullptr,static_cast<size_t>(st.st_size),
+                     PROT_READ,MAP_PRIVATE,fd,0);
+    if(map!=MAP_FAILED) {
+      _map     = map;
+      _mapSize = static_cast<size_t>(st.st_size);
+      _data    = static_cast<const char*>(map)+offset;
+      _size    = _mapSize-static_cast<size_t>(offset);
+      return;
+    }
+  }
+#endif
+  (void)offset;
+  // compressed files and pipes are read until the end of file
+  size_t n = 0;
+  do {
+    _buffer.resize(n+(1<<22));
+    n += fread(&_buffer[n],1,_buffer.size()-n,fp);
+  } while(n==_buffer.size());
+  _buffer.resize(n);
+  _data = (n>0)?&_buffer[0]:nullptr;
+  _size = n;
+}
+
+InputData::~InputData() {
+#if defined(__unix__) || defined(__APPLE__)
+  if(_map!=nullptr)
+    munmap(_map,_mapSize);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+int InputParser::numberOfThreads(const int nThreads) {
+  int n = nThreads;
+  if(n<=0)
+    n = static_cast<int>(thread::hardware_concurrency());
+  return (n<1)?1:n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+void InputParser::runChunks
+(int nThreads, const int nChunks, const function<void(const int)>& work) {
+  if(nChunks<=0)
+    return;
+  nThreads = numberOfThreads(nThreads);
+  if(nThreads>nChunks)
+    nThreads = nChunks;
+  auto run = [&](const int iThread) {
+    for(int iChunk=iThread;iChunk<nChunks;iChunk+=nThreads)
+      work(iChunk);
+  };
+  vector<thread> worker;
+  for(int iThread=1;iThread<nThreads;iThread++)
+    worker.push_back(thread(run,iThread));
+  run(0);
+  for(thread& t : worker)
+    t.join();
+}
@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-10 09:42:17 taubin>
+//------------------------------------------------------------------------
+//
+// InputFile.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _INPUT_FILE_HPP_
+#define _INPUT_FILE_HPP_
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <functional>
+
+using namespace std;
+
+// opens the input files of the loaders, decompressing them on the fly
+//
+// - "name.gz" files are gzip streams, possibly with several members
+// - "archive.zip/member" names a member of a zip archive, which may
+//   be stored or deflated
+// - every other filename is opened with fopen()
+//
+// the compressed data is inflated into large buffers by a separate
+// thread, which runs ahead of the reader, and the FILE* returned reads
+// from those buffers, so that the loaders, and TokenizerFile, can use
+// the usual stdio functions; the FILE* only supports seeking forward,
+// and ftell(); it should be closed with fclose()
+//
+// compressed files are supported only if the code is compiled with
+// HAVE_ZLIB defined; on platforms without stdio cookies the data is
+// inflated into a temporary file before it is read
+
+class InputFile {
+
+public:
+
+  // returns nullptr if the file cannot be opened
+  static FILE*  open(const char* filename, const char* mode);
+
+  // true if the filename refers to a gzip file or to a member of a
+  // zip archive
+  static bool   isCompressed(const char* filename);
+
+  // filename without the ".gz" suffix, used to find the loader
+  static string uncompressedName(const char* filename);
+
+  // true if compiled with HAVE_ZLIB
+  static bool   hasZlib();
+
+};
+
+// the data of an input file, from the current position of fp to the
+// end of the file, for the loaders which parse text in parallel; the
+// data is memory mapped if fp is a regular file, and it is read into
+// memory otherwise, as for compressed files; fp may be closed once the
+// InputData has been constructed
+
+class InputData {
+
+public:
+
+  InputData(FILE* fp);
+  ~InputData();
+
+  const char* data() const { return _data; }
+  size_t      size() const { return _size; }
+
+private:
+
+  const char*  _data;
+  size_t       _size;
+  void*        _map;
+  size_t       _mapSize;
+  vector<char> _buffer;
+
+};
+
+// helpers of the loaders which parse the InputData in parallel
+
+class InputParser {
+
+public:
+
+  // number of threads for a setNumberOfThreads() value; nThreads<=0
+  // uses std::thread::hardware_concurrency(), and the result is >=1
+  static int  numberOfThreads(const int nThreads);
+
+  // calls work(iChunk) for iChunk=0,...,nChunks-1 using nThreads
+  // threads, resolved as in numberOfThreads()
+  static void runChunks
+  (int nThreads, const int nChunks, const function<void(const int)>& work);
+
+  // the same separators as Tokenizer::get()
+  static bool isSeparator(const char c) {
+    return (c==' ' || c=='\t' || c=='\n' || c==',' || c=='\015');
+  }
+
+  // finds the next token in [p,end), skipping comments as
+  // Tokenizer::get() does, and leaves p at the end of the token
+  static bool nextToken(const char*& p, const char* end, const char*& token) {
+    for(;;) {
+      while(p<end && isSeparator(*p)) p++;
+      if(p==end) return false;
+      if(*p!='#') break;
+      while(p<end && *p!='\n') p++;
+    }
+    token = p;
+    while(p<end && isSeparator(*p)==false) p++;
+    return true;
+  }
+
+  // parses the token [token,end) with from_chars() when available; the
+  // values are the same as sscanf() with "%d", "%lld", "%f" or "%lf",
+  // which is used as fallback, and value is not changed if the token
+  // does not start with a number
+  static bool parse(const char* token, const char* end, int& value) {
+    return _parse(token,end,value,"%d");
+  }
+  static bool parse(const char* token, const char* end, long long& value) {
+    return _parse(token,end,value,"%lld");
+  }
+  static bool parse(const char* token, const char* end, float& value) {
+    return _parse(token,end,value,"%f");
+  }
+  static bool parse(const char* token, const char* end, double& value) {
+    return _parse(token,end,value,"%lf");
+  }
+
+private:
+
+  template<class T>
+  static bool _parse
+  (const char* token, const char* end, T& value, const char* format) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+    from_chars_result r = from_chars(token,end,value);
+    if(r.ptr==end && r.ec==errc()) return true;
+#endif
+    char s[64];
+    size_t n = static_cast<size_t>(end-token);
+    if(n>63) n = 63;
+    memcpy(s,token,n); s[n] = '\0';
+    return (sscanf(s,format,&value)==1);
+  }
+
+};
+
+#endif /* _INPUT_FILE_HPP_ */
@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-09 16:21:05 taubin>
+//------------------------------------------------------------------------
+//
+// LoaderEbm.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <cstring>
+#include "LoaderEbm.hpp"
+#include "InputFile.hpp"
+#include "StrException.hpp"
+
+#include <wrl/Shape.hpp>
+#include <wrl/Appearance.hpp>
+#include <wrl/Material.hpp>
+
+const char* LoaderEbm::_ext = "ebm";
+
+const char  LoaderEbm::FILE_SIGNATURE[8] = { 'D','G','P','-','E','B','M','\0' };
+
+//////////////////////////////////////////////////////////////////////
+// static
+void LoaderEbm::resolvePredictors
+(vector<int>& pred, const vector<uint8_t>& kind) {
+  int i,j,k,n = static_cast<int>(pred.size()/3);
+  for(i=0;i<n;i++) {
+    int* p = &pred[3*i];
+    for(j=k=0;j<3;j++)
+      if(p[j]>=0 && kind[p[j]]!=VERTEX_DUMMY)
+        p[k++] = p[j];
+    for(;k<3;k++)
+      p[k] = -1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderEbm::_decodeTriangles
+(RangeDecoder& decoder, const int nTriangles, const int nComponents,
+ vector<int>& triangle, vector<int>& pred) {
+
+  // cut-border elements are created for the twins of the edges of
+  // every decoded triangle; each one stores the vertex opposite to
+  // the edge in the decoded triangle, used for the prediction
+  vector<int> eSrc,eDst,eOpp,eNext,ePrev;
+  size_t nE = 3*static_cast<size_t>(nTriangles)+3;
+  eSrc.reserve(nE); eDst.reserve(nE); eOpp.reserve(nE);
+  eNext.reserve(nE); ePrev.reserve(nE);
+  vector<int> stack;
+  triangle.clear();
+  triangle.reserve(3*static_cast<size_t>(nTriangles));
+  pred.clear();
+
+  RangeSymbolModel opModel(3,7);
+  RangeIntModel    offsetModel,stackModel;
+  int context = 6;
+  int nV = 0, nT = 0;
+  int a,b,c,g,x,y,v,P,N,A,B,U,W,k,jS,iComponent,op;
+
+#define NEW_ELEMENT(e,s,d,o) { e = static_cast<int>(eSrc.size()); \
+    eSrc.push_back(s); eDst.push_back(d); eOpp.push_back(o);       \
+    eNext.push_back(-1); ePrev.push_back(-1); }
+#define LINK(e0,e1) { eNext[e0] = (e1); ePrev[e1] = (e0); }
+#define VISIT(p0,p1,p2) { pred.push_back(p0); pred.push_back(p1); \
+    pred.push_back(p2); nV++; }
+
+  for(iComponent=0;iComponent<nComponents;iComponent++) {
+    a = nV; VISIT(-1,-1,-1);
+    b = nV; VISIT(a,-1,-1);
+    c = nV; VISIT(a,b,-1);
+    triangle.push_back(a); triangle.push_back(b); triangle.push_back(c);
+    if(++nT>nTriangles) throw new StrException("corrupted connectivity");
+    int e0,e1,e2;
+    NEW_ELEMENT(e0,b,a,c);
+    NEW_ELEMENT(e1,c,b,a);
+    NEW_ELEMENT(e2,a,c,b);
+    LINK(e0,e2); LINK(e2,e1); LINK(e1,e0);
+    g = e0;
+    stack.clear();
+
+    for(;;) {
+      op = opModel.decode(decoder,context);
+      context = op;
+      x = eSrc[g];
+      y = eDst[g];
+      P = ePrev[g];
+      N = eNext[g];
+      switch(op) {
+      case OP_C:
+        v = nV; VISIT(x,y,eOpp[g]);
+        NEW_ELEMENT(A,x,v,y);
+        NEW_ELEMENT(B,v,y,x);
+        LINK(P,A); LINK(A,B); LINK(B,N);
+        g = B;
+        break;
+      case OP_L:
+        v = eSrc[P];
+        NEW_ELEMENT(B,v,y,x);
+        U = ePrev[P];
+        LINK(U,B); LINK(B,N);
+        g = B;
+        break;
+      case OP_R:
+        v = eDst[N];
+        NEW_ELEMENT(A,x,v,y);
+        W = eNext[N];
+        LINK(P,A); LINK(A,W);
+        g = A;
+        break;
+      case OP_E:
+        v = eSrc[P];
+        break;
+      case OP_S:
+      case OP_M:
+        if(op==OP_S) {
+          k = static_cast<int>(offsetModel.decode(decoder))+1;
+          W = N;
+        } else {
+          jS = static_cast<int>(stackModel.decode(decoder));
+          k  = static_cast<int>(offsetModel.decode(decoder));
+          if(jS<0 || jS>=static_cast<int>(stack.size()))
+            throw new StrException("corrupted connectivity");
+          jS = static_cast<int>(stack.size())-1-jS;
+          W  = stack[jS];
+          stack.erase(stack.begin()+jS);
+        }
+        if(k<0 || k>static_cast<int>(eSrc.size()))
+          throw new StrException("corrupted connectivity");
+        while(k-->0) W = eNext[W];
+        v = eSrc[W];
+        U = ePrev[W];
+        NEW_ELEMENT(A,x,v,y);
+        NEW_ELEMENT(B,v,y,x);
+        LINK(P,A); LINK(A,W);
+        LINK(U,B); LINK(B,N);
+        if(op==OP_S) stack.push_back(A);
+        g = B;
+        break;
+      default:
+        throw new StrException("corrupted connectivity");
+      }
+      triangle.push_back(x); triangle.push_back(y); triangle.push_back(v);
+      if(++nT>nTriangles || decoder.hasFailed())
+        throw new StrException("corrupted connectivity");
+      if(op==OP_E) {
+        if(stack.empty()) break;
+        g = stack.back();
+        stack.pop_back();
+      }
+    }
+  }
+
+#undef NEW_ELEMENT
+#undef LINK
+#undef VISIT
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderEbm::_decodeAttribute
+(RangeDecoder& decoder, vector<float>& value, const int dim,
+ const vector<int>& pred, const vector<uint8_t>& kind,
+ const vector<int>& rep, const vector<int>& vOut, const int nOut) {
+
+  int nBits = static_cast<int>(decoder.decodeDirect(5));
+  if(nBits<1 || nBits>30)
+    throw new StrException("corrupted attribute");
+  int maxQ = (1<<nBits)-1;
+  int i,j,type,last,qij;
+  float  vMin[4];
+  double step[4];
+  for(j=0;j<dim;j++) {
+    vMin[j] = decoder.decodeFloat();
+    float vMax = decoder.decodeFloat();
+    step[j] = (static_cast<double>(vMax)-vMin[j])/maxQ;
+  }
+
+  int n = static_cast<int>(kind.size());
+  vector<int> q(static_cast<size_t>(n)*dim,0);
+  vector<RangeIntModel> model(3*dim);
+  value.resize(static_cast<size_t>(nOut)*dim);
+  for(i=0,last=-1;i<n;i++) {
+    if(kind[i]==VERTEX_DUMMY) continue;
+    if(kind[i]==VERTEX_SPLIT) {
+      for(j=0;j<dim;j++)
+        q[i*dim+j] = q[rep[i]*dim+j];
+      continue;
+    }
+    const int* p = &pred[3*i];
+    type = (p[2]>=0)?0:(p[1]>=0)?1:2;
+    for(j=0;j<dim;j++) {
+      qij = predict(q,dim,j,p,last,maxQ)+model[type*dim+j].decodeSigned(decoder);
+      if(qij<0 || qij>maxQ)
+        throw new StrException("corrupted attribute");
+      q[i*dim+j] = qij;
+      value[vOut[i]*dim+j] = static_cast<float>(vMin[j]+qij*step[j]);
+    }
+    last = i;
+  }
+  if(decoder.hasFailed())
+    throw new StrException("unexpected end of file");
+}
+
+//////////////////////////////////////////////////////////////////////
+bool LoaderEbm::load(const char* filename, SceneGraph& wrl) {
+  bool success = false;
+  FILE* fp = (FILE*)0;
+  try {
+    if(filename==(char*)0) throw new StrException("filename==null");
+
+    fp = InputFile::open(filename,"rb");
+    if(fp==(FILE*)0)
+      throw new StrException("unable to open file for binary read");
+    // read in chunks until the end of file, since the size of a
+    // compressed input stream is not known in advance
+    vector<uint8_t> data;
+    size_t nData = 0;
+    do {
+      data.resize(nData+(1<<20));
+      nData += fread(&data[nData],1,data.size()-nData,fp);
+    } while(nData==data.size());
+    if(ferror(fp))
+      throw new StrException("unable to read file");
+    data.resize(nData);
+    fclose(fp);
+    fp = (FILE*)0;
+    if(nData<8)
+      throw new StrException("unable to read file signature");
+    if(memcmp(&data[0],FILE_SIGNATURE,8)!=0)
+      throw new StrException("not an EBM file");
+
+    RangeDecoder decoder(&data[8],data.size()-8);
+    if(decoder.decodeDirect(32)!=FILE_VERSION)
+      throw new StrException("unsupported EBM file version");
+    uint32_t flags = decoder.decodeDirect(8);
+    Color diffuseColor;
+    diffuseColor.r = decoder.decodeFloat();
+    diffuseColor.g = decoder.decodeFloat();
+    diffuseColor.b = decoder.decodeFloat();
+
+    wrl.clear();
+    wrl.setUrl(filename);
+    Shape* shape = new Shape();
+    wrl.addChild(shape);
+    Appearance* appearance = new Appearance();
+    shape->setAppearance(appearance);
+    shape->setName("SURFACE");
+    Material* material = new Material();
+    material->setDiffuseColor(diffuseColor);
+    appearance->setMaterial(material);
+    IndexedFaceSet* ifs = new IndexedFaceSet();
+    shape->setGeometry(ifs);
+    vector<int>& coordIndex = ifs->getCoordIndex();
+
+    // vertices in the order they are stored, their kind, predictors,
+    // the first occurrence of each split vertex, and the index of
+    // the output vertex each one corresponds to
+    vector<int>     pred,rep,vOut;
+    vector<uint8_t> kind;
+    int             i,j,k,n,nOut;
+    RangeIntModel   countModel;
+
+    if(flags&RAW_CONNECTIVITY) {
+
+      int nV = static_cast<int>(countModel.decode(decoder));
+      int nF = static_cast<int>(countModel.decode(decoder));
+      if(nV<1 || static_cast<size_t>(nV)>8*data.size() ||
+         nF<0 || static_cast<size_t>(nF)>8*data.size())
+        throw new StrException("corrupted header");
+      RangeIntModel sizeModel,indexModel;
+      int iF,nFs,iV,last = 0;
+      for(iF=0;iF<nF;iF++) {
+        nFs = static_cast<int>(sizeModel.decode(decoder))+1;
+        if(nFs<1 || decoder.hasFailed())
+          throw new StrException("corrupted connectivity");
+        for(i=0;i<nFs;i++,last=iV) {
+          iV = last+indexModel.decodeSigned(decoder);
+          if(iV<0 || iV>=nV)
+            throw new StrException("corrupted connectivity");
+          coordIndex.push_back(iV);
+        }
+        coordIndex.push_back(-1);
+      }
+
+      kind.assign(nV,VERTEX_CODED);
+      rep.assign(nV,-1);
+      pred.assign(3*static_cast<size_t>(nV),-1);
+      vOut.resize(nV);
+      for(iV=0;iV<nV;iV++)
+        vOut[iV] = iV;
+      nOut = nV;
+
+    } else /* if((flags&RAW_CONNECTIVITY)==0) */ {
+
+      int nTriangles  = static_cast<int>(countModel.decode(decoder));
+      int nComponents = static_cast<int>(countModel.decode(decoder));
+      if(nTriangles<0 || static_cast<size_t>(nTriangles)>64*data.size() ||
+         nComponents<0 || nComponents>nTriangles)
+        throw new StrException("corrupted header");
+      vector<int> triangle;
+      _decodeTriangles(decoder,nTriangles,nComponents,triangle,pred);
+      int nDecoded = static_cast<int>(pred.size()/3);
+
+      kind.assign(nDecoded,VERTEX_CODED);
+      rep.assign(nDecoded,-1);
+      n = static_cast<int>(countModel.decode(decoder));
+      for(k=-1,i=0;i<n;i++) {
+        k += static_cast<int>(countModel.decode(decoder))+1;
+        if(k<0 || k>=nDecoded)
+          throw new StrException("corrupted dummy vertices");
+        kind[k] = VERTEX_DUMMY;
+      }
+      n = static_cast<int>(countModel.decode(decoder));
+      for(k=-1,i=0;i<n;i++) {
+        k += static_cast<int>(countModel.decode(decoder))+1;
+        j  = k-static_cast<int>(countModel.decode(decoder))-1;
+        if(k<0 || k>=nDecoded || j<0 || kind[k]!=VERTEX_CODED ||
+           kind[j]!=VERTEX_CODED)
+          throw new StrException("corrupted split vertices");
+        kind[k] = VERTEX_SPLIT;
+        rep[k]  = j;
+      }
+      n = static_cast<int>(countModel.decode(decoder));
+      if(n<0 || static_cast<size_t>(n)>8*data.size())
+        throw new StrException("corrupted header");
+      kind.resize(nDecoded+n,VERTEX_CODED);
+      rep.resize(nDecoded+n,-1);
+      pred.resize(3*static_cast<size_t>(nDecoded+n),-1);
+      resolvePredictors(pred,kind);
+
+      vOut.resize(kind.size());
+      for(nOut=i=0;i<static_cast<int>(kind.size());i++)
+        vOut[i] =
+          (kind[i]==VERTEX_DUMMY)?-1:
+          (kind[i]==VERTEX_SPLIT)?vOut[rep[i]]:nOut++;
+
+      // the triangles incident to dummy vertices close the boundary
+      // loops, and are not part of the mesh
+      int nT = static_cast<int>(triangle.size()/3);
+      coordIndex.reserve(4*static_cast<size_t>(nT));
+      for(i=0;i<nT;i++) {
+        int* t = &triangle[3*i];
+        if(vOut[t[0]]<0 || vOut[t[1]]<0 || vOut[t[2]]<0) continue;
+        coordIndex.push_back(vOut[t[0]]);
+        coordIndex.push_back(vOut[t[1]]);
+        coordIndex.push_back(vOut[t[2]]);
+        coordIndex.push_back(-1);
+      }
+    }
+
+    _decodeAttribute(decoder,ifs->getCoord(),3,pred,kind,rep,vOut,nOut);
+    if(flags&HAS_NORMAL) {
+      _decodeAttribute(decoder,ifs->getNormal(),3,pred,kind,rep,vOut,nOut);
+      ifs->setNormalPerVertex(true);
+    }
+    if(flags&HAS_COLOR) {
+      _decodeAttribute(decoder,ifs->getColor(),3,pred,kind,rep,vOut,nOut);
+      ifs->setColorPerVertex(true);
+    }
+    if(flags&HAS_TEX_COORD)
+      _decodeAttribute(decoder,ifs->getTexCoord(),2,pred,kind,rep,vOut,nOut);
+
+    success = true;
+
+  } catch(StrException* e) { 
+
+    if(fp!=(FILE*)0) fclose(fp);
+    fprintf(stderr,"LoaderEbm | ERROR | %s\n",e->what());
+    delete e;
+    wrl.clear();
+    wrl.setUrl("");
+
+  }
+
+  return success;
+}
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-09 16:21:05 taubin>
+//------------------------------------------------------------------------
+//
+// LoaderEbm.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _LOADER_EBM_HPP_
+#define _LOADER_EBM_HPP_
+
+#include <cstdint>
+#include <vector>
+#include "Loader.hpp"
+#include "RangeCoder.hpp"
+
+#include <wrl/IndexedFaceSet.hpp>
+
+// Compressed mesh format, for archiving single IndexedFaceSet scenes
+//
+// - the file is the "DGP-EBM\0" signature, followed by a single range
+//   coded stream (see RangeCoder.hpp), which is independent of the
+//   byte order of the machine
+// - coordinates are quantized to a fixed number of bits (16 by
+//   default) relative to their bounding box; per-vertex normals, colors
+//   and texture coordinates are quantized in the same way, to their own
+//   number of bits
+// - triangle meshes are traversed one connected component at a time
+//   with the Edgebreaker / cut-border machine; every triangle is coded
+//   as one of the operations C, L, R, E, S, M, with the position of
+//   the vertex on the cut-border as the argument of the S and M
+//   operations
+// - boundary loops are closed by fans of triangles incident to a
+//   dummy vertex, and singular vertices are split, before the
+//   traversal; the dummy vertices and the split vertices are listed
+//   after the operations, and removed when the mesh is decoded
+// - the vertices are stored in the order they are visited by the
+//   traversal, with parallelogram prediction from the triangle across
+//   the cut-border edge; unreferenced vertices are stored at the end
+// - meshes with polygonal faces, or with edges shared by more than
+//   two faces, or with inconsistently oriented faces, are stored
+//   with the face sizes and the coordIndex values delta coded, and
+//   the vertices in their original order
+// - per-face and per-corner properties are not stored
+//
+// the decoded IndexedFaceSet has the same faces, with the same
+// orientation, but its vertices and faces are in general in a
+// different order
+
+class LoaderEbm : public Loader {
+
+private:
+
+  const static char* _ext;
+
+public:
+
+  enum Operation {
+    OP_C = 0, // new vertex
+    OP_L,     // closes the cut-border edge before the gate
+    OP_R,     // closes the cut-border edge after the gate
+    OP_E,     // closes a cut-border loop of three edges
+    OP_S,     // splits the cut-border loop
+    OP_M      // merges a cut-border loop from the stack
+  };
+
+  enum Flags {
+    HAS_NORMAL       = 0x01,
+    HAS_COLOR        = 0x02,
+    HAS_TEX_COORD    = 0x04,
+    RAW_CONNECTIVITY = 0x08
+  };
+
+  enum VertexKind {
+    VERTEX_CODED = 0,
+    VERTEX_DUMMY,
+    VERTEX_SPLIT
+  };
+
+  static const char     FILE_SIGNATURE[8];
+  static const uint32_t FILE_VERSION = 1;
+
+  LoaderEbm()  {};
+  ~LoaderEbm() {};
+
+  bool  load(const char* filename, SceneGraph& wrl);
+  const char* ext() const { return _ext; }
+
+  // predicted value of the component j of a quantized attribute of
+  // dimension dim, from the (up to three) predictor vertices of the
+  // vertex, or from the last coded vertex if it has none; shared by
+  // the encoder and the decoder
+  static int predict
+  (const vector<int>& q, const int dim, const int j,
+   const int* pred /*[3]*/, const int last, const int maxQ) {
+    int p;
+    if(pred[2]>=0)
+      p = q[pred[0]*dim+j]+q[pred[1]*dim+j]-q[pred[2]*dim+j];
+    else if(pred[1]>=0)
+      p = (q[pred[0]*dim+j]+q[pred[1]*dim+j])>>1;
+    else if(pred[0]>=0)
+      p = q[pred[0]*dim+j];
+    else if(last>=0)
+      p = q[last*dim+j];
+    else
+      p = (maxQ+1)>>1;
+    return (p<0)?0:(p>maxQ)?maxQ:p;
+  }
+
+  // removes the dummy vertices from the predictors of every vertex
+  static void resolvePredictors
+  (vector<int>& pred, const vector<uint8_t>& kind);
+
+private:
+
+  void  _decodeAttribute
+  (RangeDecoder& decoder, vector<float>& value, const int dim,
+   const vector<int>& pred, const vector<uint8_t>& kind,
+   const vector<int>& rep, const vector<int>& vOut, const int nOut);
+  void  _decodeTriangles
+  (RangeDecoder& decoder, const int nTriangles, const int nComponents,
+   vector<int>& triangle, vector<int>& pred);
+};
+
+#endif /* _LOADER_EBM_HPP_ */
@@ -41,12 +41,15 @@
 
 // #include <stdio.h>
 #include <iostream>
+#include <stdlib.h>
+#include <cstring>
+#include <algorithm>
 
 using namespace std;
 
 #include "LoaderPly.hpp"
 #include "TokenizerFile.hpp"
-#include "TokenizerString.hpp"
+#include "InputFile.hpp"
 #include "StrException.hpp"
 #include <wrl/Shape.hpp>
 #include <wrl/Appearance.hpp>
@@ -56,6 +59,33 @@ using namespace std;
 
 const char* LoaderPly::_ext = "ply";
 
+bool LoaderPly::_compactCoord = false;
+bool LoaderPly::_dropUnusedProperties = false;
+
+//////////////////////////////////////////////////////////////////////
+// static
+void LoaderPly::setCompactCoord(const bool value) {
+  _compactCoord = value;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool LoaderPly::getCompactCoord() {
+  return _compactCoord;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+void LoaderPly::setDropUnusedProperties(const bool value) {
+  _dropUnusedProperties = value;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool LoaderPly::getDropUnusedProperties() {
+  return _dropUnusedProperties;
+}
+
 //////////////////////////////////////////////////////////////////////
 // static
 Ply::DataType LoaderPly::systemEndian() {
@@ -90,6 +120,7 @@ void LoaderPly::addBinaryValue
     break;
   case Ply::Element::Property::UCHAR:
   case Ply::Element::Property::UINT8:
+  case Ply::Element::Property::UINT8_4:
     {
       vector<uchar>* valueUChar= static_cast<vector<uchar>*>(value);
       uchar v = buff.uc[0];
@@ -159,6 +190,110 @@ void LoaderPly::addBinaryValue
   }
 }
 
+//////////////////////////////////////////////////////////////////////
+// static
+bool LoaderPly::readBinaryValues
+(FILE* fp,
+ const Ply::Element::Property::Type propertyType,
+ const bool swapBytes,
+ void* value,
+ const size_t nValues) {
+
+  char*  data      = nullptr;
+  size_t valueSize = 0;
+  size_t n0;
+
+  switch(propertyType) {
+  case Ply::Element::Property::CHAR:
+  case Ply::Element::Property::INT8:
+    {
+      vector<char>* v = static_cast<vector<char>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(char);
+    }
+    break;
+  case Ply::Element::Property::UCHAR:
+  case Ply::Element::Property::UINT8:
+  case Ply::Element::Property::UINT8_4:
+    {
+      vector<uchar>* v = static_cast<vector<uchar>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(uchar);
+    }
+    break;
+  case Ply::Element::Property::SHORT:
+  case Ply::Element::Property::INT16:
+    {
+      vector<short>* v = static_cast<vector<short>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(short);
+    }
+    break;
+  case Ply::Element::Property::USHORT:
+  case Ply::Element::Property::UINT16:
+    {
+      vector<ushort>* v = static_cast<vector<ushort>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(ushort);
+    }
+    break;
+  case Ply::Element::Property::INT:
+  case Ply::Element::Property::INT32:
+    {
+      vector<int>* v = static_cast<vector<int>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(int);
+    }
+    break;
+  case Ply::Element::Property::UINT:
+  case Ply::Element::Property::UINT32:
+    {
+      vector<uint>* v = static_cast<vector<uint>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(uint);
+    }
+    break;
+  case Ply::Element::Property::FLOAT:
+  case Ply::Element::Property::FLOAT32:
+  case Ply::Element::Property::FLOAT32_2:
+  case Ply::Element::Property::FLOAT32_3:
+    {
+      vector<float>* v = static_cast<vector<float>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(float);
+    }
+    break;
+  case Ply::Element::Property::DOUBLE:
+  case Ply::Element::Property::FLOAT64:
+    {
+      vector<double>* v = static_cast<vector<double>*>(value);
+      n0 = v->size(); v->resize(n0+nValues);
+      data = reinterpret_cast<char*>(v->data()+n0);
+      valueSize = sizeof(double);
+    }
+    break; 
+  case Ply::Element::Property::NONE:
+    {
+      throw new StrException("unexpected NONE binary value tyde");
+    }
+  }
+
+  if(nValues==0)
+    return true;
+  if(fread(data,valueSize,nValues,fp)<nValues)
+    return false;
+  if(swapBytes)
+    Endian::swap(data,data,nValues,valueSize);
+  return true;
+}
+
 //////////////////////////////////////////////////////////////////////
 // static
 void LoaderPly::addAsciiValue
@@ -177,6 +312,7 @@ void LoaderPly::addAsciiValue
     break;
   case Ply::Element::Property::UCHAR:
   case Ply::Element::Property::UINT8:
+  case Ply::Element::Property::UINT8_4:
     {
       vector<uchar>* valueUChar= static_cast<vector<uchar>*>(value);
       uchar v = static_cast<uchar>(atoi(token.c_str()));
@@ -438,7 +574,7 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
     long fp0 = ftell(fp);
 
     int                     nElements,iElement,nProperties,iProperty;
-    int                     nRecords,iRecord,k0,k1,i;
+    int                     nRecords,iRecord,k0,k1;
     int                     nList,nBytesListCount, nBytesListValue;
     int                     nBytesValue,nBytesRead,nBytesRecord;
     string                  name;
@@ -505,6 +641,24 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
       //          .arg(indent.c_str())
       //          .arg(nRecords));
 
+      // the records of an element with a single scalar property are
+      // stored in the file exactly as in memory, and are read as one
+      // block
+      if(nProperties==1) {
+        property     = element->getProperty(0);
+        propertyType = property->getPropertyType();
+        if(property->isList()==false &&
+           (wrlMode==false || property->getName()!="color")) {
+          size_t n =
+            (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
+            (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
+          if(readBinaryValues(fp,propertyType,swapBytes,property->getValue(),
+                              n*static_cast<size_t>(nRecords))==false)
+            throw new StrException("end of file in single property element");
+          continue;
+        }
+      }
+
       k0 = 0;
       for(iRecord=0;iRecord<nRecords;iRecord++) {
         nBytesRecord = 0;
@@ -568,20 +722,14 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
 
             // read nList values, each of length nBytesListValue
 
-            for(i=0;i<nList;i++) {
-              nBytesRead =
-                static_cast<int>
-                (fread(&(buff.c),1,static_cast<size_t>(nBytesListValue),fp));
-              if(nBytesRead<nBytesListValue) {
-                char s[128]; snprintf(s,128,"end of file in record %d",iRecord);
-                throw new StrException(string(s));
-              }
-
-              nBytesRecord += nBytesRead;
-
-              addBinaryValue(buff,propertyType,swapBytes,value);
+            if(readBinaryValues
+               (fp,propertyType,swapBytes,value,static_cast<size_t>(nList))==false) {
+              char s[128]; snprintf(s,128,"end of file in record %d",iRecord);
+              throw new StrException(string(s));
             }
 
+            nBytesRecord += nList*nBytesListValue;
+
             if(wrlMode && propertyName=="coordIndex")
               static_cast<vector<int>*>(value)->push_back(-1);
 
@@ -591,7 +739,8 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
             if(wrlMode) {
               int n =
                 (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
-                (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
+                (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:
+                (propertyType==Ply::Element::Property::Type::UINT8_4)?3:1;
             
               if(propertyName=="color")
                 nBytesValue = 1;
@@ -609,7 +758,11 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
 
                 nBytesRecord += nBytesRead;
 
-                if(wrlMode && propertyName=="color") {
+                if(wrlMode && propertyName=="color" &&
+                   propertyType==Ply::Element::Property::Type::UINT8_4) {
+                  vector<uchar>* colorValue = static_cast<vector<uchar>*>(value);
+                  colorValue->push_back(buff.uc[0]);
+                } else if(wrlMode && propertyName=="color") {
                   vector<float>* colorValue = static_cast<vector<float>*>(value);
                   colorValue->push_back(static_cast<float>(buff.uc[0])/255.0f);
                 } else {
@@ -617,6 +770,10 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
                 }
               }
 
+              // opaque alpha
+              if(propertyType==Ply::Element::Property::Type::UINT8_4)
+                static_cast<vector<uchar>*>(value)->push_back(255);
+
             } else {
 
               nBytesRead =
@@ -656,133 +813,434 @@ size_t LoaderPly::readBinaryData(FILE* fp, Ply& ply, const string indent) {
 }
 
 //////////////////////////////////////////////////////////////////////
+// parallel ascii data parsing
+//
+// each record is a line, so the data following the header is mapped
+// into memory as an InputData, the line boundaries are found by
+// counting end of line characters in parallel, and each element is
+// parsed in chunks of records by several threads; the scalar property
+// values of each record have a known position in the property arrays,
+// which are sized before parsing, while the list property values are
+// parsed into a separate buffer for each chunk, and appended in order
+
+int LoaderPly::_nThreads = 0;
+
 // static
-size_t LoaderPly::readAsciiData(FILE* fp, Ply& ply, const string indent) {
+void LoaderPly::setNumberOfThreads(const int nThreads) {
+  _nThreads = nThreads;
+}
 
-  (void)indent;
+// static
+int LoaderPly::getNumberOfThreads() {
+  return _nThreads;
+}
 
-  // APP->log(QString("%1LoaderPly::readAsciiData() {").arg(indent.c_str()));
+// finds the first character of any line of the data, using the number
+// of end of line characters in each block of the data, which are
+// counted in parallel
+class AsciiLines {
+public:
+  AsciiLines(const char* data, const size_t size, const int nThreads);
+  // returns size if the data has fewer than iLine+1 lines
+  size_t start(const int64_t iLine) const;
+private:
+  const char*     _data;
+  size_t          _size;
+  vector<size_t>  _blockStart;
+  vector<int64_t> _blockLines; // lines which end before each block
+};
+
+AsciiLines::AsciiLines
+(const char* data, const size_t size, const int nThreads):
+  _data(data),
+  _size(size) {
+  int nBlocks = static_cast<int>((size>>16)+1);
+  if(nBlocks>1024) nBlocks = 1024;
+  _blockStart.resize(static_cast<size_t>(nBlocks)+1);
+  _blockLines.resize(static_cast<size_t>(nBlocks)+1,0);
+  for(int iBlock=0;iBlock<=nBlocks;iBlock++)
+    _blockStart[iBlock] = (size/nBlocks)*iBlock+((size%nBlocks)*iBlock)/nBlocks;
+  InputParser::runChunks(nThreads,nBlocks,[&](const int iBlock) {
+      const char* p   = data+_blockStart[iBlock];
+      const char* end = data+_blockStart[iBlock+1];
+      int64_t n = 0;
+      while(p<end && (p=static_cast<const char*>(memchr(p,'\n',end-p)))!=nullptr)
+        { n++; p++; }
+      _blockLines[iBlock+1] = n;
+    });
+  for(int iBlock=0;iBlock<nBlocks;iBlock++)
+    _blockLines[iBlock+1] += _blockLines[iBlock];
+}
 
-  size_t nBytes = 0;
-  if(fp) {
-    long fp0 = ftell(fp);
-    TokenizerFile ftkn(fp);
+size_t AsciiLines::start(const int64_t iLine) const {
+  if(iLine<=0) return 0;
+  // the block which contains the iLine-th end of line
+  vector<int64_t>::const_iterator i =
+    lower_bound(_blockLines.begin(),_blockLines.end(),iLine);
+  if(i==_blockLines.end()) return _size;
+  size_t iBlock = static_cast<size_t>(i-_blockLines.begin())-1;
+  int64_t n = iLine-_blockLines[iBlock];
+  const char* p = _data+_blockStart[iBlock];
+  while((p=static_cast<const char*>(memchr(p,'\n',_data+_size-p)))!=nullptr) {
+    p++;
+    if(--n==0) break;
+  }
+  return static_cast<size_t>(p-_data);
+}
 
-    int nElements = ply.getNumberOfElements();
-    // APP->log(QString("%1  nElements = %2")
-    //          .arg(indent.c_str())
-    //          .arg(nElements));
+// the same separators as Tokenizer::get()
+static inline bool _isAsciiSeparator(const char c) {
+  return (c==' ' || c=='\t' || c==',' || c=='\015');
+}
 
-    Ply::Element* element;
-    Ply::Element::Property* property;
-    // Ply::Element::Property::Type listType = Ply::Element::Property::Type::NONE;
-    Ply::Element::Property::Type propertyType = Ply::Element::Property::Type::NONE;
-    void* value;
-    string line,name,propertyName,token;
-    int i,iElement,iProperty,iRecord,k0,k1,nList,nProperties,nRecords;
+// finds the next token of the line [p,end); a token starting with '#'
+// comments out the rest of the line
+static inline bool _nextAsciiToken
+(const char*& p, const char* end, const char*& token) {
+  while(p<end && _isAsciiSeparator(*p)) p++;
+  if(p==end || *p=='#') return false;
+  token = p;
+  while(p<end && _isAsciiSeparator(*p)==false) p++;
+  return true;
+}
 
-    bool wrlMode = ply.getWrlMode();
+// same values as atoi() and atof()
+static inline long long _asciiInt(const char* token, const char* end) {
+  long long v = 0;
+  InputParser::parse(token,end,v);
+  return v;
+}
 
-    for(iElement=0;iElement<nElements;iElement++) {
-       element = ply.getElement(iElement);
-
-       name    = element->getName();
-       // APP->log(QString("%1    name =\"%2\"")
-       //          .arg(indent.c_str())
-       //          .arg(name.c_str()));
-
-       nProperties = element->getNumberOfProperties();
-       // APP->log(QString("%1      nProperties = %2")
-       //          .arg(indent.c_str())
-       //          .arg(nProperties));
-
-       nRecords = element->getNumberOfRecords();
-       // APP->log(QString("%1      nRecords = %2")
-       //          .arg(indent.c_str())
-       //          .arg(nRecords));
-
-       k0 = 0;
-       for(iRecord=0;iRecord<nRecords;iRecord++) {
-
-          // one record per line
-          if(ftkn.getline()==false) {
-            char s[128]; snprintf(s,128,"found empty record %d",iRecord);
-            throw new StrException(string(s));
-          }
+static inline double _asciiDouble(const char* token, const char* end) {
+  double v = 0.0;
+  InputParser::parse(token,end,v);
+  return v;
+}
 
-          TokenizerString stkn(ftkn);
+// size of each value stored in the array of a property
+static size_t _asciiValueSize(const Ply::Element::Property::Type type) {
+  switch(type) {
+  case Ply::Element::Property::CHAR:
+  case Ply::Element::Property::INT8:
+  case Ply::Element::Property::UCHAR:
+  case Ply::Element::Property::UINT8:
+  case Ply::Element::Property::UINT8_4:
+    return 1;
+  case Ply::Element::Property::SHORT:
+  case Ply::Element::Property::INT16:
+  case Ply::Element::Property::USHORT:
+  case Ply::Element::Property::UINT16:
+    return 2;
+  case Ply::Element::Property::DOUBLE:
+  case Ply::Element::Property::FLOAT64:
+    return 8;
+  case Ply::Element::Property::NONE:
+    throw new StrException("unexpected NONE ascii value type");
+  default:
+    return 4;
+  }
+}
 
-          for(iProperty=0;iProperty<nProperties;iProperty++) {
+// appends n values to the array of a property, and returns a pointer to
+// the first one
+static void* _growAsciiValues
+(void* value, const Ply::Element::Property::Type type, const size_t n) {
+  switch(type) {
+  case Ply::Element::Property::CHAR:
+  case Ply::Element::Property::INT8:
+    {
+      vector<char>* v = static_cast<vector<char>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::UCHAR:
+  case Ply::Element::Property::UINT8:
+  case Ply::Element::Property::UINT8_4:
+    {
+      vector<uchar>* v = static_cast<vector<uchar>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::SHORT:
+  case Ply::Element::Property::INT16:
+    {
+      vector<short>* v = static_cast<vector<short>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::USHORT:
+  case Ply::Element::Property::UINT16:
+    {
+      vector<ushort>* v = static_cast<vector<ushort>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::INT:
+  case Ply::Element::Property::INT32:
+    {
+      vector<int>* v = static_cast<vector<int>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::UINT:
+  case Ply::Element::Property::UINT32:
+    {
+      vector<uint>* v = static_cast<vector<uint>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::FLOAT:
+  case Ply::Element::Property::FLOAT32:
+  case Ply::Element::Property::FLOAT32_2:
+  case Ply::Element::Property::FLOAT32_3:
+    {
+      vector<float>* v = static_cast<vector<float>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::DOUBLE:
+  case Ply::Element::Property::FLOAT64:
+    {
+      vector<double>* v = static_cast<vector<double>*>(value);
+      v->resize(v->size()+n);
+      return v->data()+v->size()-n;
+    }
+  case Ply::Element::Property::NONE:
+    break;
+  }
+  throw new StrException("unexpected NONE ascii value type");
+}
 
-            property     = element->getProperty(iProperty);
-            propertyName = property->getName();
-            propertyType = property->getPropertyType();
-  
-            if(property->isList()==true) {
- 
-              nList = 0;
+// stores the value of the token as the i-th value of an array of the
+// given type, converted as in LoaderPly::addAsciiValue()
+static inline void _putAsciiValue
+(const char* token, const char* end,
+ const Ply::Element::Property::Type type, void* values, const size_t i) {
+  switch(type) {
+  case Ply::Element::Property::CHAR:
+  case Ply::Element::Property::INT8:
+    static_cast<char*>(values)[i] =
+      static_cast<char>(_asciiInt(token,end));
+    break;
+  case Ply::Element::Property::UCHAR:
+  case Ply::Element::Property::UINT8:
+  case Ply::Element::Property::UINT8_4:
+    static_cast<uchar*>(values)[i] =
+      static_cast<uchar>(_asciiInt(token,end));
+    break;
+  case Ply::Element::Property::SHORT:
+  case Ply::Element::Property::INT16:
+    static_cast<short*>(values)[i] =
+      static_cast<short>(_asciiInt(token,end));
+    break;
+  case Ply::Element::Property::USHORT:
+  case Ply::Element::Property::UINT16:
+    static_cast<ushort*>(values)[i] =
+      static_cast<ushort>(_asciiInt(token,end));
+    break;
+  case Ply::Element::Property::INT:
+  case Ply::Element::Property::INT32:
+    static_cast<int*>(values)[i] =
+      static_cast<int>(_asciiInt(token,end));
+    break;
+  case Ply::Element::Property::UINT:
+  case Ply::Element::Property::UINT32:
+    static_cast<uint*>(values)[i] =
+      static_cast<uint>(_asciiInt(token,end));
+    break;
+  case Ply::Element::Property::FLOAT:
+  case Ply::Element::Property::FLOAT32:
+  case Ply::Element::Property::FLOAT32_2:
+  case Ply::Element::Property::FLOAT32_3:
+    static_cast<float*>(values)[i] =
+      static_cast<float>(_asciiDouble(token,end));
+    break;
+  case Ply::Element::Property::DOUBLE:
+  case Ply::Element::Property::FLOAT64:
+    static_cast<double*>(values)[i] = _asciiDouble(token,end);
+    break;
+  case Ply::Element::Property::NONE:
+    break;
+  }
+}
 
-              if(stkn.get()==false) {
-                char s[128];
-                snprintf(s,128,"end of line in property record %d",iRecord);
-                throw new StrException(string(s));
-              }
+// where the values of one property of the element being parsed go
+class AsciiProperty {
+public:
+  Ply::Element::Property*      property;
+  Ply::Element::Property::Type type;
+  bool                         list;
+  bool                         coordIndex; // wrlMode, with -1 separators
+  bool                         color;      // wrlMode, scaled to [0,1]
+  bool                         rgba8;      // wrlMode, with an opaque alpha
+  int                          nValues;    // per record, if not a list
+  size_t                       valueSize;
+  void*                        values;     // of the element, if not a list
+};
+
+// the list property values of a chunk of records
+class AsciiChunk {
+public:
+  vector< vector<char> > values;
+  vector< vector<int> >  listSize;
+  string                 error;
+  const char*            end;
+};
+
+// parses the records [iRecord0,iRecord1) of an element, starting at p
+static void _parseAsciiRecords
+(const char* p, const char* end, vector<AsciiProperty>& property,
+ const int iRecord0, const int iRecord1, AsciiChunk& chunk) {
+  const char* token = nullptr;
+  char s[128];
+  for(int iRecord=iRecord0;iRecord<iRecord1;iRecord++) {
+
+    // one record per line
+    const char* eol = (p<end)?
+      static_cast<const char*>(memchr(p,'\n',end-p)):nullptr;
+    if(eol==nullptr) eol = end;
+    if(eol==p) {
+      snprintf(s,128,"found empty record %d",iRecord);
+      chunk.error = s;
+      return;
+    }
 
-              nList = atoi(stkn.c_str());
-
-              if(wrlMode==false || propertyName!="coordIndex")
-                property->pushBackList(nList);
- 
-              value = property->getValue();
-  
-               for(i=0;i<nList;i++) {
-                 if(stkn.get()==false) {
-                   char s[128];
-                   snprintf(s,128,"end of line in property record %d",iRecord);
-                   throw new StrException(string(s));
-                 }
-                 addAsciiValue(stkn,propertyType,value);
-               }
-
-               if(wrlMode && propertyName=="coordIndex")
-                 static_cast<vector<int>*>(value)->push_back(-1);
-
-            } else /* if(property.isList()==false) */ {
-
-              value = property->getValue();
- 
-              int n =
-                (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
-                (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
+    bool ok = true;
+    for(size_t iProperty=0;ok && iProperty<property.size();iProperty++) {
+      AsciiProperty& ap = property[iProperty];
+      if(ap.list) {
+        if((ok=_nextAsciiToken(p,eol,token))==false) break;
+        int nList = static_cast<int>(_asciiInt(token,p));
+        int n = (nList>0)?nList:0;
+        vector<char>& buffer = chunk.values[iProperty];
+        size_t i = buffer.size()/ap.valueSize;
+        buffer.resize(buffer.size()+(n+(ap.coordIndex?1:0))*ap.valueSize);
+        for(int k=0;ok && k<n;k++,i++)
+          if((ok=_nextAsciiToken(p,eol,token))==true)
+            _putAsciiValue(token,p,ap.type,buffer.data(),i);
+        if(ap.coordIndex)
+          reinterpret_cast<int*>(buffer.data())[i] = -1;
+        else
+          chunk.listSize[iProperty].push_back(nList);
+      } else {
+        size_t i = static_cast<size_t>(iRecord)*ap.nValues;
+        int nTokens = (ap.rgba8)?3:ap.nValues;
+        for(int k=0;ok && k<nTokens;k++,i++) {
+          if((ok=_nextAsciiToken(p,eol,token))==false) break;
+          _putAsciiValue(token,p,ap.type,ap.values,i);
+          if(ap.color)
+            static_cast<float*>(ap.values)[i] /= 255.0;
+        }
+        if(ap.rgba8)
+          static_cast<uchar*>(ap.values)[i] = 255;
+      }
+    }
+    if(ok==false) {
+      snprintf(s,128,"end of line in property record %d",iRecord);
+      chunk.error = s;
+      return;
+    }
 
-              while(--n>=0) {
-                if(stkn.get()==false) {
-                  char s[128];
-                  snprintf(s,128,"end of line in property record %d",iRecord);
-                  throw new StrException(string(s));
-                }
-                addAsciiValue(stkn,propertyType,value);
-                if(wrlMode && propertyName=="color") {
-                    static_cast<vector<float>*>(value)->back() /= 255.0;
-                }
-              }
-            }
-          }
+    p = (eol<end)?eol+1:end;
+  }
+  chunk.end = p;
+}
 
-          // report progress
-          k1 = (10*(iRecord+1))/nRecords;
-          if(k1>k0) {
-            char s[128];
-            snprintf(s,128,"        %3d %%",10*k1);
-            // APP->log(QString(indent.c_str())+s);
-            k0 = k1;
-          }
+//////////////////////////////////////////////////////////////////////
+// static
+size_t LoaderPly::readAsciiData(FILE* fp, Ply& ply, const string indent) {
+
+  (void)indent;
+
+  // APP->log(QString("%1LoaderPly::readAsciiData() {").arg(indent.c_str()));
+
+  size_t nBytes = 0;
+  if(fp) {
+    InputData   body(fp);
+    const char* data = body.data();
+    const char* end  = data+body.size();
+
+    int nThreads = InputParser::numberOfThreads(_nThreads);
+    AsciiLines lines(data,body.size(),nThreads);
+
+    bool    wrlMode   = ply.getWrlMode();
+    int     nElements = ply.getNumberOfElements();
+    int64_t iLine     = 0; // first line of the element
+    const char* p     = data;
+    for(int iElement=0;iElement<nElements;iElement++) {
+      Ply::Element* element = ply.getElement(iElement);
+      int nRecords    = element->getNumberOfRecords();
+      int nProperties = element->getNumberOfProperties();
+      if(nRecords<=0) continue;
+
+      // size the scalar property arrays
+      vector<AsciiProperty> property(static_cast<size_t>(nProperties));
+      for(int iProperty=0;iProperty<nProperties;iProperty++) {
+        AsciiProperty& ap = property[iProperty];
+        ap.property   = element->getProperty(iProperty);
+        ap.type       = ap.property->getPropertyType();
+        ap.list       = ap.property->isList();
+        ap.coordIndex = (wrlMode && ap.property->getName()=="coordIndex");
+        ap.rgba8      = (ap.type==Ply::Element::Property::Type::UINT8_4);
+        ap.color      = (wrlMode && ap.property->getName()=="color" &&
+                         ap.rgba8==false);
+        ap.nValues    =
+          (ap.type==Ply::Element::Property::Type::FLOAT32_3)?3:
+          (ap.type==Ply::Element::Property::Type::FLOAT32_2)?2:
+          (ap.rgba8)?4:1;
+        ap.valueSize  = _asciiValueSize(ap.type);
+        ap.values     = (ap.list)?nullptr:
+          _growAsciiValues(ap.property->getValue(),ap.type,
+                           static_cast<size_t>(nRecords)*ap.nValues);
+      }
 
-      } // for(iRecord=0;iRecord<nRecords;iRecord++)
+      // a few chunks of records per thread, each starting on a line
+      int nChunks = (nRecords+(1<<12)-1)>>12;
+      if(nChunks>4*nThreads) nChunks = 4*nThreads;
+      vector<AsciiChunk> chunk(static_cast<size_t>(nChunks));
+      vector<int>        iRecord(static_cast<size_t>(nChunks)+1);
+      for(int iChunk=0;iChunk<=nChunks;iChunk++)
+        iRecord[iChunk] = static_cast<int>
+          ((static_cast<int64_t>(nRecords)*iChunk)/nChunks);
+      for(int iChunk=0;iChunk<nChunks;iChunk++) {
+        chunk[iChunk].values.resize(property.size());
+        chunk[iChunk].listSize.resize(property.size());
+        chunk[iChunk].end = data+lines.start(iLine+iRecord[iChunk]);
+      }
+
+      InputParser::runChunks(nThreads,nChunks,[&](const int iChunk) {
+          _parseAsciiRecords(chunk[iChunk].end,end,property,
+                             iRecord[iChunk],iRecord[iChunk+1],chunk[iChunk]);
+        });
+
+      // append the list property values in order
+      for(int iChunk=0;iChunk<nChunks;iChunk++)
+        if(chunk[iChunk].error!="")
+          throw new StrException(chunk[iChunk].error);
+      for(size_t iProperty=0;iProperty<property.size();iProperty++) {
+        AsciiProperty& ap = property[iProperty];
+        if(ap.list==false) continue;
+        size_t nValues = 0;
+        for(int iChunk=0;iChunk<nChunks;iChunk++)
+          nValues += chunk[iChunk].values[iProperty].size()/ap.valueSize;
+        char* values = static_cast<char*>
+          (_growAsciiValues(ap.property->getValue(),ap.type,nValues));
+        for(int iChunk=0;iChunk<nChunks;iChunk++) {
+          vector<char>& buffer = chunk[iChunk].values[iProperty];
+          if(buffer.size()>0)
+            memcpy(values,buffer.data(),buffer.size());
+          values += buffer.size();
+          vector<char>().swap(buffer);
+          for(int nList : chunk[iChunk].listSize[iProperty])
+            ap.property->pushBackList(nList);
+        }
+      }
+
+      p      = chunk[nChunks-1].end;
+      iLine += nRecords;
     } // for(iElement=0;iElement<nElements;iElement++)
 
-    long fp1 = ftell(fp);
-    nBytes = static_cast<size_t>(fp1-fp0);
+    nBytes = static_cast<size_t>(p-data);
   }
   // APP->log(QString(indent.c_str())+"} LoaderPly::readAsciiData()");
   return nBytes;
@@ -805,7 +1263,7 @@ bool LoaderPly::load(const char* filename, Ply & ply, const string indent) {
     // open the file for ascii reading
     if(filename==nullptr)
       throw new StrException("no filename");
-    fp = fopen(filename,"r");
+    fp = InputFile::open(filename,"r");
     if(fp==nullptr)
       throw new StrException("unable to open file for ascii reading");
 
@@ -830,7 +1288,7 @@ bool LoaderPly::load(const char* filename, Ply & ply, const string indent) {
                  ply.getDataType()==Ply::DataType::BINARY_BIG_ENDIAN) */ {
 
       fclose(fp);
-      fp = fopen(filename,"rb");
+      fp = InputFile::open(filename,"rb");
       if(fp==nullptr)
         throw new StrException("unable to open file to read binary data");
 
@@ -859,7 +1317,6 @@ bool LoaderPly::load(const char* filename, Ply & ply, const string indent) {
 
     ply.clear();
     if(fp) fclose(fp);
-    // APP->log(QString("%1  %2").arg(indent.c_str()).arg(e->what()));
     delete e;
   }
 
@@ -868,6 +1325,139 @@ bool LoaderPly::load(const char* filename, Ply & ply, const string indent) {
   return success;
 }
 
+//////////////////////////////////////////////////////////////////////
+LoaderPly::RecordReader::RecordReader():
+  _fp(nullptr),
+  _ftkn(nullptr),
+  _dataType(Ply::DataType::NONE),
+  _swapBytes(false) {
+}
+
+//////////////////////////////////////////////////////////////////////
+LoaderPly::RecordReader::~RecordReader() {
+  close();
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderPly::RecordReader::open(const char* filename, Ply& ply) {
+  close();
+  ply.clear();
+  if(filename==nullptr)
+    throw new StrException("no filename");
+  if(ply.getWrlMode())
+    throw new StrException("streaming requires wrlMode==false");
+  // binary mode works for ascii data as well
+  _fp = InputFile::open(filename,"rb");
+  if(_fp==nullptr)
+    throw new StrException("unable to open file");
+  // the stdio buffer is the only buffer used for the data
+  setvbuf(_fp,nullptr,_IOFBF,1<<20);
+  readHeader(_fp,ply);
+  _dataType  = ply.getDataType();
+  _swapBytes = (_dataType!=Ply::DataType::ASCII &&
+                sameAsSystemEndian(_dataType)==false);
+  if(_dataType==Ply::DataType::ASCII)
+    _ftkn = new TokenizerFile(_fp);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderPly::RecordReader::close() {
+  if(_ftkn!=nullptr) { delete _ftkn; _ftkn = nullptr; }
+  if(_fp!=nullptr) { fclose(_fp); _fp = nullptr; }
+}
+
+//////////////////////////////////////////////////////////////////////
+double LoaderPly::RecordReader::_readBinary
+(const Ply::Element::Property::Type type) {
+  Endian::SingleValueBuffer buff;
+  size_t nBytes = static_cast<size_t>(Ply::Element::Property::getTypeSize(type));
+  if(nBytes==0)
+    throw new StrException("unexpected binary value type");
+  if(fread(&(buff.c),1,nBytes,_fp)<nBytes)
+    throw new StrException("unexpected end of file");
+  double value = 0.0;
+  switch(type) {
+  case Ply::Element::Property::CHAR:
+  case Ply::Element::Property::INT8:
+    value = static_cast<double>(buff.c[0]);
+    break;
+  case Ply::Element::Property::UCHAR:
+  case Ply::Element::Property::UINT8:
+    value = static_cast<double>(buff.uc[0]);
+    break;
+  case Ply::Element::Property::SHORT:
+  case Ply::Element::Property::INT16:
+    if(_swapBytes) Endian::swapShort(buff);
+    value = static_cast<double>(buff.s[0]);
+    break;
+  case Ply::Element::Property::USHORT:
+  case Ply::Element::Property::UINT16:
+    if(_swapBytes) Endian::swapUShort(buff);
+    value = static_cast<double>(buff.us[0]);
+    break;
+  case Ply::Element::Property::INT:
+  case Ply::Element::Property::INT32:
+    if(_swapBytes) Endian::swapInt(buff);
+    value = static_cast<double>(buff.i[0]);
+    break;
+  case Ply::Element::Property::UINT:
+  case Ply::Element::Property::UINT32:
+    if(_swapBytes) Endian::swapUInt(buff);
+    value = static_cast<double>(buff.ui[0]);
+    break;
+  case Ply::Element::Property::FLOAT:
+  case Ply::Element::Property::FLOAT32:
+    if(_swapBytes) Endian::swapFloat(buff);
+    value = static_cast<double>(buff.f[0]);
+    break;
+  case Ply::Element::Property::DOUBLE:
+  case Ply::Element::Property::FLOAT64:
+    if(_swapBytes) Endian::swapDouble(buff);
+    value = buff.d[0];
+    break;
+  default:
+    throw new StrException("unexpected binary value type");
+  }
+  return value;
+}
+
+//////////////////////////////////////////////////////////////////////
+double LoaderPly::RecordReader::_readAscii() {
+  if(_ftkn->get()==false)
+    throw new StrException("unexpected end of file");
+  char* end = nullptr;
+  double value = strtod(_ftkn->c_str(),&end);
+  if(end==_ftkn->c_str())
+    throw new StrException("unable to parse ascii value");
+  return value;
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderPly::RecordReader::read
+(Ply::Element& element, vector<double>& record) {
+  if(_fp==nullptr)
+    throw new StrException("stream is not open");
+  record.clear();
+  bool ascii = (_dataType==Ply::DataType::ASCII);
+  int nProperties = element.getNumberOfProperties();
+  for(int iProperty=0;iProperty<nProperties;iProperty++) {
+    Ply::Element::Property* property = element.getProperty(iProperty);
+    Ply::Element::Property::Type type = property->getPropertyType();
+    if(property->isList()) {
+      double count =
+        (ascii)?_readAscii():_readBinary(property->getListType());
+      if(count<0.0)
+        throw new StrException("negative list count");
+      record.push_back(count);
+      int nList = static_cast<int>(count);
+      for(int i=0;i<nList;i++)
+        record.push_back((ascii)?_readAscii():_readBinary(type));
+    } else {
+      record.push_back((ascii)?_readAscii():_readBinary(type));
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////
 bool LoaderPly::load
 (const char* filename, SceneGraph& wrl) {
@@ -907,7 +1497,12 @@ bool LoaderPly::load
     }
     s->setAppearance(a);
 
+    // the property arrays are moved out of the ply
     IndexedFaceSetPly* ifsPly = new IndexedFaceSetPly(ply,"  ");
+    if(_dropUnusedProperties)
+      ifsPly->dropUnusedProperties();
+    if(_compactCoord)
+      ifsPly->compactCoord();
     s->setGeometry(ifsPly);
 
     wrl.addChild(s);
@@ -47,6 +47,8 @@
 #include <wrl/Ply.hpp>
 #include <wrl/SceneGraph.hpp>
 
+class TokenizerFile;
+
 class LoaderPly : public Loader {
 
 private:
@@ -63,8 +65,59 @@ public:
 
   static bool load(const char* filename, Ply & ply, const string indent="");
 
+  // number of threads used to parse ascii data; 1 parses serially, and
+  // nThreads<=0 uses std::thread::hardware_concurrency()
+  static void setNumberOfThreads(const int nThreads);
+  static int  getNumberOfThreads();
+
+  // quantize the coordinates of the loaded IndexedFaceSetPly to 16
+  // bits per component, see IndexedFaceSet::compactCoord(); the
+  // colors are kept as bytes if Ply::getDefaultCompactColor()==true
+  static void setCompactCoord(const bool value);
+  static bool getCompactCoord();
+
+  // delete the vertex and face properties of the loaded Ply which are
+  // not used by the IndexedFaceSetPly, such as per vertex quality or
+  // confidence values; they are not saved back to a ply file
+  static void setDropUnusedProperties(const bool value);
+  static bool getDropUnusedProperties();
+
+  // streaming interface: only the header is stored in the Ply, and
+  // the data records are read one at a time, so that files larger
+  // than memory can be processed; the Ply must be constructed with
+  // Ply::getDefaultWrlMode()==false
+  //
+  // each record is returned as a sequence of values, one per scalar
+  // property, and the list size followed by the list values for each
+  // list property, in the order in which the properties are declared
+  // in the header
+
+  class RecordReader {
+  public:
+    RecordReader();
+    ~RecordReader();
+    // reads the header; throws StrException* on error
+    void  open(const char* filename, Ply& ply);
+    // reads the next record of the element; the elements must be
+    // read in the order in which they are declared in the header;
+    // throws StrException* on error
+    void  read(Ply::Element& element, vector<double>& record);
+    void  close();
+  private:
+    FILE*          _fp;
+    TokenizerFile* _ftkn;
+    Ply::DataType  _dataType;
+    bool           _swapBytes;
+    double         _readBinary(const Ply::Element::Property::Type type);
+    double         _readAscii();
+  };
+
 private:
 
+  static int           _nThreads;
+  static bool          _compactCoord;
+  static bool          _dropUnusedProperties;
+
   static Ply::DataType systemEndian();
   static bool          sameAsSystemEndian(Ply::DataType fileEndian);
 
@@ -73,6 +126,15 @@ private:
    const Ply::Element::Property::Type propertyType,
    const bool swapBytes,
    void* value);
+
+  // appends nValues values read with a single fread() call, and
+  // swapped in bulk if needed; returns false at the end of the file
+  static bool readBinaryValues
+  (FILE* fp,
+   const Ply::Element::Property::Type propertyType,
+   const bool swapBytes,
+   void* value,
+   const size_t nValues);
   
   static void addAsciiValue
   (const string& token,
@@ -43,7 +43,8 @@
 
 #include <cstdio>
 #include <cstring>
-#include "TokenizerFile.hpp"
+#include <cstdlib>
+#include "InputFile.hpp"
 #include "LoaderStl.hpp"
 #include "StrException.hpp"
 
@@ -81,8 +82,65 @@ IndexedFaceSet* LoaderStl::_initializeSceneGraph
   return ifs;
 }
 
+//////////////////////////////////////////////////////////////////////
+// ascii parsing
+//
+// the file is mapped into memory, and split into one chunk per thread
+// right after "endfacet" keywords; the facets of each chunk are parsed
+// in parallel, and the chunks are concatenated in order
+
+int LoaderStl::_nThreads = 0;
+
+// static
+void LoaderStl::setNumberOfThreads(const int nThreads) {
+  _nThreads = nThreads;
+}
+
+// static
+int LoaderStl::getNumberOfThreads() {
+  return _nThreads;
+}
+
+static inline bool _expectingStl
+(const char*& p, const char* end, const char* keyword, const size_t n) {
+  const char* token = nullptr;
+  return (InputParser::nextToken(p,end,token) &&
+          static_cast<size_t>(p-token)==n && memcmp(token,keyword,n)==0);
+}
+
+static inline bool _getStlFloat(const char*& p, const char* end, float& f) {
+  const char* token = nullptr;
+  return
+    InputParser::nextToken(p,end,token) &&
+    InputParser::parse(token,p,f);
+}
+
+static inline bool _getStlVec3f(const char*& p, const char* end, Vec3f& v) {
+  return
+    _getStlFloat(p,end,v.x) &&
+    _getStlFloat(p,end,v.y) &&
+    _getStlFloat(p,end,v.z);
+}
+
+// returns the position right after the first "endfacet" keyword found
+// in [p,end), or end; begin is the start of the data
+static const char* _findEndfacet
+(const char* begin, const char* p, const char* end) {
+  const char*  keyword = "endfacet";
+  const size_t n       = 8;
+  while(p+n<=end &&
+        (p=static_cast<const char*>(memchr(p,'e',end-p)))!=nullptr) {
+    if(p+n<=end && memcmp(p,keyword,n)==0 &&
+       (p==begin || InputParser::isSeparator(p[-1])) &&
+       (p+n==end || InputParser::isSeparator(p[n])))
+      return p+n;
+    p++;
+  }
+  return end;
+}
+
 bool LoaderStl::_loadFacetAscii
-(TokenizerFile& tkn, Vec3f& n, Vec3f& v1, Vec3f& v2, Vec3f& v3) {
+(const char*& p, const char* end, Vec3f& n, Vec3f& v1, Vec3f& v2, Vec3f& v3) {
 
   // - parse one facet :
   //
@@ -97,28 +155,110 @@ bool LoaderStl::_loadFacetAscii
   // - return true if successful, false if not
 
   // facet normal ni nj nk
-  if(tkn.expecting("facet")==false) return false;
-  if(tkn.expecting("normal")==false) return false;
-  if(tkn.getVec3f(n)==false) return false;
+  if(_expectingStl(p,end,"facet",5)==false) return false;
+  if(_expectingStl(p,end,"normal",6)==false) return false;
+  if(_getStlVec3f(p,end,n)==false) return false;
   //   outer loop
-  if(tkn.expecting("outer")==false) return false;
-  if(tkn.expecting("loop")==false) return false;
+  if(_expectingStl(p,end,"outer",5)==false) return false;
+  if(_expectingStl(p,end,"loop",4)==false) return false;
   //     vertex v1x v1y v1z
-  if(tkn.expecting("vertex")==false) return false;
-  if(tkn.getVec3f(v1)==false) return false;
+  if(_expectingStl(p,end,"vertex",6)==false) return false;
+  if(_getStlVec3f(p,end,v1)==false) return false;
   //     vertex v2x v2y v2z
-  if(tkn.expecting("vertex")==false) return false;
-  if(tkn.getVec3f(v2)==false) return false;
+  if(_expectingStl(p,end,"vertex",6)==false) return false;
+  if(_getStlVec3f(p,end,v2)==false) return false;
   //     vertex v3x v3y v3z
-  if(tkn.expecting("vertex")==false) return false;
-  if(tkn.getVec3f(v3)==false) return false;
+  if(_expectingStl(p,end,"vertex",6)==false) return false;
+  if(_getStlVec3f(p,end,v3)==false) return false;
   //   endloop
-  if(tkn.expecting("endloop")==false) return false;
+  if(_expectingStl(p,end,"endloop",7)==false) return false;
   // endfacet
-  if(tkn.expecting("endfacet")==false) return false;
+  if(_expectingStl(p,end,"endfacet",8)==false) return false;
   return true;
 }
 
+// the facets parsed from one chunk of the file
+class StlChunk {
+public:
+  const char*   begin;
+  const char*   end;
+  const char*   next;   // where parsing stopped
+  bool          failed; // a facet could not be parsed
+  vector<float> coord;
+  vector<float> normal;
+};
+
+void LoaderStl::_loadFacetsAscii
+(const char* p, const char* end, vector<float>& coord, vector<float>& normal) {
+
+  int nThreads = InputParser::numberOfThreads(_nThreads);
+  // about 200 bytes per facet; small files are parsed serially
+  if(static_cast<size_t>(end-p)<(static_cast<size_t>(nThreads)<<16))
+    nThreads = 1;
+
+  // chunk boundaries right after "endfacet" keywords
+  vector<StlChunk> chunk(static_cast<size_t>(nThreads));
+  const size_t size = static_cast<size_t>(end-p);
+  chunk[0].begin = p;
+  for(int iChunk=1;iChunk<nThreads;iChunk++) {
+    const char* q = p+(size/nThreads)*iChunk;
+    if(q<chunk[iChunk-1].begin) q = chunk[iChunk-1].begin;
+    chunk[iChunk].begin = chunk[iChunk-1].end = _findEndfacet(p,q,end);
+  }
+  chunk[nThreads-1].end = end;
+
+  auto parse = [&](StlChunk& c) {
+    Vec3f n,v1,v2,v3;
+    const char* q = c.begin;
+    c.failed = false;
+    c.coord.reserve(static_cast<size_t>(c.end-c.begin)/20);
+    c.normal.reserve(static_cast<size_t>(c.end-c.begin)/60);
+    while(q<c.end) {
+      if(_loadFacetAscii(q,end,n,v1,v2,v3)==false) {
+        c.failed = true;
+        break;
+      }
+      c.normal.insert(c.normal.end(),&n.x,&n.x+3);
+      c.coord.insert(c.coord.end(),&v1.x,&v1.x+3);
+      c.coord.insert(c.coord.end(),&v2.x,&v2.x+3);
+      c.coord.insert(c.coord.end(),&v3.x,&v3.x+3);
+    }
+    c.next = q;
+  };
+
+  InputParser::runChunks(nThreads,nThreads,[&](const int iChunk) {
+      parse(chunk[iChunk]);
+    });
+
+  // as in a serial parse, which stops at the first facet which cannot
+  // be parsed, such as "endsolid"
+  size_t nCoord = coord.size(), nNormal = normal.size();
+  for(StlChunk& c : chunk) {
+    nCoord  += c.coord.size();
+    nNormal += c.normal.size();
+  }
+  coord.reserve(nCoord);
+  normal.reserve(nNormal);
+  for(int iChunk=0;iChunk<nThreads;iChunk++) {
+    StlChunk& c = chunk[iChunk];
+    coord.insert(coord.end(),c.coord.begin(),c.coord.end());
+    normal.insert(normal.end(),c.normal.begin(),c.normal.end());
+    vector<float>().swap(c.coord);
+    vector<float>().swap(c.normal);
+    if(c.failed) break;
+    if(c.next!=c.end) {
+      // "endfacet" was found in a comment; parse the rest serially
+      StlChunk rest;
+      rest.begin = c.next;
+      rest.end   = end;
+      parse(rest);
+      coord.insert(coord.end(),rest.coord.begin(),rest.coord.end());
+      normal.insert(normal.end(),rest.normal.begin(),rest.normal.end());
+      break;
+    }
+  }
+}
+
 bool LoaderStl::_loadFacetBinary
 (FILE* fp, Vec3f& n, Vec3f& v1, Vec3f& v2, Vec3f& v3, uint16_t* abc) {
 
@@ -148,7 +288,7 @@ bool LoaderStl::load(const char* filename, SceneGraph& wrl) {
     char header[80];
     memset(header,0x00,80);
     // determine if file is ascii or binary
-    fp = fopen(filename,"rb");
+    fp = InputFile::open(filename,"rb");
     if(fp==(FILE*)0)
       throw new StrException("unable to open file for binary read");
     if(fread(header,1,5,fp)<5)
@@ -201,21 +341,25 @@ bool LoaderStl::load(const char* filename, SceneGraph& wrl) {
 
       fclose(fp);
     } else /* if(ascii) */ {
-      // close the binary file and reopen it
+      // close the binary file, reopen it, and map it into memory
       fclose(fp);
-      fp = fopen(filename,"r");
+      fp = InputFile::open(filename,"rb");
       if(fp==(FILE*)0)
         throw new StrException("unable to open ASCII STL file");
-        
-      // use the io/TokenizerFile class to parse the input ascii file
-      TokenizerFile tkn(fp);
+      InputData input(fp);
+      fclose(fp);
+      fp = (FILE*)0;
+      const char* p     = input.data();
+      const char* end   = p+input.size();
+      const char* token = nullptr;
+
       // first token should be "solid"
-      if(tkn.expecting("solid")==false)
+      if(_expectingStl(p,end,"solid",5)==false)
         throw new StrException("not an ASCII STL file");
       // second token should be the solid name
-      if(tkn.get()==false)
+      if(InputParser::nextToken(p,end,token)==false)
         throw new StrException("unable to get solid name");
-      string stlName = tkn; // second token should be the solid name
+      string stlName(token,p); // second token should be the solid name
 
       // create the scene graph structure :
       IndexedFaceSet* ifs = _initializeSceneGraph(filename,wrl);
@@ -226,34 +370,19 @@ bool LoaderStl::load(const char* filename, SceneGraph& wrl) {
       // set the normalPerVertex variable to false (i.e., normals per face)  
       ifs->setNormalPerVertex(false);
 
-      int   iV0,iV1,iV2;
-      Vec3f n,v1,v2,v3;
-      while(_loadFacetAscii(tkn,n,v1,v2,v3)) {
-        normal.push_back(n[0]);
-        normal.push_back(n[1]);
-        normal.push_back(n[2]);
-        iV0 = static_cast<int>(coord.size()/3);
-        coord.push_back(v1[0]);
-        coord.push_back(v1[1]);
-        coord.push_back(v1[2]);
-        iV1 = static_cast<int>(coord.size()/3);
-        coord.push_back(v2[0]);
-        coord.push_back(v2[1]);
-        coord.push_back(v2[2]);
-        iV2 = static_cast<int>(coord.size()/3);
-        coord.push_back(v3[0]);
-        coord.push_back(v3[1]);
-        coord.push_back(v3[2]);
-        coordIndex.push_back(iV0);
-        coordIndex.push_back(iV1);
-        coordIndex.push_back(iV2);
-        coordIndex.push_back(-1);
+      _loadFacetsAscii(p,end,coord,normal);
+
+      // three vertices per facet
+      int nV = static_cast<int>(coord.size()/3);
+      coordIndex.resize(static_cast<size_t>(4*(nV/3)));
+      for(int iV=0,i=0;iV<nV;iV+=3) {
+        coordIndex[i++] = iV;
+        coordIndex[i++] = iV+1;
+        coordIndex[i++] = iV+2;
+        coordIndex[i++] = -1;
       }
 
       success = true;
-
-      // close the file (this statement may not be reached)
-      fclose(fp);
     }
  
   } catch(StrException* e) { 
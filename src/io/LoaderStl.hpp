@@ -37,8 +37,8 @@
 #ifndef _LOADER_STL_HPP_
 #define _LOADER_STL_HPP_
 
+#include <vector>
 #include "Loader.hpp"
-#include "TokenizerFile.hpp"
 
 #include "wrl/Node.hpp"
 #include "wrl/IndexedFaceSet.hpp"
@@ -57,12 +57,24 @@ public:
   bool  load(const char* filename, SceneGraph& wrl);
   const char* ext() const { return _ext; }
 
+  // number of threads used to parse ascii files; 1 parses serially,
+  // and nThreads<=0 uses std::thread::hardware_concurrency()
+  static void setNumberOfThreads(const int nThreads);
+  static int  getNumberOfThreads();
+
 private:
 
+  static int _nThreads;
+
   IndexedFaceSet* _initializeSceneGraph(const char* filename, SceneGraph& wrl);
 
-  bool _loadFacetAscii
-  (TokenizerFile& tkn, Vec3f& n, Vec3f& v1, Vec3f& v2, Vec3f& v3);
+  static bool _loadFacetAscii
+  (const char*& p, const char* end, Vec3f& n, Vec3f& v1, Vec3f& v2, Vec3f& v3);
+
+  // appends three vertices to coord, and a normal to normal, for each
+  // facet found in [p,end)
+  static void _loadFacetsAscii
+  (const char* p, const char* end, vector<float>& coord, vector<float>& normal);
 
   bool _loadFacetBinary
   (FILE* fp, Vec3f& n, Vec3f& v1, Vec3f& v2, Vec3f& v3, uint16_t* abc);
@@ -0,0 +1,514 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-04 11:08:15 taubin>
+//------------------------------------------------------------------------
+//
+// LoaderWrb.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <cstring>
+#include "LoaderWrb.hpp"
+#include "LoaderWrl.hpp"
+#include "StrException.hpp"
+
+const char* LoaderWrb::_ext = "wrb";
+
+string LoaderWrb::_cacheDir = "";
+
+const char  LoaderWrb::FILE_SIGNATURE[8] = { 'D','G','P','-','W','R','B','\0' };
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool LoaderWrb::hashFile
+(const char* filename, uint64_t& size, uint64_t& hash) {
+  size = 0;
+  hash = 14695981039346656037ULL; // FNV-1a offset basis
+  if(filename==(char*)0) return false;
+  FILE* fp = fopen(filename,"rb");
+  if(fp==(FILE*)0) return false;
+  vector<unsigned char> buffer(1<<20);
+  size_t i,n;
+  while((n=fread(&buffer[0],1,buffer.size(),fp))>0) {
+    for(i=0;i<n;i++) {
+      hash ^= buffer[i];
+      hash *= 1099511628211ULL; // FNV-1a prime
+    }
+    size += n;
+  }
+  bool success = (ferror(fp)==0);
+  fclose(fp);
+  return success;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+void LoaderWrb::setCacheDirectory(const string& dir) {
+  _cacheDir = dir;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+string LoaderWrb::getCacheDirectory() {
+  return _cacheDir;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+string LoaderWrb::cacheFilename(const char* filename) {
+  if(filename==(char*)0 || _cacheDir=="") return string("");
+  string path = LoaderWrl::absolutePath(filename);
+  uint64_t hash = 14695981039346656037ULL; // FNV-1a offset basis
+  for(size_t i=0;i<path.size();i++) {
+    hash ^= (unsigned char)path[i];
+    hash *= 1099511628211ULL; // FNV-1a prime
+  }
+  char str[24];
+  snprintf(str,sizeof(str),"-%016llx.",(unsigned long long)hash);
+  string dir = _cacheDir;
+  if(dir.find_last_of("/\\")!=dir.size()-1) dir += "/";
+  return dir+path.substr(path.find_last_of("/\\")+1)+str+_ext;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool LoaderWrb::readHeader(FILE* fp, uint64_t& size, uint64_t& hash) {
+  char     signature[8];
+  uint32_t version,byteOrder;
+  if(fread(signature,1,8,fp)!=8) return false;
+  if(memcmp(signature,FILE_SIGNATURE,8)!=0) return false;
+  if(fread(&version,sizeof(uint32_t),1,fp)!=1 || version!=FILE_VERSION)
+    return false;
+  if(fread(&byteOrder,sizeof(uint32_t),1,fp)!=1 || byteOrder!=FILE_BYTE_ORDER)
+    return false;
+  if(fread(&size,sizeof(uint64_t),1,fp)!=1) return false;
+  if(fread(&hash,sizeof(uint64_t),1,fp)!=1) return false;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool LoaderWrb::isCacheValid(const char* filename) {
+  string cache = cacheFilename(filename);
+  if(cache=="") return false;
+  FILE* fp = fopen(cache.c_str(),"rb");
+  if(fp==(FILE*)0) return false;
+  uint64_t cacheSize,cacheHash,size,hash;
+  vector<string>   inlinedPath;
+  vector<uint64_t> inlinedSize,inlinedHash;
+  bool success = readHeader(fp,cacheSize,cacheHash);
+  if(success) {
+    LoaderWrb loader;
+    fseek(fp,0,SEEK_END);
+    loader._fileSize = (uint64_t)ftell(fp);
+    fseek(fp,32,SEEK_SET);
+    try {
+      loader.loadInlined(fp,inlinedPath,inlinedSize,inlinedHash);
+    } catch(StrException* e) {
+      delete e;
+      success = false;
+    }
+  }
+  fclose(fp);
+  if(success==false || cacheSize==0) return false;
+  // hashing the files is much faster than parsing them
+  if(hashFile(filename,size,hash)==false) return false;
+  if(size!=cacheSize || hash!=cacheHash) return false;
+  string dir = LoaderWrl::dirName(filename);
+  for(size_t i=0;i<inlinedPath.size();i++) {
+    string path = LoaderWrl::relativeUrl(inlinedPath[i],dir,"");
+    if(hashFile(path.c_str(),size,hash)==false) return false;
+    if(size!=inlinedSize[i] || hash!=inlinedHash[i]) return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadInlined
+(FILE* fp, vector<string>& path, vector<uint64_t>& size, vector<uint64_t>& hash) {
+  uint64_t nInlined = 0;
+  loadBlock(fp,&nInlined,sizeof(uint64_t));
+  if(nInlined>_fileSize) throw new StrException("corrupted number of inlined files");
+  path.resize((size_t)nInlined);
+  size.resize((size_t)nInlined);
+  hash.resize((size_t)nInlined);
+  uint64_t value[2]; // size, hash
+  for(uint64_t i=0;i<nInlined;i++) {
+    loadString(fp,path[i]);
+    loadBlock(fp,value,sizeof(value));
+    size[i] = value[0];
+    hash[i] = value[1];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadBlock(FILE* fp, void* data, const size_t nBytes) {
+  if(nBytes>0 && fread(data,1,nBytes,fp)!=nBytes)
+    throw new StrException("unexpected end of file");
+  char pad[8];
+  size_t nPad = (8-nBytes%8)%8;
+  if(nPad>0 && fread(pad,1,nPad,fp)!=nPad)
+    throw new StrException("unexpected end of file");
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadString(FILE* fp, string& str) {
+  uint64_t n = 0;
+  loadBlock(fp,&n,sizeof(uint64_t));
+  if(n>_fileSize) throw new StrException("corrupted string length");
+  str.resize((size_t)n);
+  if(n>0) loadBlock(fp,&str[0],(size_t)n);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadVecFloat(FILE* fp, vector<float>& vec) {
+  uint64_t n = 0;
+  loadBlock(fp,&n,sizeof(uint64_t));
+  if(n*sizeof(float)>_fileSize) throw new StrException("corrupted array length");
+  vec.resize((size_t)n);
+  if(n>0) loadBlock(fp,&vec[0],(size_t)n*sizeof(float));
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadVecInt(FILE* fp, vector<int>& vec) {
+  uint64_t n = 0;
+  loadBlock(fp,&n,sizeof(uint64_t));
+  if(n*sizeof(int)>_fileSize) throw new StrException("corrupted array length");
+  vec.resize((size_t)n);
+  if(n>0) loadBlock(fp,&vec[0],(size_t)n*sizeof(int));
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadFloats(FILE* fp, float* value, const int n) {
+  loadBlock(fp,value,n*sizeof(float));
+}
+
+//////////////////////////////////////////////////////////////////////
+bool LoaderWrb::loadBool(FILE* fp) {
+  unsigned char value = 0;
+  loadBlock(fp,&value,1);
+  return (value!=0);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadNode(FILE* fp, Node*& node) {
+  node = (Node*)0;
+  uint32_t header[2]; // type, show
+  loadBlock(fp,header,sizeof(header));
+  if(header[0]==NODE_NULL) return;
+  if(header[0]==NODE_USE) {
+    uint64_t index = 0;
+    loadBlock(fp,&index,sizeof(uint64_t));
+    if(index>=_loaded.size()) throw new StrException("USE of undefined node");
+    node = _loaded[(size_t)index];
+    return;
+  }
+  string name;
+  loadString(fp,name);
+  try {
+    switch(header[0]) {
+    case NODE_GROUP:
+      node = new Group();
+      loadGroup(fp,*((Group*)node));
+      break;
+    case NODE_TRANSFORM:
+      node = new Transform();
+      loadTransform(fp,*((Transform*)node));
+      break;
+    case NODE_INLINE:
+      node = new Inline();
+      loadInline(fp,*((Inline*)node));
+      break;
+    case NODE_SHAPE:
+      node = new Shape();
+      loadShape(fp,*((Shape*)node));
+      break;
+    case NODE_APPEARANCE:
+      node = new Appearance();
+      loadAppearance(fp,*((Appearance*)node));
+      break;
+    case NODE_MATERIAL:
+      node = new Material();
+      loadMaterial(fp,*((Material*)node));
+      break;
+    case NODE_IMAGE_TEXTURE:
+      node = new ImageTexture();
+      loadImageTexture(fp,*((ImageTexture*)node));
+      break;
+    case NODE_PIXEL_TEXTURE:
+      node = new PixelTexture();
+      loadPixelTexture(fp,*((PixelTexture*)node));
+      break;
+    case NODE_INDEXED_FACE_SET:
+      node = new IndexedFaceSet();
+      loadIndexedFaceSet(fp,*((IndexedFaceSet*)node));
+      break;
+    case NODE_INDEXED_LINE_SET:
+      node = new IndexedLineSet();
+      loadIndexedLineSet(fp,*((IndexedLineSet*)node));
+      break;
+    default:
+      throw new StrException("unknown node type");
+    }
+  } catch(StrException* e) {
+    if(node!=(Node*)0) delete node;
+    node = (Node*)0;
+    throw e;
+  }
+  node->setName(name);
+  node->setShow(header[1]!=0);
+  // numbered after its descendants, as in SaverWrb::saveNode()
+  _loaded.push_back(node);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadGroup(FILE* fp, Group& group) {
+  float bbox[6]; // center, size
+  loadFloats(fp,bbox,6);
+  Vec3f center(bbox[0],bbox[1],bbox[2]);
+  Vec3f size(bbox[3],bbox[4],bbox[5]);
+  group.setBBoxCenter(center);
+  group.setBBoxSize(size);
+  uint64_t nChildren = 0;
+  loadBlock(fp,&nChildren,sizeof(uint64_t));
+  if(nChildren>_fileSize) throw new StrException("corrupted number of children");
+  for(uint64_t i=0;i<nChildren;i++) {
+    Node* child = (Node*)0;
+    loadNode(fp,child);
+    // the content of the Inline nodes is owned by them
+    if(child!=(Node*)0 && _content.find(child)!=_content.end())
+      throw new StrException("corrupted Inline content");
+    if(child!=(Node*)0) group.addChild(child);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadTransform(FILE* fp, Transform& transform) {
+  // center, rotation, scale, scaleOrientation, translation
+  float value[17];
+  loadFloats(fp,value,17);
+  Vec3f center(value[0],value[1],value[2]);
+  Vec4f rotation(value[3],value[4],value[5],value[6]);
+  Vec3f scale(value[7],value[8],value[9]);
+  Vec4f scaleOrientation(value[10],value[11],value[12],value[13]);
+  Vec3f translation(value[14],value[15],value[16]);
+  transform.setCenter(center);
+  transform.setRotation(rotation);
+  transform.setScale(scale);
+  transform.setScaleOrientation(scaleOrientation);
+  transform.setTranslation(translation);
+  loadGroup(fp,transform);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadInline(FILE* fp, Inline& inl) {
+  float bbox[6]; // center, size
+  loadFloats(fp,bbox,6);
+  Vec3f center(bbox[0],bbox[1],bbox[2]);
+  Vec3f size(bbox[3],bbox[4],bbox[5]);
+  inl.setBBoxCenter(center);
+  inl.setBBoxSize(size);
+  uint64_t nUrl = 0;
+  loadBlock(fp,&nUrl,sizeof(uint64_t));
+  if(nUrl>_fileSize) throw new StrException("corrupted number of urls");
+  vector<string>& url = inl.getUrl();
+  url.resize((size_t)nUrl);
+  for(uint64_t i=0;i<nUrl;i++)
+    loadString(fp,url[i]);
+  string path;
+  loadString(fp,path);
+  if(path!="")
+    path = LoaderWrl::normalPath(LoaderWrl::relativeUrl(path,_dir,""));
+  inl.setPath(path);
+  Node* node = (Node*)0;
+  loadNode(fp,node);
+  if(node==(Node*)0) return;
+  map<Node*,shared_ptr<Group> >::iterator i = _content.find(node);
+  if(i!=_content.end()) {
+    inl.setContent(i->second);
+  } else if(node->isGroup() && node->getParent()==(Node*)0) {
+    // a Group which is not a child of another node yet
+    shared_ptr<Group> content((Group*)node);
+    _content[node] = content;
+    inl.setContent(content);
+  } else {
+    throw new StrException("corrupted Inline content");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadShape(FILE* fp, Shape& shape) {
+  Node* node = (Node*)0;
+  loadNode(fp,node);
+  if(node!=(Node*)0) shape.setAppearance(node);
+  loadNode(fp,node);
+  if(node!=(Node*)0) shape.setGeometry(node);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadAppearance(FILE* fp, Appearance& appearance) {
+  Node* node = (Node*)0;
+  loadNode(fp,node);
+  if(node!=(Node*)0) appearance.setMaterial(node);
+  loadNode(fp,node);
+  if(node!=(Node*)0) appearance.setTexture(node);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadMaterial(FILE* fp, Material& material) {
+  // ambientIntensity, diffuseColor, emissiveColor, shininess,
+  // specularColor, transparency
+  float value[12];
+  loadFloats(fp,value,12);
+  Color diffuseColor(value[1],value[2],value[3]);
+  Color emissiveColor(value[4],value[5],value[6]);
+  Color specularColor(value[8],value[9],value[10]);
+  material.setAmbientIntensity(value[0]);
+  material.setDiffuseColor(diffuseColor);
+  material.setEmissiveColor(emissiveColor);
+  material.setShininess(value[7]);
+  material.setSpecularColor(specularColor);
+  material.setTransparency(value[11]);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadPixelTexture(FILE* fp, PixelTexture& pixelTexture) {
+  pixelTexture.setRepeatS(loadBool(fp));
+  pixelTexture.setRepeatT(loadBool(fp));
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadImageTexture(FILE* fp, ImageTexture& imageTexture) {
+  loadPixelTexture(fp,imageTexture);
+  uint64_t nUrl = 0;
+  loadBlock(fp,&nUrl,sizeof(uint64_t));
+  if(nUrl>_fileSize) throw new StrException("corrupted number of urls");
+  vector<string>& url = imageTexture.getUrl();
+  url.resize((size_t)nUrl);
+  for(uint64_t i=0;i<nUrl;i++)
+    loadString(fp,url[i]);
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadIndexedFaceSet(FILE* fp, IndexedFaceSet& ifs) {
+  ifs.getCcw()             = loadBool(fp);
+  ifs.getConvex()          = loadBool(fp);
+  ifs.getSolid()           = loadBool(fp);
+  ifs.getNormalPerVertex() = loadBool(fp);
+  ifs.getColorPerVertex()  = loadBool(fp);
+  loadFloats(fp,&(ifs.getCreaseangle()),1);
+  loadVecFloat(fp,ifs.getCoord());
+  loadVecInt(fp,ifs.getCoordIndex());
+  loadVecFloat(fp,ifs.getNormal());
+  loadVecInt(fp,ifs.getNormalIndex());
+  loadVecFloat(fp,ifs.getColor());
+  loadVecInt(fp,ifs.getColorIndex());
+  loadVecFloat(fp,ifs.getTexCoord());
+  loadVecInt(fp,ifs.getTexCoordIndex());
+}
+
+//////////////////////////////////////////////////////////////////////
+void LoaderWrb::loadIndexedLineSet(FILE* fp, IndexedLineSet& ils) {
+  ils.getColorPerVertex() = loadBool(fp);
+  loadVecFloat(fp,ils.getCoord());
+  loadVecInt(fp,ils.getCoordIndex());
+  loadVecFloat(fp,ils.getColor());
+  loadVecInt(fp,ils.getColorIndex());
+}
+
+//////////////////////////////////////////////////////////////////////
+bool LoaderWrb::load(const char* filename, SceneGraph& wrl) {
+  bool success = false;
+
+  FILE* fp = (FILE*)0;
+  try {
+
+    // open the file
+    if(filename==(char*)0) throw new StrException("filename==null");
+    fp = fopen(filename,"rb");
+    if(fp==(FILE*)0) throw new StrException("fp==(FILE*)0");
+    setvbuf(fp,(char*)0,_IOFBF,1<<20);
+
+    fseek(fp,0,SEEK_END);
+    _fileSize = (uint64_t)ftell(fp);
+    fseek(fp,0,SEEK_SET);
+
+    _loaded.clear();
+    _content.clear();
+    _dir = LoaderWrl::dirName((_cacheSource!="")?_cacheSource:filename);
+
+    // clear the container
+    wrl.clear();
+    wrl.setUrl((_cacheSource!="")?_cacheSource.c_str():filename);
+
+    uint64_t size,hash;
+    if(readHeader(fp,size,hash)==false)
+      throw new StrException("not a wrb file, or different byte order");
+    // the inlined files are only checked by isCacheValid()
+    vector<string>   inlinedPath;
+    vector<uint64_t> inlinedSize,inlinedHash;
+    loadInlined(fp,inlinedPath,inlinedSize,inlinedHash);
+
+    // the root node is stored as a Group
+    uint32_t header[2];
+    string   name;
+    loadBlock(fp,header,sizeof(header));
+    if(header[0]!=NODE_GROUP) throw new StrException("root node is not a Group");
+    loadString(fp,name);
+    loadGroup(fp,wrl);
+
+    fclose(fp);
+    _loaded.clear();
+    _content.clear();
+    success = true;
+
+  } catch(StrException* e) {
+
+    if(fp!=(FILE*)0) fclose(fp);
+    fprintf(stderr,"ERROR | %s\n",e->what());
+    delete e;
+    _loaded.clear();
+    _content.clear();
+    wrl.clear();
+    wrl.setUrl("");
+
+  }
+
+  return success;
+}
+
+//////////////////////////////////////////////////////////////////////
+bool LoaderWrb::loadCache(const char* filename, SceneGraph& wrl) {
+  string cache = cacheFilename(filename);
+  if(cache=="") return false;
+  _cacheSource = filename;
+  bool success = load(cache.c_str(),wrl);
+  _cacheSource = "";
+  return success;
+}
@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-04 11:08:15 taubin>
+//------------------------------------------------------------------------
+//
+// LoaderWrb.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _LOADER_WRB_HPP_
+#define _LOADER_WRB_HPP_
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <map>
+#include "Loader.hpp"
+
+#include <wrl/Transform.hpp>
+#include <wrl/Inline.hpp>
+#include <wrl/Shape.hpp>
+#include <wrl/Appearance.hpp>
+#include <wrl/Material.hpp>
+#include <wrl/ImageTexture.hpp>
+#include <wrl/IndexedFaceSet.hpp>
+#include <wrl/IndexedLineSet.hpp>
+
+// Binary SceneGraph container, used as a cache of parsed files
+//
+// - a 32 byte header: the "DGP-WRB\0" signature, format version,
+//   byte order mark, and the size and hash of the source file the
+//   SceneGraph was parsed from (0 if unknown)
+// - the number of files inlined in the source file, followed by the
+//   path, size and hash of each; a relative path is relative to the
+//   directory of the source file
+// - followed by the nodes in depth first order; every node starts
+//   with its type and show flag, and its name
+// - nodes are numbered in the order in which they are first written;
+//   a node shared through DEF/USE is written only once, and every
+//   other occurrence is stored as a NODE_USE record holding its number
+// - an Inline node stores its urls, the path of the file its content
+//   was loaded from, and its content, which is shared by all the
+//   Inline nodes referencing the same file; the urls are relative to
+//   the directory of the wrb file, as in a wrl file, except in the
+//   content of other Inline nodes, and the paths are relative to the
+//   directory of the wrb file
+// - every string and array is stored as a 64 bit length followed by
+//   the data, padded with zeros to a multiple of 8 bytes, so that
+//   every block is aligned, and each array is adopted by the
+//   IndexedFaceSet and IndexedLineSet nodes with a single read and no
+//   parsing
+//
+// the data is stored in the byte order of the machine which wrote the
+// file; files written with a different byte order are rejected, and
+// should be regenerated from the source file
+
+class LoaderWrb : public Loader {
+
+private:
+
+  const static char* _ext;
+
+  // directory where the cache files are stored, or empty if the
+  // SceneGraphs are not cached
+  static string _cacheDir;
+
+  // used to reject corrupted array lengths before allocating memory
+  uint64_t _fileSize;
+
+  // nodes in the order in which they were loaded, referenced by the
+  // NODE_USE records
+  vector<Node*> _loaded;
+
+  // directory of the file, the paths of the Inline nodes are relative to
+  string _dir;
+
+  // source file of the cache loaded by loadCache(); the paths of a
+  // cache are relative to the directory of its source file
+  string _cacheSource;
+
+  // content of the Inline nodes, shared by the NODE_USE records
+  map<Node*,shared_ptr<Group> > _content;
+
+public:
+
+  enum NodeType {
+    NODE_NULL = 0,
+    NODE_GROUP,
+    NODE_TRANSFORM,
+    NODE_SHAPE,
+    NODE_APPEARANCE,
+    NODE_MATERIAL,
+    NODE_IMAGE_TEXTURE,
+    NODE_PIXEL_TEXTURE,
+    NODE_INDEXED_FACE_SET,
+    NODE_INDEXED_LINE_SET,
+    NODE_USE,
+    NODE_INLINE
+  };
+
+  static const char     FILE_SIGNATURE[8];
+  static const uint32_t FILE_VERSION    = 3;
+  static const uint32_t FILE_BYTE_ORDER = 0x01020304;
+
+  LoaderWrb():_fileSize(0) {};
+  ~LoaderWrb() {};
+
+  bool  load(const char* filename, SceneGraph& wrl);
+  const char* ext() const { return _ext; }
+
+  // 64 bit FNV-1a hash of the file contents; returns false if the
+  // file cannot be read
+  static bool   hashFile(const char* filename, uint64_t& size, uint64_t& hash);
+
+  // directory where the cache files are stored; caching is disabled
+  // until it is set, and an empty dir disables it again
+  static void   setCacheDirectory(const string& dir);
+  static string getCacheDirectory();
+
+  // name of the cache file of a source file in the cache directory,
+  // made unique by the hash of the absolute path of the source file;
+  // empty if caching is disabled
+  static string cacheFilename(const char* filename);
+
+  // true if the cache file exists, and was written from a source file
+  // with the same size and contents as the current one, and from the
+  // same contents of the files inlined in it
+  static bool   isCacheValid(const char* filename);
+
+  // loads the SceneGraph from the cache of filename, as if it had been
+  // loaded from filename
+  bool  loadCache(const char* filename, SceneGraph& wrl);
+
+private:
+
+  static bool   readHeader(FILE* fp, uint64_t& size, uint64_t& hash);
+
+  void  loadInlined
+  (FILE* fp, vector<string>& path, vector<uint64_t>& size, vector<uint64_t>& hash);
+
+  void  loadNode(FILE* fp, Node*& node);
+  void  loadGroup(FILE* fp, Group& group);
+  void  loadTransform(FILE* fp, Transform& transform);
+  void  loadInline(FILE* fp, Inline& inl);
+  void  loadShape(FILE* fp, Shape& shape);
+  void  loadAppearance(FILE* fp, Appearance& appearance);
+  void  loadMaterial(FILE* fp, Material& material);
+  void  loadPixelTexture(FILE* fp, PixelTexture& pixelTexture);
+  void  loadImageTexture(FILE* fp, ImageTexture& imageTexture);
+  void  loadIndexedFaceSet(FILE* fp, IndexedFaceSet& ifs);
+  void  loadIndexedLineSet(FILE* fp, IndexedLineSet& ils);
+  void  loadBlock(FILE* fp, void* data, const size_t nBytes);
+  void  loadString(FILE* fp, string& str);
+  void  loadVecFloat(FILE* fp, vector<float>& vec);
+  void  loadVecInt(FILE* fp, vector<int>& vec);
+  void  loadFloats(FILE* fp, float* value, const int n);
+  bool  loadBool(FILE* fp);
+};
+
+#endif /* _LOADER_WRB_HPP_ */
@@ -33,7 +33,19 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdio.h>
-#include "TokenizerFile.hpp"
+#include <cstring>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef _WIN32
+#include <direct.h>
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
+#include "TokenizerBuffer.hpp"
+#include "InputFile.hpp"
 #include "LoaderWrl.hpp"
 #include "StrException.hpp"
 
@@ -41,7 +53,24 @@
 
 const char* LoaderWrl::_ext = "wrl";
 
-bool LoaderWrl::loadSceneGraph(TokenizerFile& tkn, SceneGraph& wrl) {
+// names the node, and makes it available to later USE statements; a
+// name defined again refers to the last node defined with it
+void LoaderWrl::_define(const string& name, Node* node) {
+  node->setName(name);
+  if(name!="")
+    _def[name] = node;
+}
+
+// called after the "USE" token; returns the node defined with the name
+Node* LoaderWrl::_use(TokenizerBuffer& tkn) {
+  tkn.get("missing token after USE");
+  map<string,Node*>::iterator i = _def.find(tkn);
+  if(i==_def.end())
+    throw new StrException("USE of undefined node "+tkn);
+  return i->second;
+}
+
+bool LoaderWrl::loadSceneGraph(TokenizerBuffer& tkn, Group& group) {
 
   string name    = "";
   bool   success = false;
@@ -51,22 +80,33 @@ bool LoaderWrl::loadSceneGraph(TokenizerFile& tkn, SceneGraph& wrl) {
       name = tkn;
     } else if(tkn.equals("Group")) {
       Group* g = new Group();
-      wrl.addChild(g);
+      group.addChild(g);
       loadGroup(tkn,*g);
-      g->setName(name);
+      _define(name,g);
       name = "";
     } else if(tkn.equals("Transform")) {
       Transform* t = new Transform();
-      wrl.addChild(t);
+      group.addChild(t);
       loadTransform(tkn,*t);
-      t->setName(name);
+      _define(name,t);
       name = "";
     } else if(tkn.equals("Shape")) {
       Shape* s = new Shape();
-      wrl.addChild(s);
+      group.addChild(s);
       loadShape(tkn,*s);
-      s->setName(name);
+      _define(name,s);
       name = "";
+    } else if(tkn.equals("Inline")) {
+      Inline* n = new Inline();
+      group.addChild(n);
+      loadInline(tkn,*n);
+      _define(name,n);
+      name = "";
+    } else if(tkn.equals("USE")) {
+      Node* node = _use(tkn);
+      if(node->isShape()==false && node->isGroup()==false)
+        throw new StrException("USE of a node which cannot be a child");
+      group.addChild(node);
     } else if(tkn.equals("")) {
       break;
     } else {
@@ -78,7 +118,7 @@ bool LoaderWrl::loadSceneGraph(TokenizerFile& tkn, SceneGraph& wrl) {
   return success;
 }
 
-bool LoaderWrl::loadGroup(TokenizerFile& tkn, Group& group) {
+bool LoaderWrl::loadGroup(TokenizerBuffer& tkn, Group& group) {
 
   // Group {
   //   MFNode children    []
@@ -110,7 +150,7 @@ bool LoaderWrl::loadGroup(TokenizerFile& tkn, Group& group) {
   return success;
 }
 
-bool LoaderWrl::loadTransform(TokenizerFile& tkn, Transform& transform) {
+bool LoaderWrl::loadTransform(TokenizerBuffer& tkn, Transform& transform) {
 
   // Transform {
   //   MFNode     children          []
@@ -174,7 +214,7 @@ bool LoaderWrl::loadTransform(TokenizerFile& tkn, Transform& transform) {
   return success;
 }
 
-bool LoaderWrl::loadChildren(TokenizerFile& tkn, Group& group) {
+bool LoaderWrl::loadChildren(TokenizerBuffer& tkn, Group& group) {
   string name    = "";
   bool   success = false;
   if(tkn.expecting("[")==false) throw new StrException("expecting \"[\"");
@@ -186,20 +226,31 @@ bool LoaderWrl::loadChildren(TokenizerFile& tkn, Group& group) {
       Group* g = new Group();
       group.addChild(g);
       loadGroup(tkn,*g);
-      g->setName(name);
+      _define(name,g);
       name = "";
     } else if(tkn.equals("Transform")) {
       Transform* t = new Transform();
       group.addChild(t);
       loadTransform(tkn,*t); 
-      t->setName(name);
+      _define(name,t);
       name = "";
    } else if(tkn.equals("Shape")) {
       Shape* s = new Shape();
       group.addChild(s);
       loadShape(tkn,*s);
-      s->setName(name);
+      _define(name,s);
+      name = "";
+    } else if(tkn.equals("Inline")) {
+      Inline* n = new Inline();
+      group.addChild(n);
+      loadInline(tkn,*n);
+      _define(name,n);
       name = "";
+    } else if(tkn.equals("USE")) {
+      Node* node = _use(tkn);
+      if(node->isShape()==false && node->isGroup()==false)
+        throw new StrException("USE of a node which cannot be a child");
+      group.addChild(node);
     } else if(tkn.equals("]")) {
       success = true;
     } else {
@@ -209,22 +260,59 @@ bool LoaderWrl::loadChildren(TokenizerFile& tkn, Group& group) {
   return success;
 }
 
-bool LoaderWrl::loadShape(TokenizerFile& tkn, Shape& shape) {
+bool LoaderWrl::loadInline(TokenizerBuffer& tkn, Inline& inl) {
+
+  // Inline {
+  //   MFString url        []
+  //   SFVec3f  bboxCenter  0 0 0
+  //   SFVec3f  bboxSize   -1 -1 -1
+  // }
+
+  bool success = false;
+  if(tkn.expecting("{")==false) throw new StrException("expecting \"{\"");
+  while(success==false && tkn.get()) {
+    if(tkn.equals("url")) {
+      loadVecString(tkn,inl.getUrl());
+    } else if(tkn.equals("bboxCenter")) {
+      Vec3f v;
+      if(tkn.getVec3f(v)==false)
+        throw new StrException("expecting Vec3f");
+      inl.setBBoxCenter(v);
+    } else if(tkn.equals("bboxSize")) {
+      Vec3f v;
+      if(tkn.getVec3f(v)==false)
+        throw new StrException("expecting Vec3f");
+      inl.setBBoxSize(v);
+    } else if(tkn.equals("}")) {
+      success = true;
+    } else {
+      throw new StrException("unexpected token while parsing Inline");
+    }
+  }
+  _inline.push_back(&inl);
+  return success;
+}
+
+bool LoaderWrl::loadShape(TokenizerBuffer& tkn, Shape& shape) {
 
   // Shape {
   //   SFNode appearance NULL
   //   SFNode geometry   NULL
   // }
 
-  // TODO Mon Nov 12 10:22:28 2012
-  // implement DEF name for appearance and geometry nodes
-
   string name    = "";
   bool   success = false;
   if(tkn.expecting("{")==false) throw new StrException("expecting \"{\"");
   while(success==false && tkn.get()) {
     if(tkn.equals("appearance")) {
       tkn.get("expecting appearance node");
+      if(tkn.equals("USE")) {
+        Node* node = _use(tkn);
+        if(node->isAppearance()==false)
+          throw new StrException("expecting Appearance");
+        shape.setAppearance(node);
+        continue;
+      }
       if(tkn.equals("DEF")) {
         tkn.get("missing token after DEF");
         name = tkn;
@@ -233,12 +321,19 @@ bool LoaderWrl::loadShape(TokenizerFile& tkn, Shape& shape) {
       if(tkn.equals("Appearance")==false)
         throw new StrException("expecting Appearance");
       Appearance* a = new Appearance();
-      a->setName(name);
+      _define(name,a);
       name = "";
       shape.setAppearance(a);
       loadAppearance(tkn,*a);
     } else if(tkn.equals("geometry")) {
       tkn.get("expecting geometry node");
+      if(tkn.equals("USE")) {
+        Node* node = _use(tkn);
+        if(node->isIndexedFaceSet()==false && node->isIndexedLineSet()==false)
+          throw new StrException("found unexpected geometry node");
+        shape.setGeometry(node);
+        continue;
+      }
       if(tkn.equals("DEF")) {
         tkn.get("missing token after DEF");
         name = tkn;
@@ -246,13 +341,13 @@ bool LoaderWrl::loadShape(TokenizerFile& tkn, Shape& shape) {
       }
       if(tkn.equals("IndexedFaceSet")) {
         IndexedFaceSet* ifs = new IndexedFaceSet();
-        ifs->setName(name);
+        _define(name,ifs);
         name = "";
         shape.setGeometry(ifs);
         loadIndexedFaceSet(tkn,*ifs);
       } else if(tkn.equals("IndexedLineSet")) {
         IndexedLineSet* ils = new IndexedLineSet();
-        ils->setName(name);
+        _define(name,ils);
         name = "";
         shape.setGeometry(ils);
         loadIndexedLineSet(tkn,*ils);
@@ -268,7 +363,7 @@ bool LoaderWrl::loadShape(TokenizerFile& tkn, Shape& shape) {
   return success;
 }
 
-bool LoaderWrl::loadAppearance(TokenizerFile& tkn, Appearance& appearance) {
+bool LoaderWrl::loadAppearance(TokenizerBuffer& tkn, Appearance& appearance) {
 
   // Appearance {
   //   SFNode material NULL
@@ -276,15 +371,19 @@ bool LoaderWrl::loadAppearance(TokenizerFile& tkn, Appearance& appearance) {
   //   // SFNode textureTransform NULL
   // }
 
-  // TODO Mon Nov 12 10:22:28 2012
-  // implement DEF name for matrial and texture nodes
-
   string name    = "";
   bool   success = false;
   if(tkn.expecting("{")==false) throw new StrException("expecting \"[\"");
   while(success==false && tkn.get()) {
     if(tkn.equals("material")) {
       tkn.get("expecting material node");
+      if(tkn.equals("USE")) {
+        Node* node = _use(tkn);
+        if(node->isMaterial()==false)
+          throw new StrException("expecting Material");
+        appearance.setMaterial(node);
+        continue;
+      }
       if(tkn.equals("DEF")) {
         tkn.get("missing token after DEF");
         name = tkn;
@@ -293,12 +392,19 @@ bool LoaderWrl::loadAppearance(TokenizerFile& tkn, Appearance& appearance) {
       if(tkn.equals("Material")==false)
         throw new StrException("expecting Material");
       Material* m = new Material();
-      m->setName(name);
+      _define(name,m);
       name = "";
       appearance.setMaterial(m);
       loadMaterial(tkn,*m);
     } else if(tkn.equals("texture")) {
       tkn.get("expecting Texture node");
+      if(tkn.equals("USE")) {
+        Node* node = _use(tkn);
+        if(node->isImageTexture()==false)
+          throw new StrException("found unexpected Texture node");
+        appearance.setTexture(node);
+        continue;
+      }
       if(tkn.equals("DEF")) {
         tkn.get("missing token after DEF");
         name = tkn;
@@ -306,7 +412,7 @@ bool LoaderWrl::loadAppearance(TokenizerFile& tkn, Appearance& appearance) {
       }
       if(tkn.equals("ImageTexture")) {
         ImageTexture* it = new ImageTexture();
-        it->setName(name);
+        _define(name,it);
         name = "";
         appearance.setTexture(it);
         loadImageTexture(tkn,*it);
@@ -326,7 +432,7 @@ bool LoaderWrl::loadAppearance(TokenizerFile& tkn, Appearance& appearance) {
   return success;
 }
 
-bool LoaderWrl::loadMaterial(TokenizerFile& tkn, Material& material) {
+bool LoaderWrl::loadMaterial(TokenizerBuffer& tkn, Material& material) {
 
   // Material {
   //   SFFloat ambientIntensity 0.2
@@ -380,7 +486,7 @@ bool LoaderWrl::loadMaterial(TokenizerFile& tkn, Material& material) {
 
 }
 
-bool LoaderWrl::loadImageTexture(TokenizerFile& tkn, ImageTexture& imageTexture) {
+bool LoaderWrl::loadImageTexture(TokenizerBuffer& tkn, ImageTexture& imageTexture) {
 
   // ImageTexture {
   //   MFString url []
@@ -414,7 +520,7 @@ bool LoaderWrl::loadImageTexture(TokenizerFile& tkn, ImageTexture& imageTexture)
   return success;
 }
 
-bool LoaderWrl::loadIndexedFaceSet(TokenizerFile& tkn, IndexedFaceSet& ifs) {
+bool LoaderWrl::loadIndexedFaceSet(TokenizerBuffer& tkn, IndexedFaceSet& ifs) {
 
   // IndexedFaceSet {
   //   SFNode  color             NULL
@@ -563,7 +669,7 @@ bool LoaderWrl::loadIndexedFaceSet(TokenizerFile& tkn, IndexedFaceSet& ifs) {
   return success;
 }
 
-bool LoaderWrl::loadIndexedLineSet(TokenizerFile& tkn, IndexedLineSet& ifs) {
+bool LoaderWrl::loadIndexedLineSet(TokenizerBuffer& tkn, IndexedLineSet& ifs) {
 
   // IndexedFaceSet {
   //   SFNode  coord             NULL
@@ -634,40 +740,416 @@ bool LoaderWrl::loadIndexedLineSet(TokenizerFile& tkn, IndexedLineSet& ifs) {
   return success;
 }
 
-bool LoaderWrl::loadVecFloat(TokenizerFile&tkn,vector<float>& vec) {
-  bool success = false;
+bool LoaderWrl::loadVecFloat(TokenizerBuffer&tkn,vector<float>& vec) {
+  return _skipArray(tkn,&vec,nullptr);
+}
+
+bool LoaderWrl::loadVecInt(TokenizerBuffer&tkn,vector<int>& vec) {
+  return _skipArray(tkn,nullptr,&vec);
+}
+
+//////////////////////////////////////////////////////////////////////
+// array fields
+
+int LoaderWrl::_nThreads = 0;
+
+// static
+void LoaderWrl::setNumberOfThreads(const int nThreads) {
+  _nThreads = nThreads;
+}
+
+// static
+int LoaderWrl::getNumberOfThreads() {
+  return _nThreads;
+}
+
+// returns the position of the first "]" token in [begin,end), or end
+static const char* _findArrayEnd(const char* begin, const char* end) {
+  const char* p = begin;
+  while(p<end && (p=static_cast<const char*>(memchr(p,']',end-p)))!=nullptr) {
+    if((p==begin || InputParser::isSeparator(p[-1])) &&
+       (p+1==end || InputParser::isSeparator(p[1]))) {
+      // make sure that it is not in a comment
+      const char* line = p;
+      while(line>begin && line[-1]!='\n') line--;
+      const char* token = nullptr;
+      while(InputParser::nextToken(line,p+1,token) && token<p);
+      if(token==p) return p;
+      // skip the comment
+      p = static_cast<const char*>(memchr(p,'\n',end-p));
+      if(p==nullptr) break;
+    }
+    p++;
+  }
+  return end;
+}
+
+// records the extent of the array, and moves the tokenizer past it
+bool LoaderWrl::_skipArray
+(TokenizerBuffer& tkn, vector<float>* vecFloat, vector<int>* vecInt) {
   if(tkn.expecting("[")==false) throw new StrException("expecting \"[\"");
-  float value;
-  while(success==false && tkn.get()) {
-    if(tkn.equals("]")) {
-      success = true; // done
-    } else if(sscanf(tkn.c_str(),"%f",&value)==1) {
-      vec.push_back(value);
-    } else {
+  Array array;
+  array.begin    = tkn.getPosition();
+  array.end      = _findArrayEnd(array.begin,tkn.getEnd());
+  array.vecFloat = vecFloat;
+  array.vecInt   = vecInt;
+  if(array.end==tkn.getEnd()) return false;
+  _array.push_back(array);
+  tkn.setPosition(array.end+1);
+  return true;
+}
+
+// parses the arrays found by the first pass; the arrays are split into
+// pieces of about the same size, starting at the beginning of a line;
+// the values in each piece are counted in parallel, the vectors are
+// sized, and the pieces are parsed in parallel into the vectors
+void LoaderWrl::_parseArrays(int nThreads) {
+
+  class Piece {
+  public:
+    size_t      iArray;
+    const char* begin;
+    const char* end;
+    size_t      nValues;
+    size_t      first;
+    bool        failed;
+  };
+
+  const size_t PIECE_SIZE = (1<<18);
+  vector<Piece> piece;
+  size_t size = 0;
+  for(size_t iArray=0;iArray<_array.size();iArray++) {
+    const char* p   = _array[iArray].begin;
+    const char* end = _array[iArray].end;
+    size += static_cast<size_t>(end-p);
+    do {
+      Piece pc;
+      pc.iArray = iArray;
+      pc.begin  = p;
+      pc.end    = end;
+      pc.failed = false;
+      if(static_cast<size_t>(end-p)>PIECE_SIZE) {
+        const char* q = static_cast<const char*>
+          (memchr(p+PIECE_SIZE,'\n',end-p-PIECE_SIZE));
+        if(q!=nullptr) pc.end = q+1;
+      }
+      piece.push_back(pc);
+      p = pc.end;
+    } while(p<end);
+  }
+
+  nThreads = InputParser::numberOfThreads(nThreads);
+  if(size<PIECE_SIZE)
+    nThreads = 1;
+  const int nPieces = static_cast<int>(piece.size());
+
+  // count the values
+  InputParser::runChunks(nThreads,nPieces,[&](const int iPiece) {
+      Piece& pc = piece[iPiece];
+      const char* p     = pc.begin;
+      const char* token = nullptr;
+      size_t n = 0;
+      while(InputParser::nextToken(p,pc.end,token)) n++;
+      pc.nValues = n;
+    });
+
+  // size the vectors; several arrays may be appended to the same one
+  map<void*,size_t> vecSize;
+  for(Piece& pc : piece) {
+    Array& array = _array[pc.iArray];
+    void*  vec   = (array.vecFloat!=nullptr)?
+      static_cast<void*>(array.vecFloat):static_cast<void*>(array.vecInt);
+    map<void*,size_t>::iterator i = vecSize.find(vec);
+    if(i==vecSize.end())
+      i = vecSize.insert(pair<void*,size_t>
+                         (vec,(array.vecFloat!=nullptr)?
+                          array.vecFloat->size():array.vecInt->size())).first;
+    pc.first   = i->second;
+    i->second += pc.nValues;
+  }
+  for(Array& array : _array)
+    if(array.vecFloat!=nullptr)
+      array.vecFloat->resize(vecSize[array.vecFloat]);
+    else
+      array.vecInt->resize(vecSize[array.vecInt]);
+
+  // parse the values
+  InputParser::runChunks(nThreads,nPieces,[&](const int iPiece) {
+      Piece& pc    = piece[iPiece];
+      Array& array = _array[pc.iArray];
+      const char* p     = pc.begin;
+      const char* token = nullptr;
+      if(array.vecFloat!=nullptr) {
+        float* value = array.vecFloat->data()+pc.first;
+        while(pc.failed==false && InputParser::nextToken(p,pc.end,token))
+          pc.failed = (InputParser::parse(token,p,*(value++))==false);
+      } else {
+        int* value = array.vecInt->data()+pc.first;
+        while(pc.failed==false && InputParser::nextToken(p,pc.end,token))
+          pc.failed = (InputParser::parse(token,p,*(value++))==false);
+      }
+    });
+
+  _array.clear();
+  for(Piece& pc : piece)
+    if(pc.failed)
       throw new StrException("expecting int value");
+}
+
+//////////////////////////////////////////////////////////////////////
+// Inline nodes
+
+// the files referenced by the Inline nodes, indexed by path; the files
+// are loaded by several threads, which take the paths from the queue,
+// and add the files referenced by the Inline nodes found in them
+class LoaderWrl::InlineFiles {
+public:
+
+  class File {
+  public:
+    shared_ptr<Group> content;
+    vector<Inline*>   node;     // the Inline nodes found in the file
+    vector<string>    path;     // the file referenced by each node
+    int               state = 0; // 0: new, 1: being attached, 2: attached
+  };
+
+  map<string,File>    file;
+  vector<string>      queue;
+  int                 nActive = 0;
+  mutex               lock;
+  condition_variable  changed;
+
+  // must be called with the lock held
+  void add
+  (const string& filename, shared_ptr<Group> content, vector<Inline*>& node);
+  void work();
+  void attach(const string& filename);
+};
+
+// splits the path in components, removing the "." and "dir/.."
+// components; the first component of an absolute path is "", or the
+// drive letter
+static void _splitPath(const string& path, vector<string>& part) {
+  part.clear();
+  size_t begin = 0;
+  while(begin<=path.size()) {
+    size_t end = path.find_first_of("/\\",begin);
+    if(end==string::npos)
+      end = path.size();
+    string p = path.substr(begin,end-begin);
+    if(p==".." && part.size()>0 && part.back()!=".." && part.back()!="")
+      part.pop_back();
+    else if(p!="." && (p!="" || part.size()==0))
+      part.push_back(p);
+    begin = end+1;
+  }
+}
+
+static bool _isAbsolute(const string& path) {
+  return
+    (path.size()>0 && (path[0]=='/' || path[0]=='\\')) ||
+    (path.size()>1 && path[1]==':');
+}
+
+static string _absolutePath(const string& path) {
+  if(_isAbsolute(path))
+    return path;
+  char cwd[4096];
+  if(getcwd(cwd,sizeof(cwd))==(char*)0)
+    return path;
+  return string(cwd)+"/"+path;
+}
+
+// static
+string LoaderWrl::dirName(const string& filename) {
+  size_t slash = filename.find_last_of("/\\");
+  return (slash==string::npos)?string(""):filename.substr(0,slash+1);
+}
+
+// static
+string LoaderWrl::normalPath(const string& path) {
+  vector<string> part;
+  _splitPath(path,part);
+  string normal = "";
+  for(size_t i=0;i<part.size();i++)
+    normal += ((i>0)?"/":"")+part[i];
+  return normal;
+}
+
+// static
+string LoaderWrl::absolutePath(const string& path) {
+  return normalPath(_absolutePath(path));
+}
+
+// static
+string LoaderWrl::relativePath(const string& path, const string& dir) {
+  vector<string> p,d;
+  _splitPath(path,p);
+  _splitPath(dir,d);
+  if(d.size()==1 && d[0]=="" && _isAbsolute(dir)==false)
+    d.clear(); // the current directory
+  size_t k = 0;
+  while(k<p.size() && k<d.size() && p[k]==d[k])
+    k++;
+  // a relative path cannot go up from a relative directory starting
+  // with "..", or from a relative to an absolute directory, without
+  // knowing the current directory; an absolute path is kept absolute
+  // if the directory is relative
+  bool known = (_isAbsolute(path)==_isAbsolute(dir) || d.size()==0);
+  for(size_t i=k;known && i<d.size();i++)
+    if(d[i]=="..")
+      known = false;
+  if(known==false) {
+    if(_isAbsolute(path))
+      return normalPath(path);
+    string absolutePath = _absolutePath(path);
+    string absoluteDir  = _absolutePath(dir);
+    if(_isAbsolute(absolutePath)==false || _isAbsolute(absoluteDir)==false)
+      return normalPath(path);
+    return relativePath(absolutePath,absoluteDir);
+  }
+  // absolute paths on different drives
+  if(_isAbsolute(path) && k==0)
+    return normalPath(path);
+  string relative = "";
+  for(size_t i=k;i<d.size();i++)
+    relative += "../";
+  for(size_t i=k;i<p.size();i++)
+    relative += ((i>k)?"/":"")+p[i];
+  return relative;
+}
+
+// static
+string LoaderWrl::relativeUrl
+(const string& url, const string& srcDir, const string& dstDir) {
+  string u = url;
+  bool quoted = (u.size()>=2 && u.front()=='"' && u.back()=='"');
+  if(quoted)
+    u = u.substr(1,u.size()-2);
+  if(u.compare(0,7,"file://")==0)
+    u = u.substr(7);
+  else if(u.find("://")!=string::npos)
+    return url;
+  if(u=="" || _isAbsolute(u) || normalPath(srcDir)==normalPath(dstDir))
+    return url;
+  u = relativePath(srcDir+u,dstDir);
+  return (quoted)?"\""+u+"\"":u;
+}
+
+// returns the path of the first url which names an existing file, relative
+// to the directory of the file containing the Inline node; the urls are
+// stored with the quotes
+static string _inlinePath(const string& filename, vector<string>& url) {
+  string dir = LoaderWrl::dirName(filename);
+  for(string u : url) {
+    if(u.size()>=2 && u.front()=='"' && u.back()=='"')
+      u = u.substr(1,u.size()-2);
+    if(u.compare(0,7,"file://")==0)
+      u = u.substr(7);
+    if(u=="")
+      continue;
+    string path = LoaderWrl::normalPath((_isAbsolute(u))?u:dir+u);
+    FILE* fp = fopen(path.c_str(),"rb");
+    if(fp!=(FILE*)0) {
+      fclose(fp);
+      return path;
     }
   }
+  return "";
+}
 
-  return success;
+void LoaderWrl::InlineFiles::add
+(const string& filename, shared_ptr<Group> content, vector<Inline*>& node) {
+  File& f = file[filename];
+  f.content = content;
+  f.node    = node;
+  for(Inline* inl : node) {
+    string path = _inlinePath(filename,inl->getUrl());
+    if(path=="")
+      fprintf(stderr,"WARNING | Inline url not found in \"%s\"\n",
+              filename.c_str());
+    else if(file.find(path)==file.end()) {
+      file[path];
+      queue.push_back(path);
+    }
+    f.path.push_back(path);
+  }
+  changed.notify_all();
 }
 
-bool LoaderWrl::loadVecInt(TokenizerFile&tkn,vector<int>& vec) {
-  bool success = false;
-  if(tkn.expecting("[")==false) throw new StrException("expecting \"[\"");
-  int value;
-  while(success==false && tkn.get()) {
-    if(tkn.equals("]")) {
-      success = true; // done
-    } else if(sscanf(tkn.c_str(),"%d",&value)==1) {
-      vec.push_back(value);
+void LoaderWrl::InlineFiles::work() {
+  unique_lock<mutex> guard(lock);
+  for(;;) {
+    if(queue.size()>0) {
+      string path = queue.back();
+      queue.pop_back();
+      nActive++;
+      guard.unlock();
+      shared_ptr<Group> content(new Group());
+      LoaderWrl loader;
+      try {
+        // the files are loaded concurrently, and their arrays serially
+        loader._loadFile(path.c_str(),*content,1);
+      } catch(StrException* e) {
+        fprintf(stderr,"WARNING | cannot load Inline \"%s\" | %s\n",
+                path.c_str(),e->what());
+        delete e;
+        content.reset(new Group());
+        loader._inline.clear();
+      }
+      guard.lock();
+      add(path,content,loader._inline);
+      nActive--;
+    } else if(nActive>0) {
+      changed.wait(guard);
     } else {
-      throw new StrException("expecting int value");
+      break;
     }
   }
-  return success;
 }
 
-bool LoaderWrl::loadVecString(TokenizerFile&tkn,vector<string>& vec) {
+// attaches the content of the files to the Inline nodes, depth first;
+// an Inline node which would make a file include itself is left empty
+void LoaderWrl::InlineFiles::attach(const string& filename) {
+  File& f = file[filename];
+  f.state = 1;
+  for(size_t i=0;i<f.node.size();i++) {
+    f.node[i]->setPath(f.path[i]);
+    if(f.path[i]=="")
+      continue;
+    File& g = file[f.path[i]];
+    if(g.state==1) {
+      fprintf(stderr,"WARNING | \"%s\" includes itself\n",
+              f.path[i].c_str());
+      continue;
+    }
+    f.node[i]->setContent(g.content);
+    if(g.state==0)
+      attach(f.path[i]);
+  }
+  f.state = 2;
+}
+
+void LoaderWrl::_loadInlines(const string& filename) {
+  if(_inline.size()==0)
+    return;
+  InlineFiles files;
+  const string path = normalPath(filename);
+  files.add(path,shared_ptr<Group>(),_inline);
+  _inline.clear();
+  int nThreads = InputParser::numberOfThreads(_nThreads);
+  vector<thread> worker;
+  for(int iThread=1;iThread<nThreads;iThread++)
+    worker.push_back(thread(&InlineFiles::work,&files));
+  files.work();
+  for(thread& t : worker)
+    t.join();
+  files.attach(path);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool LoaderWrl::loadVecString(TokenizerBuffer&tkn,vector<string>& vec) {
   bool success = false;
   tkn.get("expecting a token");
   if(tkn.equals("[")) {
@@ -681,51 +1163,69 @@ bool LoaderWrl::loadVecString(TokenizerFile&tkn,vector<string>& vec) {
     success = true;
   } else {
     // expecting a single string
-    tkn.get("expecting a token");
     vec.push_back(tkn);
     success = true;
   }
   return success;
 }
 
+// opens the file, builds the scene graph as children of the group, and
+// parses the array fields
+void LoaderWrl::_loadFile
+(const char* filename, Group& group, const int nThreads) {
+
+  // open the file
+  FILE* fp = InputFile::open(filename,"rb");
+  if(fp==(FILE*)0) throw new StrException("fp==(FILE*)0");
+
+  // map the file into memory
+  InputData input(fp);
+  fclose(fp);
+
+  // check header line
+  const size_t nHeader = strlen(VRML_HEADER);
+  if(input.size()<nHeader ||
+     strncmp(input.data(),VRML_HEADER,nHeader)!=0)
+    throw new StrException("header!=VRM_HEADER");
+
+  // create a TokenizerBuffer and build the scene graph; then parse
+  // the array fields
+  TokenizerBuffer tkn(input.data()+nHeader,input.size()-nHeader);
+  _array.clear();
+  _inline.clear();
+  _def.clear();
+  loadSceneGraph(tkn,group);
+  _def.clear();
+  _parseArrays(nThreads);
+}
+
 bool LoaderWrl::load(const char* filename, SceneGraph& wrl) {
   bool success = false;
 
-  FILE* fp = (FILE*)0;
   try {
 
-    // open the file
     if(filename==(char*)0) throw new StrException("filename==null");
-    fp = fopen(filename,"r");
-    if(fp==(FILE*)0) throw new StrException("fp==(FILE*)0");
 
     // clear the container
     wrl.clear();
     wrl.setUrl(filename);
 
-    // read and check header line
-    char header[16];
-    // memset(header,'\0',16);
-    for(int i=0;i<16;i++) header[i] = '\0';
-    fscanf(fp,"%15c",header);
-    if(string(header)!=VRML_HEADER) throw new StrException("header!=VRM_HEADER");
-
-    // create a TokenizerFile and start parsing
-    TokenizerFile tkn(fp);
-    loadSceneGraph(tkn,wrl);
+    // load the file, and then the files referenced by its Inline nodes
+    _loadFile(filename,wrl,_nThreads);
+    _loadInlines(filename);
 
     // will be done later
     // wrl.updateBBox();
     
     // if we have reached this point we have succeeded
-    fclose(fp);
     success = true;
 
   } catch(StrException* e) { 
 
-    if(fp!=(FILE*)0) fclose(fp);
     fprintf(stderr,"ERROR | %s\n",e->what());
     delete e;
+    _array.clear();
+    _inline.clear();
     wrl.clear();
     wrl.setUrl("");
 
@@ -733,4 +1233,3 @@ bool LoaderWrl::load(const char* filename, SceneGraph& wrl) {
 
   return success;
 }
-
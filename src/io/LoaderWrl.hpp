@@ -35,9 +35,11 @@
 #ifndef _LOADER_WRL_HPP_
 #define _LOADER_WRL_HPP_
 
+#include <map>
 #include "Loader.hpp"
-#include "TokenizerFile.hpp"
+#include "TokenizerBuffer.hpp"
 #include <wrl/Transform.hpp>
+#include <wrl/Inline.hpp>
 #include <wrl/Shape.hpp>
 #include <wrl/Appearance.hpp>
 #include <wrl/Material.hpp>
@@ -59,21 +61,89 @@ public:
   bool  load(const char* filename, SceneGraph& wrl);
   const char* ext() const { return _ext; }
 
+  // number of threads used to parse the array fields, and to load the
+  // files referenced by Inline nodes; 1 parses serially, and
+  // nThreads<=0 uses std::thread::hardware_concurrency()
+  static void setNumberOfThreads(const int nThreads);
+  static int  getNumberOfThreads();
+
+  // directory of a file, ending with a separator, or empty for the
+  // current directory
+  static string dirName(const string& filename);
+
+  // removes the "." and "dir/.." components of a path, so that the
+  // same file is found under the same path
+  static string normalPath(const string& path);
+
+  // normal absolute path of a path relative to the current directory
+  static string absolutePath(const string& path);
+
+  // path of a file relative to a directory, both absolute or relative
+  // to the current directory; an absolute path is returned if there is
+  // no relative path
+  static string relativePath(const string& path, const string& dir);
+
+  // url of a file, relative to the directory srcDir of the file which
+  // references it, rewritten relative to the directory dstDir; the
+  // directories are empty or end with a separator, and urls which are
+  // absolute or are not files are not changed
+  static string relativeUrl
+  (const string& url, const string& srcDir, const string& dstDir);
+
 private:
 
-  bool loadSceneGraph(TokenizerFile& tkn, SceneGraph& wrl);
-  bool loadGroup(TokenizerFile& tkn, Group& group);
-  bool loadTransform(TokenizerFile& tkn, Transform& transform);
-  bool loadChildren(TokenizerFile& tkn, Group& group);
-  bool loadShape(TokenizerFile& tkn, Shape& transform);
-  bool loadAppearance(TokenizerFile& tkn, Appearance& appearance);
-  bool loadMaterial(TokenizerFile& tkn, Material& material);
-  bool loadImageTexture(TokenizerFile& tkn, ImageTexture& imageTexture);
-  bool loadIndexedFaceSet(TokenizerFile& tkn, IndexedFaceSet& ifs);
-  bool loadIndexedLineSet(TokenizerFile& tkn, IndexedLineSet& ifs);
-  bool loadVecFloat(TokenizerFile& tkn,vector<float>& vec);
-  bool loadVecInt(TokenizerFile& tkn,vector<int>& vec);
-  bool loadVecString(TokenizerFile& tkn,vector<string>& vec);
+  static int _nThreads;
+
+  // the file is loaded in two passes: the first pass builds the scene
+  // graph, but only finds the extent of each array field; the arrays
+  // are parsed by the second pass, in parallel
+
+  class Array {
+  public:
+    const char*    begin; // after "["
+    const char*    end;   // at "]"
+    vector<float>* vecFloat;
+    vector<int>*   vecInt;
+  };
+
+  vector<Array> _array;
+
+  bool _skipArray
+  (TokenizerBuffer& tkn, vector<float>* vecFloat, vector<int>* vecInt);
+  void _parseArrays(int nThreads);
+
+  // the files referenced by the Inline nodes are loaded after the file
+  // containing them, concurrently; each file is loaded only once, and
+  // its content is shared by all the Inline nodes referencing it
+
+  class InlineFiles;
+
+  vector<Inline*> _inline;
+
+  void _loadFile(const char* filename, Group& group, const int nThreads);
+  void _loadInlines(const string& filename);
+
+  // the nodes named by DEF, which may be shared by USE
+
+  map<string,Node*> _def;
+
+  void  _define(const string& name, Node* node);
+  Node* _use(TokenizerBuffer& tkn);
+
+  bool loadSceneGraph(TokenizerBuffer& tkn, Group& group);
+  bool loadGroup(TokenizerBuffer& tkn, Group& group);
+  bool loadTransform(TokenizerBuffer& tkn, Transform& transform);
+  bool loadChildren(TokenizerBuffer& tkn, Group& group);
+  bool loadInline(TokenizerBuffer& tkn, Inline& inl);
+  bool loadShape(TokenizerBuffer& tkn, Shape& transform);
+  bool loadAppearance(TokenizerBuffer& tkn, Appearance& appearance);
+  bool loadMaterial(TokenizerBuffer& tkn, Material& material);
+  bool loadImageTexture(TokenizerBuffer& tkn, ImageTexture& imageTexture);
+  bool loadIndexedFaceSet(TokenizerBuffer& tkn, IndexedFaceSet& ifs);
+  bool loadIndexedLineSet(TokenizerBuffer& tkn, IndexedLineSet& ifs);
+  bool loadVecFloat(TokenizerBuffer& tkn,vector<float>& vec);
+  bool loadVecInt(TokenizerBuffer& tkn,vector<int>& vec);
+  bool loadVecString(TokenizerBuffer& tkn,vector<string>& vec);
 };
 
 #endif /* _LOADER_WRL_HPP_ */
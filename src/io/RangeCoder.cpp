@@ -0,0 +1,204 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-09 16:21:05 taubin>
+//------------------------------------------------------------------------
+//
+// RangeCoder.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+#include "RangeCoder.hpp"
+
+const int      RangeEncoder::PROB_BITS;
+const uint16_t RangeEncoder::PROB_INIT;
+
+RangeEncoder::RangeEncoder(vector<uint8_t>& out):
+  _out(out),
+  _start(out.size()),
+  _low(0),
+  _range(0xFFFFFFFF),
+  _cache(0),
+  _cacheSize(1),
+  _bits(0),
+  _nBits(0) {
+  // the size of the range coded stream is set by finish()
+  _out.resize(_start+8,0);
+}
+
+void RangeEncoder::_shiftLow() {
+  if(static_cast<uint32_t>(_low)<0xFF000000 || (_low>>32)!=0) {
+    // resolve the carry into the pending bytes
+    uint8_t carry = static_cast<uint8_t>(_low>>32);
+    uint8_t temp  = _cache;
+    do {
+      _out.push_back(static_cast<uint8_t>(temp+carry));
+      temp = 0xFF;
+    } while(--_cacheSize!=0);
+    _cache = static_cast<uint8_t>(_low>>24);
+  }
+  _cacheSize++;
+  _low = (_low&0x00FFFFFF)<<8;
+}
+
+void RangeEncoder::encodeDirect(const uint32_t value, const int nBits) {
+  for(int i=nBits-1;i>=0;i--) {
+    _range >>= 1;
+    if((value>>i)&1) _low += _range;
+    while(_range<_TOP) {
+      _range <<= 8;
+      _shiftLow();
+    }
+  }
+}
+
+void RangeEncoder::encodeFloat(const float value) {
+  uint32_t bits;
+  memcpy(&bits,&value,4);
+  encodeDirect(bits,32);
+}
+
+void RangeEncoder::finish() {
+  for(int i=0;i<5;i++)
+    _shiftLow();
+  uint64_t size = _out.size()-_start-8;
+  for(int i=0;i<8;i++)
+    _out[_start+i] = static_cast<uint8_t>(size>>(8*i));
+  if(_nBits>0)
+    _bypass.push_back(static_cast<uint8_t>(_bits));
+  _out.insert(_out.end(),_bypass.begin(),_bypass.end());
+  _bits  = 0;
+  _nBits = 0;
+  _bypass.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+RangeDecoder::RangeDecoder(const uint8_t* data, const size_t size):
+  _next(data),
+  _endRange(data),
+  _nextBypass(data),
+  _end(data+size),
+  _code(0),
+  _range(0xFFFFFFFF),
+  _bits(0),
+  _nBits(0),
+  _overrun(0) {
+  uint64_t rangeSize = 0;
+  if(size>=8) {
+    for(int i=0;i<8;i++)
+      rangeSize |= static_cast<uint64_t>(data[i])<<(8*i);
+    if(rangeSize>size-8) rangeSize = size-8;
+    _next       = data+8;
+    _endRange   = _next+rangeSize;
+    _nextBypass = _endRange;
+  } else {
+    _overrun = 5;
+  }
+  // the first byte written by the encoder is always zero
+  for(int i=0;i<5;i++)
+    _code = (_code<<8)|_nextByte();
+}
+
+uint32_t RangeDecoder::decodeDirect(const int nBits) {
+  uint32_t value = 0;
+  for(int i=0;i<nBits;i++) {
+    _range >>= 1;
+    uint32_t bit = 0;
+    if(_code>=_range) {
+      _code -= _range;
+      bit    = 1;
+    }
+    value = (value<<1)|bit;
+    while(_range<_TOP) {
+      _range <<= 8;
+      _code   = (_code<<8)|_nextByte();
+    }
+  }
+  return value;
+}
+
+float RangeDecoder::decodeFloat() {
+  uint32_t bits = decodeDirect(32);
+  float value;
+  memcpy(&value,&bits,4);
+  return value;
+}
+
+//////////////////////////////////////////////////////////////////////
+RangeIntModel::RangeIntModel() {
+  for(int i=0;i<64;i++)
+    _length[i] = RangeEncoder::PROB_INIT;
+  for(int i=0;i<33;i++)
+    _leading[i][0] = _leading[i][1] = _leading[i][2] = RangeEncoder::PROB_INIT;
+}
+
+void RangeIntModel::encode(RangeEncoder& encoder, const uint32_t value) {
+  uint64_t v = static_cast<uint64_t>(value)+1;
+  int nBits = 64-__builtin_clzll(v); // in [1,33]
+  // the length, as a 6 bit symbol
+  int len = nBits-1, node = 1;
+  for(int i=5;i>=0;i--) {
+    int bit = (len>>i)&1;
+    encoder.encodeBit(_length[node],bit);
+    node = (node<<1)|bit;
+  }
+  int m = nBits-1; // bits following the most significant one
+  if(m==0) return;
+  int b0 = static_cast<int>(v>>(m-1))&1;
+  encoder.encodeBit(_leading[len][0],b0);
+  if(m==1) return;
+  int b1 = static_cast<int>(v>>(m-2))&1;
+  encoder.encodeBit(_leading[len][1+b0],b1);
+  if(m==2) return;
+  encoder.encodeBypass(static_cast<uint32_t>(v&((1ULL<<(m-2))-1)),m-2);
+}
+
+uint32_t RangeIntModel::decode(RangeDecoder& decoder) {
+  int node = 1;
+  for(int i=0;i<6;i++)
+    node = (node<<1)|decoder.decodeBit(_length[node]);
+  int len = node-64;
+  if(len>32) len = 32; // only in corrupted streams
+  uint64_t v = 1;
+  int m = len;
+  if(m>0) {
+    int b0 = decoder.decodeBit(_leading[len][0]);
+    v = (v<<1)|b0;
+    if(m>1) {
+      v = (v<<1)|decoder.decodeBit(_leading[len][1+b0]);
+      if(m>2) v = (v<<(m-2))|decoder.decodeBypass(m-2);
+    }
+  }
+  return static_cast<uint32_t>(v-1);
+}
+
+//////////////////////////////////////////////////////////////////////
+RangeSymbolModel::RangeSymbolModel(const int nBits, const int nContexts):
+  _nBits(nBits),
+  _prob(static_cast<size_t>(nContexts)<<nBits,RangeEncoder::PROB_INIT) {
+}
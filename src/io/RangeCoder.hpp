@@ -0,0 +1,245 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-09 16:21:05 taubin>
+//------------------------------------------------------------------------
+//
+// RangeCoder.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RANGE_CODER_HPP
+#define RANGE_CODER_HPP
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// adaptive binary range coder used by the compressed mesh format (see
+// LoaderEbm.hpp)
+//
+// - every binary decision is coded with an adaptive probability,
+//   stored as an 11 bit fixed point number in a uint16_t, which is
+//   updated after each bit is coded
+// - bits coded with encodeDirect() have a fixed probability of 1/2;
+//   bits coded with encodeBypass() are not range coded, but stored
+//   as they are in a second stream which follows the range coded
+//   one, and which is much faster to decode
+// - the encoded data starts with the size of the range coded stream,
+//   as a 64 bit little endian number
+// - RangeIntModel codes unsigned integers as the number of
+//   significant bits, with an adaptive model, followed by the bits
+//   themselves; the two leading bits are coded with adaptive models
+//   as well, and the remaining ones are bypass bits
+// - RangeSymbolModel codes small symbols with a binary tree of
+//   adaptive models, selected by a context
+
+class RangeEncoder {
+
+public:
+
+  RangeEncoder(vector<uint8_t>& out);
+
+  static const int      PROB_BITS = 11;
+  static const uint16_t PROB_INIT = (1<<(PROB_BITS-1));
+
+  void encodeBit(uint16_t& prob, const int bit) {
+    uint32_t bound = (_range>>PROB_BITS)*prob;
+    if(bit==0) {
+      _range = bound;
+      prob  += ((1<<PROB_BITS)-prob)>>_MOVE_BITS;
+    } else {
+      _low   += bound;
+      _range -= bound;
+      prob  -= prob>>_MOVE_BITS;
+    }
+    while(_range<_TOP) {
+      _range <<= 8;
+      _shiftLow();
+    }
+  }
+
+  void encodeDirect(const uint32_t value, const int nBits);
+  void encodeFloat(const float value);
+
+  void encodeBypass(const uint32_t value, const int nBits) {
+    _bits  |= static_cast<uint64_t>(value)<<_nBits;
+    _nBits += nBits;
+    while(_nBits>=8) {
+      _bypass.push_back(static_cast<uint8_t>(_bits));
+      _bits  >>= 8;
+      _nBits  -= 8;
+    }
+  }
+
+  // flushes the pending bytes, and appends the bypass stream; no bit
+  // should be encoded afterwards
+  void finish();
+
+private:
+
+  static const int      _MOVE_BITS = 5;
+  static const uint32_t _TOP       = (1<<24);
+
+  void _shiftLow();
+
+  vector<uint8_t>& _out;
+  size_t           _start;
+  uint64_t         _low;
+  uint32_t         _range;
+  uint8_t          _cache;
+  uint64_t         _cacheSize;
+  vector<uint8_t>  _bypass;
+  uint64_t         _bits;
+  int              _nBits;
+};
+
+class RangeDecoder {
+
+public:
+
+  RangeDecoder(const uint8_t* data, const size_t size);
+
+  // branchless, since the decoded bits are hard to predict
+  int decodeBit(uint16_t& prob) {
+    uint32_t bound = (_range>>RangeEncoder::PROB_BITS)*prob;
+    uint32_t bit   = (_code>=bound);
+    uint32_t mask  = 0u-bit;
+    int      p     = prob;
+    _code  -= bound&mask;
+    _range  = (bound&~mask)|((_range-bound)&mask);
+    p      += ((((1<<RangeEncoder::PROB_BITS)-p)>>_MOVE_BITS)&~mask)-
+              ((p>>_MOVE_BITS)&mask);
+    prob    = static_cast<uint16_t>(p);
+    while(_range<_TOP) {
+      _range <<= 8;
+      _code   = (_code<<8)|_nextByte();
+    }
+    return static_cast<int>(bit);
+  }
+
+  uint32_t decodeDirect(const int nBits);
+  float    decodeFloat();
+
+  uint32_t decodeBypass(const int nBits) {
+    while(_nBits<nBits) {
+      if(_nextBypass<_end) _bits |= static_cast<uint64_t>(*_nextBypass++)<<_nBits;
+      else _overrun++;
+      _nBits += 8;
+    }
+    uint32_t value = static_cast<uint32_t>(_bits&((1ULL<<nBits)-1));
+    _bits  >>= nBits;
+    _nBits  -= nBits;
+    return value;
+  }
+
+  // true if the decoder has read past the end of the data, which
+  // only happens if the data is truncated or corrupted
+  bool     hasFailed() const { return _overrun>4; }
+
+private:
+
+  static const int      _MOVE_BITS = 5;
+  static const uint32_t _TOP       = (1<<24);
+
+  uint32_t _nextByte() {
+    if(_next<_endRange) return *_next++;
+    _overrun++;
+    return 0;
+  }
+
+  const uint8_t* _next;
+  const uint8_t* _endRange;
+  const uint8_t* _nextBypass;
+  const uint8_t* _end;
+  uint32_t       _code;
+  uint32_t       _range;
+  uint64_t       _bits;
+  int            _nBits;
+  size_t         _overrun;
+};
+
+class RangeIntModel {
+
+public:
+
+  RangeIntModel();
+
+  void     encode(RangeEncoder& encoder, const uint32_t value);
+  uint32_t decode(RangeDecoder& decoder);
+
+  // signed values are mapped to unsigned ones as 0,-1,1,-2,2,...
+  void     encodeSigned(RangeEncoder& encoder, const int32_t value) {
+    encode(encoder,(static_cast<uint32_t>(value)<<1)^
+                   static_cast<uint32_t>(value>>31));
+  }
+  int32_t  decodeSigned(RangeDecoder& decoder) {
+    uint32_t u = decode(decoder);
+    return static_cast<int32_t>(u>>1)^-static_cast<int32_t>(u&1);
+  }
+
+private:
+
+  // binary tree over the number of significant bits of value+1
+  uint16_t _length[64];
+  // the two bits following the most significant one, for each length
+  uint16_t _leading[33][3];
+};
+
+class RangeSymbolModel {
+
+public:
+
+  // symbols in the range [0,2^nBits), coded in one of nContexts
+  // independent models
+  RangeSymbolModel(const int nBits, const int nContexts);
+
+  void encode(RangeEncoder& encoder, const int symbol, const int context) {
+    uint16_t* prob = &_prob[context<<_nBits];
+    int node = 1;
+    for(int i=_nBits-1;i>=0;i--) {
+      int bit = (symbol>>i)&1;
+      encoder.encodeBit(prob[node],bit);
+      node = (node<<1)|bit;
+    }
+  }
+  int  decode(RangeDecoder& decoder, const int context) {
+    uint16_t* prob = &_prob[context<<_nBits];
+    int node = 1;
+    for(int i=0;i<_nBits;i++)
+      node = (node<<1)|decoder.decodeBit(prob[node]);
+    return node-(1<<_nBits);
+  }
+
+private:
+
+  int              _nBits;
+  vector<uint16_t> _prob;
+};
+
+#endif // RANGE_CODER_HPP
@@ -0,0 +1,593 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-09 16:21:05 taubin>
+//------------------------------------------------------------------------
+//
+// SaverEbm.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include "SaverEbm.hpp"
+#include "LoaderEbm.hpp"
+#include "StrException.hpp"
+
+#include <wrl/Shape.hpp>
+#include <wrl/Appearance.hpp>
+#include <wrl/Material.hpp>
+#include <util/BBox.hpp>
+
+const char* SaverEbm::_ext = "ebm";
+
+int SaverEbm::_coordBits = 16;
+
+//////////////////////////////////////////////////////////////////////
+// static
+void SaverEbm::setCoordBits(const int nBits) {
+  _coordBits = (nBits<4)?4:(nBits>24)?24:nBits;
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+int SaverEbm::getCoordBits() {
+  return _coordBits;
+}
+
+// corners of triangle t are 3*t, 3*t+1, and 3*t+2; the half edge of
+// corner c goes from the vertex of c to the vertex of _next(c)
+
+static inline int _next(const int c) { return (c%3==2)?c-2:c+1; }
+static inline int _prev(const int c) { return (c%3==0)?c+2:c-1; }
+
+//////////////////////////////////////////////////////////////////////
+bool SaverEbm::_closeMesh
+(const int nV, const vector<int>& coordIndex,
+ vector<int>& tv, vector<int>& twin, vector<int>& origin) const {
+
+  tv.clear();
+  twin.clear();
+  origin.clear();
+
+  // 1) all the faces should be non degenerate triangles
+  int i0,i1,a,b,c;
+  int nCI = static_cast<int>(coordIndex.size());
+  for(i0=i1=0;i1<=nCI;i1++) {
+    if(i1<nCI && coordIndex[i1]>=0) continue;
+    if(i1>i0) {
+      if(i1-i0!=3) return false;
+      a = coordIndex[i0]; b = coordIndex[i0+1]; c = coordIndex[i0+2];
+      if(a==b || b==c || c==a) return false;
+      tv.push_back(a); tv.push_back(b); tv.push_back(c);
+    }
+    i0 = i1+1;
+  }
+
+  // 2) pair the half edges; every edge should be shared by at most
+  //    two faces, with opposite orientations
+  int nC = static_cast<int>(tv.size());
+  vector< pair<uint64_t,int> > edge(nC);
+  for(c=0;c<nC;c++) {
+    a = tv[c]; b = tv[_next(c)];
+    uint64_t lo = static_cast<uint64_t>((a<b)?a:b);
+    uint64_t hi = static_cast<uint64_t>((a<b)?b:a);
+    edge[c] = make_pair((lo<<32)|hi,c);
+  }
+  sort(edge.begin(),edge.end());
+  twin.assign(nC,-1);
+  int i,j;
+  for(i=0;i<nC;i=j) {
+    for(j=i+1;j<nC && edge[j].first==edge[i].first;j++);
+    if(j-i>2) return false;
+    if(j-i==2) {
+      a = edge[i].second; b = edge[i+1].second;
+      if(tv[a]==tv[b]) return false;
+      twin[a] = b; twin[b] = a;
+    }
+  }
+  vector< pair<uint64_t,int> >().swap(edge);
+
+  origin.resize(nV);
+  for(i=0;i<nV;i++)
+    origin[i] = i;
+
+  // 3) close every boundary loop with a fan of triangles incident to
+  //    a new dummy vertex; the boundary half edge following h is
+  //    found by rotating around the last vertex of h
+  vector<int>     loop;
+  vector<uint8_t> inLoop(nC,0);
+  int h,n,nRot,m,t0,d;
+  for(c=0;c<nC;c++) {
+    if(twin[c]>=0 || inLoop[c]) continue;
+    loop.clear();
+    h = c;
+    do {
+      if(inLoop[h]) return false;
+      inLoop[h] = 1;
+      loop.push_back(h);
+      for(n=_next(h),nRot=0;twin[n]>=0;n=_next(twin[n]))
+        if(++nRot>nC) return false;
+      h = n;
+    } while(h!=c);
+    d  = static_cast<int>(origin.size());
+    origin.push_back(-1);
+    m  = static_cast<int>(loop.size());
+    t0 = static_cast<int>(tv.size()/3);
+    for(i=0;i<m;i++) {
+      h = loop[i];
+      tv.push_back(tv[_next(h)]); tv.push_back(tv[h]); tv.push_back(d);
+      twin.push_back(h); twin.push_back(-1); twin.push_back(-1);
+      twin[h] = 3*(t0+i);
+    }
+    for(i=0;i<m;i++) {
+      a = 3*(t0+i)+2;
+      b = 3*(t0+(i+1)%m)+1;
+      twin[a] = b; twin[b] = a;
+    }
+  }
+
+  // 4) split the singular vertices, so that the corners of every
+  //    vertex form a single cycle around it
+  nC = static_cast<int>(tv.size());
+  vector<uint8_t> seen(origin.size(),0);
+  vector<uint8_t> done(nC,0);
+  int v,vNew;
+  for(c=0;c<nC;c++) {
+    if(done[c]) continue;
+    v = tv[c];
+    if(seen[v]) {
+      vNew = static_cast<int>(origin.size());
+      origin.push_back(origin[v]);
+    } else {
+      seen[v] = 1;
+      vNew    = v;
+    }
+    h = c; nRot = 0;
+    do {
+      tv[h]   = vNew;
+      done[h] = 1;
+      h = twin[_prev(h)];
+      if(++nRot>nC) return false;
+    } while(h!=c);
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+int SaverEbm::_traverse
+(const vector<int>& tv, const vector<int>& twin, const int nVc,
+ vector<uint8_t>& op, vector<int>& arg,
+ vector<int>& order, vector<int>& pred) const {
+
+  // the cut-border loops are doubly linked lists of the half edges of
+  // the triangles not yet visited, which are twins of the half edges
+  // of the visited triangles; a half edge h is on the cut-border iff
+  // bNext[h]>=0
+  int nC = static_cast<int>(tv.size());
+  int nT = nC/3;
+  vector<uint8_t> triDone(nT,0);
+  vector<int>     bNext(nC,-1);
+  vector<int>     bPrev(nC,-1);
+  vector<int>     did(nVc,-1);
+  vector<int>     stack;
+  op.clear();
+  arg.clear();
+  order.clear();
+  pred.clear();
+  op.reserve(nT);
+  order.reserve(nVc);
+  pred.reserve(3*nVc);
+
+  int nComponents = 0;
+  int t,g,ny,nv,x,y,v,P,N,A,B,U,W,e,k,jS,iS;
+  bool l,r,found;
+
+#define LINK(e0,e1) { bNext[e0] = (e1); bPrev[e1] = (e0); }
+#define UNLINK(e0)  { bNext[e0] = bPrev[e0] = -1; }
+#define VISIT(iV,p0,p1,p2) { did[iV] = static_cast<int>(order.size()); \
+    order.push_back(iV);                                                \
+    pred.push_back(p0); pred.push_back(p1); pred.push_back(p2); }
+
+  for(t=0;t<nT;t++) {
+    if(triDone[t]) continue;
+    nComponents++;
+
+    // the first triangle of the component
+    triDone[t] = 1;
+    int c0 = 3*t, c1 = c0+1, c2 = c0+2;
+    if(did[tv[c0]]>=0 || did[tv[c1]]>=0 || did[tv[c2]]>=0)
+      throw new StrException("inconsistent mesh traversal");
+    VISIT(tv[c0],-1,-1,-1);
+    VISIT(tv[c1],did[tv[c0]],-1,-1);
+    VISIT(tv[c2],did[tv[c0]],did[tv[c1]],-1);
+    LINK(twin[c0],twin[c2]);
+    LINK(twin[c2],twin[c1]);
+    LINK(twin[c1],twin[c0]);
+    g = twin[c0];
+    stack.clear();
+
+    for(;;) {
+      t = g/3;
+      if(triDone[t])
+        throw new StrException("inconsistent mesh traversal");
+      triDone[t] = 1;
+      ny = _next(g);
+      nv = _prev(g);
+      x  = tv[g];
+      y  = tv[ny];
+      v  = tv[nv];
+      P  = bPrev[g];
+      N  = bNext[g];
+      l  = (bNext[nv]>=0);
+      r  = (bNext[ny]>=0);
+
+      if(l && r) { // E
+        if(P!=nv || N!=ny || bNext[N]!=P)
+          throw new StrException("inconsistent mesh traversal");
+        op.push_back(LoaderEbm::OP_E);
+        UNLINK(g); UNLINK(P); UNLINK(N);
+        if(stack.empty()) break;
+        g = stack.back();
+        stack.pop_back();
+
+      } else if(l) { // L
+        if(P!=nv)
+          throw new StrException("inconsistent mesh traversal");
+        op.push_back(LoaderEbm::OP_L);
+        B = twin[ny];
+        U = bPrev[P];
+        UNLINK(g); UNLINK(P);
+        LINK(U,B); LINK(B,N);
+        g = B;
+
+      } else if(r) { // R
+        if(N!=ny)
+          throw new StrException("inconsistent mesh traversal");
+        op.push_back(LoaderEbm::OP_R);
+        A = twin[nv];
+        W = bNext[N];
+        UNLINK(g); UNLINK(N);
+        LINK(P,A); LINK(A,W);
+        g = A;
+
+      } else if(did[v]<0) { // C
+        op.push_back(LoaderEbm::OP_C);
+        VISIT(v,did[x],did[y],did[tv[_prev(twin[g])]]);
+        A = twin[nv];
+        B = twin[ny];
+        UNLINK(g);
+        LINK(P,A); LINK(A,B); LINK(B,N);
+        g = B;
+
+      } else { // S or M
+        // W is the cut-border half edge leaving v which bounds the
+        // same gap of unvisited triangles around v as this triangle
+        for(W=twin[nv],k=0;;k++) {
+          W = _next(W);
+          if(bNext[W]>=0) break;
+          if(k>nC) throw new StrException("inconsistent mesh traversal");
+          W = twin[W];
+        }
+        for(e=N,k=0;e!=W && e!=g;e=bNext[e],k++);
+        if(e==W) {
+          op.push_back(LoaderEbm::OP_S);
+          arg.push_back(k-1);
+        } else {
+          found = false;
+          for(jS=0;found==false && jS<static_cast<int>(stack.size());jS++) {
+            iS = static_cast<int>(stack.size())-1-jS;
+            for(e=stack[iS],k=0;;) {
+              if(e==W) { found = true; break; }
+              e = bNext[e]; k++;
+              if(e==stack[iS]) break;
+            }
+          }
+          if(found==false)
+            throw new StrException("inconsistent mesh traversal");
+          jS--;
+          op.push_back(LoaderEbm::OP_M);
+          arg.push_back(jS);
+          arg.push_back(k);
+          stack.erase(stack.begin()+(stack.size()-1-jS));
+        }
+        A = twin[nv];
+        B = twin[ny];
+        U = bPrev[W];
+        UNLINK(g);
+        LINK(P,A); LINK(A,W);
+        LINK(U,B); LINK(B,N);
+        if(op.back()==LoaderEbm::OP_S)
+          stack.push_back(A);
+        g = B;
+      }
+    }
+  }
+
+#undef LINK
+#undef UNLINK
+#undef VISIT
+
+  return nComponents;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverEbm::_encodeAttribute
+(RangeEncoder& encoder, const vector<float>& value, const int dim,
+ const int nBits, const float* vMin, const float* vMax,
+ const vector<int>& vIn, const vector<int>& pred,
+ const vector<uint8_t>& kind, const vector<int>& rep) const {
+
+  int maxQ = (1<<nBits)-1;
+  int i,j,type,last,qij;
+  double scale[4],dq;
+  encoder.encodeDirect(static_cast<uint32_t>(nBits),5);
+  for(j=0;j<dim;j++) {
+    encoder.encodeFloat(vMin[j]);
+    encoder.encodeFloat(vMax[j]);
+    double side = static_cast<double>(vMax[j])-vMin[j];
+    scale[j] = (side>0.0)?maxQ/side:0.0;
+  }
+
+  int n = static_cast<int>(vIn.size());
+  vector<int> q(static_cast<size_t>(n)*dim,0);
+  vector<RangeIntModel> model(3*dim);
+  for(i=0,last=-1;i<n;i++) {
+    if(kind[i]==LoaderEbm::VERTEX_DUMMY) continue;
+    if(kind[i]==LoaderEbm::VERTEX_SPLIT) {
+      for(j=0;j<dim;j++)
+        q[i*dim+j] = q[rep[i]*dim+j];
+      continue;
+    }
+    const int* p = &pred[3*i];
+    type = (p[2]>=0)?0:(p[1]>=0)?1:2;
+    for(j=0;j<dim;j++) {
+      dq  = static_cast<double>(value[vIn[i]*dim+j])-vMin[j];
+      dq  = floor(dq*scale[j]+0.5);
+      qij = (dq>0.0)?((dq<maxQ)?static_cast<int>(dq):maxQ):0;
+      q[i*dim+j] = qij;
+      model[type*dim+j].encodeSigned
+        (encoder,qij-LoaderEbm::predict(q,dim,j,p,last,maxQ));
+    }
+    last = i;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SaverEbm::save(const char* filename, SceneGraph& wrl) const {
+  bool success = false;
+  FILE* fp = (FILE*)0;
+  try {
+    // Check these conditions
+    if(filename==(char*)0)
+      throw new StrException("empty filename");
+    // 1) the SceneGraph should have a single child
+    if(wrl.getNumberOfChildren()!=1)
+      throw new StrException("number of SceneGraph children != 1");
+    // 2) the child should be a Shape node
+    Shape* shape = dynamic_cast<Shape*>(wrl[0]);
+    if(shape==(Shape*)0)
+      throw new StrException("first SceneGraph child not a Shape node");
+    // 3) the geometry of the Shape node should be an IndexedFaceSet node
+    IndexedFaceSet* ifs = dynamic_cast<IndexedFaceSet*>(shape->getGeometry());
+    if(ifs==(IndexedFaceSet*)0)
+      throw new StrException("Shape geometry not an IndexedFaceSet");
+
+    Color diffuseColor(0.8f,0.8f,0.8f);
+    Appearance* appearance = dynamic_cast<Appearance*>(shape->getAppearance());
+    if(appearance!=(Appearance*)0) {
+      Material* material = dynamic_cast<Material*>(appearance->getMaterial());
+      if(material!=(Material*)0)
+        diffuseColor = material->getDiffuseColor();
+    }
+
+    vector<int>&   coordIndex = ifs->getCoordIndex();
+    vector<float>  tmpCoord,tmpColor;
+    const vector<float>& coord = ifs->readCoord(tmpCoord);
+    vector<float>& normal     = ifs->getNormal();
+    const vector<float>& color = ifs->readColor(tmpColor);
+    vector<float>& texCoord   = ifs->getTexCoord();
+    int nV = static_cast<int>(coord.size()/3);
+    int i,iV,nF,nFs,iC0,iC1;
+    if(nV<1)
+      throw new StrException("IndexedFaceSet has no vertices");
+    for(i=0;i<static_cast<int>(coordIndex.size());i++)
+      if(coordIndex[i]>=nV)
+        throw new StrException("coordIndex value out of range");
+
+    uint32_t flags = 0;
+    if(ifs->getNormalBinding()==IndexedFaceSet::PB_PER_VERTEX &&
+       normal.size()==coord.size())
+      flags |= LoaderEbm::HAS_NORMAL;
+    if(ifs->getColorBinding()==IndexedFaceSet::PB_PER_VERTEX &&
+       color.size()==coord.size())
+      flags |= LoaderEbm::HAS_COLOR;
+    if(ifs->getTexCoordBinding()==IndexedFaceSet::PB_PER_VERTEX &&
+       texCoord.size()==2*static_cast<size_t>(nV))
+      flags |= LoaderEbm::HAS_TEX_COORD;
+
+    vector<int> tv,twin,origin;
+    bool manifold = _closeMesh(nV,coordIndex,tv,twin,origin);
+    if(manifold==false)
+      flags |= LoaderEbm::RAW_CONNECTIVITY;
+
+    vector<uint8_t> data;
+    data.reserve(coord.size()+tv.size()/4+1024);
+    RangeEncoder encoder(data);
+    encoder.encodeDirect(LoaderEbm::FILE_VERSION,32);
+    encoder.encodeDirect(flags,8);
+    encoder.encodeFloat(diffuseColor.r);
+    encoder.encodeFloat(diffuseColor.g);
+    encoder.encodeFloat(diffuseColor.b);
+
+    // vertices in the order they are stored, their kind, predictors,
+    // and the first occurrence of each split vertex
+    vector<int>     vIn,pred,rep;
+    vector<uint8_t> kind;
+    RangeIntModel   countModel;
+
+    if(manifold) {
+
+      vector<uint8_t> op;
+      vector<int>     arg,order;
+      int nComponents =
+        _traverse(tv,twin,static_cast<int>(origin.size()),op,arg,order,pred);
+      vector<int>().swap(twin);
+
+      countModel.encode(encoder,static_cast<uint32_t>(tv.size()/3));
+      countModel.encode(encoder,static_cast<uint32_t>(nComponents));
+      RangeSymbolModel opModel(3,7);
+      RangeIntModel    offsetModel,stackModel;
+      int context = 6, iArg = 0;
+      for(i=0;i<static_cast<int>(op.size());i++) {
+        opModel.encode(encoder,op[i],context);
+        if(op[i]==LoaderEbm::OP_S) {
+          offsetModel.encode(encoder,arg[iArg++]);
+        } else if(op[i]==LoaderEbm::OP_M) {
+          stackModel.encode(encoder,arg[iArg++]);
+          offsetModel.encode(encoder,arg[iArg++]);
+        }
+        context = op[i];
+      }
+
+      int nDecoded = static_cast<int>(order.size());
+      vIn.resize(nDecoded);
+      kind.assign(nDecoded,LoaderEbm::VERTEX_CODED);
+      rep.assign(nDecoded,-1);
+      vector<int> first(nV,-1),dummy,split;
+      for(i=0;i<nDecoded;i++) {
+        vIn[i] = iV = origin[order[i]];
+        if(iV<0) {
+          kind[i] = LoaderEbm::VERTEX_DUMMY;
+          dummy.push_back(i);
+        } else if(first[iV]>=0) {
+          kind[i] = LoaderEbm::VERTEX_SPLIT;
+          rep[i]  = first[iV];
+          split.push_back(i);
+        } else {
+          first[iV] = i;
+        }
+      }
+      int last;
+      countModel.encode(encoder,static_cast<uint32_t>(dummy.size()));
+      for(last=-1,i=0;i<static_cast<int>(dummy.size());last=dummy[i++])
+        countModel.encode(encoder,dummy[i]-last-1);
+      countModel.encode(encoder,static_cast<uint32_t>(split.size()));
+      for(last=-1,i=0;i<static_cast<int>(split.size());last=split[i++]) {
+        countModel.encode(encoder,split[i]-last-1);
+        countModel.encode(encoder,split[i]-rep[split[i]]-1);
+      }
+
+      // unreferenced vertices are stored at the end
+      int nLonely = 0;
+      for(iV=0;iV<nV;iV++) {
+        if(first[iV]>=0) continue;
+        vIn.push_back(iV);
+        kind.push_back(LoaderEbm::VERTEX_CODED);
+        rep.push_back(-1);
+        pred.push_back(-1); pred.push_back(-1); pred.push_back(-1);
+        nLonely++;
+      }
+      countModel.encode(encoder,nLonely);
+      LoaderEbm::resolvePredictors(pred,kind);
+
+    } else /* if(manifold==false) */ {
+
+      int nCI = static_cast<int>(coordIndex.size());
+      for(nF=iC0=iC1=0;iC1<=nCI;iC1++) {
+        if(iC1<nCI && coordIndex[iC1]>=0) continue;
+        if(iC1>iC0) nF++;
+        iC0 = iC1+1;
+      }
+      countModel.encode(encoder,nV);
+      countModel.encode(encoder,nF);
+      RangeIntModel sizeModel,indexModel;
+      int last = 0;
+      for(iC0=iC1=0;iC1<=nCI;iC1++) {
+        if(iC1<nCI && coordIndex[iC1]>=0) continue;
+        if((nFs=iC1-iC0)>0) {
+          sizeModel.encode(encoder,nFs-1);
+          for(i=iC0;i<iC1;last=coordIndex[i++])
+            indexModel.encodeSigned(encoder,coordIndex[i]-last);
+        }
+        iC0 = iC1+1;
+      }
+
+      vIn.resize(nV);
+      for(iV=0;iV<nV;iV++)
+        vIn[iV] = iV;
+      kind.assign(nV,LoaderEbm::VERTEX_CODED);
+      rep.assign(nV,-1);
+      pred.assign(3*static_cast<size_t>(nV),-1);
+    }
+
+    BBox coordBox(3,coord,false);
+    _encodeAttribute(encoder,coord,3,_coordBits,
+                     coordBox.getMin(),coordBox.getMax(),vIn,pred,kind,rep);
+    if(flags&LoaderEbm::HAS_NORMAL) {
+      BBox normalBox(3,normal,false);
+      _encodeAttribute(encoder,normal,3,NORMAL_BITS,
+                       normalBox.getMin(),normalBox.getMax(),vIn,pred,kind,rep);
+    }
+    if(flags&LoaderEbm::HAS_COLOR) {
+      static const float colorMin[3] = { 0.0f,0.0f,0.0f };
+      static const float colorMax[3] = { 1.0f,1.0f,1.0f };
+      _encodeAttribute(encoder,color,3,COLOR_BITS,
+                       colorMin,colorMax,vIn,pred,kind,rep);
+    }
+    if(flags&LoaderEbm::HAS_TEX_COORD) {
+      BBox texCoordBox(2,texCoord,false);
+      _encodeAttribute(encoder,texCoord,2,TEX_COORD_BITS,
+                       texCoordBox.getMin(),texCoordBox.getMax(),
+                       vIn,pred,kind,rep);
+    }
+    encoder.finish();
+
+    fp = fopen(filename,"wb");
+    if(fp==(FILE*)0)
+      throw new StrException("unable to open output file");
+    if(fwrite(LoaderEbm::FILE_SIGNATURE,1,8,fp)!=8 ||
+       fwrite(&data[0],1,data.size(),fp)!=data.size())
+      throw new StrException("unable to write file");
+    if(fclose(fp)!=0) {
+      fp = (FILE*)0;
+      throw new StrException("unable to write file");
+    }
+    fp = (FILE*)0;
+
+    success = true;
+
+  } catch(StrException* e) {
+
+    if(fp!=(FILE*)0) fclose(fp);
+    fprintf(stderr,"SaverEbm | ERROR | %s\n",e->what());
+    delete e;
+  }
+  return success;
+}
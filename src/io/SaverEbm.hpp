@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-09 16:21:05 taubin>
+//------------------------------------------------------------------------
+//
+// SaverEbm.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _SAVER_EBM_HPP_
+#define _SAVER_EBM_HPP_
+
+#include <cstdint>
+#include <vector>
+#include "Saver.hpp"
+#include "RangeCoder.hpp"
+
+#include <wrl/IndexedFaceSet.hpp>
+
+// see LoaderEbm.hpp for a description of the file format
+
+class SaverEbm : public Saver {
+
+private:
+
+  const static char* _ext;
+
+public:
+
+  SaverEbm()  {};
+  ~SaverEbm() {};
+
+  bool  save(const char* filename, SceneGraph& wrl) const;
+  const char* ext() const { return _ext; }
+
+  // number of bits of the quantized coordinates, in the range [4,24]
+  static void setCoordBits(const int nBits);
+  static int  getCoordBits();
+
+  static const int NORMAL_BITS    = 12;
+  static const int COLOR_BITS     = 8;
+  static const int TEX_COORD_BITS = 14;
+
+private:
+
+  static int _coordBits; // default : 16
+
+  // splits the faces into triangles (tv), and builds a closed
+  // oriented manifold mesh, by closing the boundary loops with
+  // dummy vertices and splitting the singular vertices; origin maps
+  // the vertices of the closed mesh to the vertices of the
+  // IndexedFaceSet, or to -1 for the dummy vertices; returns false
+  // if the faces are not all triangles, or if the mesh is not an
+  // oriented manifold with boundary
+  bool  _closeMesh
+  (const int nV, const vector<int>& coordIndex,
+   vector<int>& tv, vector<int>& twin, vector<int>& origin) const;
+
+  // Edgebreaker traversal of the closed mesh; returns the sequence
+  // of operations and their arguments, the vertices of the closed
+  // mesh in the order they are visited, and their predictors
+  int   _traverse
+  (const vector<int>& tv, const vector<int>& twin, const int nVc,
+   vector<uint8_t>& op, vector<int>& arg,
+   vector<int>& order, vector<int>& pred) const;
+
+  void  _encodeAttribute
+  (RangeEncoder& encoder, const vector<float>& value, const int dim,
+   const int nBits, const float* vMin, const float* vMax,
+   const vector<int>& vIn, const vector<int>& pred,
+   const vector<uint8_t>& kind, const vector<int>& rep) const;
+};
+
+#endif /* _SAVER_EBM_HPP_ */
@@ -40,6 +40,9 @@
 // DAMAGE.
 
 #include "SaverPly.hpp"
+#include "LoaderPly.hpp"
+#include "TextWriter.hpp"
+#include "BinaryWriter.hpp"
 #include <wrl/Shape.hpp>
 #include <wrl/Appearance.hpp>
 #include <wrl/Material.hpp>
@@ -50,6 +53,7 @@
 #include <util/CastMacros.hpp>
 
 #include <iostream>
+#include <atomic>
 using namespace std;
 
 const char*   SaverPly::_ext = "ply";
@@ -115,251 +119,216 @@ bool SaverPly::sameAsSystemEndian(Ply::DataType fileEndian) {
 //////////////////////////////////////////////////////////////////////
 // static
 bool SaverPly::writeBinaryValue
-(FILE * fp, const Ply::Element::Property::Type listType,
- const bool swapBytes, int nList) {
-  bool success = false;
-  if(fp!=nullptr) {
-    Endian::SingleValueBuffer svb;
-    switch(listType) {
-    case Ply::Element::Property::Type::CHAR:
-    case Ply::Element::Property::Type::INT8:
-      svb.c[0] = static_cast<char>(nList);
-      success = (fwrite(&(svb.c[0]),1,1,fp)==1);
-      break;
-    case Ply::Element::Property::Type::UCHAR:
-    case Ply::Element::Property::Type::UINT8:
-      svb.uc[0] = static_cast<uchar>(nList);
-      success = (fwrite(&(svb.uc[0]),1,1,fp)==1);
-      break;
-    case Ply::Element::Property::Type::SHORT:
-    case Ply::Element::Property::Type::INT16:
-      svb.s[0] = static_cast<short>(nList);
-      if(swapBytes) Endian::swapShort(svb);
-      success = (fwrite(&(svb.s[0]),1,2,fp)==2);
-      break;
-    case Ply::Element::Property::Type::USHORT:
-    case Ply::Element::Property::Type::UINT16:
-      svb.us[0] = static_cast<ushort>(nList);
-      if(swapBytes) Endian::swapUShort(svb);
-      success = (fwrite(&(svb.us[0]),1,2,fp)==2);
-      break;
-    case Ply::Element::Property::Type::INT:
-    case Ply::Element::Property::Type::INT32:
-      svb.i[0] = static_cast<int>(nList);
-      if(swapBytes) Endian::swapInt(svb);
-      success = (fwrite(&(svb.i[0]),1,4,fp)==4);
-      break;
-    case Ply::Element::Property::Type::UINT:
-    case Ply::Element::Property::Type::UINT32:
-      svb.ui[0] = static_cast<uint>(nList);
-      if(swapBytes) Endian::swapUInt(svb);
-      success = (fwrite(&(svb.ui[0]),1,4,fp)==4);
-      break;
-    default:
-      break;
-    }
+(BinaryWriter& bw, const Ply::Element::Property::Type listType, int nList) {
+  bool success = true;
+  switch(listType) {
+  case Ply::Element::Property::Type::CHAR:
+  case Ply::Element::Property::Type::INT8:
+    bw.putChar(static_cast<char>(nList));
+    break;
+  case Ply::Element::Property::Type::UCHAR:
+  case Ply::Element::Property::Type::UINT8:
+    bw.putUChar(static_cast<uchar>(nList));
+    break;
+  case Ply::Element::Property::Type::SHORT:
+  case Ply::Element::Property::Type::INT16:
+    bw.putShort(static_cast<short>(nList));
+    break;
+  case Ply::Element::Property::Type::USHORT:
+  case Ply::Element::Property::Type::UINT16:
+    bw.putUShort(static_cast<ushort>(nList));
+    break;
+  case Ply::Element::Property::Type::INT:
+  case Ply::Element::Property::Type::INT32:
+    bw.putInt(static_cast<int>(nList));
+    break;
+  case Ply::Element::Property::Type::UINT:
+  case Ply::Element::Property::Type::UINT32:
+    bw.putUInt(static_cast<uint>(nList));
+    break;
+  default:
+    success = false;
+    break;
   }
-  return success;
+  return success && (bw.hasFailed()==false);
 }
 
 //////////////////////////////////////////////////////////////////////
 // static
 bool SaverPly::writeBinaryValue
-(FILE * fp, const Ply::Element::Property::Type propertyType,
- const bool swapBytes, void* value, int index) {
-  bool success = false;
-  if(fp!=nullptr) {
-    Endian::SingleValueBuffer svb;
-    switch(propertyType) {
-    case Ply::Element::Property::Type::CHAR:
-    case Ply::Element::Property::Type::INT8:
-      {
-        svb.c[0] = (*static_cast<vector<char>*>(value))[UL(index)];
-        success = (fwrite(&(svb.c[0]),1,1,fp)==2);
-      }
-      break;
-    case Ply::Element::Property::Type::UCHAR:
-    case Ply::Element::Property::Type::UINT8:
-      {
-        svb.uc[0] = (*static_cast<vector<uchar>*>(value))[UL(index)];
-        success = (fwrite(&(svb.uc[0]),1,1,fp)==2);
-      }
-      break;
-    case Ply::Element::Property::Type::SHORT:
-    case Ply::Element::Property::Type::INT16:
-      {
-        svb.s[0] = (*static_cast<vector<short>*>(value))[UL(index)];
-        if(swapBytes) Endian::swapShort(svb);
-        success = (fwrite(&(svb.s[0]),1,2,fp)==2);
-      }
-      break;
-    case Ply::Element::Property::Type::USHORT:
-    case Ply::Element::Property::Type::UINT16:
-      {
-        svb.us[0] = (*static_cast<vector<ushort>*>(value))[UL(index)];
-        if(swapBytes) Endian::swapUShort(svb);
-        success = (fwrite(&(svb.us[0]),1,2,fp)==2);
-      }
-      break;
-    case Ply::Element::Property::Type::INT:
-    case Ply::Element::Property::Type::INT32:
-      {
-        svb.i[0] = (*static_cast<vector<int>*>(value))[UL(index)];
-        if(swapBytes) Endian::swapInt(svb);
-        success = (fwrite(&(svb.i[0]),1,4,fp)==4);
-      }
-      break;
-    case Ply::Element::Property::Type::UINT:
-    case Ply::Element::Property::Type::UINT32:
-      {
-        svb.ui[0] = (*static_cast<vector<uint>*>(value))[UL(index)];
-        if(swapBytes) Endian::swapUInt(svb);
-        success = (fwrite(&(svb.ui[0]),1,4,fp)==4);
-      }
-      break;
-    case Ply::Element::Property::Type::FLOAT:
-    case Ply::Element::Property::Type::FLOAT32:
-    case Ply::Element::Property::Type::FLOAT32_2:
-    case Ply::Element::Property::Type::FLOAT32_3:
-      {
-        int n =
-          (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
-          (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
-        for(int i=0;i<n;i++) {
-          svb.f[0] = (*static_cast<vector<float>*>(value))[n*UL(index)+i];
-          if(swapBytes) Endian::swapFloat(svb);
-          success = (fwrite(&(svb.f[0]),1,4,fp)==4);
-          if(success==false) break;
-        }
-      }
-      break;
-    case Ply::Element::Property::Type::DOUBLE:
-    case Ply::Element::Property::Type::FLOAT64:
-      {
-        svb.d[0] = (*static_cast<vector<double>*>(value))[UL(index)];
-        if(swapBytes) Endian::swapDouble(svb);
-        success = (fwrite(&(svb.d[0]),1,8,fp)==8);
-      }
-      break; 
-    default:
-      break;
+(BinaryWriter& bw, const Ply::Element::Property::Type propertyType,
+ void* value, int index, int n) {
+  size_t valueSize = 0;
+  size_t nValues   = 0;
+  const void* data = nullptr;
+  switch(propertyType) {
+  case Ply::Element::Property::Type::CHAR:
+  case Ply::Element::Property::Type::INT8:
+    {
+      vector<char>& v = *static_cast<vector<char>*>(value);
+      valueSize = sizeof(char); nValues = v.size(); data = v.data();
+    }
+    break;
+  case Ply::Element::Property::Type::UCHAR:
+  case Ply::Element::Property::Type::UINT8:
+    {
+      vector<uchar>& v = *static_cast<vector<uchar>*>(value);
+      valueSize = sizeof(uchar); nValues = v.size(); data = v.data();
+    }
+    break;
+  case Ply::Element::Property::Type::SHORT:
+  case Ply::Element::Property::Type::INT16:
+    {
+      vector<short>& v = *static_cast<vector<short>*>(value);
+      valueSize = sizeof(short); nValues = v.size(); data = v.data();
+    }
+    break;
+  case Ply::Element::Property::Type::USHORT:
+  case Ply::Element::Property::Type::UINT16:
+    {
+      vector<ushort>& v = *static_cast<vector<ushort>*>(value);
+      valueSize = sizeof(ushort); nValues = v.size(); data = v.data();
+    }
+    break;
+  case Ply::Element::Property::Type::INT:
+  case Ply::Element::Property::Type::INT32:
+    {
+      vector<int>& v = *static_cast<vector<int>*>(value);
+      valueSize = sizeof(int); nValues = v.size(); data = v.data();
+    }
+    break;
+  case Ply::Element::Property::Type::UINT:
+  case Ply::Element::Property::Type::UINT32:
+    {
+      vector<uint>& v = *static_cast<vector<uint>*>(value);
+      valueSize = sizeof(uint); nValues = v.size(); data = v.data();
     }
+    break;
+  case Ply::Element::Property::Type::FLOAT:
+  case Ply::Element::Property::Type::FLOAT32:
+  case Ply::Element::Property::Type::FLOAT32_2:
+  case Ply::Element::Property::Type::FLOAT32_3:
+    {
+      vector<float>& v = *static_cast<vector<float>*>(value);
+      valueSize = sizeof(float); nValues = v.size(); data = v.data();
+    }
+    break;
+  case Ply::Element::Property::Type::DOUBLE:
+  case Ply::Element::Property::Type::FLOAT64:
+    {
+      vector<double>& v = *static_cast<vector<double>*>(value);
+      valueSize = sizeof(double); nValues = v.size(); data = v.data();
+    }
+    break; 
+  default:
+    return false;
   }
-  return success;
+  size_t k =
+    (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
+    (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
+  if(index<0 || n<0 || k*(UL(index)+UL(n))>nValues)
+    return false;
+  bw.putArray(static_cast<const char*>(data)+k*UL(index)*valueSize,
+              k*UL(n),valueSize);
+  return (bw.hasFailed()==false);
 }
 
 //////////////////////////////////////////////////////////////////////
 // static
   
 bool SaverPly::writeBinaryColorValue
-(FILE * fp, const bool swapBytes, void* value, int index) {
-  bool success = false;
-  if(fp!=nullptr) {
-    Endian::SingleValueBuffer svb;
-    for(int i=0;i<3;i++) {
-      float& f = (*static_cast<vector<float>*>(value))[3*UL(index)+i]; 
-      svb.uc[0] = static_cast<uchar>(255.0*f); 
-      success = (fwrite(&(svb.uc[0]),1,1,fp)==1);
-      if(success==false) break;
-    }
+(BinaryWriter& bw, const Ply::Element::Property::Type propertyType,
+ void* value, int index) {
+  if(propertyType==Ply::Element::Property::Type::UINT8_4) {
+    // RGBA8; the alpha is not written
+    vector<uchar>& c = *static_cast<vector<uchar>*>(value);
+    bw.putArray(&c[4*UL(index)],3,sizeof(uchar));
+    return (bw.hasFailed()==false);
   }
-  return success;
+  for(int i=0;i<3;i++) {
+    float& f = (*static_cast<vector<float>*>(value))[3*UL(index)+i]; 
+    bw.putUChar(static_cast<uchar>(255.0*f)); 
+  }
+  return (bw.hasFailed()==false);
 }
 
 //////////////////////////////////////////////////////////////////////
 // static
 bool SaverPly::writeAsciiValue
-(FILE * fp, const Ply::Element::Property::Type propertyType,
+(TextWriter& tw, const Ply::Element::Property::Type propertyType,
  void* value, int index) {
-  bool success = false;
-  if(fp!=nullptr) {
-    switch(propertyType) {
-    case Ply::Element::Property::Type::CHAR:
-    case Ply::Element::Property::Type::INT8:
-      {
-        char & c = (*static_cast<vector<char>*>(value))[UL(index)];
-        success = (fprintf(fp,"%d",c)>0);
-      }
-      break;
-    case Ply::Element::Property::Type::UCHAR:
-    case Ply::Element::Property::Type::UINT8:
-      {
-        uchar & uc = (*static_cast<vector<uchar>*>(value))[UL(index)];
-        success = (fprintf(fp,"%d",uc)>0);
-      }
-      break;
-    case Ply::Element::Property::Type::SHORT:
-    case Ply::Element::Property::Type::INT16:
-      {
-        short & s = (*static_cast<vector<short>*>(value))[UL(index)];
-        success = (fprintf(fp,"%d",s)>0);
+  bool success = true;
+  switch(propertyType) {
+  case Ply::Element::Property::Type::CHAR:
+  case Ply::Element::Property::Type::INT8:
+    tw.putInt((*static_cast<vector<char>*>(value))[UL(index)]);
+    break;
+  case Ply::Element::Property::Type::UCHAR:
+  case Ply::Element::Property::Type::UINT8:
+    tw.putInt((*static_cast<vector<uchar>*>(value))[UL(index)]);
+    break;
+  case Ply::Element::Property::Type::SHORT:
+  case Ply::Element::Property::Type::INT16:
+    tw.putInt((*static_cast<vector<short>*>(value))[UL(index)]);
+    break;
+  case Ply::Element::Property::Type::USHORT:
+  case Ply::Element::Property::Type::UINT16:
+    tw.putInt((*static_cast<vector<ushort>*>(value))[UL(index)]);
+    break;
+  case Ply::Element::Property::Type::INT:
+  case Ply::Element::Property::Type::INT32:
+    tw.putInt((*static_cast<vector<int>*>(value))[UL(index)]);
+    break;
+  case Ply::Element::Property::Type::UINT:
+  case Ply::Element::Property::Type::UINT32:
+    tw.putUInt((*static_cast<vector<uint>*>(value))[UL(index)]);
+    break;
+  case Ply::Element::Property::Type::FLOAT:
+  case Ply::Element::Property::Type::FLOAT32:
+  case Ply::Element::Property::Type::FLOAT32_2:
+  case Ply::Element::Property::Type::FLOAT32_3:
+    {
+      int n =
+        (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
+        (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
+      vector<float>& f = *static_cast<vector<float>*>(value);
+      for(int i=0;i<n;i++) {
+        if(i>0) tw.put(' ');
+        tw.putFloat(f[i+n*UL(index)]);
       }
-      break;
-    case Ply::Element::Property::Type::USHORT:
-    case Ply::Element::Property::Type::UINT16:
-      {
-        ushort & us = (*static_cast<vector<ushort>*>(value))[UL(index)];
-        success = (fprintf(fp,"%d",us)>0);
-      }
-      break;
-    case Ply::Element::Property::Type::INT:
-    case Ply::Element::Property::Type::INT32:
-      {
-        int & i = (*static_cast<vector<int>*>(value))[UL(index)];
-        success = (fprintf(fp,"%d",i)>0);
-      }
-      break;
-    case Ply::Element::Property::Type::UINT:
-    case Ply::Element::Property::Type::UINT32:
-      {
-        uint & ui = (*static_cast<vector<uint>*>(value))[UL(index)];
-        success = (fprintf(fp,"%d",ui)>0);
-      }
-      break;
-    case Ply::Element::Property::Type::FLOAT:
-    case Ply::Element::Property::Type::FLOAT32:
-    case Ply::Element::Property::Type::FLOAT32_2:
-    case Ply::Element::Property::Type::FLOAT32_3:
-      {
-        int n =
-          (propertyType==Ply::Element::Property::Type::FLOAT32_3)?3:
-          (propertyType==Ply::Element::Property::Type::FLOAT32_2)?2:1;
-        for(int i=0;i<n;i++) {
-          float & f = (*static_cast<vector<float>*>(value))[i+n*UL(index)];
-          success = (fprintf(fp,"%f ",D(f))>0);
-          if(success==false) break;
-        }
-      }
-      break;
-    case Ply::Element::Property::Type::DOUBLE:
-    case Ply::Element::Property::Type::FLOAT64:
-      {
-        double & d = (*static_cast<vector<double>*>(value))[UL(index)];
-        success = (fprintf(fp,"%f",d)>0);
-      }
-      break; 
-    default:
-      break;
     }
+    break;
+  case Ply::Element::Property::Type::DOUBLE:
+  case Ply::Element::Property::Type::FLOAT64:
+    tw.putDouble((*static_cast<vector<double>*>(value))[UL(index)]);
+    break; 
+  default:
+    success = false;
+    break;
   }
   return success;
 }
 
 //////////////////////////////////////////////////////////////////////
 // static
-  
 bool SaverPly::writeAsciiColorValue
-(FILE * fp, void* value, int index) {
-  bool success = false;
-  if(fp!=nullptr) {
+(TextWriter& tw, const Ply::Element::Property::Type propertyType,
+ void* value, int index) {
+  if(propertyType==Ply::Element::Property::Type::UINT8_4) {
+    // RGBA8; the alpha is not written
+    vector<uchar>& c = *static_cast<vector<uchar>*>(value);
     for(int i=0;i<3;i++) {
-      float& f = (*static_cast<vector<float>*>(value))[3*UL(index)+i]; 
-      uchar uc = static_cast<uchar>(255.0*f); 
-      success = (fprintf(fp,"%3d ",uc)>0);
-      if(success==false) break;
+      if(i>0) tw.put(' ');
+      tw.putInt(c[4*UL(index)+UL(i)]);
     }
+    return true;
   }
-  return success;
+  for(int i=0;i<3;i++) {
+    float& f = (*static_cast<vector<float>*>(value))[3*UL(index)+i]; 
+    if(i>0) tw.put(' ');
+    tw.putInt(static_cast<uchar>(255.0*f));
+  }
+  return true;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -575,15 +544,20 @@ SaverPly::writeBinaryData
   try {
 
     bool swapBytes = (sameAsSystemEndian(dataType)==false);
+    BinaryWriter bw(fp,swapBytes);
 
     Ply::Element* element;
     Ply::Element::Property* property;
     Ply::Element::Property::Type listType;
     Ply::Element::Property::Type propertyType;
     void* propertyValue;
-    int iElement,iList0,iList1,iList,nList,k0,k1;
+    int iElement,iList0,iList1,nList,k0,k1;
     int iProperty,iRecord,nElements,nProperties,nRecords;
     string name,propertyName;
+    // in wrlMode the faces are stored in coordIndex separated by -1
+    // values, without list offsets, and read sequentially
+    bool wrlMode = ply.getWrlMode();
+    int iWrl = 0;
 
     nElements = ply.getNumberOfElements();
     if(_ostrm!=nullptr) {
@@ -609,6 +583,22 @@ SaverPly::writeBinaryData
         *_ostrm << indent << "        ";
       }
 
+      // a single scalar property is stored in the file exactly as in
+      // memory, and is written as one block
+      if(nProperties==1) {
+        property = element->getProperty(0);
+        if(property->isList()==false && property->getName()!="color" &&
+           property->getName()!="alpha") {
+          if(writeBinaryValue(bw,property->getPropertyType(),
+                              property->getValue(),0,nRecords)==false)
+            throw new StrException("unable to write binary values");
+          if(_ostrm!=nullptr) {
+            *_ostrm << "100%" << endl;
+          }
+          continue;
+        }
+      }
+
       for(k0=iRecord=0;iRecord<nRecords;iRecord++) {
 
         for(iProperty=0;iProperty<nProperties;iProperty++) {
@@ -620,25 +610,32 @@ SaverPly::writeBinaryData
 
           if(property->isList()) {
             listType = property->getListType();
-            iList0   = property->getListFirst(iRecord );
-            nList    = property->getListFirst(iRecord+1)-iList0;
-            if(propertyName=="coordIndex") nList--; // don't write -1 separator
-            iList1   = iList0+nList;
+            if(wrlMode && propertyName=="coordIndex") {
+              vector<int>& coordIndex = *static_cast<vector<int>*>(propertyValue);
+              iList0 = iList1 = iWrl;
+              while(iList1<I(coordIndex.size()) && coordIndex[UI(iList1)]>=0)
+                iList1++;
+              iWrl  = iList1+1;
+              nList = iList1-iList0;
+            } else {
+              iList0   = property->getListFirst(iRecord );
+              nList    = property->getListFirst(iRecord+1)-iList0;
+              if(propertyName=="coordIndex") nList--; // don't write -1 separator
+            }
             
-            if(writeBinaryValue(fp,listType,swapBytes,nList)==false)
+            if(writeBinaryValue(bw,listType,nList)==false)
               throw new StrException("unable to write list binary count");
-            for(iList=iList0;iList<iList1;iList++) {
-              if(writeBinaryValue
-                 (fp,propertyType,swapBytes,propertyValue,iList)==false)
-                throw new StrException("unable to write list binary value");
-            }
+            if(writeBinaryValue
+               (bw,propertyType,propertyValue,iList0,nList)==false)
+              throw new StrException("unable to write list binary value");
           } else {
             if(propertyName=="color") {
-              if(writeBinaryColorValue(fp,swapBytes,propertyValue,iRecord)==false)
+              if(writeBinaryColorValue
+                 (bw,propertyType,propertyValue,iRecord)==false)
                 throw new StrException("unable to write binary value");
             } else {
               if(writeBinaryValue
-                 (fp,propertyType,swapBytes,propertyValue,iRecord)==false)
+                 (bw,propertyType,propertyValue,iRecord)==false)
                 throw new StrException("unable to write binary value");
             }
           }
@@ -661,6 +658,9 @@ SaverPly::writeBinaryData
       }
         
     }
+
+    if(bw.flush()==false)
+      throw new StrException("unable to write binary data");
       
     success = true;
       
@@ -695,14 +695,14 @@ SaverPly::writeAsciiData
     if(dataType!=Ply::DataType::ASCII)
         throw new StrException("  incorrect data type");
 
+    TextWriter tw(fp);
+
     Ply::Element* element;
     Ply::Element::Property* property;
-    // Ply::Element::Property::Type listType;
-    Ply::Element::Property::Type propertyType;
-    void* propertyValue;
-    int iElement,iList0,iList1,iList,nList,iProperty;
-    int iRecord,nElements,nProperties,nRecords,k0,k1;
-    string name,propertyName;
+    int iElement,iProperty,iRecord,nElements,nProperties,nRecords,nChunks;
+    string name;
+    // see writeBinaryData()
+    bool wrlMode = ply.getWrlMode();
 
     nElements = ply.getNumberOfElements();
     if(_ostrm!=nullptr) {
@@ -728,57 +728,97 @@ SaverPly::writeAsciiData
         *_ostrm << indent << "        ";
       }
 
-      for(k0=iRecord=0;iRecord<nRecords;iRecord++) {
-
-        for(iProperty=0;iProperty<nProperties;iProperty++) {
-          property      = element->getProperty(iProperty);
-          propertyName  = property->getName();
-          if(_skipAlpha && propertyName=="alpha") continue;
-          propertyType  = property->getPropertyType();
-          propertyValue = property->getValue();
+      // properties written, and the wrlMode coordIndex if any
+      vector<Ply::Element::Property*> written;
+      vector<int>* wrlCoordIndex = nullptr;
+      for(iProperty=0;iProperty<nProperties;iProperty++) {
+        property = element->getProperty(iProperty);
+        if(_skipAlpha && property->getName()=="alpha") continue;
+        written.push_back(property);
+        if(wrlMode && property->isList() && property->getName()=="coordIndex")
+          wrlCoordIndex = static_cast<vector<int>*>(property->getValue());
+      }
 
-          if(property->isList()) {
-            // listType = property->getListType();
-            iList0   = property->getListFirst(iRecord );
-            nList    = property->getListFirst(iRecord+1)-iList0;
-            if(propertyName=="coordIndex") nList--; // don't write -1 separator 
-            iList1   = iList0+nList;
-
-            fprintf(fp,"%d ",nList);
-            for(iList=iList0;iList<iList1;) {
-              if(writeAsciiValue(fp,propertyType,propertyValue,iList)==false)
-                throw new StrException("unable to write list ascii value");
-              if(++iList<iList1) fprintf(fp," ");
-            }
+      // the records are formatted in parallel, in chunks of
+      // recordsPerChunk records; the wrlMode faces are located by
+      // scanning coordIndex for the first face of each chunk
+      int recordsPerChunk = TextWriter::CHUNK_VALUES/4;
+      nChunks = (nRecords+recordsPerChunk-1)/recordsPerChunk;
+      vector<int> chunkWrl;
+      if(wrlCoordIndex!=nullptr) {
+        int i,nCoordIndex = I(wrlCoordIndex->size());
+        for(iRecord=i=0;iRecord<nRecords;iRecord++) {
+          if(iRecord%recordsPerChunk==0)
+            chunkWrl.push_back(i);
+          while(i<nCoordIndex && (*wrlCoordIndex)[UI(i)]>=0) i++;
+          i++;
+        }
+      }
 
-          } else /* if(property->isList()==false) */ {
-            if(propertyName=="color") {
-              if(writeAsciiColorValue(fp,propertyValue,iRecord)==false)
-                throw new StrException("unable to write ascii color value");
-            } else {
-              if(writeAsciiValue(fp,propertyType,propertyValue,iRecord)==false)
-                throw new StrException("unable to write ascii value");
+      atomic<bool> failed(false);
+      tw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+          int iRecord0 = iChunk*recordsPerChunk;
+          int iRecord1 = (iRecord0+recordsPerChunk<nRecords)?
+            iRecord0+recordsPerChunk:nRecords;
+          int iWrl = (wrlCoordIndex!=nullptr)?chunkWrl[UI(iChunk)]:0;
+          int iList0,iList1,iList,nList;
+          bool success = true;
+          for(int iRecord=iRecord0;iRecord<iRecord1 && success;iRecord++) {
+            for(Ply::Element::Property* property : written) {
+              const string& propertyName = property->getName();
+              Ply::Element::Property::Type propertyType =
+                property->getPropertyType();
+              void* propertyValue = property->getValue();
+
+              if(property->isList()) {
+                if(static_cast<void*>(wrlCoordIndex)==propertyValue) {
+                  iList0 = iList1 = iWrl;
+                  while(iList1<I(wrlCoordIndex->size()) &&
+                        (*wrlCoordIndex)[UI(iList1)]>=0)
+                    iList1++;
+                  iWrl  = iList1+1;
+                  nList = iList1-iList0;
+                } else {
+                  iList0   = property->getListFirst(iRecord );
+                  nList    = property->getListFirst(iRecord+1)-iList0;
+                  if(propertyName=="coordIndex") nList--; // don't write -1 separator 
+                  iList1   = iList0+nList;
+                }
+
+                twc.putInt(nList);
+                for(iList=iList0;iList<iList1 && success;iList++) {
+                  twc.put(' ');
+                  success = writeAsciiValue(twc,propertyType,propertyValue,iList);
+                }
+                twc.put(' ');
+
+              } else /* if(property->isList()==false) */ {
+                if(propertyName=="color") {
+                  success = writeAsciiColorValue
+                    (twc,propertyType,propertyValue,iRecord);
+                } else {
+                  success = writeAsciiValue(twc,propertyType,propertyValue,iRecord);
+                }
+                twc.put(' ');
+              }
             }
-
-            fprintf(fp," ");
+            twc.endLine(); // end of record
           }
-        }
-        fprintf(fp,"\n"); // end of record
+          if(success==false) failed = true;
+        });
 
-        k1 = (10*(iRecord+1))/nRecords;
-        if(k1>k0) {
-          if(_ostrm!=nullptr) {
-            *_ostrm << (10*k1) << "% ";
-          }
-          k0 = k1;
-        }
-      }
+      if(failed)
+        throw new StrException("unable to write ascii value");
       if(_ostrm!=nullptr) {
-        *_ostrm << endl;
+        *_ostrm << "100%" << endl;
       }
 
     }
 
+    if(tw.flush()==false)
+      throw new StrException("unable to write ascii data");
+    success = true;
+
   } catch (StrException* e) {
     if(_ostrm!=nullptr) {
       *_ostrm << indent << "  " << e->what() << endl;
@@ -962,7 +1002,7 @@ bool SaverPly::writeHeader
       }
           
       // color -> UCHAR red,green,blue
-      if(ifs.hasColorPerVertex()) {
+      if(ifs.hasColorPerFace()) {
         fprintf(fp,"property uchar red\n");
         fprintf(fp,"property uchar green\n");
         fprintf(fp,"property uchar blue\n");            
@@ -1018,13 +1058,21 @@ SaverPly::writeBinaryData
 
   bool swapBytes = (sameAsSystemEndian(dataType)==false);
 
-  int i,i0,i1,iF,nList,iV,iN,iC,j,k0,k1;
+  int i0,i1,iF,nList,iV,iN,iC,j,k0,k1;
+  float x[3];
 
-  vector<float>& coord         = ifs.getCoord();
+  // the compact colors are written as they are, and the compact
+  // coordinates are decoded one at a time, so that the storage of
+  // the IndexedFaceSet does not change
+  const uchar*   colorRGBA8    = (ifs.hasCompactColor())?
+    ifs.getColorRGBA8().data():nullptr;
+  const float*   coord         = (ifs.hasCompactCoord())?
+    nullptr:ifs.getCoord().data();
   vector<int>&   coordIndex    = ifs.getCoordIndex();
   vector<float>& normal        = ifs.getNormal();
   vector<int>&   normalIndex   = ifs.getNormalIndex();
-  vector<float>& color         = ifs.getColor();
+  const float*   color         = (colorRGBA8!=nullptr)?
+    nullptr:ifs.getColor().data();
   vector<int>&   colorIndex    = ifs.getColorIndex();
   vector<float>& texCoord      = ifs.getTexCoord();
   // vector<int>&   texCoordIndex = ifs.getTexCoordIndex();
@@ -1032,56 +1080,64 @@ SaverPly::writeBinaryData
   int nVertices = ifs.getNumberOfVertices();
   int nFaces    = ifs.getNumberOfFaces();
 
-  Endian::SingleValueBuffer svb;
+  BinaryWriter bw(fp,swapBytes);
 
   if(_ostrm!=nullptr) {
     *_ostrm << indent << "  name = vertex" << endl;
     *_ostrm << indent << "    ";
   }
 
-  for(k0=iV=0;iV<nVertices;iV++) {
+  bool ifsHasNormalPerVertex   = ifs.hasNormalPerVertex();
+  bool ifsHasColorPerVertex    = ifs.hasColorPerVertex();
+  bool ifsHasTexCoordPerVertex = ifs.hasTexCoordPerVertex();
 
-    if(true /* ifs.hasCoordPerVertex() */) {
-      for(j=0;j<3;j++) {
-        svb.f[0] = coord[UI(3*iV+j)];
-        if(swapBytes) Endian::swapFloat(svb);
-        fwrite(&(svb.f[0]),1,4,fp); // ==4
-      }
+  if(ifsHasNormalPerVertex==false &&
+     ifsHasColorPerVertex==false &&
+     ifsHasTexCoordPerVertex==false &&
+     coord!=nullptr) {
+
+    // the vertex records are the coord array
+    bw.putArray(coord,3*UL(nVertices),sizeof(float));
+    if(_ostrm!=nullptr) {
+      *_ostrm << "100% ";
     }
-    if(ifs.hasNormalPerVertex()) {
-      for(j=0;j<3;j++) {
-        svb.f[0] = normal[UI(3*iV+j)];
-        if(swapBytes) Endian::swapFloat(svb);
-        fwrite(&(svb.f[0]),1,4,fp); // ==4
+
+  } else {
+
+    for(k0=iV=0;iV<nVertices;iV++) {
+
+      if(coord==nullptr) {
+        ifs.getCoordValue(iV,x);
+        bw.putArray(x,3,sizeof(float));
+      } else /* if(ifs.hasCoordPerVertex()) */ {
+        bw.putArray(&coord[3*UL(iV)],3,sizeof(float));
       }
-    }
-    if(ifs.hasColorPerVertex()) {
-      for(j=0;j<3;j++) {
-        svb.uc[0] = UC(color[UI(3*iV+j)]*255.0f);
-        if(swapBytes) Endian::swapFloat(svb);
-        fwrite(&(svb.uc[0]),1,1,fp); // ==1
+      if(ifsHasNormalPerVertex) {
+        bw.putArray(&normal[3*UL(iV)],3,sizeof(float));
       }
-    }
-    if(ifs.hasTexCoordPerVertex()) {
-      for(j=0;j<2;j++) {
-        svb.f[0] = texCoord[UI(2*iV+j)];
-        if(swapBytes) Endian::swapFloat(svb);
-        fwrite(&(svb.f[0]),1,4,fp); // ==4
+      if(ifsHasColorPerVertex && colorRGBA8!=nullptr) {
+        bw.putArray(&colorRGBA8[4*UL(iV)],3,sizeof(uchar));
+      } else if(ifsHasColorPerVertex) {
+        for(j=0;j<3;j++)
+          bw.putUChar(UC(color[UI(3*iV+j)]*255.0f));
+      }
+      if(ifsHasTexCoordPerVertex) {
+        bw.putArray(&texCoord[2*UL(iV)],2,sizeof(float));
       }
-    }
 
-    k1 = (10*(iV+1))/nVertices;
-    if(k1>k0) {
-      if(_ostrm!=nullptr) {
-        *_ostrm << (10*k1) << "% ";
+      k1 = (10*(iV+1))/nVertices;
+      if(k1>k0) {
+        if(_ostrm!=nullptr) {
+          *_ostrm << (10*k1) << "% ";
+        }
+        k0 = k1;
       }
-      k0 = k1;
     }
   }
   if(_ostrm!=nullptr) {
     *_ostrm << endl;
   }
-
+
   if(nFaces>0) {
     if(_ostrm!=nullptr) {
       *_ostrm << indent << "  name = face" << endl;
@@ -1096,31 +1152,21 @@ SaverPly::writeBinaryData
       if(coordIndex[UI(i1)]<0) {
         nList = i1-i0;
 
-        svb.uc[0] = UC(nList);
-        fwrite(&(svb.uc[0]),1,1,fp); // ==1
-
-        for(i=i0;i<i1;i++) {
-          svb.i[0] = coordIndex[UI(i)];
-          if(swapBytes) Endian::swapInt(svb);
-          fwrite(&(svb.i[0]),1,4,fp); // ==4
-        }
+        bw.putUChar(UC(nList));
+        bw.putArray(&coordIndex[UI(i0)],UL(nList),sizeof(int));
 
         if(ifsHasNormalPerFace) {
           iN = (normalIndex.size()>0)?normalIndex[UI(iF)]:iF;
-          for(j=0;j<3;j++) {
-            svb.f[0] = normal[UI(3*iN+j)];
-            if(swapBytes) Endian::swapFloat(svb);
-            fwrite(&(svb.f[0]),1,4,fp); // ==4
-          }
+          bw.putArray(&normal[3*UL(iN)],3,sizeof(float));
         }
 
         if(ifsHasColorPerFace) {
           iC = (colorIndex.size()>0)?colorIndex[UI(iF)]:iF;
-          for(j=0;j<3;j++) {
-            svb.uc[0] = UC(color[UI(3*iC+j)]*255.0f);
-            if(swapBytes) Endian::swapFloat(svb);
-            fwrite(&(svb.uc[0]),1,1,fp); // ==1
-          }
+          if(colorRGBA8!=nullptr)
+            bw.putArray(&colorRGBA8[4*UL(iC)],3,sizeof(uchar));
+          else
+            for(j=0;j<3;j++)
+              bw.putUChar(UC(color[UI(3*iC+j)]*255.0f));
         }
 
         k1 = (10*(iF+1))/nFaces;
@@ -1141,11 +1187,13 @@ SaverPly::writeBinaryData
     
   } // if(nFaces>0)
 
+  bool success = bw.flush();
+
   if(_ostrm!=nullptr) {
     *_ostrm << indent << "} SaverPly::writeBinaryData(IndexedFaceSet &)" << endl;
   }
 
-  return true;
+  return success;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -1171,14 +1219,18 @@ SaverPly::writeAsciiData
     return false;
   }
 
-  int i,i0,i1,iF,iV,iN,iC,j,k0,k1;
-  uint nList;
+  int i,iF,iV;
 
-  vector<float>& coord         = ifs.getCoord();
+  // see writeBinaryData(IndexedFaceSet&)
+  const uchar*   colorRGBA8    = (ifs.hasCompactColor())?
+    ifs.getColorRGBA8().data():nullptr;
+  const float*   coord         = (ifs.hasCompactCoord())?
+    nullptr:ifs.getCoord().data();
   vector<int>&   coordIndex    = ifs.getCoordIndex();
   vector<float>& normal        = ifs.getNormal();
   vector<int>&   normalIndex   = ifs.getNormalIndex();
-  vector<float>& color         = ifs.getColor();
+  const float*   color         = (colorRGBA8!=nullptr)?
+    nullptr:ifs.getColor().data();
   vector<int>&   colorIndex    = ifs.getColorIndex();
   vector<float>& texCoord      = ifs.getTexCoord();
   // vector<int>&   texCoordIndex = ifs.getTexCoordIndex();
@@ -1186,41 +1238,61 @@ SaverPly::writeAsciiData
   int nVertices = ifs.getNumberOfVertices();
   int nFaces    = ifs.getNumberOfFaces();
 
+  TextWriter tw(fp);
+
+  // the records are formatted in parallel, in chunks of about
+  // TextWriter::CHUNK_VALUES values; progress is reported per element
+
   if(_ostrm!=nullptr) {
     *_ostrm << indent << "  name = vertex" << endl;
     *_ostrm << indent << "    ";
   }
 
-  for(k0=iV=0;iV<nVertices;iV++) {
-
-    if(true /* ifs.hasCoordPerVertex() */) {
-      for(j=0;j<3;j++)
-        fprintf(fp,"%f ",D(coord[UI(3*iV+j)]));
-    }
-    if(ifs.hasNormalPerVertex()) {
-      for(j=0;j<3;j++)
-        fprintf(fp,"%f ",D(normal[UI(3*iV+j)]));
-    }
-    if(ifs.hasColorPerVertex()) {
-      for(j=0;j<3;j++)
-        fprintf(fp,"%d ",UC(color[UI(3*iV+j)]*255.0f));
-    }
-    if(ifs.hasTexCoordPerVertex()) {
-      for(j=0;j<2;j++)
-        fprintf(fp,"%f ",D(texCoord[UI(2*iV+j)]));
-    }
-    fprintf(fp,"\n");
-
-    k1 = (10*(iV+1))/nVertices;
-    if(k1>k0) {
-      if(_ostrm!=nullptr) {
-        *_ostrm << (10*k1) << "% ";
+  bool ifsHasNormalPerVertex   = ifs.hasNormalPerVertex();
+  bool ifsHasColorPerVertex    = ifs.hasColorPerVertex();
+  bool ifsHasTexCoordPerVertex = ifs.hasTexCoordPerVertex();
+
+  int vChunk  = TextWriter::CHUNK_VALUES/4;
+  int nChunks = (nVertices+vChunk-1)/vChunk;
+  tw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+      int iV0 = iChunk*vChunk, j;
+      int iV1 = (iV0+vChunk<nVertices)?iV0+vChunk:nVertices;
+      float x[3];
+      for(int iV=iV0;iV<iV1;iV++) {
+        if(coord==nullptr) {
+          ifs.getCoordValue(iV,x);
+          for(j=0;j<3;j++) {
+            twc.putFloat(x[j]); twc.put(' ');
+          }
+        } else /* if(ifs.hasCoordPerVertex()) */ {
+          for(j=0;j<3;j++) {
+            twc.putFloat(coord[UI(3*iV+j)]); twc.put(' ');
+          }
+        }
+        if(ifsHasNormalPerVertex) {
+          for(j=0;j<3;j++) {
+            twc.putFloat(normal[UI(3*iV+j)]); twc.put(' ');
+          }
+        }
+        if(ifsHasColorPerVertex && colorRGBA8!=nullptr) {
+          for(j=0;j<3;j++) {
+            twc.putInt(colorRGBA8[4*UL(iV)+UL(j)]); twc.put(' ');
+          }
+        } else if(ifsHasColorPerVertex) {
+          for(j=0;j<3;j++) {
+            twc.putInt(UC(color[UI(3*iV+j)]*255.0f)); twc.put(' ');
+          }
+        }
+        if(ifsHasTexCoordPerVertex) {
+          for(j=0;j<2;j++) {
+            twc.putFloat(texCoord[UI(2*iV+j)]); twc.put(' ');
+          }
+        }
+        twc.endLine();
       }
-      k0 = k1;
-    }
-  }
+    });
   if(_ostrm!=nullptr) {
-    *_ostrm << endl;
+    *_ostrm << "100%" << endl;
   }
   
   if(nFaces>0) {
@@ -1232,48 +1304,66 @@ SaverPly::writeAsciiData
     bool ifsHasNormalPerFace = ifs.hasNormalPerFace();
     bool ifsHasColorPerFace  = ifs.hasColorPerFace();
 
-    for(k0=iF=i0=i1=0;i1<I(coordIndex.size());i1++) {
-      if(coordIndex[UI(i1)]<0) {
-        nList = UC(i1-i0);
-
-        fprintf(fp,"%d ",nList);
-        for(i=i0;i<i1;i++)
-          fprintf(fp,"%d ",coordIndex[UI(i)]);
+    // first face and first coordIndex of each chunk
+    int nCoordIndex = I(coordIndex.size());
+    vector<int> chunkFace,chunkFirst;
+    for(iF=iV=i=0;i<nCoordIndex;i++) {
+      if(iV>=I(chunkFirst.size())*TextWriter::CHUNK_VALUES) {
+        chunkFace.push_back(iF);
+        chunkFirst.push_back(iV);
+      }
+      if(coordIndex[UI(i)]<0) {
+        iV = i+1; iF++;
+      }
+    }
+    chunkFace.push_back(iF);
+    chunkFirst.push_back(iV);
+
+    nChunks = I(chunkFirst.size())-1;
+    tw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+        int i,i0,i1,iN,iC,j;
+        int iF  = chunkFace[UI(iChunk)];
+        int iF1 = chunkFace[UI(iChunk+1)];
+        for(i0=i1=chunkFirst[UI(iChunk)];iF<iF1;i1++) {
+          if(coordIndex[UI(i1)]<0) {
+            twc.putInt(UC(i1-i0)); twc.put(' ');
+            for(i=i0;i<i1;i++) {
+              twc.putInt(coordIndex[UI(i)]); twc.put(' ');
+            }
         
-        if(ifsHasNormalPerFace) {
-          iN = (normalIndex.size()>0)?normalIndex[UI(iF)]:iF;
-          for(j=0;j<3;j++)
-            fprintf(fp,"%f ",D(normal[UI(iN)]));
-        }
-
-        if(ifsHasColorPerFace) {
-          iC = (colorIndex.size()>0)?colorIndex[UI(iF)]:iF;
-          for(j=0;j<3;j++)
-            fprintf(fp,"%f ",D(color[UC(iC)]));
-        }
+            if(ifsHasNormalPerFace) {
+              iN = (normalIndex.size()>0)?normalIndex[UI(iF)]:iF;
+              for(j=0;j<3;j++) {
+                twc.putFloat(normal[UI(3*iN+j)]); twc.put(' ');
+              }
+            }
 
-        fprintf(fp,"\n");
+            // declared as uchar properties by writeHeader()
+            if(ifsHasColorPerFace) {
+              iC = (colorIndex.size()>0)?colorIndex[UI(iF)]:iF;
+              for(j=0;j<3;j++) {
+                if(colorRGBA8!=nullptr)
+                  twc.putInt(colorRGBA8[4*UL(iC)+UL(j)]);
+                else
+                  twc.putInt(UC(color[UI(3*iC+j)]*255.0f));
+                twc.put(' ');
+              }
+            }
 
-        k1 = (10*(iF+1))/nFaces;
-        if(k1>k0) {
-          if(_ostrm!=nullptr) {
-            *_ostrm << (10*k1) << "% ";
+            twc.endLine();
+            i0=i1+1; iF++;
           }
-          k0 = k1;
         }
-
-        i0=i1+1; iF++;
-      }
-    }
+      });
     if(_ostrm!=nullptr) {
-      *_ostrm << endl;
+      *_ostrm << "100%" << endl;
     }
   } // if(nFaces>0)
 
   if(_ostrm!=nullptr) {
     *_ostrm << indent << "} SaverPly::writeAsciiData(IndexedFaceSet &)" << endl;
   }
-  return true;
+  return tw.flush();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -1376,8 +1466,17 @@ SaverPly::save(const char* filename, SceneGraph& wrl) const {
       Ply* ply = ifsPly->getPly();
       if(ply==nullptr) throw new StrException("ply==nullptr");
 
-      if(save(filename,*ply,indent+"  ",_dataType)==false)
-        throw new StrException("save(fp,Ply&)==false");
+      // the property arrays were moved into the IndexedFaceSet, and
+      // are only put back in the Ply while it is saved; if they no
+      // longer match the Ply header, the IndexedFaceSet is saved
+      if(ifsPly->restorePly()) {
+        bool saved = save(filename,*ply,indent+"  ",_dataType);
+        ifsPly->releasePly();
+        if(saved==false)
+          throw new StrException("save(fp,Ply&)==false");
+      } else if(save(filename,*ifsPly,indent+"  ",_dataType)==false) {
+        throw new StrException("save(fp,IndexedFaceSet&)==false");
+      }
     
       success = true;
 
@@ -1405,3 +1504,223 @@ SaverPly::save(const char* filename, SceneGraph& wrl) const {
 
   return success;
 }
+
+//////////////////////////////////////////////////////////////////////
+SaverPly::RecordWriter::RecordWriter():
+  _fp(nullptr),
+  _tw(nullptr),
+  _bw(nullptr),
+  _dataType(Ply::DataType::NONE) {
+}
+
+//////////////////////////////////////////////////////////////////////
+SaverPly::RecordWriter::~RecordWriter() {
+  close();
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverPly::RecordWriter::open
+(const char* filename, Ply& ply, const Ply::DataType dataType) {
+  close();
+  if(filename==nullptr)
+    throw new StrException("filename==nullptr");
+  if(dataType==Ply::DataType::NONE)
+    throw new StrException("ply DataType is NONE");
+  _fp = fopen(filename,"wb");
+  if(_fp==nullptr)
+    throw new StrException("unable to open file");
+  setvbuf(_fp,nullptr,_IOFBF,1<<20);
+  if(writeHeader(_fp,ply,_indent+"  ",dataType)==false)
+    throw new StrException("unable to write file header");
+  _dataType = dataType;
+  if(dataType==Ply::DataType::ASCII)
+    _tw = new TextWriter(_fp);
+  else
+    _bw = new BinaryWriter(_fp,sameAsSystemEndian(dataType)==false);
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SaverPly::RecordWriter::close() {
+  bool success = true;
+  if(_tw!=nullptr) {
+    success = _tw->flush();
+    delete _tw;
+    _tw = nullptr;
+  }
+  if(_bw!=nullptr) {
+    success = _bw->flush();
+    delete _bw;
+    _bw = nullptr;
+  }
+  if(_fp!=nullptr) {
+    if(ferror(_fp)!=0) success = false;
+    if(fclose(_fp)!=0) success = false;
+    _fp = nullptr;
+  }
+  return success;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverPly::RecordWriter::_writeBinary
+(const Ply::Element::Property::Type type, const double value) {
+  switch(type) {
+  case Ply::Element::Property::Type::CHAR:
+  case Ply::Element::Property::Type::INT8:
+    _bw->putChar(static_cast<char>(value));
+    break;
+  case Ply::Element::Property::Type::UCHAR:
+  case Ply::Element::Property::Type::UINT8:
+    _bw->putUChar(static_cast<uchar>(value));
+    break;
+  case Ply::Element::Property::Type::SHORT:
+  case Ply::Element::Property::Type::INT16:
+    _bw->putShort(static_cast<short>(value));
+    break;
+  case Ply::Element::Property::Type::USHORT:
+  case Ply::Element::Property::Type::UINT16:
+    _bw->putUShort(static_cast<ushort>(value));
+    break;
+  case Ply::Element::Property::Type::INT:
+  case Ply::Element::Property::Type::INT32:
+    _bw->putInt(static_cast<int>(value));
+    break;
+  case Ply::Element::Property::Type::UINT:
+  case Ply::Element::Property::Type::UINT32:
+    _bw->putUInt(static_cast<uint>(value));
+    break;
+  case Ply::Element::Property::Type::FLOAT:
+  case Ply::Element::Property::Type::FLOAT32:
+    _bw->putFloat(static_cast<float>(value));
+    break;
+  case Ply::Element::Property::Type::DOUBLE:
+  case Ply::Element::Property::Type::FLOAT64:
+    _bw->putDouble(value);
+    break;
+  default:
+    throw new StrException("unexpected binary value type");
+  }
+  if(_bw->hasFailed())
+    throw new StrException("unable to write binary value");
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverPly::RecordWriter::_writeAscii
+(const Ply::Element::Property::Type type, const double value) {
+  switch(type) {
+  case Ply::Element::Property::Type::FLOAT:
+  case Ply::Element::Property::Type::FLOAT32:
+    _tw->putFloat(static_cast<float>(value));
+    break;
+  case Ply::Element::Property::Type::DOUBLE:
+  case Ply::Element::Property::Type::FLOAT64:
+    _tw->putDouble(value);
+    break;
+  case Ply::Element::Property::Type::UINT:
+  case Ply::Element::Property::Type::UINT32:
+    _tw->putUInt(static_cast<uint>(value));
+    break;
+  case Ply::Element::Property::Type::NONE:
+    throw new StrException("unexpected ascii value type");
+  default:
+    _tw->putInt(static_cast<int>(value));
+    break;
+  }
+  if(_tw->hasFailed())
+    throw new StrException("unable to write ascii value");
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverPly::RecordWriter::write
+(Ply::Element& element, const vector<double>& record) {
+  if(_fp==nullptr)
+    throw new StrException("stream is not open");
+  bool ascii = (_dataType==Ply::DataType::ASCII);
+  size_t j = 0, nValues = record.size();
+  bool first = true;
+  int nProperties = element.getNumberOfProperties();
+  for(int iProperty=0;iProperty<nProperties;iProperty++) {
+    Ply::Element::Property* property = element.getProperty(iProperty);
+    Ply::Element::Property::Type type = property->getPropertyType();
+    // writeHeader() does not declare the alpha property
+    bool skip = (_skipAlpha && property->getName()=="alpha");
+    size_t n = 1;
+    if(property->isList()) {
+      if(j>=nValues) throw new StrException("incomplete record");
+      n += static_cast<size_t>(record[j]);
+    }
+    if(j+n>nValues) throw new StrException("incomplete record");
+    if(skip) { j += n; continue; }
+    for(size_t i=0;i<n;i++,j++) {
+      Ply::Element::Property::Type t =
+        (property->isList() && i==0)?property->getListType():type;
+      if(ascii) {
+        if(first==false) _tw->put(' ');
+        _writeAscii(t,record[j]);
+      } else {
+        _writeBinary(t,record[j]);
+      }
+      first = false;
+    }
+  }
+  if(ascii) _tw->put('\n');
+}
+
+//////////////////////////////////////////////////////////////////////
+// static
+bool SaverPly::convert
+(const char* inFilename, const char* outFilename,
+ const Ply::DataType dataType) {
+
+  bool success = false;
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "SaverPly::convert() {" << endl;
+  }
+
+  // the streaming interface requires the properties not to be merged
+  bool wrlMode = Ply::getDefaultWrlMode();
+  Ply::setDefaultWrlMode(false);
+  Ply ply;
+  Ply::setDefaultWrlMode(wrlMode);
+
+  LoaderPly::RecordReader reader;
+  RecordWriter            writer;
+  vector<double>          record;
+
+  try {
+
+    reader.open(inFilename,ply);
+    writer.open(outFilename,ply,dataType);
+
+    int nElements = ply.getNumberOfElements();
+    for(int iElement=0;iElement<nElements;iElement++) {
+      Ply::Element* element = ply.getElement(iElement);
+      int nRecords = element->getNumberOfRecords();
+      if(_ostrm!=nullptr) {
+        *_ostrm << _indent << "  element " << element->getName()
+                << " " << nRecords << endl;
+      }
+      for(int iRecord=0;iRecord<nRecords;iRecord++) {
+        reader.read(*element,record);
+        writer.write(*element,record);
+      }
+    }
+
+    reader.close();
+    if(writer.close()==false)
+      throw new StrException("unable to flush output file");
+    success = true;
+
+  } catch(StrException* e) {
+    if(_ostrm!=nullptr) {
+      *_ostrm << _indent << "  " << e->what() << endl;
+    }
+    delete e;
+  }
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "} SaverPly::convert()" << endl;
+  }
+
+  return success;
+}
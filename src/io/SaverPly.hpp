@@ -49,6 +49,9 @@
 #include <wrl/IndexedFaceSetPly.hpp>
 #include "Saver.hpp"
 
+class TextWriter;
+class BinaryWriter;
+
 class SaverPly : public Saver {
 
 public:
@@ -76,28 +79,62 @@ public:
   static void setOstream(ostream* ostrm);
   static void setIndent(const string s="");
 
+  // streaming interface; see LoaderPly::RecordReader for the record
+  // layout; the header is written from a Ply which only contains the
+  // element and property declarations
+
+  class RecordWriter {
+  public:
+    RecordWriter();
+    ~RecordWriter();
+    // writes the header; throws StrException* on error
+    void  open(const char* filename, Ply& ply, const Ply::DataType dataType);
+    // writes one record of the element; throws StrException* on error
+    void  write(Ply::Element& element, const vector<double>& record);
+    // returns false if the data could not be flushed to the file
+    bool  close();
+  private:
+    FILE*         _fp;
+    TextWriter*   _tw; // ascii output only
+    BinaryWriter* _bw; // binary output only
+    Ply::DataType _dataType;
+    void          _writeBinary
+                  (const Ply::Element::Property::Type type, const double value);
+    void          _writeAscii
+                  (const Ply::Element::Property::Type type, const double value);
+  };
+
+  // converts between ply encodings record by record, using a bounded
+  // amount of memory independently of the size of the file
+  static bool convert(const char* inFilename, const char* outFilename,
+                      const Ply::DataType dataType);
+
   private:
 
   static Ply::DataType systemEndian();
   static bool          sameAsSystemEndian(Ply::DataType fileEndian);
 
   static bool writeBinaryValue
-  (FILE * fp, const Ply::Element::Property::Type listType,
-   const bool swapBytes, int nList);
+  (BinaryWriter& bw, const Ply::Element::Property::Type listType,
+   int nList);
 
+  // writes the n consecutive values starting at index i
   static bool writeBinaryValue
-  (FILE * fp, const Ply::Element::Property::Type propertyType,
-   const bool swapBytes, void* value, int i);
+  (BinaryWriter& bw, const Ply::Element::Property::Type propertyType,
+   void* value, int i, int n=1);
   
+  // the color property is FLOAT32_3 scaled to [0,1], or UINT8_4
   static bool writeBinaryColorValue
-  (FILE * fp, const bool swapBytes, void* value, int i);
+  (BinaryWriter& bw, const Ply::Element::Property::Type propertyType,
+   void* value, int i);
 
   static bool writeAsciiValue
-  (FILE * fp, const Ply::Element::Property::Type propertyType,
+  (TextWriter& tw, const Ply::Element::Property::Type propertyType,
    void* value, int i);
   
   static bool writeAsciiColorValue
-  (FILE * fp, void* value, int i);
+  (TextWriter& tw, const Ply::Element::Property::Type propertyType,
+   void* value, int i);
   
   static bool
   writeHeader(FILE * fp, Ply& ply, const string indent="",
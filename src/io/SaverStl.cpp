@@ -38,8 +38,11 @@
 
 #include "SaverStl.hpp"
 #include "StrException.hpp"
+#include "TextWriter.hpp"
+#include "BinaryWriter.hpp"
 
 #include "wrl/Shape.hpp"
+#include "util/Endian.hpp"
 // #include "wrl/Appearance.hpp"
 // #include "wrl/Material.hpp"
 // #include "core/Faces.hpp"
@@ -58,56 +61,93 @@ bool SaverStl::_saveAscii
 (FILE* fp, const char* solidname, IndexedFaceSet& ifs) const {
 
   int nF = ifs.getNumberOfFaces();
-  vector<float>& coord       = ifs.getCoord();
+  vector<float>  tmpCoord;
+  const vector<float>& coord = ifs.readCoord(tmpCoord);
   vector<int>&   coordIndex  = ifs.getCoordIndex();
   vector<float>& normal      = ifs.getNormal();
   vector<int>&   normalIndex = ifs.getNormalIndex();
   // already checked that ifs.getNormalPerVertex()==false
   bool           npf_indexed = (static_cast<int>(normalIndex.size())==nF);
 
-  fprintf(fp,"solid %s\n",solidname);
-    
-  int iF,iV0,iV1,iV2,iN;
-  float x0,x1,x2,n0,n1,n2;
-  for(iF=0;iF<nF;iF++) { // for each face ...
-
-    iN = (npf_indexed)? normalIndex[iF] : iF;
-    float nx = normal[3*iN  ];
-    float ny = normal[3*iN+1];
-    float nz = normal[3*iN+2];
-
-    iV0 = coordIndex[4*iF+0];
-    iV1 = coordIndex[4*iF+1];
-    iV2 = coordIndex[4*iF+2];
-
-    float x0 = coord[3*iV0  ];
-    float y0 = coord[3*iV0+1];
-    float z0 = coord[3*iV0+2];
-
-    float x1 = coord[3*iV1  ];
-    float y1 = coord[3*iV1+1];
-    float z1 = coord[3*iV1+2];
-
-    float x2 = coord[3*iV2  ];
-    float y2 = coord[3*iV2+1];
-    float z2 = coord[3*iV2+2];
-
-    fprintf(fp,"  facet normal %g %g %g\n",nx,ny,nz);
-    fprintf(fp,"    outer loop\n");
-    fprintf(fp,"      vertex %g %g %g\n",x0,y0,z0);
-    fprintf(fp,"      vertex %g %g %g\n",x1,y1,z1);
-    fprintf(fp,"      vertex %g %g %g\n",x2,y2,z2);
-    fprintf(fp,"    endloop\n");
-    fprintf(fp,"  endfacet\n");
-
-    // TODO
-    // use fprintf() to print formatted text
-
+  // formatting the floats is most of the cost, and in a connected
+  // mesh each vertex is shared by about six triangles, so the
+  // " x y z\n" text of each vertex is formatted only once, and then
+  // copied into each facet; triangle soups are formatted directly
+  int  nV     = static_cast<int>(coord.size()/3);
+  bool shared = (2*nV<3*nF);
+  vector<size_t> vStart;
+  TextWriter vtw;
+  if(shared) {
+    int vChunk  = TextWriter::CHUNK_VALUES/3;
+    int nChunks = (nV+vChunk-1)/vChunk;
+    vStart.resize(static_cast<size_t>(nV)+1,0);
+    vtw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+        int iV0 = iChunk*vChunk;
+        int iV1 = (iV0+vChunk<nV)?iV0+vChunk:nV;
+        int iV,j;
+        size_t size0;
+        for(iV=iV0;iV<iV1;iV++) {
+          size0 = twc.size();
+          for(j=0;j<3;j++) {
+            twc.put(' ');
+            twc.putFloat(coord[3*iV+j]);
+          }
+          twc.put('\n');
+          vStart[iV+1] = twc.size()-size0; // length, for now
+        }
+      });
+    for(int iV=0;iV<nV;iV++)
+      vStart[iV+1] += vStart[iV];
   }
-
-  fprintf(fp,"endsolid %s\n",solidname);
-
-  return true;
+  const char* vText = vtw.data();
+
+  TextWriter tw(fp);
+
+  tw.put("solid ");
+  tw.put(solidname);
+  tw.put('\n');
+
+  // the facets are formatted in parallel, in chunks of about
+  // TextWriter::CHUNK_VALUES values
+  int fChunk  = TextWriter::CHUNK_VALUES/12;
+  int nChunks = (nF+fChunk-1)/fChunk;
+  tw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+      int iF0 = iChunk*fChunk;
+      int iF1 = (iF0+fChunk<nF)?iF0+fChunk:nF;
+      int iF,iV,iN,j,k;
+      for(iF=iF0;iF<iF1;iF++) { // for each face ...
+
+        iN = (npf_indexed)? normalIndex[iF] : iF;
+
+        twc.put("  facet normal");
+        for(j=0;j<3;j++) {
+          twc.put(' ');
+          twc.putFloat(normal[3*iN+j]);
+        }
+        twc.put("\n    outer loop\n");
+        for(k=0;k<3;k++) {
+          iV = coordIndex[4*iF+k];
+          twc.put("      vertex");
+          if(shared) {
+            twc.put(vText+vStart[iV],vStart[iV+1]-vStart[iV]);
+          } else {
+            for(j=0;j<3;j++) {
+              twc.put(' ');
+              twc.putFloat(coord[3*iV+j]);
+            }
+            twc.put('\n');
+          }
+        }
+        twc.put("    endloop\n  endfacet\n");
+
+      }
+    });
+
+  tw.put("endsolid ");
+  tw.put(solidname);
+  tw.put('\n');
+
+  return tw.flush();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -115,73 +155,42 @@ bool SaverStl::_saveBinary
 (FILE* fp, const char* solidname, IndexedFaceSet& ifs) const {
 
   int nF = ifs.getNumberOfFaces();
-  vector<float>& coord       = ifs.getCoord();
+  vector<float>  tmpCoord;
+  const vector<float>& coord = ifs.readCoord(tmpCoord);
   vector<int>&   coordIndex  = ifs.getCoordIndex();
   vector<float>& normal      = ifs.getNormal();
   vector<int>&   normalIndex = ifs.getNormalIndex();
   // already checked that ifs.getNormalPerVertex()==false
   bool           npf_indexed = (static_cast<int>(normalIndex.size())==nF);
 
-  size_t written = 0;
+  // binary STL files are little endian
+  BinaryWriter bw(fp,Endian::isLittleEndianSystem()==false);
 
   // allocate header and initialize to zero
   char header[80];
   memset(header,0x00,80);
   snprintf(header,80,"BINARY STL %s Exported by DGP2025",solidname);
-
-  written = fwrite(header,1,80,fp);
-  if(written!=80)
-    throw new StrException("unable to write binary STL header");
+  bw.putBytes(header,80);
 
   uint32_t nTriangles = static_cast<uint32_t>(nF);
-  written = fwrite((void*)&nTriangles,1,4,fp);
-  if(written<4)
-    throw new StrException("unable to write number of triangles");
+  bw.putUInt(nTriangles);
 
   uint16_t abc = 0x0000; // attribute byte count
 
-  int iF,iV0,iV1,iV2,iN;
-  float n[3],v[3];
+  // each 50 byte record is assembled in the BinaryWriter buffer
+  int iF,iN;
   for(iF=0;iF<nF;iF++) {
-
-    iN   = (npf_indexed)?normalIndex[iF]:iF;
-    n[0] = normal[3*iN  ];
-    n[1] = normal[3*iN+1];
-    n[2] = normal[3*iN+2];
-    written = fwrite(n,1,12,fp);
-    if(written!=12)
-      throw new StrException("unable to write normal vector");
-
-    iV0  = coordIndex[4*iF+0];
-    v[0] = coord[3*iV0  ];
-    v[1] = coord[3*iV0+1];
-    v[2] = coord[3*iV0+2];
-    written = fwrite(v,1,12,fp);
-    if(written!=12)
-      throw new StrException("unable to write vertex 0");
-
-    iV1  = coordIndex[4*iF+1];
-    v[0] = coord[3*iV1  ];
-    v[1] = coord[3*iV1+1];
-    v[2] = coord[3*iV1+2];
-    written = fwrite(v,1,12,fp);
-    if(written!=12)
-      throw new StrException("unable to write vertex 1");
-
-    iV2  = coordIndex[4*iF+2];
-    v[0] = coord[3*iV2  ];
-    v[1] = coord[3*iV2+1];
-    v[2] = coord[3*iV2+2];
-    written = fwrite(v,1,12,fp);
-    if(written!=12)
-      throw new StrException("unable to write vertex 2");
-
-    written = fwrite(&abc,1,2,fp);
-    if(written<2)
-      throw new StrException("unable to write atribute byte count");
-
+    iN = (npf_indexed)?normalIndex[iF]:iF;
+    bw.putArray(&normal[3*iN],3,sizeof(float));
+    bw.putArray(&coord[3*coordIndex[4*iF+0]],3,sizeof(float));
+    bw.putArray(&coord[3*coordIndex[4*iF+1]],3,sizeof(float));
+    bw.putArray(&coord[3*coordIndex[4*iF+2]],3,sizeof(float));
+    bw.putUShort(abc);
   }
 
+  if(bw.flush()==false)
+    throw new StrException("unable to write binary STL triangles");
+
   return true;
 }
 
@@ -0,0 +1,415 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-04 11:08:15 taubin>
+//------------------------------------------------------------------------
+//
+// SaverWrb.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include "SaverWrb.hpp"
+#include "LoaderWrb.hpp"
+#include "LoaderWrl.hpp"
+#include "StrException.hpp"
+
+const char* SaverWrb::_ext = "wrb";
+
+//////////////////////////////////////////////////////////////////////
+SaverWrb::SaverWrb():
+  _sourceSize(0),
+  _sourceHash(0),
+  _inlinedPath(),
+  _inlinedSize(),
+  _inlinedHash(),
+  _srcDir(""),
+  _dstDir(""),
+  _nInlined(0),
+  _cacheSource("") {
+}
+
+//////////////////////////////////////////////////////////////////////
+// collects the paths of the files loaded by the Inline nodes, including
+// the ones nested in their content; returns false if the url of an
+// Inline node was not found
+static bool _findInlined
+(Node* node, set<const Node*>& visited, set<string>& path) {
+  if(node==(Node*)0 || visited.insert(node).second==false) return true;
+  bool found = true;
+  if(node->isInline()) {
+    const string& p = ((Inline*)node)->getPath();
+    if(p=="") found = false;
+    else      path.insert(p);
+  }
+  if(node->isGroup()) {
+    vector<pNode>& children = ((Group*)node)->getChildren();
+    for(size_t i=0;i<children.size();i++)
+      if(_findInlined(children[i],visited,path)==false)
+        found = false;
+  }
+  return found;
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SaverWrb::setSourceFile(const char* filename, SceneGraph& wrl) {
+  _sourceSize = _sourceHash = 0;
+  _inlinedPath.clear();
+  _inlinedSize.clear();
+  _inlinedHash.clear();
+  if(filename==(char*)0) return true;
+  set<const Node*> visited;
+  set<string>      path;
+  bool success =
+    LoaderWrb::hashFile(filename,_sourceSize,_sourceHash) &&
+    _findInlined(&wrl,visited,path);
+  string dir = LoaderWrl::dirName(filename);
+  set<string>::iterator i;
+  for(i=path.begin();success && i!=path.end();i++) {
+    uint64_t size,hash;
+    success = LoaderWrb::hashFile(i->c_str(),size,hash);
+    _inlinedPath.push_back(LoaderWrl::relativePath(*i,dir));
+    _inlinedSize.push_back(size);
+    _inlinedHash.push_back(hash);
+  }
+  if(success) return true;
+  setSourceFile((char*)0,wrl);
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SaverWrb::saveCache(const char* filename, SceneGraph& wrl) {
+  string cache = LoaderWrb::cacheFilename(filename);
+  if(cache=="") return false;
+  if(setSourceFile(filename,wrl)==false) return false;
+  _cacheSource = filename;
+  bool success = save(cache.c_str(),wrl);
+  _cacheSource = "";
+  setSourceFile((char*)0,wrl);
+  return success;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveBlock
+(FILE* fp, const void* data, const size_t nBytes) const {
+  if(nBytes>0 && fwrite(data,1,nBytes,fp)!=nBytes)
+    throw new StrException("unable to write file");
+  static const char pad[8] = { 0,0,0,0,0,0,0,0 };
+  size_t nPad = (8-nBytes%8)%8;
+  if(nPad>0 && fwrite(pad,1,nPad,fp)!=nPad)
+    throw new StrException("unable to write file");
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveString(FILE* fp, const string& str) const {
+  uint64_t n = str.size();
+  saveBlock(fp,&n,sizeof(uint64_t));
+  if(n>0) saveBlock(fp,str.data(),(size_t)n);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveVecFloat(FILE* fp, const vector<float>& vec) const {
+  uint64_t n = vec.size();
+  saveBlock(fp,&n,sizeof(uint64_t));
+  if(n>0) saveBlock(fp,&vec[0],(size_t)n*sizeof(float));
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveVecInt(FILE* fp, const vector<int>& vec) const {
+  uint64_t n = vec.size();
+  saveBlock(fp,&n,sizeof(uint64_t));
+  if(n>0) saveBlock(fp,&vec[0],(size_t)n*sizeof(int));
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveFloats(FILE* fp, const float* value, const int n) const {
+  saveBlock(fp,value,n*sizeof(float));
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveBool(FILE* fp, const bool value) const {
+  unsigned char b = (value)?1:0;
+  saveBlock(fp,&b,1);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveNode(FILE* fp, Node* node) const {
+  uint32_t header[2] = { LoaderWrb::NODE_NULL, 0 };
+  map<const Node*,uint64_t>::const_iterator i;
+  if(node!=(Node*)0 && (i=_saved.find(node))!=_saved.end()) {
+    // a node shared through DEF/USE
+    header[0] = LoaderWrb::NODE_USE;
+    uint64_t index = i->second;
+    saveBlock(fp,header,sizeof(header));
+    saveBlock(fp,&index,sizeof(uint64_t));
+    return;
+  }
+  if(node!=(Node*)0) {
+    header[1] = (node->getShow())?1:0;
+    if(node->isTransform())
+      header[0] = LoaderWrb::NODE_TRANSFORM;
+    else if(node->isInline())
+      header[0] = LoaderWrb::NODE_INLINE;
+    else if(node->isGroup())
+      header[0] = LoaderWrb::NODE_GROUP;
+    else if(node->isShape())
+      header[0] = LoaderWrb::NODE_SHAPE;
+    else if(node->isAppearance())
+      header[0] = LoaderWrb::NODE_APPEARANCE;
+    else if(node->isMaterial())
+      header[0] = LoaderWrb::NODE_MATERIAL;
+    else if(node->isImageTexture())
+      header[0] = LoaderWrb::NODE_IMAGE_TEXTURE;
+    else if(node->isPixelTexture())
+      header[0] = LoaderWrb::NODE_PIXEL_TEXTURE;
+    else if(node->isIndexedFaceSet())
+      header[0] = LoaderWrb::NODE_INDEXED_FACE_SET;
+    else if(node->isIndexedLineSet())
+      header[0] = LoaderWrb::NODE_INDEXED_LINE_SET;
+  }
+  saveBlock(fp,header,sizeof(header));
+  if(header[0]==LoaderWrb::NODE_NULL) return;
+  saveString(fp,node->getName());
+  switch(header[0]) {
+  case LoaderWrb::NODE_GROUP:
+    saveGroup(fp,*((Group*)node));
+    break;
+  case LoaderWrb::NODE_TRANSFORM:
+    saveTransform(fp,*((Transform*)node));
+    break;
+  case LoaderWrb::NODE_INLINE:
+    saveInline(fp,*((Inline*)node));
+    break;
+  case LoaderWrb::NODE_SHAPE:
+    saveShape(fp,*((Shape*)node));
+    break;
+  case LoaderWrb::NODE_APPEARANCE:
+    saveAppearance(fp,*((Appearance*)node));
+    break;
+  case LoaderWrb::NODE_MATERIAL:
+    saveMaterial(fp,*((Material*)node));
+    break;
+  case LoaderWrb::NODE_IMAGE_TEXTURE:
+    saveImageTexture(fp,*((ImageTexture*)node));
+    break;
+  case LoaderWrb::NODE_PIXEL_TEXTURE:
+    savePixelTexture(fp,*((PixelTexture*)node));
+    break;
+  case LoaderWrb::NODE_INDEXED_FACE_SET:
+    saveIndexedFaceSet(fp,*((IndexedFaceSet*)node));
+    break;
+  case LoaderWrb::NODE_INDEXED_LINE_SET:
+    saveIndexedLineSet(fp,*((IndexedLineSet*)node));
+    break;
+  }
+  // numbered after its descendants, as in LoaderWrb::loadNode()
+  uint64_t index = _saved.size();
+  _saved[node] = index;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveGroup(FILE* fp, Group& group) const {
+  Vec3f& center = group.getBBoxCenter();
+  Vec3f& size   = group.getBBoxSize();
+  float bbox[6] = { center.x, center.y, center.z, size.x, size.y, size.z };
+  saveFloats(fp,bbox,6);
+  vector<pNode>& children = group.getChildren();
+  uint64_t nChildren = children.size();
+  saveBlock(fp,&nChildren,sizeof(uint64_t));
+  for(size_t i=0;i<children.size();i++)
+    saveNode(fp,children[i]);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveTransform(FILE* fp, Transform& transform) const {
+  Vec3f& center           = transform.getCenter();
+  Rotation& rotation      = transform.getRotation();
+  Vec3f& scale            = transform.getScale();
+  Rotation& scaleOrientation = transform.getScaleOrientation();
+  Vec3f& translation      = transform.getTranslation();
+  Vec3f& rAxis            = rotation.getAxis();
+  Vec3f& sAxis            = scaleOrientation.getAxis();
+  float value[17] = {
+    center.x, center.y, center.z,
+    rAxis.x, rAxis.y, rAxis.z, rotation.getAngle(),
+    scale.x, scale.y, scale.z,
+    sAxis.x, sAxis.y, sAxis.z, scaleOrientation.getAngle(),
+    translation.x, translation.y, translation.z
+  };
+  saveFloats(fp,value,17);
+  saveGroup(fp,transform);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveInline(FILE* fp, Inline& inl) const {
+  Vec3f& center = inl.getBBoxCenter();
+  Vec3f& size   = inl.getBBoxSize();
+  float bbox[6] = { center.x, center.y, center.z, size.x, size.y, size.z };
+  saveFloats(fp,bbox,6);
+  vector<string>& url = inl.getUrl();
+  uint64_t nUrl = url.size();
+  saveBlock(fp,&nUrl,sizeof(uint64_t));
+  for(size_t i=0;i<url.size();i++)
+    saveString(fp,(_nInlined>0)?url[i]:
+               LoaderWrl::relativeUrl(url[i],_srcDir,_dstDir));
+  const string& path = inl.getPath();
+  saveString(fp,(path=="")?path:LoaderWrl::relativePath(path,_dstDir));
+  // shared by the Inline nodes referencing the same file, and written
+  // once as any other shared node
+  _nInlined++;
+  saveNode(fp,inl.getContent().get());
+  _nInlined--;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveShape(FILE* fp, Shape& shape) const {
+  saveNode(fp,shape.getAppearance());
+  saveNode(fp,shape.getGeometry());
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveAppearance(FILE* fp, Appearance& appearance) const {
+  saveNode(fp,appearance.getMaterial());
+  saveNode(fp,appearance.getTexture());
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveMaterial(FILE* fp, Material& material) const {
+  Color& diffuseColor  = material.getDiffuseColor();
+  Color& emissiveColor = material.getEmissiveColor();
+  Color  specularColor = material.getSpecularColor();
+  float value[12] = {
+    material.getAmbientIntensity(),
+    diffuseColor.r, diffuseColor.g, diffuseColor.b,
+    emissiveColor.r, emissiveColor.g, emissiveColor.b,
+    material.getShininess(),
+    specularColor.r, specularColor.g, specularColor.b,
+    material.getTransparency()
+  };
+  saveFloats(fp,value,12);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::savePixelTexture(FILE* fp, PixelTexture& pixelTexture) const {
+  saveBool(fp,pixelTexture.getRepeatS());
+  saveBool(fp,pixelTexture.getRepeatT());
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveImageTexture(FILE* fp, ImageTexture& imageTexture) const {
+  savePixelTexture(fp,imageTexture);
+  vector<string>& url = imageTexture.getUrl();
+  uint64_t nUrl = url.size();
+  saveBlock(fp,&nUrl,sizeof(uint64_t));
+  for(size_t i=0;i<url.size();i++)
+    saveString(fp,url[i]);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveIndexedFaceSet(FILE* fp, IndexedFaceSet& ifs) const {
+  saveBool(fp,ifs.getCcw());
+  saveBool(fp,ifs.getConvex());
+  saveBool(fp,ifs.getSolid());
+  saveBool(fp,ifs.getNormalPerVertex());
+  saveBool(fp,ifs.getColorPerVertex());
+  saveFloats(fp,&(ifs.getCreaseangle()),1);
+  vector<float> tmp;
+  saveVecFloat(fp,ifs.readCoord(tmp));
+  saveVecInt(fp,ifs.getCoordIndex());
+  saveVecFloat(fp,ifs.getNormal());
+  saveVecInt(fp,ifs.getNormalIndex());
+  saveVecFloat(fp,ifs.readColor(tmp));
+  saveVecInt(fp,ifs.getColorIndex());
+  saveVecFloat(fp,ifs.getTexCoord());
+  saveVecInt(fp,ifs.getTexCoordIndex());
+}
+
+//////////////////////////////////////////////////////////////////////
+void SaverWrb::saveIndexedLineSet(FILE* fp, IndexedLineSet& ils) const {
+  saveBool(fp,ils.getColorPerVertex());
+  saveVecFloat(fp,ils.getCoord());
+  saveVecInt(fp,ils.getCoordIndex());
+  saveVecFloat(fp,ils.getColor());
+  saveVecInt(fp,ils.getColorIndex());
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SaverWrb::save(const char* filename, SceneGraph& wrl) const {
+  bool success = false;
+
+  FILE* fp = (FILE*)0;
+  try {
+
+    if(filename==(char*)0) throw new StrException("filename==null");
+    fp = fopen(filename,"wb");
+    if(fp==(FILE*)0) throw new StrException("fp==(FILE*)0");
+    setvbuf(fp,(char*)0,_IOFBF,1<<20);
+    _saved.clear();
+    _srcDir   = LoaderWrl::dirName(wrl.getUrl());
+    _dstDir   = LoaderWrl::dirName((_cacheSource!="")?_cacheSource:filename);
+    _nInlined = 0;
+
+    uint32_t version[2] = { LoaderWrb::FILE_VERSION, LoaderWrb::FILE_BYTE_ORDER };
+    saveBlock(fp,LoaderWrb::FILE_SIGNATURE,8);
+    saveBlock(fp,version,sizeof(version));
+    saveBlock(fp,&_sourceSize,sizeof(uint64_t));
+    saveBlock(fp,&_sourceHash,sizeof(uint64_t));
+    uint64_t nInlined = _inlinedPath.size();
+    saveBlock(fp,&nInlined,sizeof(uint64_t));
+    for(size_t i=0;i<_inlinedPath.size();i++) {
+      uint64_t value[2] = { _inlinedSize[i], _inlinedHash[i] };
+      saveString(fp,_inlinedPath[i]);
+      saveBlock(fp,value,sizeof(value));
+    }
+
+    // the root node is stored as a Group
+    uint32_t header[2] = { LoaderWrb::NODE_GROUP, 1 };
+    saveBlock(fp,header,sizeof(header));
+    saveString(fp,wrl.getName());
+    saveGroup(fp,wrl);
+
+    int failed = fclose(fp);
+    fp = (FILE*)0;
+    if(failed!=0) throw new StrException("unable to write file");
+    _saved.clear();
+    success = true;
+
+  } catch(StrException* e) {
+
+    if(fp!=(FILE*)0) fclose(fp);
+    fprintf(stderr,"ERROR | %s\n",e->what());
+    delete e;
+    _saved.clear();
+    // do not leave a truncated file behind
+    if(filename!=(char*)0) remove(filename);
+
+  }
+
+  return success;
+}
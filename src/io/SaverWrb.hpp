@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-04 11:08:15 taubin>
+//------------------------------------------------------------------------
+//
+// SaverWrb.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _SAVER_WRB_HPP_
+#define _SAVER_WRB_HPP_
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <map>
+#include "Saver.hpp"
+
+#include <wrl/Transform.hpp>
+#include <wrl/Inline.hpp>
+#include <wrl/Shape.hpp>
+#include <wrl/Appearance.hpp>
+#include <wrl/Material.hpp>
+#include <wrl/ImageTexture.hpp>
+#include <wrl/IndexedFaceSet.hpp>
+#include <wrl/IndexedLineSet.hpp>
+
+// see LoaderWrb.hpp for a description of the file format
+
+class SaverWrb : public Saver {
+
+private:
+
+  const static char* _ext;
+
+  uint64_t _sourceSize;
+  uint64_t _sourceHash;
+
+  // path relative to the directory of the source file, size and hash
+  // of the files inlined in the source file
+  vector<string>   _inlinedPath;
+  vector<uint64_t> _inlinedSize;
+  vector<uint64_t> _inlinedHash;
+
+  // number of every node already written, in the order in which they
+  // were written; used to write shared nodes only once
+  mutable map<const Node*,uint64_t> _saved;
+
+  // the urls of the Inline nodes of the SceneGraph are relative to the
+  // directory of the file it was loaded from, and are rewritten
+  // relative to the directory of the saved file; the urls nested in
+  // their content are relative to the inlined files, and the paths
+  // are relative to the current directory
+  mutable string _srcDir;
+  mutable string _dstDir;
+  mutable int    _nInlined; // Inline nodes containing the current node
+
+  // source file of the cache saved by saveCache(); the urls and paths
+  // of a cache are relative to the directory of its source file, which
+  // is not the directory of the cache file
+  string _cacheSource;
+
+public:
+
+  SaverWrb();
+  ~SaverWrb() {};
+
+  bool  save(const char* filename, SceneGraph& wrl) const;
+  const char* ext() const { return _ext; }
+
+  // records the size and hash of the file the SceneGraph was loaded
+  // from, and of the files inlined in it, in the header of the files
+  // saved afterwards; a nullptr filename clears them
+  bool  setSourceFile(const char* filename, SceneGraph& wrl);
+
+  // saves the SceneGraph to LoaderWrb::cacheFilename(filename), if
+  // caching is enabled; a SceneGraph with an Inline node whose url was
+  // not found is not cached, since the file may be created later
+  bool  saveCache(const char* filename, SceneGraph& wrl);
+
+private:
+
+  void  saveNode(FILE* fp, Node* node) const;
+  void  saveGroup(FILE* fp, Group& group) const;
+  void  saveTransform(FILE* fp, Transform& transform) const;
+  void  saveInline(FILE* fp, Inline& inl) const;
+  void  saveShape(FILE* fp, Shape& shape) const;
+  void  saveAppearance(FILE* fp, Appearance& appearance) const;
+  void  saveMaterial(FILE* fp, Material& material) const;
+  void  savePixelTexture(FILE* fp, PixelTexture& pixelTexture) const;
+  void  saveImageTexture(FILE* fp, ImageTexture& imageTexture) const;
+  void  saveIndexedFaceSet(FILE* fp, IndexedFaceSet& ifs) const;
+  void  saveIndexedLineSet(FILE* fp, IndexedLineSet& ils) const;
+  void  saveBlock(FILE* fp, const void* data, const size_t nBytes) const;
+  void  saveString(FILE* fp, const string& str) const;
+  void  saveVecFloat(FILE* fp, const vector<float>& vec) const;
+  void  saveVecInt(FILE* fp, const vector<int>& vec) const;
+  void  saveFloats(FILE* fp, const float* value, const int n) const;
+  void  saveBool(FILE* fp, const bool value) const;
+};
+
+#endif /* _SAVER_WRB_HPP_ */
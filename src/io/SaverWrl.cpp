@@ -33,13 +33,72 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SaverWrl.hpp"
+#include "LoaderWrl.hpp"
+#include "TextWriter.hpp"
 
 const char* SaverWrl::_ext = "wrl";
 
+//////////////////////////////////////////////////////////////////////
+// n values per line
+void SaverWrl::saveVecFloat
+(FILE* fp, const string& indent, const vector<float>& vec, const int n) const {
+  TextWriter tw(fp);
+  // n values per line, and a whole number of lines per chunk
+  int size = (int)vec.size();
+  int chunkSize = n*((TextWriter::CHUNK_VALUES+n-1)/n);
+  int nChunks = (size+chunkSize-1)/chunkSize;
+  tw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+      int i = iChunk*chunkSize, j;
+      int iEnd = (i+chunkSize<size)?i+chunkSize:size;
+      while(i<iEnd) {
+        twc.put(indent);
+        for(j=0;j<n && i<iEnd;j++,i++) {
+          twc.put(' ');
+          twc.putFloat(vec[i]);
+        }
+        twc.put('\n');
+      }
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+// one face or polyline per line; the lines are also broken after a
+// fixed number of values to handle arrays without -1 separators
+void SaverWrl::saveVecInt
+(FILE* fp, const string& indent, const vector<int>& vec) const {
+  TextWriter tw(fp);
+  // the chunks start at the first line starting after a multiple of
+  // CHUNK_VALUES; finding the lines is much cheaper than formatting
+  int i,j,size = (int)vec.size();
+  vector<int> chunkStart;
+  for(i=0;i<size;) {
+    if(i>=(int)chunkStart.size()*TextWriter::CHUNK_VALUES)
+      chunkStart.push_back(i);
+    for(j=0;j<16 && i<size;j++)
+      if(vec[i++]<0) break;
+  }
+  chunkStart.push_back(size);
+  int nChunks = (int)chunkStart.size()-1;
+  tw.putChunks(nChunks,[&](TextWriter& twc, const int iChunk) {
+      int i = chunkStart[iChunk], j;
+      int iEnd = chunkStart[iChunk+1];
+      while(i<iEnd) {
+        twc.put(indent);
+        for(j=0;j<16 && i<iEnd;j++) {
+          twc.put(' ');
+          twc.putInt(vec[i]);
+          if(vec[i++]<0) break;
+        }
+        twc.put('\n');
+      }
+    });
+}
+
 //////////////////////////////////////////////////////////////////////
 void SaverWrl::saveMaterial
 (FILE* fp, string indent, Material* material) const {
   if(material==(Material*)0) return;
+  if(saveUse(fp,indent,material)) return;
 
   const char* str = indent.c_str();
 
@@ -52,7 +111,7 @@ void SaverWrl::saveMaterial
   //   SFFloat transparency     0
   // }
 
-  const string& name = material->getName();
+  const string& name = defName(material);
   if(name=="")
     fprintf(fp,"%sMaterial {\n",str);
   else
@@ -92,6 +151,7 @@ void SaverWrl::saveMaterial
 void SaverWrl::saveImageTexture
 (FILE* fp, string indent, ImageTexture* imageTexture) const {
   if(imageTexture==(ImageTexture*)0) return;
+  if(saveUse(fp,indent,imageTexture)) return;
 
   const char* str = indent.c_str();
 
@@ -101,7 +161,7 @@ void SaverWrl::saveImageTexture
   //   SFBool repeatT TRUE
   // }
 
-  const string& name = imageTexture->getName();
+  const string& name = defName(imageTexture);
   if(name=="")
     fprintf(fp,"%sImageTexture {\n",str);
   else
@@ -132,6 +192,7 @@ void SaverWrl::saveImageTexture
 void SaverWrl::saveAppearance
 (FILE* fp, string indent, Appearance* appearance) const {
   if(appearance==(Appearance*)0) return;
+  if(saveUse(fp,indent,appearance)) return;
 
   const char* str = indent.c_str();
 
@@ -143,7 +204,7 @@ void SaverWrl::saveAppearance
 
   Node* node;
 
-  const string& name = appearance->getName();
+  const string& name = defName(appearance);
   if(name=="")
     fprintf(fp,"%sAppearance {\n",str);
   else
@@ -171,6 +232,7 @@ void SaverWrl::saveAppearance
 void SaverWrl::saveIndexedFaceSet
 (FILE* fp, string indent, IndexedFaceSet* indexedFaceSet) const {
   if(indexedFaceSet==(IndexedFaceSet*)0) return;
+  if(saveUse(fp,indent,indexedFaceSet)) return;
 
   const char* str = indent.c_str();
 
@@ -191,7 +253,7 @@ void SaverWrl::saveIndexedFaceSet
   //   MFInt32 texCoordIndex     []        # [-1,)
   // }
 
-  const string& name = indexedFaceSet->getName();
+  const string& name = defName(indexedFaceSet);
   if(name=="")
     fprintf(fp,"%sIndexedFaceSet {\n",str);
   else
@@ -205,11 +267,12 @@ void SaverWrl::saveIndexedFaceSet
   bool&          solid           = ifs.getSolid();
   bool&          normalPerVertex = ifs.getNormalPerVertex();
   bool&          colorPerVertex  = ifs.getColorPerVertex();
-  vector<float>& coord           = ifs.getCoord();
+  vector<float>  tmpCoord,tmpColor;
+  const vector<float>& coord     = ifs.readCoord(tmpCoord);
   vector<int>&   coordIndex      = ifs.getCoordIndex();
   vector<float>& normal          = ifs.getNormal();
   vector<int>&   normalIndex     = ifs.getNormalIndex();
-  vector<float>& color           = ifs.getColor();
+  const vector<float>& color     = ifs.readColor(tmpColor);
   vector<int>&   colorIndex      = ifs.getColorIndex();
   vector<float>& texCoord        = ifs.getTexCoord();
   vector<int>&   texCoordIndex   = ifs.getTexCoordIndex();
@@ -225,24 +288,16 @@ void SaverWrl::saveIndexedFaceSet
   if(creaseAngle>0.0) fprintf(fp,"%s creaseAngle %8.4f\n",str,creaseAngle);
 
   if(coordIndex.size()>0) {
-    int i;
     fprintf(fp,"%s coordIndex [\n",str);
-    for(i=0;i<(int)coordIndex.size();i++) {
-      fprintf(fp,"%s%6d ",str,coordIndex[i]);
-      if(coordIndex[i]<0) fprintf(fp,"%s\n",str);
-    }
+    saveVecInt(fp,indent+"  ",coordIndex);
     fprintf(fp,"%s ]\n",str);
   }
 
   // COORD_PER_VERTEX
   if(coord.size()>0) {
-    int i;
     fprintf(fp,"%s coord Coordinate {\n",str);
     fprintf(fp,"%s  point [\n",str);
-    for(i=0;i<(int)coord.size();i++) {
-      fprintf(fp,"%s%8.4f ",str,coord[i]);
-      if(i%3==2) fprintf(fp,"%s\n",str);
-    }
+    saveVecFloat(fp,indent+"   ",coord,3);
     fprintf(fp,"%s  ]\n",str);
     fprintf(fp,"%s }\n",str);
   }
@@ -265,25 +320,18 @@ void SaverWrl::saveIndexedFaceSet
   //     normal.size()/3==coord.size()/3
 
   if(normal.size()>0) {
-    int i;
     fprintf(fp,"%s normalPerVertex %s\n",str,
             (normalPerVertex==true)?"TRUE":"FALSE");
 
     fprintf(fp,"%s normal Normal {\n",str);
     fprintf(fp,"%s  vector [\n",str);
-    for(i=0;i<(int)normal.size();i++) {
-      fprintf(fp,"%s%8.4f ",str,normal[i]);
-      if(i%3==2) fprintf(fp,"%s\n",str);
-    }
+    saveVecFloat(fp,indent+"   ",normal,3);
     fprintf(fp,"%s  ]\n",str);
     fprintf(fp,"%s }\n",str);
 
     if(normalIndex.size()>0) {
       fprintf(fp,"%s normalIndex [\n",str);
-      for(i=0;i<(int)normalIndex.size();i++) {
-        fprintf(fp,"%s%d ",str,normalIndex[i]);
-        if(normalIndex[i]<0) fprintf(fp,"%s\n",str);
-      }
+      saveVecInt(fp,indent+"  ",normalIndex);
       fprintf(fp,"%s ]\n",str);
     }
   }
@@ -306,25 +354,18 @@ void SaverWrl::saveIndexedFaceSet
   //     color.size()/3==coord.size()/3
 
   if(color.size()>0) {
-    int i;
     fprintf(fp,"%s colorPerVertex %s\n",str,
             (colorPerVertex==true)?"TRUE":"FALSE");
 
     fprintf(fp,"%s color Color {\n",str);
     fprintf(fp,"%s  color [\n",str);
-    for(i=0;i<(int)color.size();i++) {
-      fprintf(fp,"%s%8.4f ",str,color[i]);
-      if(i%3==2) fprintf(fp,"%s\n",str);
-    }
+    saveVecFloat(fp,indent+"   ",color,3);
     fprintf(fp,"%s  ]\n",str);
     fprintf(fp,"%s }\n",str);
 
     if(colorIndex.size()>0) {
       fprintf(fp,"%s colorIndex [\n",str);
-      for(i=0;i<(int)colorIndex.size();i++) {
-        fprintf(fp,"%s%d ",str,colorIndex[i]);
-        if(colorIndex[i]<0) fprintf(fp,"%s\n",str);
-      }
+      saveVecInt(fp,indent+"  ",colorIndex);
       fprintf(fp,"%s ]\n",str);
     }
   }
@@ -339,23 +380,16 @@ void SaverWrl::saveIndexedFaceSet
   //   texCoord.size()/2==coord.size()/3
 
   if(texCoord.size()>0) {
-    int i;
 
     fprintf(fp,"%s texCoord TextureCoordinate {\n",str);
     fprintf(fp,"%s  point [\n",str);
-    for(i=0;i<(int)texCoord.size();i++) {
-      fprintf(fp,"%s%8.4f ",str,texCoord[i]);
-      if(i%2==1) fprintf(fp,"%s\n",str);
-    }
+    saveVecFloat(fp,indent+"   ",texCoord,2);
     fprintf(fp,"%s  ]\n",str);
     fprintf(fp,"%s }\n",str);
 
     if(texCoordIndex.size()>0) {
       fprintf(fp,"%s texCoordIndex [\n",str);
-      for(i=0;i<(int)texCoordIndex.size();i++) {
-        fprintf(fp,"%s%d ",str,texCoordIndex[i]);
-        if(texCoordIndex[i]<0) fprintf(fp,"%s\n",str);
-      }
+      saveVecInt(fp,indent+"  ",texCoordIndex);
       fprintf(fp,"%s ]\n",str);
     }
   }
@@ -367,6 +401,7 @@ void SaverWrl::saveIndexedFaceSet
 void SaverWrl::saveIndexedLineSet
 (FILE* fp, string indent, IndexedLineSet* indexedLineSet) const {
   if(indexedLineSet==(IndexedLineSet*)0) return;
+  if(saveUse(fp,indent,indexedLineSet)) return;
 
   const char* str = indent.c_str();
 
@@ -378,7 +413,7 @@ void SaverWrl::saveIndexedLineSet
   //   SFBool  colorPerVertex    TRUE
   // }
 
-  const string& name = indexedLineSet->getName();
+  const string& name = defName(indexedLineSet);
   if(name=="")
     fprintf(fp,"%sIndexedLineSet {\n",str);
   else
@@ -393,48 +428,33 @@ void SaverWrl::saveIndexedLineSet
   bool&          colorPerVertex  = ifs.getColorPerVertex();
 
   {
-    int i;
     fprintf(fp,"%s coordIndex [\n",str);
-    for(i=0;i<(int)coordIndex.size();i++) {
-      fprintf(fp,"%s%6d ",str,coordIndex[i]);
-      if(coordIndex[i]<0) fprintf(fp,"%s\n",str);
-    }
+    saveVecInt(fp,indent+"  ",coordIndex);
     fprintf(fp,"%s ]\n",str);
   }
 
   // COORD_PER_VERTEX
   {
-    int i;
     fprintf(fp,"%s coord Coordinate {\n",str);
     fprintf(fp,"%s  point [\n",str);
-    for(i=0;i<(int)coord.size();i++) {
-      fprintf(fp,"%s%8.4f ",str,coord[i]);
-      if(i%3==2) fprintf(fp,"%s\n",str);
-    }
+    saveVecFloat(fp,indent+"   ",coord,3);
     fprintf(fp,"%s  ]\n",str);
     fprintf(fp,"%s }\n",str);
   }
 
   if(color.size()>0) {
-    int i;
     fprintf(fp,"%s colorPerVertex %s\n",str,
             (colorPerVertex==true)?"TRUE":"FALSE");
 
     fprintf(fp,"%s color Color {\n",str);
     fprintf(fp,"%s  color [\n",str);
-    for(i=0;i<(int)color.size();i++) {
-      fprintf(fp,"%s%8.4f ",str,color[i]);
-      if(i%3==2) fprintf(fp,"%s\n",str);
-    }
+    saveVecFloat(fp,indent+"   ",color,3);
     fprintf(fp,"%s  ]\n",str);
     fprintf(fp,"%s }\n",str);
 
     if(colorIndex.size()>0) {
       fprintf(fp,"%s colorIndex [\n",str);
-      for(i=0;i<(int)colorIndex.size();i++) {
-        fprintf(fp,"%s%d ",str,colorIndex[i]);
-        if(colorIndex[i]<0) fprintf(fp,"%s\n",str);
-      }
+      saveVecInt(fp,indent+"  ",colorIndex);
       fprintf(fp,"%s ]\n",str);
     }
   }
@@ -446,6 +466,7 @@ void SaverWrl::saveIndexedLineSet
 void SaverWrl::saveShape
 (FILE* fp, string indent, Shape* shape) const {
   if(shape==(Shape*)0) return;
+  if(saveUse(fp,indent,shape)) return;
 
   const char* str = indent.c_str();
 
@@ -456,7 +477,7 @@ void SaverWrl::saveShape
 
   Node* node;
 
-  const string& name = shape->getName();
+  const string& name = defName(shape);
   if(name=="")
     fprintf(fp,"%sShape {\n",str);
   else
@@ -489,6 +510,7 @@ void SaverWrl::saveShape
 void SaverWrl::saveTransform
 (FILE* fp, string indent, Transform* transform) const {
   if(transform==(Transform*)0) return;
+  if(saveUse(fp,indent,transform)) return;
 
   const char* str = indent.c_str();
 
@@ -503,7 +525,7 @@ void SaverWrl::saveTransform
   //   MFNode     children          []
   // }
 
-  const string& name = transform->getName();
+  const string& name = defName(transform);
   if(name=="")
     fprintf(fp,"%sTransform {\n",str);
   else
@@ -558,6 +580,8 @@ void SaverWrl::saveTransform
         saveShape(fp,indent+"  ",(Shape*)node);
 	  } else if(node->isTransform()) {
         saveTransform(fp,indent+"  ",(Transform*)node);
+	  } else if(node->isInline()) {
+        saveInline(fp,indent+"  ",(Inline*)node);
 	  } else if(node->isGroup()) {
         saveGroup(fp,indent+"  ",(Group*)node);
       } else {
@@ -570,10 +594,54 @@ void SaverWrl::saveTransform
   fprintf(fp,"%s}\n",str);
 }
 
+//////////////////////////////////////////////////////////////////////
+void SaverWrl::saveInline
+(FILE* fp, string indent, Inline* inl) const {
+  if(inl==(Inline*)0) return;
+  if(saveUse(fp,indent,inl)) return;
+
+  const char* str = indent.c_str();
+
+  // Inline {
+  //   MFString url        []
+  //   SFVec3f  bboxCenter  0 0 0
+  //   SFVec3f  bboxSize   -1 -1 -1
+  // }
+
+  // only the references are saved; the content is saved in the
+  // referenced files
+
+  const string& name = defName(inl);
+  if(name=="")
+    fprintf(fp,"%sInline {\n",str);
+  else
+    fprintf(fp,"%sDEF %s Inline {\n",str,name.c_str());
+
+  vector<string>& url = inl->getUrl();
+  fprintf(fp,"%s url [\n",str);
+  for(int i=0;i<(int)url.size();i++)
+    fprintf(fp,"%s  %s\n",str,
+            LoaderWrl::relativeUrl(url[i],_srcDir,_dstDir).c_str());
+  fprintf(fp,"%s ]\n",str);
+
+  Vec3f&    bboxCenter       = inl->getBBoxCenter();
+  if(bboxCenter.x!=0.0f || bboxCenter.y!=0.0f || bboxCenter.z!= 0.0f)
+    fprintf(fp,"%s bboxCenter %8.4f %8.4f %8.4f\n",str,
+            bboxCenter.x,bboxCenter.y,bboxCenter.z);
+  
+  Vec3f&    bboxSize         = inl->getBBoxSize();
+  if(bboxSize.x!=-1.0f || bboxSize.y!=-1.0f || bboxSize.z!= -1.0f)
+    fprintf(fp,"%s bboxSize %8.4f %8.4f %8.4f\n",str,
+            bboxSize.x,bboxSize.y,bboxSize.z);
+
+  fprintf(fp,"%s}\n",str);
+}
+
 //////////////////////////////////////////////////////////////////////
 void SaverWrl::saveGroup
 (FILE* fp, string indent, Group* group) const {
   if(group==(Group*)0) return;
+  if(saveUse(fp,indent,group)) return;
 
   const char* str = indent.c_str();
 
@@ -583,7 +651,7 @@ void SaverWrl::saveGroup
   //   MFNode children    []
   // }
 
-  const string& name = group->getName();
+  const string& name = defName(group);
   if(name=="")
     fprintf(fp,"%sGroup {\n",str);
   else
@@ -602,23 +670,95 @@ void SaverWrl::saveGroup
   int nChildren = group->getNumberOfChildren();
   if(nChildren>0) {
     Node* node;
+    fprintf(fp,"%s children [\n",indent.c_str());
     for(int i=0;i<nChildren;i++) {
       node = (*group)[i];
       if(node->isShape()) {
-        saveShape(fp,indent+" ",(Shape*)node);
+        saveShape(fp,indent+"  ",(Shape*)node);
 	  } else if(node->isTransform()) {
-        saveTransform(fp,indent+" ",(Transform*)node);
+        saveTransform(fp,indent+"  ",(Transform*)node);
+	  } else if(node->isInline()) {
+        saveInline(fp,indent+"  ",(Inline*)node);
 	  } else if(node->isGroup()) {
-        saveGroup(fp,indent+" ",(Group*)node);
+        saveGroup(fp,indent+"  ",(Group*)node);
       } else {
         // throw StrException("unexpected node type as child of Transform");
       }
     }
+    fprintf(fp,"%s ]\n",indent.c_str());
   }
 
   fprintf(fp,"%s}\n",str);
 }
 
+//////////////////////////////////////////////////////////////////////
+// counts the references to each node, and lists the nodes in the
+// order in which they are saved
+static void _countReferences
+(Node* node, map<const Node*,int>& nRef, vector<const Node*>& order) {
+  if(node==(Node*)0 || (nRef[node]++)>0) return;
+  order.push_back(node);
+  if(node->isShape()) {
+    Shape* shape = (Shape*)node;
+    _countReferences(shape->getAppearance(),nRef,order);
+    _countReferences(shape->getGeometry(),nRef,order);
+  } else if(node->isAppearance()) {
+    Appearance* appearance = (Appearance*)node;
+    _countReferences(appearance->getMaterial(),nRef,order);
+    _countReferences(appearance->getTexture(),nRef,order);
+  } else if(node->isGroup() && node->isInline()==false) {
+    // the content of Inline nodes is not saved
+    Group* group = (Group*)node;
+    int nChildren = group->getNumberOfChildren();
+    for(int i=0;i<nChildren;i++)
+      _countReferences((*group)[i],nRef,order);
+  }
+}
+
+// names the nodes referenced more than once; unnamed nodes, and nodes
+// with the same name as another node, get a new name which is not the
+// name of any node, numbered in the order in which they are saved
+void SaverWrl::findShared(SceneGraph& wrl) const {
+  _shared.clear();
+  _saved.clear();
+  map<const Node*,int> nRef;
+  vector<const Node*> order;
+  int nChildren = wrl.getNumberOfChildren();
+  for(int i=0;i<nChildren;i++)
+    _countReferences(wrl[i],nRef,order);
+  map<string,int> nSameName;
+  for(const Node* node : order)
+    nSameName[node->getName()]++;
+  set<string> used;
+  for(auto& same : nSameName)
+    used.insert(same.first);
+  int nNamed = 0;
+  for(const Node* node : order) {
+    if(nRef[node]<2) continue;
+    string name = node->getName();
+    if(name=="" || nSameName[name]>1)
+      do {
+        name = node->getType()+"_"+to_string(++nNamed);
+      } while(used.insert(name).second==false);
+    _shared[node] = name;
+  }
+}
+
+// writes "USE name" and returns true if the node is shared and has
+// already been saved
+bool SaverWrl::saveUse
+(FILE* fp, const string& indent, const Node* node) const {
+  if(_shared.find(node)==_shared.end()) return false;
+  if(_saved.insert(node).second) return false;
+  fprintf(fp,"%sUSE %s\n",indent.c_str(),_shared[node].c_str());
+  return true;
+}
+
+const string& SaverWrl::defName(const Node* node) const {
+  map<const Node*,string>::const_iterator i = _shared.find(node);
+  return (i!=_shared.end())?i->second:node->getName();
+}
+
 //////////////////////////////////////////////////////////////////////
 bool SaverWrl::save(const char* filename, SceneGraph& wrl) const {
   bool success = false;
@@ -626,6 +766,9 @@ bool SaverWrl::save(const char* filename, SceneGraph& wrl) const {
      FILE* fp = fopen(filename,"w");
     if(	fp!=(FILE*)0) {
       fprintf(fp,"#VRML V2.0 utf8\n");
+      findShared(wrl);
+      _srcDir = LoaderWrl::dirName(wrl.getUrl());
+      _dstDir = LoaderWrl::dirName(filename);
       string indent="";
       int nChildren = wrl.getNumberOfChildren();
       for(int i=0;i<nChildren;i++) {
@@ -636,12 +779,17 @@ bool SaverWrl::save(const char* filename, SceneGraph& wrl) const {
         } else if(node->isTransform()) {
           Transform* transform = (Transform*)node;
           saveTransform(fp,indent,transform);
+        } else if(node->isInline()) {
+          Inline* inl = (Inline*)node;
+          saveInline(fp,indent,inl);
         } else if(node->isGroup()) {
           Group* group = (Group*)node;
           saveGroup(fp,indent,group);
         }
       }
       fclose(fp);
+      _shared.clear();
+      _saved.clear();
       success = true;
     }
   }
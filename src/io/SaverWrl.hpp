@@ -35,6 +35,8 @@
 #ifndef _SAVER_WRL_HPP_
 #define _SAVER_WRL_HPP_
 
+#include <map>
+#include <set>
 #include "Saver.hpp"
 #include <wrl/Shape.hpp>
 #include <wrl/Appearance.hpp>
@@ -43,6 +45,7 @@
 #include <wrl/IndexedLineSet.hpp>
 #include <wrl/ImageTexture.hpp>
 #include <wrl/Transform.hpp>
+#include <wrl/Inline.hpp>
 #include <wrl/SceneGraphTraversal.hpp>
 
 class SaverWrl : public Saver {
@@ -71,12 +74,35 @@ private:
   (FILE* fp, string indent, IndexedFaceSet* indexedFaceSet) const;
   void saveIndexedLineSet
   (FILE* fp, string indent, IndexedLineSet* indexedLineSet) const;
+  void saveInline
+  (FILE* fp, string indent, Inline* inl) const;
   void saveMaterial
   (FILE* fp, string indent, Material* material) const;
   void saveShape
   (FILE* fp, string indent, Shape* shape) const;
   void saveTransform
   (FILE* fp, string indent, Transform* transform) const;
+  void saveVecFloat
+  (FILE* fp, const string& indent, const vector<float>& vec, const int n) const;
+  void saveVecInt
+  (FILE* fp, const string& indent, const vector<int>& vec) const;
+
+  // the nodes referenced more than once (VRML USE) are saved with DEF
+  // the first time, and with USE afterwards
+
+  mutable map<const Node*,string> _shared;
+  mutable set<const Node*>        _saved;
+
+  void findShared(SceneGraph& wrl) const;
+  bool saveUse(FILE* fp, const string& indent, const Node* node) const;
+  const string& defName(const Node* node) const;
+
+  // the urls of the Inline nodes are relative to the directory of the
+  // file the SceneGraph was loaded from, and are rewritten relative to
+  // the directory of the saved file
+
+  mutable string _srcDir;
+  mutable string _dstDir;
   
 };
 
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-06 09:41:27 taubin>
+//------------------------------------------------------------------------
+//
+// TextWriter.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "TextWriter.hpp"
+
+#include <thread>
+
+int TextWriter::_nThreads = 0;
+
+TextWriter::TextWriter(FILE* fp, const size_t bufferSize):
+  _fp(fp),
+  _buffer((bufferSize<4*MAX_VALUE_CHARS)?4*MAX_VALUE_CHARS:bufferSize),
+  _size(0),
+  _failed(fp==(FILE*)0) {
+}
+
+TextWriter::TextWriter():
+  _fp((FILE*)0),
+  _buffer(1<<16),
+  _size(0),
+  _failed(false) {
+}
+
+TextWriter::~TextWriter() {
+  flush();
+}
+
+// a trailing space is kept in the buffer, so that endLine() produces
+// the same output wherever the buffer boundaries fall
+
+void TextWriter::_flush(const bool keepSpace) {
+  if(_fp==(FILE*)0) {
+    // memory TextWriter
+    _buffer.resize(2*_buffer.size());
+    return;
+  }
+  size_t n = _size;
+  if(keepSpace && n>0 && _buffer[n-1]==' ') n--;
+  if(n>0 && _failed==false)
+    _failed = (fwrite(&_buffer[0],1,n,_fp)!=n);
+  _size -= n;
+  if(_size>0) _buffer[0] = ' ';
+}
+
+bool TextWriter::flush() {
+  if(_fp==(FILE*)0)
+    return (_failed==false);
+  _flush(false);
+  if(_failed==false && _fp!=(FILE*)0)
+    _failed = (fflush(_fp)!=0);
+  return (_failed==false);
+}
+
+void TextWriter::put(const char* str, const size_t n) {
+  if(_size+n>_buffer.size()) {
+    // the trailing space is only kept if str fits after it, since
+    // otherwise str is written before it
+    _flush(n<_buffer.size());
+    while(_fp==(FILE*)0 && _size+n>_buffer.size())
+      _flush();
+    if(_size+n>_buffer.size()) {
+      // too long to be buffered
+      if(_failed==false)
+        _failed = (fwrite(str,1,n,_fp)!=n);
+      return;
+    }
+  }
+  memcpy(&_buffer[_size],str,n);
+  _size += n;
+}
+
+// std::to_chars() for floating point values is not available in all
+// the standard libraries; "%.9g" and "%.17g" also round trip, but are
+// not always the shortest representation
+
+void TextWriter::putFloat(const float value) {
+  if(_size+MAX_VALUE_CHARS>_buffer.size()) _flush();
+  char* p = &_buffer[_size];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+  _size += (size_t)(to_chars(p,p+MAX_VALUE_CHARS,value).ptr-p);
+#else
+  _size += (size_t)snprintf(p,MAX_VALUE_CHARS,"%.9g",(double)value);
+#endif
+}
+
+void TextWriter::putDouble(const double value) {
+  if(_size+MAX_VALUE_CHARS>_buffer.size()) _flush();
+  char* p = &_buffer[_size];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+  _size += (size_t)(to_chars(p,p+MAX_VALUE_CHARS,value).ptr-p);
+#else
+  _size += (size_t)snprintf(p,MAX_VALUE_CHARS,"%.17g",value);
+#endif
+}
+
+// static
+void TextWriter::setNumberOfThreads(const int nThreads) {
+  _nThreads = nThreads;
+}
+
+// static
+int TextWriter::getNumberOfThreads() {
+  return _nThreads;
+}
+
+void TextWriter::putChunks
+(const int nChunks, const function<void(TextWriter&,const int)>& format) {
+  int nThreads = _nThreads;
+  if(nThreads<=0)
+    nThreads = static_cast<int>(thread::hardware_concurrency());
+  if(nThreads>nChunks)
+    nThreads = nChunks;
+  if(nThreads<=1) {
+    for(int iChunk=0;iChunk<nChunks;iChunk++)
+      format(*this,iChunk);
+    return;
+  }
+
+  // each pass formats nThreads chunks per thread into memory, and
+  // then writes them in order
+  const int nPerPass = 2*nThreads;
+  vector<TextWriter> chunk(static_cast<size_t>(nPerPass));
+  for(int iChunk0=0;iChunk0<nChunks;iChunk0+=nPerPass) {
+    int nPass = (nChunks-iChunk0<nPerPass)?nChunks-iChunk0:nPerPass;
+    auto work = [&](const int iThread) {
+      for(int i=iThread;i<nPass;i+=nThreads) {
+        chunk[static_cast<size_t>(i)].clear();
+        format(chunk[static_cast<size_t>(i)],iChunk0+i);
+      }
+    };
+    vector<thread> worker;
+    for(int iThread=1;iThread<nThreads;iThread++)
+      worker.push_back(thread(work,iThread));
+    work(0);
+    for(thread& t : worker)
+      t.join();
+    for(int i=0;i<nPass;i++)
+      put(chunk[static_cast<size_t>(i)].data(),
+          chunk[static_cast<size_t>(i)].size());
+  }
+}
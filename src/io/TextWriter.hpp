@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-06 09:41:27 taubin>
+//------------------------------------------------------------------------
+//
+// TextWriter.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TEXT_WRITER_HPP
+#define TEXT_WRITER_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <functional>
+
+using namespace std;
+
+// buffered text output used by the ascii savers
+//
+// - the text is formatted into a large memory buffer, which is
+//   written to the file with a single fwrite() call when full, and
+//   when the TextWriter is flushed or destroyed
+// - floating point values are written with the shortest
+//   representation which parses back to the same value
+// - the FILE* should not be written to directly until flush() is
+//   called
+// - errors are sticky, and reported by flush() and hasFailed()
+// - a TextWriter constructed without a FILE* keeps all the text in
+//   memory, growing the buffer as needed
+
+class TextWriter {
+
+public:
+
+  TextWriter(FILE* fp, const size_t bufferSize=(1<<20));
+  TextWriter(); // formats into memory
+  ~TextWriter();
+
+  void put(const char c) {
+    if(_size+1>_buffer.size()) _flush();
+    _buffer[_size++] = c;
+  }
+
+  void put(const char* str) {
+    put(str,strlen(str));
+  }
+
+  void put(const string& str) {
+    put(str.data(),str.size());
+  }
+
+  void put(const char* str, const size_t n);
+
+  void putInt(const int value) {
+    if(_size+MAX_VALUE_CHARS>_buffer.size()) _flush();
+    char* p = &_buffer[_size];
+    _size += (size_t)(to_chars(p,p+MAX_VALUE_CHARS,value).ptr-p);
+  }
+
+  void putUInt(const unsigned int value) {
+    if(_size+MAX_VALUE_CHARS>_buffer.size()) _flush();
+    char* p = &_buffer[_size];
+    _size += (size_t)(to_chars(p,p+MAX_VALUE_CHARS,value).ptr-p);
+  }
+
+  void putFloat(const float value);
+  void putDouble(const double value);
+
+  // replaces a trailing space by the end of line
+  void endLine() {
+    if(_size>0 && _buffer[_size-1]==' ') _buffer[_size-1] = '\n';
+    else put('\n');
+  }
+
+  bool flush();
+  bool hasFailed() const { return _failed; }
+
+  // text formatted so far, for a TextWriter without a FILE*
+  const char* data() const { return _buffer.data(); }
+  size_t      size() const { return _size; }
+  void        clear()      { _size = 0; }
+
+  // formats nChunks independent pieces of text in parallel, calling
+  // format(tw,iChunk) with a different memory TextWriter for each
+  // chunk, and writes the chunks in order; the output is the same as
+  // calling format(*this,iChunk) for iChunk=0,...,nChunks-1
+  // - only a few chunks per thread are kept in memory at once
+  void putChunks(const int nChunks,
+                 const function<void(TextWriter&,const int)>& format);
+
+  // number of threads used by putChunks(); 1 formats serially, and
+  // nThreads<=0 uses std::thread::hardware_concurrency()
+  static void setNumberOfThreads(const int nThreads);
+  static int  getNumberOfThreads();
+
+  // chunk size, in values, used by the savers to split large arrays
+  static const int CHUNK_VALUES = (1<<16);
+
+  // enough for any int, or the shortest representation of any double
+  static const size_t MAX_VALUE_CHARS = 32;
+
+private:
+
+  static int   _nThreads;
+
+  FILE*        _fp;
+  vector<char> _buffer;
+  size_t       _size;
+  bool         _failed;
+
+  void         _flush(const bool keepSpace=true);
+
+};
+
+#endif // TEXT_WRITER_HPP
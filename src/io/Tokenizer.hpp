@@ -57,6 +57,7 @@ private:
 public:
 
   Tokenizer();
+  virtual ~Tokenizer() {}
 
   bool get();
   void get(const string& errMsg);
@@ -45,9 +45,13 @@ using namespace std;
 #include <io/LoaderPly.hpp>
 #include <io/LoaderStl.hpp>
 #include <io/LoaderWrl.hpp>
+#include <io/LoaderWrb.hpp>
+#include <io/LoaderEbm.hpp>
 #include <io/SaverPly.hpp>
 #include <io/SaverStl.hpp>
 #include <io/SaverWrl.hpp>
+#include <io/SaverWrb.hpp>
+#include <io/SaverEbm.hpp>
 #include "dgpPrt.hpp"
 
 class Data {
@@ -134,6 +138,10 @@ int main(int argc, char **argv) {
   loaderFactory.registerLoader(stlLoader);
   LoaderWrl* wrlLoader = new LoaderWrl();
   loaderFactory.registerLoader(wrlLoader);
+  LoaderWrb* wrbLoader = new LoaderWrb();
+  loaderFactory.registerLoader(wrbLoader);
+  LoaderEbm* ebmLoader = new LoaderEbm();
+  loaderFactory.registerLoader(ebmLoader);
 
   // register output file savers  
   SaverPly* plySaver = new SaverPly();
@@ -142,6 +150,10 @@ int main(int argc, char **argv) {
   saverFactory.registerSaver(stlSaver);
   SaverWrl* wrlSaver = new SaverWrl();
   saverFactory.registerSaver(wrlSaver);
+  SaverWrb* wrbSaver = new SaverWrb();
+  saverFactory.registerSaver(wrbSaver);
+  SaverEbm* ebmSaver = new SaverEbm();
+  saverFactory.registerSaver(ebmSaver);
 
   SaverStl::FileType stlFt =
     (D._binaryOutput)?SaverStl::FileType::BINARY:SaverStl::FileType::ASCII;
@@ -34,18 +34,33 @@
 
 #include <string>
 #include <iostream>
+#include <chrono>
+#include <deque>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cmath>
 
 using namespace std;
 
 #include <wrl/SceneGraphTraversal.hpp>
+#include <wrl/SceneGraphProcessor.hpp>
+#include <wrl/OutOfCoreProcessor.hpp>
 #include <io/AppLoader.hpp>
 #include <io/AppSaver.hpp>
 #include <io/LoaderPly.hpp>
 #include <io/LoaderStl.hpp>
 #include <io/LoaderWrl.hpp>
+#include <io/LoaderWrb.hpp>
+#include <io/LoaderEbm.hpp>
 #include <io/SaverPly.hpp>
 #include <io/SaverStl.hpp>
 #include <io/SaverWrl.hpp>
+#include <io/SaverWrb.hpp>
+#include <io/SaverEbm.hpp>
+#include <io/InputFile.hpp>
+#include <io/TextWriter.hpp>
+#include <util/Endian.hpp>
 #include "dgpPrt.hpp"
 
 class Data {
@@ -55,6 +70,21 @@ public:
   bool   _removeNormal;
   bool   _removeColor;
   bool   _removeTexCoord;
+  bool   _reorder;
+  bool   _flatten;
+  int    _edges;
+  float  _featureAngle;
+  bool   _benchmark;
+  bool   _stream;
+  bool   _bigEndian;
+  int    _outOfCore;
+  string _scratch;
+  int    _threads;
+  int    _coordBits;
+  bool   _compact;
+  bool   _dropUnused;
+  bool   _swapTest;
+  bool   _roundTripTest;
   string _inFile;
   string _outFile;
 public:
@@ -64,6 +94,21 @@ public:
     _removeNormal(false),
     _removeColor(false),
     _removeTexCoord(false),
+    _reorder(false),
+    _flatten(false),
+    _edges(0),
+    _featureAngle(0.0f),
+    _benchmark(false),
+    _stream(false),
+    _bigEndian(false),
+    _outOfCore(0),
+    _scratch(""),
+    _threads(0),
+    _coordBits(16),
+    _compact(false),
+    _dropUnused(false),
+    _swapTest(false),
+    _roundTripTest(false),
     _inFile(""),
     _outFile("")
   { }
@@ -76,10 +121,26 @@ void options(Data& D) {
   cout << "  -rn|-removeNormal        [" << tv(D._removeNormal)   << "]" << endl;
   cout << "  -rc|-removeColor         [" << tv(D._removeColor)    << "]" << endl;
   cout << "  -rt|-removeTexCoord      [" << tv(D._removeTexCoord) << "]" << endl;
+  cout << "   -o|-reorder             [" << tv(D._reorder)        << "]" << endl;
+  cout << "  -fl|-flatten             [" << tv(D._flatten)        << "]" << endl;
+  cout << "  -ed|-edges               [" << tv(D._edges!=0)       << "]" << endl;
+  cout << "  -fe|-featureEdges angle  [" << D._featureAngle       << "]" << endl;
+  cout << "  -bm|-benchmark           [" << tv(D._benchmark)      << "]" << endl;
+  cout << "   -s|-stream              [" << tv(D._stream)         << "]" << endl;
+  cout << "  -be|-bigEndian           [" << tv(D._bigEndian)      << "]" << endl;
+  cout << " -ooc|-outOfCore nChunks   [" << D._outOfCore          << "]" << endl;
+  cout << "  -sc|-scratch prefix      [" << D._scratch            << "]" << endl;
+  cout << "   -t|-threads nThreads    [" << D._threads            << "]" << endl;
+  cout << "   -q|-quantization nBits  [" << D._coordBits          << "]" << endl;
+  cout << "   -c|-compact             [" << tv(D._compact)        << "]" << endl;
+  cout << "  -du|-dropUnused          [" << tv(D._dropUnused)     << "]" << endl;
+  cout << "  -st|-swapTest            [" << tv(D._swapTest)       << "]" << endl;
+  cout << " -rtt|-roundTripTest       [" << tv(D._roundTripTest)  << "]" << endl;
 }
 
 void usage(Data& D) {
   cout << "USAGE: dgpTest2b [options] inFile outFile" << endl;
+  cout << "       dgpTest2b -swapTest" << endl;
   cout << "   -h|-help" << endl;
   options(D);
   cout << endl;
@@ -90,7 +151,184 @@ void error(const char *msg) {
   cout << "ERROR: dgpTest2b | " << ((msg)?msg:"") << endl;
   exit(0);
 }
+
+// time a pass with the memory access pattern of
+// SceneGraphProcessor::computeNormalPerVertex(), i.e. gather the face
+// coordinates and scatter the face normals onto the vertices, and
+// compute the average number of misses per face of a FIFO vertex cache
+// of 32 entries; returns milliseconds per pass
+double benchmarkPass(SceneGraph& wrl, const int nPasses, double& acmr) {
+  double ms  = 0.0;
+  long   nF  = 0;
+  long   nM  = 0;
+  Node* node;
+  SceneGraphTraversal sgt(wrl);
+  while((node=sgt.next())!=(Node*)0) {
+    Shape* shape = dynamic_cast<Shape*>(node);
+    if(shape==(Shape*)0) continue;
+    IndexedFaceSet* ifs =
+      dynamic_cast<IndexedFaceSet*>(shape->getGeometry());
+    if(ifs==(IndexedFaceSet*)0) continue;
+    vector<float>        tmpCoord;
+    const vector<float>& coord      = ifs->readCoord(tmpCoord);
+    const vector<int>&   coordIndex = ifs->getCoordIndex();
+    int nC = static_cast<int>(coordIndex.size());
+    vector<float> normal(coord.size(),0.0f);
+
+    auto t0 = chrono::steady_clock::now();
+    for(int pass=0;pass<nPasses;pass++) {
+      int i,i0,i1,iV,jV;
+      for(i0=i1=0;i1<nC;i1++) {
+        if(coordIndex[i1]>=0) continue;
+        float n[3] = { 0.0f, 0.0f, 0.0f };
+        for(i=i0;i<i1;i++) {
+          iV = coordIndex[i];
+          jV = coordIndex[(i+1<i1)?i+1:i0];
+          const float* p = &coord[3*iV];
+          const float* q = &coord[3*jV];
+          n[0] += p[1]*q[2]-p[2]*q[1];
+          n[1] += p[2]*q[0]-p[0]*q[2];
+          n[2] += p[0]*q[1]-p[1]*q[0];
+        }
+        for(i=i0;i<i1;i++) {
+          float* m = &normal[3*coordIndex[i]];
+          m[0] += n[0]; m[1] += n[1]; m[2] += n[2];
+        }
+        i0 = i1+1;
+      }
+    }
+    auto t1 = chrono::steady_clock::now();
+    ms += chrono::duration<double,milli>(t1-t0).count();
+
+    deque<int> cache;
+    for(int iC=0;iC<nC;iC++) {
+      int iV = coordIndex[iC];
+      if(iV<0) { nF++; continue; }
+      if(find(cache.begin(),cache.end(),iV)!=cache.end()) continue;
+      nM++;
+      cache.push_back(iV);
+      if(cache.size()>32) cache.pop_front();
+    }
+  }
+  acmr = (nF>0)?(double)nM/(double)nF:0.0;
+  return (nPasses>0)?ms/(double)nPasses:0.0;
+}
 
+// compare the bulk byte swaps of Endian, which use SIMD shuffles when
+// supported by the processor, with the scalar implementation and with
+// a byte by byte reversal, for every value size, for numbers of values
+// which leave every possible tail, and for unaligned arrays; the bytes
+// around the arrays must not be modified; returns the number of errors
+int testSwap() {
+  const size_t maxValues = 80;
+  const size_t pad       = 16;
+  const size_t nBytes    = 8*maxValues+2*pad;
+  vector<char> src(nBytes),dst(nBytes),ref(nBytes),tmp(nBytes);
+  unsigned int seed = 12345;
+  for(size_t i=0;i<nBytes;i++) {
+    seed = seed*1103515245u+12345u;
+    src[i] = static_cast<char>(seed>>16);
+  }
+  int nErrors = 0;
+  const size_t valueSize[3] = { 2, 4, 8 };
+  for(size_t iSize=0;iSize<3;iSize++) {
+    size_t vs = valueSize[iSize];
+    for(size_t nValues=0;nValues<=maxValues;nValues++) {
+      for(size_t srcOffset=0;srcOffset<8;srcOffset++) {
+        for(size_t dstOffset=0;dstOffset<8;dstOffset++) {
+          const char* s = &src[pad+srcOffset];
+          // byte by byte reversal
+          memset(&ref[0],0x5a,nBytes);
+          for(size_t i=0;i<nValues;i++)
+            for(size_t j=0;j<vs;j++)
+              ref[pad+dstOffset+i*vs+j] = s[i*vs+vs-1-j];
+          // scalar and dispatched implementations
+          for(int scalar=1;scalar>=0;scalar--) {
+            Endian::setSwapScalarOnly(scalar!=0);
+            memset(&dst[0],0x5a,nBytes);
+            Endian::swap(&dst[pad+dstOffset],s,nValues,vs);
+            if(memcmp(&dst[0],&ref[0],nBytes)!=0) nErrors++;
+            // in place
+            memset(&tmp[0],0x5a,nBytes);
+            memcpy(&tmp[pad+dstOffset],s,nValues*vs);
+            char* t = &tmp[pad+dstOffset];
+            if(vs==2)      Endian::swap2(t,nValues);
+            else if(vs==4) Endian::swap4(t,nValues);
+            else           Endian::swap8(t,nValues);
+            if(memcmp(&tmp[0],&ref[0],nBytes)!=0) nErrors++;
+          }
+          Endian::setSwapScalarOnly(false);
+        }
+      }
+    }
+  }
+  return nErrors;
+}
+
+void getIndexedFaceSets(SceneGraph& wrl, vector<IndexedFaceSet*>& ifs) {
+  Node* node;
+  SceneGraphTraversal sgt(wrl);
+  while((node=sgt.next())!=(Node*)0) {
+    Shape* shape = dynamic_cast<Shape*>(node);
+    if(shape==(Shape*)0) continue;
+    IndexedFaceSet* geometry =
+      dynamic_cast<IndexedFaceSet*>(shape->getGeometry());
+    if(geometry!=(IndexedFaceSet*)0) ifs.push_back(geometry);
+  }
+}
+
+// load the saved file again, and compare its vertices with those of
+// the IndexedFaceSet nodes of the saved scene graph; the colors, saved
+// as bytes by truncation, must be the same, and the coordinates must
+// be the same up to the 16 bit quantization of the compact
+// coordinates; returns the number of errors
+int testRoundTrip
+(SceneGraph& wrl, AppLoader& loaderFactory, const char* filename) {
+  SceneGraph loaded;
+  if(loaderFactory.load(filename,loaded)==false) return 1;
+  vector<IndexedFaceSet*> ifsA,ifsB;
+  getIndexedFaceSets(wrl,ifsA);
+  getIndexedFaceSets(loaded,ifsB);
+  if(ifsA.size()!=ifsB.size()) return 1;
+  int nErrors = 0;
+  for(size_t k=0;k<ifsA.size();k++) {
+    IndexedFaceSet& a = *ifsA[k];
+    IndexedFaceSet& b = *ifsB[k];
+    int nV = a.getNumberOfCoord();
+    int nC = a.getNumberOfColor();
+    if(b.getNumberOfCoord()!=nV || b.getNumberOfColor()!=nC ||
+       a.hasColorPerVertex()!=b.hasColorPerVertex()) {
+      nErrors++;
+      continue;
+    }
+    float xa[3],xb[3],xMin[3],xMax[3],tol = 0.0f;
+    int i,j;
+    for(i=0;i<nV;i++) {
+      a.getCoordValue(i,xa);
+      for(j=0;j<3;j++) {
+        if(i==0 || xa[j]<xMin[j]) xMin[j] = xa[j];
+        if(i==0 || xa[j]>xMax[j]) xMax[j] = xa[j];
+      }
+    }
+    for(j=0;j<3 && nV>0;j++)
+      if((xMax[j]-xMin[j])/32767.0f>tol) tol = (xMax[j]-xMin[j])/32767.0f;
+    for(i=0;i<nV;i++) {
+      a.getCoordValue(i,xa);
+      b.getCoordValue(i,xb);
+      for(j=0;j<3;j++)
+        if(fabs(xa[j]-xb[j])>tol) { nErrors++; break; }
+    }
+    for(i=0;i<nC;i++) {
+      a.getColorValue(i,xa);
+      b.getColorValue(i,xb);
+      for(j=0;j<3;j++)
+        if(static_cast<int>(xa[j]*255.0f)!=
+           static_cast<int>(xb[j]*255.0f)) { nErrors++; break; }
+    }
+  }
+  return nErrors;
+}
+
 //////////////////////////////////////////////////////////////////////
 int main(int argc, char **argv) {
 
@@ -115,6 +353,42 @@ int main(int argc, char **argv) {
       D._removeColor = !D._removeColor;
     } else if(string(argv[i])=="-rt" || string(argv[i])=="-removeTexCoord") {
       D._removeTexCoord = !D._removeTexCoord;
+    } else if(string(argv[i])=="-o" || string(argv[i])=="-reorder") {
+      D._reorder = !D._reorder;
+    } else if(string(argv[i])=="-fl" || string(argv[i])=="-flatten") {
+      D._flatten = !D._flatten;
+    } else if(string(argv[i])=="-ed" || string(argv[i])=="-edges") {
+      D._edges = (D._edges)?0:SceneGraphProcessor::EDGES_ALL;
+    } else if(string(argv[i])=="-fe" || string(argv[i])=="-featureEdges") {
+      if(++i>=argc) error("-featureEdges requires the angle in degrees");
+      D._edges = SceneGraphProcessor::EDGES_ALL;
+      D._featureAngle = static_cast<float>(atof(argv[i]));
+    } else if(string(argv[i])=="-bm" || string(argv[i])=="-benchmark") {
+      D._benchmark = !D._benchmark;
+    } else if(string(argv[i])=="-s" || string(argv[i])=="-stream") {
+      D._stream = !D._stream;
+    } else if(string(argv[i])=="-be" || string(argv[i])=="-bigEndian") {
+      D._bigEndian = !D._bigEndian;
+    } else if(string(argv[i])=="-ooc" || string(argv[i])=="-outOfCore") {
+      if(++i>=argc) error("-outOfCore requires the number of chunks per axis");
+      D._outOfCore = atoi(argv[i]);
+    } else if(string(argv[i])=="-sc" || string(argv[i])=="-scratch") {
+      if(++i>=argc) error("-scratch requires a file name prefix");
+      D._scratch = string(argv[i]);
+    } else if(string(argv[i])=="-t" || string(argv[i])=="-threads") {
+      if(++i>=argc) error("-threads requires the number of threads");
+      D._threads = atoi(argv[i]);
+    } else if(string(argv[i])=="-q" || string(argv[i])=="-quantization") {
+      if(++i>=argc) error("-quantization requires the number of bits");
+      D._coordBits = atoi(argv[i]);
+    } else if(string(argv[i])=="-c" || string(argv[i])=="-compact") {
+      D._compact = true;
+    } else if(string(argv[i])=="-du" || string(argv[i])=="-dropUnused") {
+      D._dropUnused = !D._dropUnused;
+    } else if(string(argv[i])=="-st" || string(argv[i])=="-swapTest") {
+      D._swapTest = !D._swapTest;
+    } else if(string(argv[i])=="-rtt" || string(argv[i])=="-roundTripTest") {
+      D._roundTripTest = !D._roundTripTest;
     } else if(string(argv[i])[0]=='-') {
       error("unknown option");
     } else if(D._inFile=="") {
@@ -126,6 +400,13 @@ int main(int argc, char **argv) {
     }
   }
 
+  if(D._swapTest) {
+    int nErrors = testSwap();
+    cout << "dgpTest2b | swap test with " << Endian::swapImplementation()
+         << " | " << ((nErrors==0)?"passed":"FAILED") << endl;
+    return (nErrors==0)?0:1;
+  }
+
   if(D._inFile =="") error("no inFile");
   if(D._outFile=="") error("no outFile");
 
@@ -154,6 +435,10 @@ int main(int argc, char **argv) {
   loaderFactory.registerLoader(stlLoader);
   LoaderWrl* wrlLoader = new LoaderWrl();
   loaderFactory.registerLoader(wrlLoader);
+  LoaderWrb* wrbLoader = new LoaderWrb();
+  loaderFactory.registerLoader(wrbLoader);
+  LoaderEbm* ebmLoader = new LoaderEbm();
+  loaderFactory.registerLoader(ebmLoader);
 
   // register output file savers  
   SaverPly* plySaver = new SaverPly();
@@ -162,19 +447,100 @@ int main(int argc, char **argv) {
   saverFactory.registerSaver(stlSaver);
   SaverWrl* wrlSaver = new SaverWrl();
   saverFactory.registerSaver(wrlSaver);
+  SaverWrb* wrbSaver = new SaverWrb();
+  saverFactory.registerSaver(wrbSaver);
+  SaverEbm* ebmSaver = new SaverEbm();
+  saverFactory.registerSaver(ebmSaver);
 
   SaverStl::FileType stlFt =
     (D._binaryOutput)?SaverStl::FileType::BINARY:SaverStl::FileType::ASCII;
   stlSaver->setFileType(stlFt);
 
   Ply::DataType plyDt =
-    (D._binaryOutput)?Ply::DataType::BINARY_LITTLE_ENDIAN:Ply::DataType::ASCII;
+    (D._binaryOutput==false)?Ply::DataType::ASCII:
+    (D._bigEndian)?Ply::DataType::BINARY_BIG_ENDIAN:
+    Ply::DataType::BINARY_LITTLE_ENDIAN;
   SaverPly::setDefaultDataType(plyDt);
+  plySaver->setDataType(plyDt); // constructed with the previous default
+
+  // ascii parsing and formatting threads; 0 uses all the cores
+  TextWriter::setNumberOfThreads(D._threads);
+  LoaderPly::setNumberOfThreads(D._threads);
+  LoaderStl::setNumberOfThreads(D._threads);
+  LoaderWrl::setNumberOfThreads(D._threads);
+  SceneGraphProcessor::setNumberOfThreads(D._threads);
+
+  // coordinate quantization of the compressed ebm output
+  SaverEbm::setCoordBits(D._coordBits);
+
+  // ply colors kept as bytes, and coordinates quantized to 16 bits
+  Ply::setDefaultCompactColor(D._compact);
+  LoaderPly::setCompactCoord(D._compact);
+  LoaderPly::setDropUnusedProperties(D._dropUnused);
 
   if(D._debug) {
     SaverPly::setOstream(&cout);
     SaverPly::setIndent("    ");
   }
+
+  //////////////////////////////////////////////////////////////////////
+  // ply to ply conversion without building the SceneGraph
+
+  if(D._stream || D._outOfCore>0) {
+
+    string inFile = InputFile::uncompressedName(D._inFile.c_str());
+    if(string(plyLoader->ext())!=inFile.substr(inFile.find_last_of('.')+1) ||
+       string(plySaver->ext())!=D._outFile.substr(D._outFile.find_last_of('.')+1))
+      error("-stream and -outOfCore require ply inFile and outFile");
+
+    if(D._debug) {
+      cout << "  converting inFile {" << endl;
+    }
+
+    if(D._outOfCore>0) {
+
+      // normal per vertex and boundary/singular classification
+      // computed one chunk at a time
+      if(D._scratch=="") D._scratch = D._outFile+".ooc";
+      if(D._debug) {
+        OutOfCoreProcessor::setOstream(&cout);
+        OutOfCoreProcessor::setIndent("    ");
+      }
+      OutOfCoreProcessor ooc;
+      success =
+        ooc.partition(D._inFile.c_str(),D._scratch.c_str(),D._outOfCore) &&
+        ooc.process() &&
+        ooc.save(D._outFile.c_str(),plyDt);
+      if(success) {
+        cout << "  nVertices         = " << ooc.getNumberOfVertices()         << endl;
+        cout << "  nFaces            = " << ooc.getNumberOfFaces()            << endl;
+        cout << "  nChunks           = " << ooc.getNumberOfChunks()           << endl;
+        cout << "  nHaloFaces        = " << ooc.getNumberOfHaloFaces()        << endl;
+        cout << "  maxChunkFaces     = " << ooc.getMaxChunkFaces()            << endl;
+        cout << "  nEdges            = " << ooc.getNumberOfEdges()            << endl;
+        cout << "  nBoundaryEdges    = " << ooc.getNumberOfBoundaryEdges()    << endl;
+        cout << "  nSingularEdges    = " << ooc.getNumberOfSingularEdges()    << endl;
+        cout << "  nBoundaryVertices = " << ooc.getNumberOfBoundaryVertices() << endl;
+        cout << "  nSingularVertices = " << ooc.getNumberOfSingularVertices() << endl;
+      }
+      ooc.clear();
+
+    } else {
+
+      success = SaverPly::convert(D._inFile.c_str(),D._outFile.c_str(),plyDt);
+
+    }
+
+    if(D._debug) {
+      cout << "    success        = " << tv(success)          << endl;
+      cout << "  } converting inFile" << endl;
+      cout << endl;
+      cout << "} dgpTest2b" << endl;
+      fflush(stderr);
+    }
+
+    return (success)?0:-1;
+  }
 
   //////////////////////////////////////////////////////////////////////
   // read ScheneGraph
@@ -230,6 +596,52 @@ int main(int argc, char **argv) {
 
     if(D._debug) cout << "  }" << endl;  
   }
+
+  if(D._flatten) {
+    auto t0 = chrono::steady_clock::now();
+    SceneGraphProcessor processor(wrl);
+    processor.flatten();
+    auto t1 = chrono::steady_clock::now();
+    if(D._debug || D._benchmark)
+      cout << "  flattening                  : "
+           << chrono::duration<double,milli>(t1-t0).count() << " ms" << endl;
+  }
+
+  if(D._edges) {
+    auto t0 = chrono::steady_clock::now();
+    SceneGraphProcessor processor(wrl);
+    processor.edgesAdd(D._edges,D._featureAngle*3.14159265f/180.0f);
+    auto t1 = chrono::steady_clock::now();
+    if(D._debug || D._benchmark)
+      cout << "  adding edges                : "
+           << chrono::duration<double,milli>(t1-t0).count() << " ms" << endl;
+  }
+
+  if(D._reorder || D._benchmark) {
+    const int nPasses = 20;
+    double acmr = 0.0;
+    double ms   = 0.0;
+    if(D._benchmark) {
+      ms = benchmarkPass(wrl,nPasses,acmr);
+      cout << "  benchmark before reordering : "
+           << ms << " ms/pass ACMR = " << acmr << endl;
+    }
+    if(D._reorder) {
+      auto t0 = chrono::steady_clock::now();
+      SceneGraphProcessor processor(wrl);
+      processor.reorderVertices();
+      processor.reorderFaces();
+      auto t1 = chrono::steady_clock::now();
+      if(D._debug || D._benchmark)
+        cout << "  reordering                  : "
+             << chrono::duration<double,milli>(t1-t0).count() << " ms" << endl;
+    }
+    if(D._benchmark) {
+      ms = benchmarkPass(wrl,nPasses,acmr);
+      cout << "  benchmark after reordering  : "
+           << ms << " ms/pass ACMR = " << acmr << endl;
+    }
+  }
   
   //////////////////////////////////////////////////////////////////////
   // write
@@ -246,6 +658,14 @@ int main(int argc, char **argv) {
     cout << endl;
   }
 
+  if(D._roundTripTest) {
+    int nErrors =
+      (success)?testRoundTrip(wrl,loaderFactory,D._outFile.c_str()):1;
+    cout << "dgpTest2b | round trip test | "
+         << ((nErrors==0)?"passed":"FAILED") << endl;
+    if(nErrors>0) return 1;
+  }
+
   //////////////////////////////////////////////////////////////////////
 
   if(D._debug) {
@@ -33,20 +33,27 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <string>
+#include <vector>
 #include <iostream>
+#include <stdlib.h>
 
 using namespace std;
 
 #include <wrl/SceneGraphTraversal.hpp>
+#include <wrl/SceneGraphBvh.hpp>
 
 #include <io/AppLoader.hpp>
 #include <io/AppSaver.hpp>
 #include <io/LoaderPly.hpp>
 #include <io/LoaderStl.hpp>
 #include <io/LoaderWrl.hpp>
+#include <io/LoaderWrb.hpp>
+#include <io/LoaderEbm.hpp>
 #include <io/SaverPly.hpp>
 #include <io/SaverStl.hpp>
 #include <io/SaverWrl.hpp>
+#include <io/SaverWrb.hpp>
+#include <io/SaverEbm.hpp>
 
 #include <core/PolygonMesh.hpp>
 #include <core/PolygonMeshTest.hpp>
@@ -58,6 +65,7 @@ public:
   bool   _debug;
   bool   _binaryOutput;
   bool   _removeProperties;
+  vector<float> _query;
   string _inFile;
   string _outFile;
 public:
@@ -65,6 +73,7 @@ public:
     _debug(false),
     _binaryOutput(false),
     _removeProperties(false),
+    _query(),
     _inFile(""),
     _outFile("")
   { }
@@ -74,6 +83,7 @@ void options(Data& D) {
   cout << "   -d|-debug               [" << tv(D._debug)            << "]" << endl;
   cout << "   -b|-binaryOutput        [" << tv(D._binaryOutput)     << "]" << endl;
   cout << "   -r|-removeProperties    [" << tv(D._removeProperties) << "]" << endl;
+  cout << "   -q|-query x y z         [" << (D._query.size()/3)     << "]" << endl;
 }
 
 void usage(Data& D) {
@@ -105,6 +115,11 @@ int main(int argc, char **argv) {
       D._binaryOutput = !D._binaryOutput;
     } else if(string(argv[i])=="-r" || string(argv[i])=="-removeProperties") {
       D._removeProperties = !D._removeProperties;
+    } else if(string(argv[i])=="-q" || string(argv[i])=="-query") {
+      if(i+3>=argc) error("-query requires three coordinates");
+      D._query.push_back(static_cast<float>(atof(argv[++i])));
+      D._query.push_back(static_cast<float>(atof(argv[++i])));
+      D._query.push_back(static_cast<float>(atof(argv[++i])));
     } else if(string(argv[i])[0]=='-') {
       error("unknown option");
     } else if(D._inFile=="") {
@@ -144,6 +159,10 @@ int main(int argc, char **argv) {
   loaderFactory.registerLoader(stlLoader);
   LoaderWrl* wrlLoader = new LoaderWrl();
   loaderFactory.registerLoader(wrlLoader);
+  LoaderWrb* wrbLoader = new LoaderWrb();
+  loaderFactory.registerLoader(wrbLoader);
+  LoaderEbm* ebmLoader = new LoaderEbm();
+  loaderFactory.registerLoader(ebmLoader);
 
   //  If SaverPly::setDefaultDataType is used, it must be called
   //  before the Saver constructor; otherwise SaverPly::setDataType
@@ -158,6 +177,10 @@ int main(int argc, char **argv) {
   saverFactory.registerSaver(stlSaver);
   SaverWrl* wrlSaver = new SaverWrl();
   saverFactory.registerSaver(wrlSaver);
+  SaverWrb* wrbSaver = new SaverWrb();
+  saverFactory.registerSaver(wrbSaver);
+  SaverEbm* ebmSaver = new SaverEbm();
+  saverFactory.registerSaver(ebmSaver);
 
   SaverStl::FileType stlFt =
     (D._binaryOutput)?SaverStl::FileType::BINARY:SaverStl::FileType::ASCII;
@@ -245,6 +268,34 @@ int main(int argc, char **argv) {
   if(D._debug) cout << "  } processing" << endl;
   if(D._debug) cout << endl;
 
+  ////////////////////////////////////////////////////////////////////
+  // distance queries
+
+  if(D._query.size()>0) {
+    SceneGraphBvh bvh(wrl);
+    cout << "  distance queries {" << endl;
+    cout << "    nTriangles = " << bvh.getNumberOfTriangles() << endl;
+    cout << "    nNodes     = " << bvh.getNumberOfNodes() << endl;
+    cout << "    depth      = " << bvh.getDepth() << endl;
+    for(size_t iQ=0;iQ+2<D._query.size();iQ+=3) {
+      Vec3f p(D._query[iQ],D._query[iQ+1],D._query[iQ+2]);
+      SceneGraphBvh::Hit hit;
+      cout << "    query[" << (iQ/3) << "] = ("
+           << p.x << "," << p.y << "," << p.z << ")";
+      if(bvh.nearestPoint(p,hit)) {
+        cout << " distance = " << hit._distance
+             << " point = ("
+             << hit._point.x << "," << hit._point.y << "," << hit._point.z
+             << ") shape = \"" << hit._shape->getName() << "\""
+             << " face = " << hit._iF << endl;
+      } else {
+        cout << " no triangles" << endl;
+      }
+    }
+    cout << "  } distance queries" << endl;
+    cout << endl;
+  }
+
   ////////////////////////////////////////////////////////////////////
   // test HalfEdges, PolygonMesh, and PolygonMeshTest
 
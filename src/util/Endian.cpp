@@ -41,6 +41,15 @@
 
 #include "Endian.hpp"
 
+#include <cstring>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define ENDIAN_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
 bool Endian::toBool(const char b[/*1*/]) {
   return (b[0] != 0);
 }
@@ -88,6 +97,232 @@ Endian::SingleValueBuffer& Endian::swap8
 }
 
 
+//////////////////////////////////////////////////////////////////////
+// bulk byte swapping
+
+namespace {
+
+  // scalar implementation; the compilers recognize the shifts and
+  // masks as byte swap instructions
+
+  inline uint16_t bswap16(uint16_t v) {
+    return static_cast<uint16_t>((v>>8)|(v<<8));
+  }
+
+  inline uint32_t bswap32(uint32_t v) {
+    return
+      ((v>>24)&0x000000ffu)|((v>> 8)&0x0000ff00u)|
+      ((v<< 8)&0x00ff0000u)|((v<<24)&0xff000000u);
+  }
+
+  inline uint64_t bswap64(uint64_t v) {
+    return
+      (static_cast<uint64_t>(bswap32(static_cast<uint32_t>(v)))<<32)|
+      static_cast<uint64_t>(bswap32(static_cast<uint32_t>(v>>32)));
+  }
+
+  void swapScalar2(char* dst, const char* src, size_t n) {
+    for(size_t i=0;i<n;i++,dst+=2,src+=2) {
+      uint16_t v; memcpy(&v,src,2); v = bswap16(v); memcpy(dst,&v,2);
+    }
+  }
+
+  void swapScalar4(char* dst, const char* src, size_t n) {
+    for(size_t i=0;i<n;i++,dst+=4,src+=4) {
+      uint32_t v; memcpy(&v,src,4); v = bswap32(v); memcpy(dst,&v,4);
+    }
+  }
+
+  void swapScalar8(char* dst, const char* src, size_t n) {
+    for(size_t i=0;i<n;i++,dst+=8,src+=8) {
+      uint64_t v; memcpy(&v,src,8); v = bswap64(v); memcpy(dst,&v,8);
+    }
+  }
+
+  typedef void (*SwapFunction)(char* dst, const char* src, size_t n);
+
+  struct SwapFunctions {
+    const char*  name;
+    SwapFunction swap2;
+    SwapFunction swap4;
+    SwapFunction swap8;
+  };
+
+  const SwapFunctions swapFunctionsScalar = {
+    "scalar", swapScalar2, swapScalar4, swapScalar8
+  };
+
+#ifdef ENDIAN_X86_DISPATCH
+
+  // each shuffle reverses the bytes within every value of a 16 byte
+  // lane; the tail which does not fill a register is swapped by the
+  // scalar functions
+
+  __attribute__((target("ssse3")))
+  void swapSse(char* dst, const char* src, size_t nBytes,
+               const __m128i mask) {
+    size_t i;
+    for(i=0;i+16<=nBytes;i+=16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),
+                       _mm_shuffle_epi8(v,mask));
+    }
+  }
+
+  __attribute__((target("ssse3")))
+  void swapSse2(char* dst, const char* src, size_t n) {
+    const __m128i mask =
+      _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+    size_t n0 = n&~static_cast<size_t>(7);
+    swapSse(dst,src,2*n0,mask);
+    swapScalar2(dst+2*n0,src+2*n0,n-n0);
+  }
+
+  __attribute__((target("ssse3")))
+  void swapSse4(char* dst, const char* src, size_t n) {
+    const __m128i mask =
+      _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    size_t n0 = n&~static_cast<size_t>(3);
+    swapSse(dst,src,4*n0,mask);
+    swapScalar4(dst+4*n0,src+4*n0,n-n0);
+  }
+
+  __attribute__((target("ssse3")))
+  void swapSse8(char* dst, const char* src, size_t n) {
+    const __m128i mask =
+      _mm_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8);
+    size_t n0 = n&~static_cast<size_t>(1);
+    swapSse(dst,src,8*n0,mask);
+    swapScalar8(dst+8*n0,src+8*n0,n-n0);
+  }
+
+  __attribute__((target("avx2")))
+  void swapAvx(char* dst, const char* src, size_t nBytes,
+               const __m256i mask) {
+    size_t i;
+    // two registers per iteration
+    for(i=0;i+64<=nBytes;i+=64) {
+      __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+i));
+      __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+i+32));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i),
+                          _mm256_shuffle_epi8(v0,mask));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i+32),
+                          _mm256_shuffle_epi8(v1,mask));
+    }
+    for(;i+32<=nBytes;i+=32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i),
+                          _mm256_shuffle_epi8(v,mask));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void swapAvx2(char* dst, const char* src, size_t n) {
+    const __m256i mask =
+      _mm256_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,
+                       1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+    size_t n0 = n&~static_cast<size_t>(15);
+    swapAvx(dst,src,2*n0,mask);
+    swapScalar2(dst+2*n0,src+2*n0,n-n0);
+  }
+
+  __attribute__((target("avx2")))
+  void swapAvx4(char* dst, const char* src, size_t n) {
+    const __m256i mask =
+      _mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+                       3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    size_t n0 = n&~static_cast<size_t>(7);
+    swapAvx(dst,src,4*n0,mask);
+    swapScalar4(dst+4*n0,src+4*n0,n-n0);
+  }
+
+  __attribute__((target("avx2")))
+  void swapAvx8(char* dst, const char* src, size_t n) {
+    const __m256i mask =
+      _mm256_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8,
+                       7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8);
+    size_t n0 = n&~static_cast<size_t>(3);
+    swapAvx(dst,src,8*n0,mask);
+    swapScalar8(dst+8*n0,src+8*n0,n-n0);
+  }
+
+  const SwapFunctions swapFunctionsSsse3 = {
+    "ssse3", swapSse2, swapSse4, swapSse8
+  };
+
+  const SwapFunctions swapFunctionsAvx2 = {
+    "avx2", swapAvx2, swapAvx4, swapAvx8
+  };
+
+#endif // ENDIAN_X86_DISPATCH
+
+  bool swapScalarOnly = false;
+
+  // selected once, the first time a bulk swap is requested
+  const SwapFunctions& swapFunctions() {
+    static const SwapFunctions* best = []() {
+#ifdef ENDIAN_X86_DISPATCH
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2"))  return &swapFunctionsAvx2;
+      if(__builtin_cpu_supports("ssse3")) return &swapFunctionsSsse3;
+#endif
+      return &swapFunctionsScalar;
+    }();
+    return (swapScalarOnly)?swapFunctionsScalar:*best;
+  }
+
+}
+
+void Endian::swap2(void* values, const size_t nValues) {
+  char* p = static_cast<char*>(values);
+  swapFunctions().swap2(p,p,nValues);
+}
+
+void Endian::swap4(void* values, const size_t nValues) {
+  char* p = static_cast<char*>(values);
+  swapFunctions().swap4(p,p,nValues);
+}
+
+void Endian::swap8(void* values, const size_t nValues) {
+  char* p = static_cast<char*>(values);
+  swapFunctions().swap8(p,p,nValues);
+}
+
+void Endian::swap2(void* dst, const void* src, const size_t nValues) {
+  swapFunctions().swap2
+    (static_cast<char*>(dst),static_cast<const char*>(src),nValues);
+}
+
+void Endian::swap4(void* dst, const void* src, const size_t nValues) {
+  swapFunctions().swap4
+    (static_cast<char*>(dst),static_cast<const char*>(src),nValues);
+}
+
+void Endian::swap8(void* dst, const void* src, const size_t nValues) {
+  swapFunctions().swap8
+    (static_cast<char*>(dst),static_cast<const char*>(src),nValues);
+}
+
+void Endian::swap
+(void* dst, const void* src, const size_t nValues, const size_t valueSize) {
+  switch(valueSize) {
+  case 2:  swap2(dst,src,nValues); break;
+  case 4:  swap4(dst,src,nValues); break;
+  case 8:  swap8(dst,src,nValues); break;
+  default:
+    if(dst!=src) memcpy(dst,src,nValues*valueSize);
+    break;
+  }
+}
+
+const char* Endian::swapImplementation() {
+  return swapFunctions().name;
+}
+
+void Endian::setSwapScalarOnly(const bool value) {
+  swapScalarOnly = value;
+}
+
 //////////////////////////////////////////////////////////////////////
 // static
 bool Endian::isLittleEndianSystem() {
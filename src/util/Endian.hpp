@@ -42,6 +42,8 @@
 #ifndef ENDIAN_HPP
 #define ENDIAN_HPP
 
+#include <cstddef>
+
 typedef unsigned char  uchar;
 typedef unsigned short ushort;
 typedef unsigned int   uint;
@@ -85,6 +87,31 @@ namespace Endian {
 #define swapLong   swap8
 #define swapDouble swap8
 
+  // bulk variants, which reverse the bytes of nValues contiguous
+  // values, either in place, or copying from src to dst; the arrays
+  // do not need to be aligned, and src and dst may not overlap unless
+  // they are equal
+  // - SSSE3 or AVX2 shuffles are used when supported by the processor,
+  //   and a scalar loop otherwise
+
+  void swap2(void* values, const size_t nValues);
+  void swap4(void* values, const size_t nValues);
+  void swap8(void* values, const size_t nValues);
+
+  void swap2(void* dst, const void* src, const size_t nValues);
+  void swap4(void* dst, const void* src, const size_t nValues);
+  void swap8(void* dst, const void* src, const size_t nValues);
+
+  // valueSize = 1, 2, 4, or 8; values of size 1 are copied unchanged
+  void swap(void* dst, const void* src,
+            const size_t nValues, const size_t valueSize);
+
+  // "avx2", "ssse3", or "scalar"
+  const char* swapImplementation();
+
+  // forces the scalar implementation, mostly for benchmarking
+  void setSwapScalarOnly(const bool value);
+
   bool isLittleEndianSystem();
 
 };
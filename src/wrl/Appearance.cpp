@@ -58,13 +58,17 @@ Node* Appearance::getTexture() {
 // }
 
 void Appearance::setMaterial(Node* material) {
-  material->setParent(this);
+  if(material->getParent()==(Node*)0)
+    material->setParent(this);
   _material = material;
+  structureChanged();
 }
 
 void Appearance::setTexture(Node* texture) {
-  texture->setParent(this);
+  if(texture->getParent()==(Node*)0)
+    texture->setParent(this);
   _texture = texture;
+  structureChanged();
 }
 
 // void Appearance::setTextureTransform(Node* textureTransform) {
@@ -45,12 +45,19 @@ _bboxCenter(0.0f,0.0f,0.0f),
 _bboxSize(-1.0f,-1.0f,-1.0f) {
 }
 
+// a child shared by several groups (VRML USE) is deleted together
+// with the last group referencing it; its parent is the first group
+// it was added to
+
 Group::~Group() {
   pNode child;
   while(_children.size()>0) {
     child = _children.back();
     _children.pop_back();
-    delete child;
+    if(child->removeReference()==0)
+      delete child;
+    else if(child->getParent()==this)
+      child->setParent((Node*)0);
   }
 }
 
@@ -96,8 +103,11 @@ float Group::getBBoxDiameter() {
 }
 
 void Group::addChild(const pNode child) {
-  child->setParent(this);
+  if(child->getParent()==(Node*)0)
+    child->setParent(this);
+  child->addReference();
   _children.push_back(child);
+  structureChanged();
 }
 
 void Group::removeChild(const pNode child) {
@@ -105,7 +115,11 @@ void Group::removeChild(const pNode child) {
   node = find(_children.begin(),_children.end(),child);
   if(node!=_children.end()) {
     _children.erase(node);
-    delete &(*node);
+    if(child->removeReference()==0)
+      delete child;
+    else if(child->getParent()==this)
+      child->setParent((Node*)0);
+    structureChanged();
   }
 }
 
@@ -204,9 +218,18 @@ void Group::updateBBox() {
       node = shape->getGeometry();
       if(node!=(Node*)0 && node->isIndexedFaceSet()) {
         IndexedFaceSet* pIfs = (IndexedFaceSet*)node;
-        vector<float> &coord = pIfs->getCoord();    
-        // update this group bounding box
-        updateBBox(coord);
+        if(pIfs->hasCompactCoord()) {
+          // the quantization box is the bounding box of the
+          // coordinates, and they are not decoded
+          vector<float> coord;
+          coord.insert(coord.end(),pIfs->getCoordMin(),pIfs->getCoordMin()+3);
+          coord.insert(coord.end(),pIfs->getCoordMax(),pIfs->getCoordMax()+3);
+          updateBBox(coord);
+        } else {
+          vector<float> &coord = pIfs->getCoord();    
+          // update this group bounding box
+          updateBBox(coord);
+        }
       } else if(node!=(Node*)0 && node->isIndexedLineSet()) {
         IndexedLineSet* pIls = (IndexedLineSet*)node;
         vector<float> &coord = pIls->getCoord();    
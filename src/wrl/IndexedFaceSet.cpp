@@ -65,7 +65,9 @@ IndexedFaceSet::IndexedFaceSet():
   _creaseAngle(0),
   _solid(true),
   _normalPerVertex(true),
-  _colorPerVertex(true)
+  _colorPerVertex(true),
+  _coordMin{0.0f,0.0f,0.0f},
+  _coordMax{0.0f,0.0f,0.0f}
 {}
 
 void IndexedFaceSet::clear() {
@@ -83,6 +85,8 @@ void IndexedFaceSet::clear() {
   _colorIndex.clear();
   _texCoord.clear();
   _texCoordIndex.clear();
+  _coordQ16.clear();
+  _colorRGBA8.clear();
 }
 
 bool&          IndexedFaceSet::getCcw()              { return _ccw;                }
@@ -91,16 +95,141 @@ float&         IndexedFaceSet::getCreaseangle()      { return _creaseAngle;
 bool&          IndexedFaceSet::getSolid()            { return _solid;              }
 bool&          IndexedFaceSet::getNormalPerVertex()  { return _normalPerVertex;    }
 bool&          IndexedFaceSet::getColorPerVertex()   { return _colorPerVertex;     }
-vector<float>& IndexedFaceSet::getCoord()            { return _coord;              }
 vector<int>&   IndexedFaceSet::getCoordIndex()       { return _coordIndex;         }
 vector<float>& IndexedFaceSet::getNormal()           { return _normal;             }
 vector<int>&   IndexedFaceSet::getNormalIndex()      { return _normalIndex;        }
-vector<float>& IndexedFaceSet::getColor()            { return _color;              }
 vector<int>&   IndexedFaceSet::getColorIndex()       { return _colorIndex;         }
 vector<float>& IndexedFaceSet::getTexCoord()         { return _texCoord;           }
 vector<int>&   IndexedFaceSet::getTexCoordIndex()    { return _texCoordIndex;      }
 
+vector<float>& IndexedFaceSet::getCoord() {
+  if(_coordQ16.size()>0) {
+    // decode and release the compact coordinates
+    readCoord(_coord);
+    vector<unsigned short>().swap(_coordQ16);
+  }
+  return _coord;
+}
+
+vector<float>& IndexedFaceSet::getColor() {
+  if(_colorRGBA8.size()>0) {
+    // decode and release the compact colors
+    readColor(_color);
+    vector<unsigned char>().swap(_colorRGBA8);
+  }
+  return _color;
+}
+
+void IndexedFaceSet::compactCoord() {
+  if(_coord.size()<3) return;
+  int nV = getNumberOfCoord();
+  int iV,j;
+  for(j=0;j<3;j++)
+    _coordMin[j] = _coordMax[j] = _coord[UL(j)];
+  for(iV=1;iV<nV;iV++) {
+    for(j=0;j<3;j++) {
+      float x = _coord[3*UL(iV)+UL(j)];
+      if(x<_coordMin[j]) _coordMin[j] = x;
+      if(x>_coordMax[j]) _coordMax[j] = x;
+    }
+  }
+  // the components of the degenerate sides of the box are all 0
+  float scale[3];
+  for(j=0;j<3;j++)
+    scale[j] = (_coordMax[j]>_coordMin[j])?
+      65535.0f/(_coordMax[j]-_coordMin[j]):0.0f;
+  _coordQ16.resize(3*UL(nV));
+  for(iV=0;iV<nV;iV++) {
+    for(j=0;j<3;j++) {
+      float q = (_coord[3*UL(iV)+UL(j)]-_coordMin[j])*scale[j]+0.5f;
+      _coordQ16[3*UL(iV)+UL(j)] =
+        static_cast<unsigned short>((q<65535.0f)?q:65535.0f);
+    }
+  }
+  vector<float>().swap(_coord);
+}
+
+void IndexedFaceSet::compactColor() {
+  if(_color.size()<3) return;
+  int nC = getNumberOfColor();
+  _colorRGBA8.resize(4*UL(nC));
+  for(int iC=0;iC<nC;iC++) {
+    for(int j=0;j<3;j++) {
+      float c = _color[3*UL(iC)+UL(j)];
+      c = (c<0.0f)?0.0f:(c>1.0f)?1.0f:c;
+      _colorRGBA8[4*UL(iC)+UL(j)] = static_cast<unsigned char>(c*255.0f+0.5f);
+    }
+    _colorRGBA8[4*UL(iC)+3] = 255;
+  }
+  vector<float>().swap(_color);
+}
+
+bool IndexedFaceSet::hasCompactCoord() {
+  return (_coordQ16.size()>0);
+}
+
+bool IndexedFaceSet::hasCompactColor() {
+  return (_colorRGBA8.size()>0);
+}
+
+vector<unsigned short>& IndexedFaceSet::getCoordQ16() {
+  return _coordQ16;
+}
+
+float* IndexedFaceSet::getCoordMin() {
+  return _coordMin;
+}
+
+float* IndexedFaceSet::getCoordMax() {
+  return _coordMax;
+}
+
+vector<unsigned char>& IndexedFaceSet::getColorRGBA8() {
+  return _colorRGBA8;
+}
+
+const vector<float>& IndexedFaceSet::readCoord(vector<float>& tmp) {
+  if(_coordQ16.size()==0) return _coord;
+  int nV = getNumberOfCoord();
+  tmp.resize(3*UL(nV));
+  for(int iV=0;iV<nV;iV++)
+    getCoordValue(iV,&tmp[3*UL(iV)]);
+  return tmp;
+}
+
+const vector<float>& IndexedFaceSet::readColor(vector<float>& tmp) {
+  if(_colorRGBA8.size()==0) return _color;
+  int nC = getNumberOfColor();
+  tmp.resize(3*UL(nC));
+  for(int iC=0;iC<nC;iC++)
+    getColorValue(iC,&tmp[3*UL(iC)]);
+  return tmp;
+}
+
+void IndexedFaceSet::getCoordValue(const int iV, float* x) {
+  if(_coordQ16.size()>0) {
+    for(int j=0;j<3;j++)
+      x[j] = _coordMin[j]+(_coordMax[j]-_coordMin[j])*
+        F(_coordQ16[3*UL(iV)+UL(j)])/65535.0f;
+  } else {
+    for(int j=0;j<3;j++)
+      x[j] = _coord[3*UL(iV)+UL(j)];
+  }
+}
+
+void IndexedFaceSet::getColorValue(const int iC, float* c) {
+  if(_colorRGBA8.size()>0) {
+    for(int j=0;j<3;j++)
+      c[j] = F(_colorRGBA8[4*UL(iC)+UL(j)])/255.0f;
+  } else {
+    for(int j=0;j<3;j++)
+      c[j] = _color[3*UL(iC)+UL(j)];
+  }
+}
+
 int IndexedFaceSet::getNumberOfCoord() {
+  if(_coordQ16.size()>0)
+    return static_cast<int>(_coordQ16.size()/3);
   return static_cast<int>(_coord.size()/3);
 }
 
@@ -113,6 +242,8 @@ int IndexedFaceSet::getNumberOfNormal() {
 }
 
 int IndexedFaceSet::getNumberOfColor() {
+  if(_colorRGBA8.size()>0)
+    return static_cast<int>(_colorRGBA8.size()/4);
   return static_cast<int>(_color.size()/3);
 }
 
@@ -200,7 +331,7 @@ IndexedFaceSet::Binding IndexedFaceSet::getColorBinding() {
   //   }
   // }
   return
-    (_color.size()==0      )?PB_NONE:
+    (getNumberOfColor()==0 )?PB_NONE:
     (_colorPerVertex==false)?
     ((_colorIndex.size()>0  )?PB_PER_FACE_INDEXED:PB_PER_FACE  ):
     ((_colorIndex.size()>0  )?PB_PER_CORNER      :PB_PER_VERTEX);
@@ -232,21 +363,21 @@ bool IndexedFaceSet::hasFaces() {
 
 bool IndexedFaceSet::hasColorPerVertex() {
   if(_colorPerVertex==false) return false;
-  if(_colorIndex.size()==0) return false;
+  if(_colorIndex.size()>0) return false;
   int nVertices = getNumberOfVertices();
   if(nVertices<=0) return false;
-  return (_color.size()==UL(3*nVertices));
+  return (getNumberOfColor()==nVertices);
 }
 
 bool IndexedFaceSet::hasColorPerFace() {
   if(_colorPerVertex==true) return false;
   int nFaces  = getNumberOfFaces();
   if(nFaces<=0) return false;
-  int nColors = I(_color.size()/3);
+  int nColors = getNumberOfColor();
   if(nColors<=0) return false;
   // color per face non-indexed
   if(_colorIndex.size()==0)
-    return (_color.size()==UL(3*nFaces));
+    return (nColors==nFaces);
   // color per face indexed
   return (_colorIndex.size()==_coordIndex.size());
 }
@@ -255,7 +386,7 @@ bool IndexedFaceSet::hasColorPerCorner() {
   if(_colorPerVertex==false) return false;
   int nVertices = getNumberOfVertices();
   if(nVertices<=0) return false;
-  int nColor    = I(_color.size()/3);
+  int nColor    = getNumberOfColor();
   if(nColor<=0) return false;
   int nFaces    = getNumberOfFaces();
   if(nFaces<=0) return false;
@@ -350,7 +481,9 @@ void IndexedFaceSet::printInfo(string indent) {
   std::cout << indent << "  coordBinding       = " <<
     stringBinding(getCoordBinding()) << "\n";
   std::cout << indent << "  nCoord             = " <<
-    _coord.size()/3 << "\n";
+    getNumberOfCoord() << "\n";
+  std::cout << indent << "  compactCoord       = " <<
+    hasCompactCoord() << "\n";
   std::cout << indent << "  coordIndex.size()  = " <<
     _coordIndex.size() << "\n";
   std::cout << indent << "  normalBinding      = " <<
@@ -366,7 +499,9 @@ void IndexedFaceSet::printInfo(string indent) {
   std::cout << indent << "  colorPerVertex     = " <<
     _colorPerVertex << "\n";
   std::cout << indent << "  nColor             = " <<
-    _color.size()/3 << "\n";
+    getNumberOfColor() << "\n";
+  std::cout << indent << "  compactColor       = " <<
+    hasCompactColor() << "\n";
   std::cout << indent << "  colorIndex.size()  = " <<
     _colorIndex.size() << "\n";
   std::cout << indent << "  texCoordBinding    = " <<
@@ -83,6 +83,12 @@ private:
   vector<float>  _color;
   vector<int>    _colorIndex;
 
+  // compact storage, used instead of _coord and _color when not empty
+  vector<unsigned short> _coordQ16;
+  float          _coordMin[3];
+  float          _coordMax[3];
+  vector<unsigned char>  _colorRGBA8;
+
   vector<float>  _texCoord;
   vector<int>    _texCoordIndex;
 
@@ -119,6 +125,31 @@ public:
   void            setNormalPerVertex(bool value);
   void            setColorPerVertex(bool value);
 
+  // compact storage modes: the coordinates quantized to 16 bits per
+  // component relative to the box [coordMin,coordMax], and the colors
+  // stored as RGBA8, four bytes per color; the float array of an
+  // attribute in compact storage is empty, and getCoord() and
+  // getColor() decode the compact array back into it on demand and
+  // release it, so that the code which modifies the float arrays does
+  // not need to know about these modes; the code which only reads
+  // them should use readCoord() and readColor(), which return the
+  // float array, or the compact array decoded into tmp, and
+  // getCoordValue() and getColorValue(), which decode a single value,
+  // without changing the storage
+
+  void                    compactCoord();
+  void                    compactColor();
+  bool                    hasCompactCoord();
+  bool                    hasCompactColor();
+  vector<unsigned short>& getCoordQ16();
+  float*                  getCoordMin(); // [3]
+  float*                  getCoordMax(); // [3]
+  vector<unsigned char>&  getColorRGBA8();
+  const vector<float>&    readCoord(vector<float>& tmp);
+  const vector<float>&    readColor(vector<float>& tmp);
+  void                    getCoordValue(const int iV, float* x /*[3]*/);
+  void                    getColorValue(const int iC, float* c /*[3]*/);
+
   enum Binding {
     PB_NONE = 0,
     PB_PER_VERTEX,
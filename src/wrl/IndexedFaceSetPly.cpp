@@ -49,10 +49,17 @@ using namespace std;
 
 IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
   IndexedFaceSet(),
-  _ply(ply) {
+  _ply(ply),
+  _coordP{nullptr,nullptr,nullptr},
+  _normalP{nullptr,nullptr,nullptr},
+  _colorP{nullptr,nullptr,nullptr},
+  _texCoordP{nullptr,nullptr},
+  _coordIndexP(nullptr) {
 
   (void)indent;
 
+  if(ply==nullptr) return;
+
   // APP->log(QString("%1IndexedFaceSetPly() {").arg(indent.c_str()));
 
   try {
@@ -65,6 +72,7 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
     vector<int>&   normalIndex   = getNormalIndex();
     vector<float>& color         = getColor();
     vector<int>&   colorIndex    = getColorIndex();
+    vector<uchar>& colorRGBA8    = getColorRGBA8();
     vector<float>& texCoord      = getTexCoord();
     vector<int>&   texCoordIndex = getTexCoordIndex();
 
@@ -121,11 +129,19 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
         throw new StrException("  ply does not have vertex coordinates");
       vector<float>* coordV =
         static_cast<vector<float>*>(coordP->getValue());
-      coord.insert(coord.end(),coordV->begin(),coordV->end());
+      coord.swap(*coordV);
+      _coordP[0] = coordP;
     
+      // the normals and colors per face, if any, replace the normals
+      // and colors per vertex, which are left in the Ply
+      bool hasNormalPerFace =
+        (face!=nullptr && face->getProperty("normal")!=nullptr);
+      bool hasColorPerFace =
+        (face!=nullptr && face->getProperty("color")!=nullptr);
+
       // normals per vertex
       Ply::Element::Property* normalP = vertex->getProperty("normal");
-      if(normalP!=nullptr) {
+      if(normalP!=nullptr && hasNormalPerFace==false) {
 
         // APP->log(QString("%1  has normals per vertex").arg(indent.c_str()));
 
@@ -134,7 +150,8 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
         normalIndex.clear();
         vector<float>* normalV =
           static_cast<vector<float>*>(normalP->getValue());
-        normal.insert(normal.end(),normalV->begin(),normalV->end());
+        normal.swap(*normalV);
+        _normalP[0] = normalP;
 
         // APP->log(QString("%1  nNormals = %2")
         //          .arg(indent.c_str()).arg(normal.size()/3));
@@ -145,16 +162,24 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
     
       // colors per vertex
       Ply::Element::Property* colorP = vertex->getProperty("color");
-      if(colorP!=nullptr) {
+      if(colorP!=nullptr && hasColorPerFace==false) {
 
         // APP->log(QString("%1  has colors per vertex").arg(indent.c_str()));
 
         setColorPerVertex(true);
         color.clear();
         colorIndex.clear();
-        vector<float>* colorV =
-          static_cast<vector<float>*>(colorP->getValue());
-        color.insert(color.end(),colorV->begin(),colorV->end());
+        colorRGBA8.clear();
+        if(colorP->getPropertyType()==Ply::Element::Property::Type::UINT8_4) {
+          vector<uchar>* colorV =
+            static_cast<vector<uchar>*>(colorP->getValue());
+          colorRGBA8.swap(*colorV);
+        } else {
+          vector<float>* colorV =
+            static_cast<vector<float>*>(colorP->getValue());
+          color.swap(*colorV);
+        }
+        _colorP[0] = colorP;
 
         // APP->log(QString("%1  nColors = %2")
         //          .arg(indent.c_str()).arg(color.size()/3));
@@ -174,7 +199,8 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
         texCoordIndex.clear();
         vector<float>* texCoordV =
           static_cast<vector<float>*>(texCoordP->getValue());
-        texCoord.insert(texCoord.end(),texCoordV->begin(),texCoordV->end());
+        texCoord.swap(*texCoordV);
+        _texCoordP[0] = texCoordP;
 
         // APP->log(QString("%1  nTexCoord = %2")
         //          .arg(indent.c_str()).arg(texCoord.size()/2));
@@ -191,7 +217,8 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
         Ply::Element::Property* coordIndexP = face->getProperty("coordIndex");
         vector<int>* coordIndexV =
           static_cast<vector<int>*>(coordIndexP->getValue());
-        coordIndex.insert(coordIndex.end(),coordIndexV->begin(),coordIndexV->end());
+        coordIndex.swap(*coordIndexV);
+        _coordIndexP = coordIndexP;
     
         // normals per face
         Ply::Element::Property* normalP = face->getProperty("normal");
@@ -204,7 +231,8 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
           normalIndex.clear();
           vector<float>* normalV =
             static_cast<vector<float>*>(normalP->getValue());
-          normal.insert(normal.end(),normalV->begin(),normalV->end());
+          normal.swap(*normalV);
+          _normalP[0] = normalP;
 
           // APP->log(QString("%1  nNormals = %2")
           //          .arg(indent.c_str()).arg(normal.size()/3));
@@ -222,9 +250,17 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
           setColorPerVertex(false);
           color.clear();
           colorIndex.clear();
-          vector<float>* colorV =
-            static_cast<vector<float>*>(colorP->getValue());
-          color.insert(color.end(),colorV->begin(),colorV->end());
+          colorRGBA8.clear();
+          if(colorP->getPropertyType()==Ply::Element::Property::Type::UINT8_4) {
+            vector<uchar>* colorV =
+              static_cast<vector<uchar>*>(colorP->getValue());
+            colorRGBA8.swap(*colorV);
+          } else {
+            vector<float>* colorV =
+              static_cast<vector<float>*>(colorP->getValue());
+            color.swap(*colorV);
+          }
+          _colorP[0] = colorP;
 
           // APP->log(QString("%1  nColors = %2")
           //          .arg(indent.c_str()).arg(color.size()/3));
@@ -250,17 +286,29 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
       vector<float>* xV = static_cast<vector<float>*>(xP->getValue());
       vector<float>* yV = static_cast<vector<float>*>(yP->getValue());
       vector<float>* zV = static_cast<vector<float>*>(zP->getValue());
+      coord.reserve(3*UL(nVertices));
       for(i=0;i<nVertices;i++) {
         coord.push_back((*xV)[UL(i)]);
         coord.push_back((*yV)[UL(i)]);
         coord.push_back((*zV)[UL(i)]);
       }
+      _release(_coordP,xP,yP,zP);
     
+      // the normals and colors per face, if any, replace the normals
+      // and colors per vertex, which are left in the Ply
+      bool hasNormalPerFace =
+        (face!=nullptr && face->getProperty("nx")!=nullptr &&
+         face->getProperty("ny")!=nullptr && face->getProperty("nz")!=nullptr);
+      bool hasColorPerFace =
+        (face!=nullptr && face->getProperty("red")!=nullptr &&
+         face->getProperty("green")!=nullptr && face->getProperty("blue")!=nullptr);
+
       // normals per vertex
       Ply::Element::Property* nxP = vertex->getProperty("nx");
       Ply::Element::Property* nyP = vertex->getProperty("ny");
       Ply::Element::Property* nzP = vertex->getProperty("nz");
-      if(nxP!=nullptr && nyP!=nullptr && nzP!=nullptr) {
+      if(nxP!=nullptr && nyP!=nullptr && nzP!=nullptr &&
+         hasNormalPerFace==false) {
 
         // APP->log(QString("%1  has normals per vertex").arg(indent.c_str()));
 
@@ -270,11 +318,13 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
         vector<float>* nxV = static_cast<vector<float>*>(nxP->getValue());
         vector<float>* nyV = static_cast<vector<float>*>(nyP->getValue());
         vector<float>* nzV = static_cast<vector<float>*>(nzP->getValue());
+        normal.reserve(3*UL(nVertices));
         for(i=0;i<nVertices;i++) {
           normal.push_back((*nxV)[UL(i)]);
           normal.push_back((*nyV)[UL(i)]);
           normal.push_back((*nzV)[UL(i)]);
         }
+        _release(_normalP,nxP,nyP,nzP);
         // APP->log(QString("%1  nNormals = %2")
         //          .arg(indent.c_str()).arg(normal.size()/3));
 
@@ -286,21 +336,35 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
       Ply::Element::Property* rP = vertex->getProperty("red");
       Ply::Element::Property* gP = vertex->getProperty("green");
       Ply::Element::Property* bP = vertex->getProperty("blue");
-      if(rP!=nullptr && gP!=nullptr && bP!=nullptr) {
+      if(rP!=nullptr && gP!=nullptr && bP!=nullptr &&
+         hasColorPerFace==false) {
 
         // APP->log(QString("%1  has color per vertex").arg(indent.c_str()));
 
         setColorPerVertex(true);
         color.clear();
         colorIndex.clear();
+        colorRGBA8.clear();
         vector<uchar>* rV = static_cast<vector<uchar>*>(rP->getValue());
         vector<uchar>* gV = static_cast<vector<uchar>*>(gP->getValue());
         vector<uchar>* bV = static_cast<vector<uchar>*>(bP->getValue());
-        for(i=0;i<nVertices;i++) {      
-          color.push_back(F((*rV)[UL(i)]&0xff)/255.0f);
-          color.push_back(F((*gV)[UL(i)]&0xff)/255.0f);
-          color.push_back(F((*bV)[UL(i)]&0xff)/255.0f);
+        if(_ply->_compactColor) {
+          colorRGBA8.reserve(4*UL(nVertices));
+          for(i=0;i<nVertices;i++) {
+            colorRGBA8.push_back((*rV)[UL(i)]);
+            colorRGBA8.push_back((*gV)[UL(i)]);
+            colorRGBA8.push_back((*bV)[UL(i)]);
+            colorRGBA8.push_back(255);
+          }
+        } else {
+          color.reserve(3*UL(nVertices));
+          for(i=0;i<nVertices;i++) {
+            color.push_back(F((*rV)[UL(i)]&0xff)/255.0f);
+            color.push_back(F((*gV)[UL(i)]&0xff)/255.0f);
+            color.push_back(F((*bV)[UL(i)]&0xff)/255.0f);
+          }
         }
+        _release(_colorP,rP,gP,bP);
         // APP->log(QString("%1  nColors = %2")
         //          .arg(indent.c_str()).arg(color.size()/3));
       } else {
@@ -319,10 +383,12 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
         texCoordIndex.clear();
         vector<float>* u = static_cast<vector<float>*>(uP->getValue());
         vector<float>* v = static_cast<vector<float>*>(vP->getValue());
+        texCoord.reserve(2*UL(nVertices));
         for(i=0;i<nVertices;i++) {      
           texCoord.push_back((*u)[UL(i)]);
           texCoord.push_back((*v)[UL(i)]);
         }
+        _release(_texCoordP,uP,vP);
         // APP->log(QString("%1  nTexCoord = %2")
         //          .arg(indent.c_str()).arg(texCoord.size()/2));
       } else {
@@ -337,6 +403,7 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
       
         Ply::Element::Property* indxP = face->getProperty("vertex_indices");
         vector<int>*            indxV = static_cast<vector<int>*>(indxP->getValue());
+        coordIndex.reserve(indxV->size()+UL(nFaces));
         for(iF=0;iF<nFaces;iF++) {
           i0   = indxP->getListFirst(iF );
           i1   = indxP->getListFirst(iF+1);
@@ -344,6 +411,7 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
             coordIndex.push_back((*indxV)[UL(i)]);
           coordIndex.push_back(-1);
         }
+        _release(&_coordIndexP,indxP);
     
         // normals per face
         Ply::Element::Property* nxP = face->getProperty("nx");
@@ -359,11 +427,13 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
           vector<float>* nxV = static_cast<vector<float>*>(nxP->getValue());
           vector<float>* nyV = static_cast<vector<float>*>(nyP->getValue());
           vector<float>* nzV = static_cast<vector<float>*>(nzP->getValue());
+          normal.reserve(3*UL(nFaces));
           for(i=0;i<nFaces;i++) {
             normal.push_back((*nxV)[UL(i)]);
             normal.push_back((*nyV)[UL(i)]);
             normal.push_back((*nzV)[UL(i)]);
           }
+          _release(_normalP,nxP,nyP,nzP);
           // APP->log(QString("%1  nNormals = %2")
           //          .arg(indent.c_str()).arg(normal.size()/3));
 
@@ -382,14 +452,27 @@ IndexedFaceSetPly::IndexedFaceSetPly(Ply * ply, const string indent):
           setColorPerVertex(false);
           color.clear();
           colorIndex.clear();
+          colorRGBA8.clear();
           vector<uchar>* rV = static_cast<vector<uchar>*>(rP->getValue());
           vector<uchar>* gV = static_cast<vector<uchar>*>(gP->getValue());
           vector<uchar>* bV = static_cast<vector<uchar>*>(bP->getValue());
-          for(i=0;i<nFaces;i++) {      
-            color.push_back(F((*rV)[UL(i)]&0xff)/255.0f);
-            color.push_back(F((*gV)[UL(i)]&0xff)/255.0f);
-            color.push_back(F((*bV)[UL(i)]&0xff)/255.0f);
+          if(_ply->_compactColor) {
+            colorRGBA8.reserve(4*UL(nFaces));
+            for(i=0;i<nFaces;i++) {
+              colorRGBA8.push_back((*rV)[UL(i)]);
+              colorRGBA8.push_back((*gV)[UL(i)]);
+              colorRGBA8.push_back((*bV)[UL(i)]);
+              colorRGBA8.push_back(255);
+            }
+          } else {
+            color.reserve(3*UL(nFaces));
+            for(i=0;i<nFaces;i++) {
+              color.push_back(F((*rV)[UL(i)]&0xff)/255.0f);
+              color.push_back(F((*gV)[UL(i)]&0xff)/255.0f);
+              color.push_back(F((*bV)[UL(i)]&0xff)/255.0f);
+            }
           }
+          _release(_colorP,rP,gP,bP);
           // APP->log(QString("%1  nColor = %2")
           //          .arg(indent.c_str()).arg(color.size()/3));
         } else {
@@ -438,6 +521,243 @@ IndexedFaceSetPly::~IndexedFaceSetPly() {
   if(_ply) delete _ply;
 }
 
+// static
+void IndexedFaceSetPly::_release
+(Ply::Element::Property** moved,
+ Ply::Element::Property* p0,
+ Ply::Element::Property* p1,
+ Ply::Element::Property* p2) {
+  Ply::Element::Property* p[3] = { p0, p1, p2 };
+  for(int k=0;k<3;k++) {
+    if(p[k]==nullptr) continue;
+    p[k]->clearValue();
+    moved[k] = p[k];
+  }
+}
+
+bool IndexedFaceSetPly::_isMoved(Ply::Element::Property* p) {
+  for(int k=0;k<3;k++)
+    if(p==_coordP[k] || p==_normalP[k] || p==_colorP[k])
+      return true;
+  return (p==_texCoordP[0] || p==_texCoordP[1] || p==_coordIndexP);
+}
+
+bool IndexedFaceSetPly::restorePly() {
+
+  if(_ply==nullptr || _coordP[0]==nullptr) return false;
+
+  int  nV      = _ply->getNumberOfVertices();
+  int  nF      = _ply->getNumberOfFaces();
+  bool wrlMode = _ply->getWrlMode();
+  bool perVertex;
+  int  i,k,n;
+
+  // the IndexedFaceSet must still match the header of the Ply
+
+  if(getNumberOfCoord()!=nV) return false;
+
+  if(_coordIndexP!=nullptr) {
+    if(getNumberOfFaces()!=nF) return false;
+  } else if(getNumberOfFaces()>0) {
+    return false;
+  }
+
+  if(_normalP[0]!=nullptr) {
+    perVertex = (_normalP[0]->element().getName()=="vertex");
+    n         = (perVertex)?nV:nF;
+    if(getNormalPerVertex()!=perVertex || getNormalIndex().size()>0 ||
+       getNormal().size()!=3*UL(n))
+      return false;
+  } else if(getNormal().size()>0) {
+    return false;
+  }
+
+  if(_colorP[0]!=nullptr) {
+    perVertex = (_colorP[0]->element().getName()=="vertex");
+    n         = (perVertex)?nV:nF;
+    if(getColorPerVertex()!=perVertex || getColorIndex().size()>0 ||
+       getNumberOfColor()!=n)
+      return false;
+    // in wrlMode the colors are swapped back as they are stored; RGBA8
+    // colors which have been decoded are encoded again below
+    if(wrlMode && hasCompactColor() &&
+       _colorP[0]->getPropertyType()!=Ply::Element::Property::Type::UINT8_4)
+      return false;
+  } else if(getNumberOfColor()>0) {
+    return false;
+  }
+
+  if(_texCoordP[0]!=nullptr) {
+    if(getTexCoordIndex().size()>0 || getTexCoord().size()!=2*UL(nV))
+      return false;
+  } else if(getTexCoord().size()>0) {
+    return false;
+  }
+
+  if(wrlMode) {
+
+    // swap the arrays back, except for the quantized coordinates,
+    // which are decoded
+
+    vector<float>* coordV =
+      static_cast<vector<float>*>(_coordP[0]->getValue());
+    if(hasCompactCoord()) {
+      coordV->resize(3*UL(nV));
+      for(i=0;i<nV;i++)
+        getCoordValue(i,coordV->data()+3*i);
+    } else {
+      coordV->swap(getCoord());
+    }
+    if(_colorP[0]!=nullptr && hasCompactColor()==false &&
+       _colorP[0]->getPropertyType()==Ply::Element::Property::Type::UINT8_4)
+      compactColor();
+    _swapArrays();
+
+  } else {
+
+    // scatter the components of the interleaved arrays
+
+    float x[3];
+    vector<float>* xV[3];
+
+    for(k=0;k<3;k++) {
+      xV[k] = static_cast<vector<float>*>(_coordP[k]->getValue());
+      xV[k]->resize(UL(nV));
+    }
+    for(i=0;i<nV;i++) {
+      getCoordValue(i,x);
+      for(k=0;k<3;k++)
+        (*xV[k])[UL(i)] = x[k];
+    }
+
+    if(_normalP[0]!=nullptr) {
+      vector<float>& normal = getNormal();
+      n = static_cast<int>(normal.size()/3);
+      for(k=0;k<3;k++) {
+        xV[k] = static_cast<vector<float>*>(_normalP[k]->getValue());
+        xV[k]->resize(UL(n));
+      }
+      for(i=0;i<n;i++)
+        for(k=0;k<3;k++)
+          (*xV[k])[UL(i)] = normal[UL(3*i+k)];
+    }
+
+    if(_colorP[0]!=nullptr) {
+      vector<uchar>* cV[3];
+      n = getNumberOfColor();
+      for(k=0;k<3;k++) {
+        cV[k] = static_cast<vector<uchar>*>(_colorP[k]->getValue());
+        cV[k]->resize(UL(n));
+      }
+      for(i=0;i<n;i++) {
+        getColorValue(i,x);
+        for(k=0;k<3;k++) {
+          float c = (x[k]<0.0f)?0.0f:(x[k]>1.0f)?1.0f:x[k];
+          (*cV[k])[UL(i)] = UC(c*255.0f+0.5f);
+        }
+      }
+    }
+
+    if(_texCoordP[0]!=nullptr) {
+      vector<float>& texCoord = getTexCoord();
+      for(k=0;k<2;k++) {
+        xV[k] = static_cast<vector<float>*>(_texCoordP[k]->getValue());
+        xV[k]->resize(UL(nV));
+      }
+      for(i=0;i<nV;i++)
+        for(k=0;k<2;k++)
+          (*xV[k])[UL(i)] = texCoord[UL(2*i+k)];
+    }
+
+    if(_coordIndexP!=nullptr) {
+      vector<int>& coordIndex = getCoordIndex();
+      vector<int>* indxV = static_cast<vector<int>*>(_coordIndexP->getValue());
+      _coordIndexP->clearValue();
+      indxV->reserve(coordIndex.size()-UL(nF));
+      int i0;
+      for(i0=i=0;i<static_cast<int>(coordIndex.size());i++) {
+        if(coordIndex[UL(i)]<0) {
+          _coordIndexP->pushBackList(i-i0);
+          i0 = i+1;
+        } else {
+          indxV->push_back(coordIndex[UL(i)]);
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+void IndexedFaceSetPly::releasePly() {
+
+  if(_ply==nullptr || _coordP[0]==nullptr) return;
+
+  if(_ply->getWrlMode()) {
+
+    if(hasCompactCoord())
+      _coordP[0]->clearValue();
+    else
+      static_cast<vector<float>*>(_coordP[0]->getValue())->swap(getCoord());
+    _swapArrays();
+
+  } else {
+
+    for(int k=0;k<3;k++) {
+      if(_coordP[k]!=nullptr)    _coordP[k]->clearValue();
+      if(_normalP[k]!=nullptr)   _normalP[k]->clearValue();
+      if(_colorP[k]!=nullptr)    _colorP[k]->clearValue();
+      if(k<2 && _texCoordP[k]!=nullptr) _texCoordP[k]->clearValue();
+    }
+    if(_coordIndexP!=nullptr)    _coordIndexP->clearValue();
+  }
+}
+
+// wrlMode: exchange the normals, colors, texture coordinates, and
+// faces between the Ply and the IndexedFaceSet
+void IndexedFaceSetPly::_swapArrays() {
+  if(_normalP[0]!=nullptr)
+    static_cast<vector<float>*>(_normalP[0]->getValue())->swap(getNormal());
+  if(_colorP[0]!=nullptr) {
+    if(_colorP[0]->getPropertyType()==Ply::Element::Property::Type::UINT8_4)
+      static_cast<vector<uchar>*>(_colorP[0]->getValue())
+        ->swap(getColorRGBA8());
+    else
+      static_cast<vector<float>*>(_colorP[0]->getValue())->swap(getColor());
+  }
+  if(_texCoordP[0]!=nullptr)
+    static_cast<vector<float>*>(_texCoordP[0]->getValue())
+      ->swap(getTexCoord());
+  if(_coordIndexP!=nullptr)
+    static_cast<vector<int>*>(_coordIndexP->getValue())
+      ->swap(getCoordIndex());
+}
+
+void IndexedFaceSetPly::dropUnusedProperties(const string& elementName) {
+
+  if(_ply==nullptr) return;
+
+  const char* name[2] = { "vertex", "face" };
+  for(int e=0;e<2;e++) {
+    if(elementName!="" && elementName!=name[e]) continue;
+    Ply::Element* element = _ply->getElement(name[e]);
+    if(element==nullptr) continue;
+    for(int i=element->getNumberOfProperties()-1;i>=0;i--) {
+      Ply::Element::Property* p = element->getProperty(i);
+      if(_isMoved(p)) continue;
+      // the wrlMode arrays of the Ply may point to the deleted values
+      void* value = p->getValue();
+      if(_ply->_coord==value)      _ply->_coord      = nullptr;
+      if(_ply->_coordIndex==value) _ply->_coordIndex = nullptr;
+      if(_ply->_normal==value)     _ply->_normal     = nullptr;
+      if(_ply->_color==value)      _ply->_color      = nullptr;
+      if(_ply->_colorRGBA8==value) _ply->_colorRGBA8 = nullptr;
+      if(_ply->_texCoord==value)   _ply->_texCoord   = nullptr;
+      element->deleteProperty(i);
+    }
+  }
+}
+
 // void IndexedFaceSetPly::printInfo(string indent) {
 //   // TODO
 //   IndexedFaceSet::printInfo(indent);
@@ -53,6 +53,21 @@ protected:
 
   Ply* _ply;
 
+  // the properties of the Ply moved into the arrays of the
+  // IndexedFaceSet, one per component, or a single one in wrlMode
+  Ply::Element::Property* _coordP[3];
+  Ply::Element::Property* _normalP[3];
+  Ply::Element::Property* _colorP[3];
+  Ply::Element::Property* _texCoordP[2];
+  Ply::Element::Property* _coordIndexP;
+
+  static  void    _release(Ply::Element::Property** moved,
+                           Ply::Element::Property* p0,
+                           Ply::Element::Property* p1=nullptr,
+                           Ply::Element::Property* p2=nullptr);
+          bool    _isMoved(Ply::Element::Property* p);
+          void    _swapArrays();
+
 public:
   
   IndexedFaceSetPly(Ply * ply = nullptr, const string indent="");
@@ -60,6 +75,20 @@ public:
 
           Ply*    getPly()                    { return _ply; }
 
+  // the constructor moves the coordinates, normals, colors, texture
+  // coordinates, and faces out of the Ply, which only keeps the header
+  // and the properties not used by the IndexedFaceSet; restorePly()
+  // fills the moved properties back from the IndexedFaceSet, so that
+  // the Ply can be saved, and releasePly() empties them again;
+  // restorePly() returns false, and does not change the Ply, if the
+  // IndexedFaceSet no longer matches the header of the Ply
+          bool    restorePly();
+          void    releasePly();
+
+  // delete the vertex and face properties of the Ply not used by the
+  // IndexedFaceSet, or only those of the named element
+          void    dropUnusedProperties(const string& elementName="");
+
   virtual string  getType()             const { return "IndexedFaceSetPly"; }
   typedef bool    (*Property)(IndexedFaceSetPly& ifsPly);
   typedef void    (*Operator)(IndexedFaceSetPly& ifsPly);
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-12 09:41:27 taubin>
+//------------------------------------------------------------------------
+//
+// Inline.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include "Inline.hpp"
+  
+Inline::Inline():
+  _path(""),
+  _content() {
+}
+
+Inline::~Inline() {
+  // the content is deleted by the shared_ptr, not by ~Group()
+  setContent(shared_ptr<Group>());
+}
+
+vector<string>& Inline::getUrl() {
+  return _url;
+}
+
+const string& Inline::getPath() const {
+  return _path;
+}
+
+void Inline::setPath(const string& path) {
+  _path = path;
+}
+
+shared_ptr<Group> Inline::getContent() const {
+  return _content;
+}
+
+void Inline::setContent(shared_ptr<Group> content) {
+  // the first Inline node referencing the content becomes its parent;
+  // if that Inline node goes away, the content becomes its own parent,
+  // as a SceneGraph, so that getDepth() still terminates
+  if(_content && _content->getParent()==this)
+    _content->setParent(_content.get());
+  _children.clear();
+  _content = content;
+  if(_content) {
+    const Node* parent = _content->getParent();
+    if(parent==(Node*)0 || parent==_content.get())
+      _content->setParent(this);
+    _children.push_back(_content.get());
+  }
+  structureChanged();
+}
+
+void Inline::printInfo(string indent) {
+  std::cout << indent;
+  if(_name!="") std::cout << "DEF " << _name << " ";
+  std::cout << "Inline {\n";
+  std::cout << indent << "  " << "url [\n";
+  for(int i=0;i<(int)_url.size();i++)
+    std::cout << indent << "    " << _url[i] << "\n";
+  std::cout << indent << "  " << "]\n";
+  std::cout << indent << "}\n";
+}
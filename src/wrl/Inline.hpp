@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-12 09:41:27 taubin>
+//------------------------------------------------------------------------
+//
+// Inline.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _Inline_h_
+#define _Inline_h_
+
+// Inline {
+//   exposedField MFString url        []
+//   field        SFVec3f  bboxCenter  0  0  0
+//   field        SFVec3f  bboxSize   -1 -1 -1
+// }
+//
+// The nodes loaded from the url are the children of a Group, which is
+// the only child of the Inline node. Several Inline nodes referencing
+// the same file share the same Group, which is deleted together with
+// the last Inline node referencing it. The path of the file the content
+// was loaded from is recorded by the loader, and is empty if none of
+// the urls names an existing file.
+
+#include <memory>
+#include "Group.hpp"
+
+using namespace std;
+
+class Inline : public Group {
+
+private:
+
+  vector<string>    _url;
+  string            _path;
+  shared_ptr<Group> _content;
+
+public:
+  
+  Inline();
+  virtual ~Inline();
+
+  vector<string>&       getUrl();
+  const string&         getPath() const;
+  void                  setPath(const string& path);
+  shared_ptr<Group>     getContent() const;
+  void                  setContent(shared_ptr<Group> content);
+
+  virtual bool          isInline() const { return     true; };
+  virtual string        getType()  const { return "Inline"; };
+  typedef bool          (*Property)(Inline& inl);
+  typedef void          (*Operator)(Inline& inl);
+
+  virtual void    printInfo(string indent);
+};
+
+#endif /* _Inline_h_ */
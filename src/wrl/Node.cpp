@@ -34,6 +34,7 @@
 
 #include <math.h>
 #include <iostream>
+#include <atomic>
 #include "Node.hpp"
 
 // Color ////////////////////////////////////////////////////////////////////
@@ -157,10 +158,15 @@ void Vec4f::normalize() {
 
 // Node ////////////////////////////////////////////////////////////////////
   
+// the loaders build several scene graphs concurrently
+static std::atomic<unsigned> _structureVersion(0);
+static std::atomic<unsigned> _transformVersion(0);
+
 Node::Node():
   _name(""),
   _parent((Node*)0),
-  _show(true) {
+  _show(true),
+  _nReferences(0) {
 }
 
 Node::~Node() {
@@ -172,6 +178,7 @@ const string& Node::getName() const {
 
 void Node::setName(const string& name) {
   _name = name;
+  structureChanged();
 }
 
 bool Node::nameEquals(const string& name) {
@@ -187,11 +194,40 @@ void Node::setParent(const Node* node) {
   _parent = node;
 }
 
+void Node::addReference() {
+  _nReferences++;
+}
+
+int Node::removeReference() {
+  return (_nReferences>0)?(--_nReferences):0;
+}
+
+// static
+unsigned Node::getStructureVersion() {
+  return _structureVersion.load();
+}
+
+// static
+unsigned Node::getTransformVersion() {
+  return _transformVersion.load();
+}
+
+// static
+void Node::structureChanged() {
+  _structureVersion++;
+}
+
+// static
+void Node::transformChanged() {
+  _transformVersion++;
+}
+
 bool Node::getShow() const {
   return _show;
 }
 
 void Node::setShow(const bool value) {
+  if(_show!=value) structureChanged();
   _show = value;
 }
 
@@ -212,6 +248,7 @@ bool    Node::isGroup() const          { return  false; }
 bool    Node::isImageTexture() const   { return  false; }
 bool    Node::isIndexedFaceSet() const { return  false; }
 bool    Node::isIndexedLineSet() const { return  false; }
+bool    Node::isInline() const         { return  false; }
 bool    Node::isMaterial() const       { return  false; }
 bool    Node::isPixelTexture() const   { return  false; }
 bool    Node::isSceneGraph() const     { return  false; }
@@ -93,6 +93,7 @@ protected:
   string      _name;
   const Node* _parent;
   bool        _show;
+  int         _nReferences; // number of groups having the node as child
 
 public:
   
@@ -108,11 +109,26 @@ public:
   void            setShow(const bool value);
   int             getDepth() const; 
 
+  // a node may be a child of several groups (VRML USE); it is deleted
+  // when removeReference() returns 0
+  void            addReference();
+  int             removeReference();
+
+  // version numbers incremented by every change of the structure of
+  // the scene graphs (children, nodes held in fields, names and show
+  // flags) and of the Transform fields; cached data, such as the
+  // SceneGraphIndex, are rebuilt when they change
+  static unsigned getStructureVersion();
+  static unsigned getTransformVersion();
+  static void     structureChanged();
+  static void     transformChanged();
+
   virtual bool    isAppearance() const;
   virtual bool    isGroup() const;
   virtual bool    isImageTexture() const;
   virtual bool    isIndexedFaceSet() const;
   virtual bool    isIndexedLineSet() const;
+  virtual bool    isInline() const;
   virtual bool    isMaterial() const;
   virtual bool    isPixelTexture() const;
   virtual bool    isSceneGraph() const;
@@ -0,0 +1,732 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-02 16:20:41 taubin>
+//------------------------------------------------------------------------
+//
+// OutOfCoreProcessor.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include "OutOfCoreProcessor.hpp"
+#include "SceneGraphProcessor.hpp"
+#include "Shape.hpp"
+#include "IndexedFaceSet.hpp"
+#include <core/Partition.hpp>
+#include <io/LoaderPly.hpp>
+#include <io/SaverPly.hpp>
+#include <io/StrException.hpp>
+
+// the face records are appended to the chunk files when the total
+// number of buffered values reaches this value
+static const size_t OOC_FLUSH_SIZE = (1<<22);
+// size of the stdio buffers used for the scratch files
+static const size_t OOC_IO_BUFFER  = (1<<20);
+
+static const unsigned short OOC_NO_CHUNK = (unsigned short)(-1);
+
+ostream* OutOfCoreProcessor::_ostrm  = nullptr;
+string   OutOfCoreProcessor::_indent = "";
+
+void OutOfCoreProcessor::setOstream(ostream* ostrm) {
+  _ostrm = ostrm;
+}
+
+void OutOfCoreProcessor::setIndent(const string s) {
+  _indent = s;
+}
+
+OutOfCoreProcessor::OutOfCoreProcessor():
+  _plyFilename(""),
+  _prefix(""),
+  _nChunksPerAxis(0),
+  _nVertices(0),
+  _nFaces(0),
+  _nHaloFaces(0),
+  _maxChunkFaces(0),
+  _nEdges(0),
+  _nBoundaryEdges(0),
+  _nSingularEdges(0),
+  _nBoundaryVertices(0),
+  _nSingularVertices(0),
+  _processed(false),
+  _vertexChunk(),
+  _chunkFaces() {
+}
+
+OutOfCoreProcessor::~OutOfCoreProcessor() {
+  clear();
+}
+
+int OutOfCoreProcessor::getNumberOfChunks() const {
+  return _nChunksPerAxis*_nChunksPerAxis*_nChunksPerAxis;
+}
+
+int OutOfCoreProcessor::getNumberOfVertices() const {
+  return _nVertices;
+}
+
+int OutOfCoreProcessor::getNumberOfFaces() const {
+  return _nFaces;
+}
+
+int OutOfCoreProcessor::getNumberOfHaloFaces() const {
+  return _nHaloFaces;
+}
+
+int OutOfCoreProcessor::getMaxChunkFaces() const {
+  return _maxChunkFaces;
+}
+
+int OutOfCoreProcessor::getNumberOfEdges() const {
+  return _nEdges;
+}
+
+int OutOfCoreProcessor::getNumberOfBoundaryEdges() const {
+  return _nBoundaryEdges;
+}
+
+int OutOfCoreProcessor::getNumberOfSingularEdges() const {
+  return _nSingularEdges;
+}
+
+int OutOfCoreProcessor::getNumberOfBoundaryVertices() const {
+  return _nBoundaryVertices;
+}
+
+int OutOfCoreProcessor::getNumberOfSingularVertices() const {
+  return _nSingularVertices;
+}
+
+string OutOfCoreProcessor::_coordFilename() const {
+  return _prefix+".coord";
+}
+
+string OutOfCoreProcessor::_normalFilename() const {
+  return _prefix+".normal";
+}
+
+string OutOfCoreProcessor::_chunkFilename(const int iChunk) const {
+  char str[32];
+  snprintf(str,sizeof(str),".%05d",iChunk);
+  return _prefix+str;
+}
+
+void OutOfCoreProcessor::clear() {
+  if(_prefix!="") {
+    remove(_coordFilename().c_str());
+    remove(_normalFilename().c_str());
+    for(int iChunk=0;iChunk<(int)_chunkFaces.size();iChunk++)
+      if(_chunkFaces[iChunk]>0)
+        remove(_chunkFilename(iChunk).c_str());
+  }
+  _plyFilename       = "";
+  _prefix            = "";
+  _nChunksPerAxis    = 0;
+  _nVertices         = 0;
+  _nFaces            = 0;
+  _nHaloFaces        = 0;
+  _maxChunkFaces     = 0;
+  _nEdges            = 0;
+  _nBoundaryEdges    = 0;
+  _nSingularEdges    = 0;
+  _nBoundaryVertices = 0;
+  _nSingularVertices = 0;
+  _processed         = false;
+  _vertexChunk.clear();
+  _vertexChunk.shrink_to_fit();
+  _chunkFaces.clear();
+}
+
+// static
+bool OutOfCoreProcessor::_seek(FILE* fp, const int64_t offset) {
+#ifdef _WIN32
+  return _fseeki64(fp,offset,SEEK_SET)==0;
+#else
+  return fseeko(fp,(off_t)offset,SEEK_SET)==0;
+#endif
+}
+
+// reads the records index[0],index[1],... of a file of fixed size
+// records; the indices must be sorted in increasing order, so that
+// consecutive records are read with a single call
+// static
+bool OutOfCoreProcessor::_readRecords
+(FILE* fp, const vector<int>& index, const int recordSize, char* data) {
+  size_t i0,i1,n = index.size();
+  for(i0=0;i0<n;i0=i1) {
+    for(i1=i0+1;i1<n && index[i1]==index[i1-1]+1;i1++);
+    if(_seek(fp,(int64_t)index[i0]*recordSize)==false) return false;
+    size_t nBytes = (i1-i0)*recordSize;
+    if(fread(data+i0*recordSize,1,nBytes,fp)!=nBytes) return false;
+  }
+  return true;
+}
+
+// static
+bool OutOfCoreProcessor::_writeRecords
+(FILE* fp, const vector<int>& index, const int recordSize, const char* data) {
+  size_t i0,i1,n = index.size();
+  for(i0=0;i0<n;i0=i1) {
+    for(i1=i0+1;i1<n && index[i1]==index[i1-1]+1;i1++);
+    if(_seek(fp,(int64_t)index[i0]*recordSize)==false) return false;
+    size_t nBytes = (i1-i0)*recordSize;
+    if(fwrite(data+i0*recordSize,1,nBytes,fp)!=nBytes) return false;
+  }
+  return true;
+}
+
+bool OutOfCoreProcessor::_flushChunks(vector< vector<int> >& buffer) {
+  for(int iChunk=0;iChunk<(int)buffer.size();iChunk++) {
+    vector<int>& b = buffer[iChunk];
+    if(b.size()==0) continue;
+    FILE* fp = fopen(_chunkFilename(iChunk).c_str(),"ab");
+    if(fp==nullptr) return false;
+    size_t n = fwrite(&b[0],sizeof(int),b.size(),fp);
+    bool success = (fclose(fp)==0 && n==b.size());
+    if(success==false) return false;
+    b.clear();
+  }
+  return true;
+}
+
+bool OutOfCoreProcessor::partition
+(const char* plyFilename, const char* prefix, const int nChunksPerAxis) {
+
+  clear();
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "OutOfCoreProcessor::partition() {" << endl;
+  }
+
+  bool success = false;
+  FILE* fp = nullptr;
+
+  // the records are streamed using the raw ply properties
+  bool wrlMode = Ply::getDefaultWrlMode();
+  Ply::setDefaultWrlMode(false);
+  Ply ply;
+  Ply::setDefaultWrlMode(wrlMode);
+
+  LoaderPly::RecordReader reader;
+  vector<double>          record;
+
+  try {
+
+    if(plyFilename==nullptr || prefix==nullptr || prefix[0]=='\0')
+      throw new StrException("no input file or scratch file prefix");
+    if(nChunksPerAxis<1 || nChunksPerAxis>MAX_CHUNKS_PER_AXIS)
+      throw new StrException("number of chunks per axis out of range");
+
+    _plyFilename    = plyFilename;
+    _prefix         = prefix;
+    _nChunksPerAxis = nChunksPerAxis;
+    const int N     = nChunksPerAxis;
+    const int nChunks = getNumberOfChunks();
+
+    // the face records are appended to the chunk files
+    for(int iChunk=0;iChunk<nChunks;iChunk++)
+      remove(_chunkFilename(iChunk).c_str());
+    _chunkFaces.insert(_chunkFaces.end(),nChunks,0);
+
+    reader.open(plyFilename,ply);
+
+    Ply::Element* vertex = ply.getElement("vertex");
+    Ply::Element* face   = ply.getElement("face");
+    if(vertex==nullptr || face==nullptr)
+      throw new StrException("no vertex or face element");
+
+    bool vertexDone = false;
+    int nElements = ply.getNumberOfElements();
+    for(int iElement=0;iElement<nElements;iElement++) {
+      Ply::Element* element = ply.getElement(iElement);
+      int nRecords = element->getNumberOfRecords();
+      int nProperties = element->getNumberOfProperties();
+      int iRecord,iProperty;
+
+      if(element==vertex) {
+
+        // pass over the vertices: bounding box and coord scratch file
+        _nVertices = nRecords;
+        float bMin[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+        float bMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        float x[3];
+        fp = fopen(_coordFilename().c_str(),"wb");
+        if(fp==nullptr) throw new StrException("unable to create coord file");
+        setvbuf(fp,nullptr,_IOFBF,OOC_IO_BUFFER);
+        for(iRecord=0;iRecord<nRecords;iRecord++) {
+          reader.read(*element,record);
+          x[0] = x[1] = x[2] = 0.0f;
+          size_t j = 0;
+          for(iProperty=0;iProperty<nProperties;iProperty++) {
+            Ply::Element::Property* property = element->getProperty(iProperty);
+            const string& name = property->getName();
+            if(property->isList()) {
+              j += 1+(size_t)record[j];
+            } else {
+              if(name=="x")      x[0] = (float)record[j];
+              else if(name=="y") x[1] = (float)record[j];
+              else if(name=="z") x[2] = (float)record[j];
+              j++;
+            }
+          }
+          for(int k=0;k<3;k++) {
+            if(x[k]<bMin[k]) bMin[k] = x[k];
+            if(x[k]>bMax[k]) bMax[k] = x[k];
+          }
+          if(fwrite(x,sizeof(float),3,fp)!=3)
+            throw new StrException("unable to write coord file");
+        }
+        if(fclose(fp)!=0) { fp = nullptr;
+          throw new StrException("unable to write coord file"); }
+        fp = nullptr;
+
+        // assign the vertices to the cells of the grid
+        _vertexChunk.insert(_vertexChunk.end(),_nVertices,OOC_NO_CHUNK);
+        fp = fopen(_coordFilename().c_str(),"rb");
+        if(fp==nullptr) throw new StrException("unable to read coord file");
+        setvbuf(fp,nullptr,_IOFBF,OOC_IO_BUFFER);
+        for(int iV=0;iV<_nVertices;iV++) {
+          if(fread(x,sizeof(float),3,fp)!=3)
+            throw new StrException("unable to read coord file");
+          int c[3];
+          for(int k=0;k<3;k++) {
+            float d = bMax[k]-bMin[k];
+            c[k] = (d>0.0f)?(int)floor(N*(x[k]-bMin[k])/d):0;
+            if(c[k]<0) c[k] = 0; else if(c[k]>=N) c[k] = N-1;
+          }
+          _vertexChunk[iV] = (unsigned short)(c[0]+N*(c[1]+N*c[2]));
+        }
+        fclose(fp);
+        fp = nullptr;
+        vertexDone = true;
+
+      } else if(element==face) {
+
+        if(vertexDone==false)
+          throw new StrException("face element found before vertex element");
+        int iList = -1;
+        for(iProperty=0;iProperty<nProperties;iProperty++) {
+          Ply::Element::Property* property = element->getProperty(iProperty);
+          if(property->isList() &&
+             (property->getName()=="vertex_indices" ||
+              property->getName()=="vertex_index"))
+            iList = iProperty;
+        }
+        if(iList<0) throw new StrException("no vertex_indices property");
+
+        // pass over the faces: each face is appended to the chunks
+        // which own at least one of its vertices
+        _nFaces = nRecords;
+        vector< vector<int> > buffer(nChunks);
+        vector<int> faceChunk;
+        size_t nBuffered = 0;
+        for(iRecord=0;iRecord<nRecords;iRecord++) {
+          reader.read(*element,record);
+          size_t j = 0;
+          for(iProperty=0;iProperty<iList;iProperty++)
+            j += (element->getProperty(iProperty)->isList())?
+              1+(size_t)record[j]:1;
+          int nCorners = (int)record[j++];
+          faceChunk.clear();
+          for(int i=0;i<nCorners;i++) {
+            int iV = (int)record[j+i];
+            if(iV<0 || iV>=_nVertices)
+              throw new StrException("vertex index out of range");
+            int iChunk = _vertexChunk[iV];
+            if(find(faceChunk.begin(),faceChunk.end(),iChunk)==faceChunk.end())
+              faceChunk.push_back(iChunk);
+          }
+          if(faceChunk.size()>1) _nHaloFaces++;
+          for(size_t k=0;k<faceChunk.size();k++) {
+            vector<int>& b = buffer[faceChunk[k]];
+            b.push_back(nCorners);
+            for(int i=0;i<nCorners;i++)
+              b.push_back((int)record[j+i]);
+            _chunkFaces[faceChunk[k]]++;
+            nBuffered += 1+nCorners;
+          }
+          if(nBuffered>=OOC_FLUSH_SIZE) {
+            if(_flushChunks(buffer)==false)
+              throw new StrException("unable to write chunk file");
+            nBuffered = 0;
+          }
+        }
+        if(_flushChunks(buffer)==false)
+          throw new StrException("unable to write chunk file");
+
+      } else {
+
+        for(iRecord=0;iRecord<nRecords;iRecord++)
+          reader.read(*element,record);
+
+      }
+    }
+
+    reader.close();
+
+    for(int iChunk=0;iChunk<nChunks;iChunk++)
+      if(_chunkFaces[iChunk]>_maxChunkFaces)
+        _maxChunkFaces = _chunkFaces[iChunk];
+
+    if(_ostrm!=nullptr) {
+      *_ostrm << _indent << "  nVertices     = " << _nVertices     << endl;
+      *_ostrm << _indent << "  nFaces        = " << _nFaces        << endl;
+      *_ostrm << _indent << "  nChunks       = " << nChunks        << endl;
+      *_ostrm << _indent << "  nHaloFaces    = " << _nHaloFaces    << endl;
+      *_ostrm << _indent << "  maxChunkFaces = " << _maxChunkFaces << endl;
+    }
+
+    success = true;
+
+  } catch(StrException* e) {
+    if(fp!=nullptr) fclose(fp);
+    if(_ostrm!=nullptr) {
+      *_ostrm << _indent << "  " << e->what() << endl;
+    }
+    delete e;
+    clear();
+  }
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "} OutOfCoreProcessor::partition()" << endl;
+  }
+
+  return success;
+}
+
+void OutOfCoreProcessor::_processChunk
+(const int iChunk, FILE* coordFp, FILE* normalFp) {
+
+  // load the face records of the chunk
+  vector<int> chunkData;
+  FILE* fp = fopen(_chunkFilename(iChunk).c_str(),"rb");
+  if(fp==nullptr) throw new StrException("unable to open chunk file");
+  int value;
+  setvbuf(fp,nullptr,_IOFBF,OOC_IO_BUFFER);
+  while(fread(&value,sizeof(int),1,fp)==1)
+    chunkData.push_back(value);
+  fclose(fp);
+
+  // global vertex indices used by the chunk, in increasing order; the
+  // local vertex indices preserve the global order
+  vector<int> vertexIndex;
+  size_t i,j,n = chunkData.size();
+  for(j=0;j<n;j+=1+chunkData[j])
+    for(i=1;i<=(size_t)chunkData[j];i++)
+      vertexIndex.push_back(chunkData[j+i]);
+  sort(vertexIndex.begin(),vertexIndex.end());
+  vertexIndex.erase(unique(vertexIndex.begin(),vertexIndex.end()),
+                    vertexIndex.end());
+  int nV = (int)vertexIndex.size();
+
+  SceneGraph wrl;
+  Shape* shape = new Shape();
+  IndexedFaceSet* ifs = new IndexedFaceSet();
+  shape->setGeometry(ifs);
+  wrl.addChild(shape);
+
+  vector<float>& coord      = ifs->getCoord();
+  vector<int>&   coordIndex = ifs->getCoordIndex();
+  coord.insert(coord.end(),3*nV,0.0f);
+  if(nV>0 && _readRecords(coordFp,vertexIndex,3*sizeof(float),
+                          (char*)&coord[0])==false)
+    throw new StrException("unable to read coord file");
+  for(j=0;j<n;j+=1+chunkData[j]) {
+    for(i=1;i<=(size_t)chunkData[j];i++)
+      coordIndex.push_back
+        ((int)(lower_bound(vertexIndex.begin(),vertexIndex.end(),
+                           chunkData[j+i])-vertexIndex.begin()));
+    coordIndex.push_back(-1);
+  }
+  chunkData.clear();
+  chunkData.shrink_to_fit();
+
+  // normals, using the same code as the in-core processor, and
+  // written only for the vertices owned by the chunk
+  SceneGraphProcessor processor(wrl);
+  processor.computeNormalPerVertex();
+  vector<float>& normal = ifs->getNormal();
+  vector<int>    ownedIndex;
+  vector<float>  ownedNormal;
+  int iV;
+  for(iV=0;iV<nV;iV++) {
+    if(_vertexChunk[vertexIndex[iV]]!=iChunk) continue;
+    ownedIndex.push_back(vertexIndex[iV]);
+    ownedNormal.push_back(normal[3*iV  ]);
+    ownedNormal.push_back(normal[3*iV+1]);
+    ownedNormal.push_back(normal[3*iV+2]);
+  }
+  if(ownedIndex.size()>0 &&
+     _writeRecords(normalFp,ownedIndex,3*sizeof(float),
+                   (const char*)&ownedNormal[0])==false)
+    throw new StrException("unable to write normal file");
+
+  // half edges sorted by edge; the key is (min vertex,max vertex)
+  int nC = (int)coordIndex.size();
+  vector<int> next(nC,-1);
+  vector< pair<uint64_t,int> > halfEdge;
+  int iC,iC0,iC1;
+  for(iC0=iC1=0;iC1<nC;iC1++) {
+    if(coordIndex[iC1]>=0) continue;
+    for(iC=iC0;iC<iC1;iC++) {
+      next[iC] = (iC+1<iC1)?iC+1:iC0;
+      uint64_t v0 = (uint64_t)coordIndex[iC];
+      uint64_t v1 = (uint64_t)coordIndex[next[iC]];
+      if(v0==v1) continue;
+      uint64_t key = (v0<v1)?((v0<<32)|v1):((v1<<32)|v0);
+      halfEdge.push_back(pair<uint64_t,int>(key,iC));
+    }
+    iC0 = iC1+1;
+  }
+  sort(halfEdge.begin(),halfEdge.end());
+
+  // as in PolygonMesh, the corners which are opposite to each other
+  // across regular edges are joined; the vertices with more than one
+  // part of corners are singular
+  Partition partition(nC);
+  vector<bool> isBoundary(nV,false);
+  size_t h0,h1,nH = halfEdge.size();
+  for(h0=0;h0<nH;h0=h1) {
+    for(h1=h0+1;h1<nH && halfEdge[h1].first==halfEdge[h0].first;h1++);
+    int iV0 = (int)(halfEdge[h0].first>>32);
+    int iV1 = (int)(halfEdge[h0].first&0xffffffff);
+    int nEdgeFaces = (int)(h1-h0);
+    if(_vertexChunk[vertexIndex[iV0]]==iChunk) {
+      _nEdges++;
+      if(nEdgeFaces==1) _nBoundaryEdges++;
+      if(nEdgeFaces>2)  _nSingularEdges++;
+    }
+    if(nEdgeFaces==1) {
+      isBoundary[iV0] = isBoundary[iV1] = true;
+    } else if(nEdgeFaces==2) {
+      int iCa = halfEdge[h0].second;
+      int iCb = halfEdge[h0+1].second;
+      if(coordIndex[iCa]==coordIndex[iCb]) {
+        // inconsistently oriented faces
+        partition.join(iCa,iCb);
+        partition.join(next[iCa],next[iCb]);
+      } else {
+        partition.join(iCa,next[iCb]);
+        partition.join(iCb,next[iCa]);
+      }
+    }
+  }
+  vector<int> nParts(nV,0);
+  for(iC=0;iC<nC;iC++)
+    if(coordIndex[iC]>=0 && partition.find(iC)==iC)
+      nParts[coordIndex[iC]]++;
+  for(iV=0;iV<nV;iV++) {
+    if(_vertexChunk[vertexIndex[iV]]!=iChunk) continue;
+    if(isBoundary[iV]) _nBoundaryVertices++;
+    if(nParts[iV]>1)   _nSingularVertices++;
+  }
+}
+
+bool OutOfCoreProcessor::process() {
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "OutOfCoreProcessor::process() {" << endl;
+  }
+
+  bool success = false;
+  FILE* coordFp  = nullptr;
+  FILE* normalFp = nullptr;
+
+  _processed         = false;
+  _nEdges            = 0;
+  _nBoundaryEdges    = 0;
+  _nSingularEdges    = 0;
+  _nBoundaryVertices = 0;
+  _nSingularVertices = 0;
+
+  try {
+
+    if(_prefix=="") throw new StrException("no partition");
+
+    // isolated vertices keep zero normals
+    normalFp = fopen(_normalFilename().c_str(),"wb");
+    if(normalFp==nullptr) throw new StrException("unable to create normal file");
+    setvbuf(normalFp,nullptr,_IOFBF,OOC_IO_BUFFER);
+    vector<float> zero(3*1024,0.0f);
+    for(int iV=0;iV<_nVertices;iV+=1024) {
+      size_t nv = (size_t)min(1024,_nVertices-iV);
+      if(fwrite(&zero[0],3*sizeof(float),nv,normalFp)!=nv)
+        throw new StrException("unable to write normal file");
+    }
+    if(fclose(normalFp)!=0) { normalFp = nullptr;
+      throw new StrException("unable to write normal file"); }
+
+    coordFp  = fopen(_coordFilename().c_str(),"rb");
+    normalFp = fopen(_normalFilename().c_str(),"r+b");
+    if(coordFp==nullptr || normalFp==nullptr)
+      throw new StrException("unable to open scratch files");
+
+    for(int iChunk=0;iChunk<(int)_chunkFaces.size();iChunk++)
+      if(_chunkFaces[iChunk]>0)
+        _processChunk(iChunk,coordFp,normalFp);
+
+    fclose(coordFp);
+    coordFp = nullptr;
+    int failed = fclose(normalFp);
+    normalFp = nullptr;
+    if(failed!=0) throw new StrException("unable to write normal file");
+
+    if(_ostrm!=nullptr) {
+      *_ostrm << _indent << "  nEdges            = " << _nEdges            << endl;
+      *_ostrm << _indent << "  nBoundaryEdges    = " << _nBoundaryEdges    << endl;
+      *_ostrm << _indent << "  nSingularEdges    = " << _nSingularEdges    << endl;
+      *_ostrm << _indent << "  nBoundaryVertices = " << _nBoundaryVertices << endl;
+      *_ostrm << _indent << "  nSingularVertices = " << _nSingularVertices << endl;
+    }
+
+    _processed = true;
+    success = true;
+
+  } catch(StrException* e) {
+    if(coordFp!=nullptr)  fclose(coordFp);
+    if(normalFp!=nullptr) fclose(normalFp);
+    if(_ostrm!=nullptr) {
+      *_ostrm << _indent << "  " << e->what() << endl;
+    }
+    delete e;
+  }
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "} OutOfCoreProcessor::process()" << endl;
+  }
+
+  return success;
+}
+
+bool OutOfCoreProcessor::save
+(const char* plyFilename, const Ply::DataType dataType) {
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "OutOfCoreProcessor::save() {" << endl;
+  }
+
+  bool success = false;
+  FILE* normalFp = nullptr;
+
+  // the input header is read twice; the normal properties are added
+  // to the output header only
+  bool wrlMode = Ply::getDefaultWrlMode();
+  Ply::setDefaultWrlMode(false);
+  Ply plyIn;
+  Ply plyOut;
+  Ply::setDefaultWrlMode(wrlMode);
+
+  LoaderPly::RecordReader reader;
+  LoaderPly::RecordReader header;
+  SaverPly::RecordWriter  writer;
+  vector<double>          record;
+
+  try {
+
+    if(_processed==false) throw new StrException("not processed");
+
+    reader.open(_plyFilename.c_str(),plyIn);
+    header.open(_plyFilename.c_str(),plyOut);
+    header.close();
+
+    Ply::Element* vertexOut = plyOut.getElement("vertex");
+    if(vertexOut->hasProperty("nx")==false) {
+      vertexOut->addProperty("nx",Ply::Element::Property::Type::FLOAT);
+      vertexOut->addProperty("ny",Ply::Element::Property::Type::FLOAT);
+      vertexOut->addProperty("nz",Ply::Element::Property::Type::FLOAT);
+    }
+
+    writer.open(plyFilename,plyOut,dataType);
+
+    normalFp = fopen(_normalFilename().c_str(),"rb");
+    if(normalFp==nullptr) throw new StrException("unable to open normal file");
+    setvbuf(normalFp,nullptr,_IOFBF,OOC_IO_BUFFER);
+
+    int nElements = plyIn.getNumberOfElements();
+    for(int iElement=0;iElement<nElements;iElement++) {
+      Ply::Element* element    = plyIn.getElement(iElement);
+      Ply::Element* elementOut = plyOut.getElement(iElement);
+      int nRecords    = element->getNumberOfRecords();
+      int nProperties = element->getNumberOfProperties();
+      bool isVertex   = (element->getName()=="vertex");
+      float n[3];
+      for(int iRecord=0;iRecord<nRecords;iRecord++) {
+        reader.read(*element,record);
+        if(isVertex) {
+          if(fread(n,sizeof(float),3,normalFp)!=3)
+            throw new StrException("unable to read normal file");
+          if(nProperties==elementOut->getNumberOfProperties()) {
+            // replace the normals found in the input file
+            size_t j = 0;
+            for(int iProperty=0;iProperty<nProperties;iProperty++) {
+              Ply::Element::Property* property = element->getProperty(iProperty);
+              const string& name = property->getName();
+              if(property->isList()) {
+                j += 1+(size_t)record[j];
+              } else {
+                if(name=="nx")      record[j] = n[0];
+                else if(name=="ny") record[j] = n[1];
+                else if(name=="nz") record[j] = n[2];
+                j++;
+              }
+            }
+          } else {
+            record.push_back(n[0]);
+            record.push_back(n[1]);
+            record.push_back(n[2]);
+          }
+        }
+        writer.write(*elementOut,record);
+      }
+    }
+
+    reader.close();
+    fclose(normalFp);
+    normalFp = nullptr;
+    if(writer.close()==false)
+      throw new StrException("unable to flush output file");
+    success = true;
+
+  } catch(StrException* e) {
+    if(normalFp!=nullptr) fclose(normalFp);
+    if(_ostrm!=nullptr) {
+      *_ostrm << _indent << "  " << e->what() << endl;
+    }
+    delete e;
+  }
+
+  if(_ostrm!=nullptr) {
+    *_ostrm << _indent << "} OutOfCoreProcessor::save()" << endl;
+  }
+
+  return success;
+}
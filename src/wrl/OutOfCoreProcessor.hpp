@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-02 16:20:41 taubin>
+//------------------------------------------------------------------------
+//
+// OutOfCoreProcessor.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _OutOfCoreProcessor_hpp_
+#define _OutOfCoreProcessor_hpp_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Ply.hpp"
+
+using namespace std;
+
+// Out-of-core processing of polygon meshes stored in ply files which
+// are too large to be loaded as a SceneGraph
+//
+// - partition() streams the ply file once; the vertices are assigned
+//   to the cells of a regular grid of N*N*N chunks defined over the
+//   bounding box, and each face is appended to the chunk files of all
+//   the chunks which own at least one of its vertices; faces written
+//   to more than one chunk are the halo faces which cover the seams
+// - since every face incident to a vertex is found in the chunk
+//   which owns the vertex, the normal per vertex and the
+//   boundary/singular classification of the owned vertices, and of
+//   the edges owned by the chunk of their lowest vertex index, are
+//   identical to the results obtained processing the whole mesh
+// - process() loads one chunk at a time, and stitches the results
+//   into a normal file indexed by global vertex index
+// - save() streams the input file again and writes the normals as
+//   the nx,ny,nz vertex properties
+//
+// only one chunk, and two bytes per vertex of bookkeeping, are kept
+// in memory at any time; the scratch files are named after the
+// prefix passed to partition(), and are deleted by clear()
+//
+// OutOfCoreProcessor ooc;
+// if(ooc.partition("large.ply","/scratch/large",8) &&
+//    ooc.process() && ooc.save("large_normals.ply",dataType)) {
+//   // ooc.getNumberOfBoundaryEdges(), ...
+// }
+// ooc.clear();
+
+class OutOfCoreProcessor {
+
+public:
+
+  // chunk file format: a sequence of face records, each one composed
+  // of the number of face corners followed by the global vertex
+  // indices, all stored as native endian int32 values
+
+  OutOfCoreProcessor();
+  ~OutOfCoreProcessor();
+
+  // 1<=nChunksPerAxis<=MAX_CHUNKS_PER_AXIS
+  bool    partition(const char* plyFilename, const char* prefix,
+                    const int nChunksPerAxis);
+  bool    process();
+  bool    save(const char* plyFilename, const Ply::DataType dataType);
+  void    clear();
+
+  int     getNumberOfChunks() const;
+  int     getNumberOfVertices() const;
+  int     getNumberOfFaces() const;
+  int     getNumberOfHaloFaces() const;
+  int     getMaxChunkFaces() const;
+  int     getNumberOfEdges() const;
+  int     getNumberOfBoundaryEdges() const;
+  int     getNumberOfSingularEdges() const;
+  int     getNumberOfBoundaryVertices() const;
+  int     getNumberOfSingularVertices() const;
+
+  static void setOstream(ostream* ostrm);
+  static void setIndent(const string s="");
+
+  static const int MAX_CHUNKS_PER_AXIS = 40;
+
+private:
+
+  string                 _plyFilename;
+  string                 _prefix;
+  int                    _nChunksPerAxis;
+  int                    _nVertices;
+  int                    _nFaces;
+  int                    _nHaloFaces;
+  int                    _maxChunkFaces;
+  int                    _nEdges;
+  int                    _nBoundaryEdges;
+  int                    _nSingularEdges;
+  int                    _nBoundaryVertices;
+  int                    _nSingularVertices;
+  bool                   _processed;
+  // chunk index of each vertex; (unsigned short)-1 if not assigned
+  vector<unsigned short> _vertexChunk;
+  vector<int>            _chunkFaces;
+
+  static ostream*        _ostrm;
+  static string          _indent;
+
+  string  _coordFilename() const;
+  string  _normalFilename() const;
+  string  _chunkFilename(const int iChunk) const;
+
+  bool    _flushChunks(vector< vector<int> >& buffer);
+  void    _processChunk(const int iChunk, FILE* coordFp, FILE* normalFp);
+
+  static bool _seek(FILE* fp, const int64_t offset);
+  static bool _readRecords(FILE* fp, const vector<int>& index,
+                           const int recordSize, char* data);
+  static bool _writeRecords(FILE* fp, const vector<int>& index,
+                            const int recordSize, const char* data);
+};
+
+#endif /* _OutOfCoreProcessor_hpp_ */
@@ -52,6 +52,7 @@ string        Ply::_floatFormat     = "%f";
 string        Ply::_intFormat       = "%d";
 Ply::DataType Ply::_defaultDataType = Ply::DataType::NONE;
 bool          Ply::_defaultWrlMode  = true; // false;
+bool          Ply::_defaultCompactColor = false;
 
 // static
 void Ply::setDebug(const bool value) {
@@ -108,6 +109,16 @@ bool Ply::getDefaultWrlMode() {
     return _defaultWrlMode;
 }
 
+// static
+void Ply::setDefaultCompactColor(const bool value) {
+  _defaultCompactColor = value;
+}
+
+// static
+bool Ply::getDefaultCompactColor() {
+  return _defaultCompactColor;
+}
+
 Ply::Ply():
   _dataType(Ply::DataType::NONE),
   _textureFile(""),
@@ -118,6 +129,8 @@ Ply::Ply():
   _normal(nullptr),
   _colorPerVertex(true),
   _color(nullptr),
+  _compactColor(_defaultCompactColor), // cannot be changed after construction
+  _colorRGBA8(nullptr),
   _texCoord(nullptr) {
 }
   
@@ -229,8 +242,8 @@ bool Ply::hasColorPerVertex() {
   if(_wrlMode) {
     return
       (_colorPerVertex==true &&
-       _color!=nullptr &&
-       _color->size()==UL(3*nVertices));
+       ((_color!=nullptr && _color->size()==UL(3*nVertices)) ||
+        (_colorRGBA8!=nullptr && _colorRGBA8->size()==UL(4*nVertices))));
   } else {
     return
       (vertex->getProperty("red")  !=nullptr &&
@@ -246,8 +259,8 @@ bool Ply::hasColorPerFace() {
   if(_wrlMode) {
     return
       (_colorPerVertex==false &&
-       _color!=nullptr &&
-       _color->size()==UL(3*nFaces));
+       ((_color!=nullptr && _color->size()==UL(3*nFaces)) ||
+        (_colorRGBA8!=nullptr && _colorRGBA8->size()==UL(4*nFaces))));
   } else {
     return
       (face->getProperty("red")  !=nullptr &&
@@ -469,6 +482,7 @@ void Ply::logInfo(ostream & ostr, const string indent) {
             break;
           case Ply::Element::Property::Type::UCHAR:
           case Ply::Element::Property::Type::UINT8:
+          case Ply::Element::Property::Type::UINT8_4:
             propertySize =
               I(static_cast<vector<unsigned char>*>(propertyValue)->size());
             break;
@@ -597,11 +611,15 @@ Ply::Element::addProperty
   } else if(wrlMode && _name=="vertex" && list==false &&
             (name=="red" || name=="green" || name=="blue") &&
             (type==Property::Type::UCHAR || type==Property::Type::UINT8)) {
-    typeWrl = Property::Type::FLOAT32_3;
+    typeWrl = (_ply._compactColor)?
+      Property::Type::UINT8_4:Property::Type::FLOAT32_3;
     if((p=getProperty("color"))==nullptr) {
       p = new Property("color",false,Property::Type::NONE,typeWrl,*this);
       _ply._colorPerVertex = true;
-      _ply._color = static_cast<vector<float>*>(p->getValue());
+      if(_ply._compactColor)
+        _ply._colorRGBA8 = static_cast<vector<unsigned char>*>(p->getValue());
+      else
+        _ply._color = static_cast<vector<float>*>(p->getValue());
       _property.push_back(p);
     }
   } else if(wrlMode && _name=="vertex" && list==false &&
@@ -628,11 +646,15 @@ Ply::Element::addProperty
   } else if(wrlMode && _name=="face" && list==false &&
             (name=="red" || name=="green" || name=="blue") &&
             (type==Property::Type::UCHAR || type==Property::Type::UINT8)) {
-    typeWrl = Property::Type::FLOAT32_3;
+    typeWrl = (_ply._compactColor)?
+      Property::Type::UINT8_4:Property::Type::FLOAT32_3;
     if((p=getProperty("color"))==nullptr) {
       p = new Property("color",false,Property::Type::NONE,typeWrl,*this);
       _ply._colorPerVertex = false;
-      _ply._color = static_cast<vector<float>*>(p->getValue());
+      if(_ply._compactColor)
+        _ply._colorRGBA8 = static_cast<vector<unsigned char>*>(p->getValue());
+      else
+        _ply._color = static_cast<vector<float>*>(p->getValue());
       _property.push_back(p);
     }
   } else if(wrlMode && _name=="face" && list==true && name=="vertex_indices") {
@@ -710,6 +732,7 @@ void Ply::Element::deleteProperty(const int i) {
   if(0<=i) {
     uint ui = static_cast<uint>(i);
     if(ui<_property.size()) {
+      delete _property[ui];
       _property.erase(_property.begin()+ui);
     }
   }
@@ -720,10 +743,7 @@ Ply& Ply::Element::ply() {
 }
 
 void Ply::Element::deleteProperty(const string& name) {
-  for(uint i=0;i<_property.size();i++) {
-    if(_property[i]->getName()!=name) continue;
-    _property.erase(_property.begin()+i);
-  }
+  deleteProperty(getPropertyIndex(name));
 }
 
 // class Ply::Element::Property //////////////////////////////////////
@@ -768,6 +788,8 @@ Ply::Element::Property::parseType(const string& token) {
     type = Type::FLOAT32_2;
   else if(token=="float32_3" || token=="FLOAT32_3")
     type = Type::FLOAT32_3;
+  else if(token=="uint8_4"   || token=="UINT8_4")
+    type = Type::UINT8_4;
 
   return type;
 }
@@ -793,6 +815,7 @@ const string Ply::Element::Property::getTypeName(const Type type) {
   case FLOAT64:   return   "float64";
   case FLOAT32_2: return "float32_2";
   case FLOAT32_3: return "float32_3";
+  case UINT8_4:   return   "uint8_4";
   default:        return      "none";
   }
 }
@@ -819,6 +842,7 @@ int Ply::Element::Property::getTypeSize(const Type type) {
   case FLOAT64:   dimension =  8; break;
   case FLOAT32_2: dimension =  8; break;
   case FLOAT32_3: dimension = 12; break;
+  case UINT8_4:   dimension =  4; break;
   case NONE:                   break;
   }
   return dimension;
@@ -841,6 +865,7 @@ Ply::Element::Property::Property
     break;
   case UCHAR:
   case UINT8:
+  case UINT8_4:
     _value = static_cast<void*>(new vector<unsigned char>());
     break;
   case SHORT:
@@ -887,6 +912,7 @@ Ply::Element::Property::~Property() {
     break;
   case UCHAR:
   case UINT8:
+  case UINT8_4:
     delete static_cast<vector<unsigned char>*>(_value);
     break;
   case SHORT:
@@ -920,6 +946,52 @@ Ply::Element::Property::~Property() {
   }
 }
 
+void Ply::Element::Property::clearValue() {
+  switch(_type) {
+  case CHAR:
+  case INT8:
+    vector<char>().swap(*static_cast<vector<char>*>(_value));
+    break;
+  case UCHAR:
+  case UINT8:
+  case UINT8_4:
+    vector<unsigned char>().swap(*static_cast<vector<unsigned char>*>(_value));
+    break;
+  case SHORT:
+  case INT16:
+    vector<short>().swap(*static_cast<vector<short>*>(_value));
+    break;
+  case USHORT:
+  case UINT16:
+    vector<unsigned short>().swap(*static_cast<vector<unsigned short>*>(_value));
+    break;
+  case INT:
+  case INT32:
+    vector<int>().swap(*static_cast<vector<int>*>(_value));
+    break;
+  case UINT:
+  case UINT32:
+    vector<unsigned int>().swap(*static_cast<vector<unsigned int>*>(_value));
+    break;
+  case FLOAT:
+  case FLOAT32:
+  case FLOAT32_2:
+  case FLOAT32_3:
+    vector<float>().swap(*static_cast<vector<float>*>(_value));
+    break;
+  case DOUBLE:
+  case FLOAT64:
+    vector<double>().swap(*static_cast<vector<double>*>(_value));
+    break;
+  case NONE:
+    break;
+  }
+  if(isList()) {
+    vector<int>().swap(_first);
+    _first.push_back(0);
+  }
+}
+
 void Ply::Element::Property::swap(Property& p) {
   string name     =     _name; _name     =     p._name; p._name     =      name;
   void*  value    =    _value; _value    =    p._value; p._value    =     value;
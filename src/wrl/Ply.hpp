@@ -66,6 +66,13 @@ public:
 
   static void         setDefaultWrlMode(const bool value);
   static bool         getDefaultWrlMode();
+
+  // in wrlMode, store the uchar vertex and face colors as they are
+  // read, four bytes per color with an opaque alpha, in a
+  // "color:uint8_4" property, rather than scaled to float; see
+  // IndexedFaceSet::getColorRGBA8()
+  static void         setDefaultCompactColor(const bool value);
+  static bool         getDefaultCompactColor();
   // if(_wrlMode) {
   //   // automatically convert on load and save :
   //   vertex:(x,y,z) to coord
@@ -89,7 +96,7 @@ public:
         NONE, CHAR, UCHAR, SHORT, USHORT, INT, UINT, FLOAT, DOUBLE,
         INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64,
         // new types to support wrlMode
-        FLOAT32_2, FLOAT32_3
+        FLOAT32_2, FLOAT32_3, UINT8_4
       };
 
       static Type         parseType(const string& token);
@@ -101,6 +108,8 @@ public:
       ~Property();
       
       void             swap(Property& p);
+      // release the values, keeping the name and the types
+      void             clearValue();
       string&          getName();
       void*            getValue();
       bool             isList();
@@ -201,6 +210,7 @@ public:
   vector<float>*        getNormal()          { return          _normal; }
   bool                  getColorPerVertex()  { return  _colorPerVertex; }
   vector<float>*        getColor()           { return           _color; }
+  vector<unsigned char>* getColorRGBA8()     { return     _colorRGBA8; }
   vector<float>*        getTexCoord()        { return        _texCoord; }
 
   void                  logInfo(ostream & ostr, const string indent="");
@@ -216,6 +226,7 @@ private:
   static string    _intFormat;
   static DataType  _defaultDataType;
   static bool      _defaultWrlMode;
+  static bool      _defaultCompactColor;
 
   DataType         _dataType;
   string           _textureFile;
@@ -231,6 +242,8 @@ private:
   vector<float>*   _normal; // vertex(nx,ny,nz) or face(nx,ny,nz)
   bool             _colorPerVertex;
   vector<float>*   _color; // vertex(red,green,blue) or face(red,green,blue)
+  bool             _compactColor;
+  vector<unsigned char>* _colorRGBA8; // as _color, if _compactColor
   vector<float>*   _texCoord; // vertex(u,v)
 
 };
@@ -34,23 +34,25 @@
 
 #include <iostream>
 #include "SceneGraph.hpp"
-#include "SceneGraphTraversal.hpp"
-#include "Shape.hpp"
-#include "Appearance.hpp"
+#include "SceneGraphIndex.hpp"
   
-SceneGraph::SceneGraph() {
+SceneGraph::SceneGraph():
+  _index((SceneGraphIndex*)0) {
   _parent = this;
 }
 
 SceneGraph::~SceneGraph() {
+  delete _index;
 }
 
 void SceneGraph::clear() {
   pNode node;
   while(_children.size()>0) {
     node = _children.back(); _children.pop_back();
-    delete node;
+    if(node->removeReference()==0)
+      delete node;
   }
+  structureChanged();
 }
 
 string& SceneGraph::getUrl() {
@@ -61,27 +63,15 @@ void SceneGraph::setUrl(const string& url) {
   _url = url;
 }
 
+SceneGraphIndex& SceneGraph::getIndex() {
+  if(_index==(SceneGraphIndex*)0)
+    _index = new SceneGraphIndex(*this);
+  return *_index;
+}
+
+// the first node with the given name visited by a SceneGraphTraversal
 Node* SceneGraph::find(const string& name) {
-  Node* node = (Node*)0;
-  SceneGraphTraversal t(*this); t.start();
-  while((node=t.next())!=(Node*)0) {
-    if(node->nameEquals(name)) break;
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      node = shape->getAppearance();
-      if(node!=(Node*)0) {
-        if(node->nameEquals(name)) break;
-        Appearance* appearance = (Appearance*)node;
-        node = appearance->getMaterial();
-        if(node!=(Node*)0 && node->nameEquals(name)) break;
-        node = appearance->getTexture();
-        if(node!=(Node*)0 && node->nameEquals(name)) break;
-      }
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->nameEquals(name)) break;
-    }
-  }
-  return node;
+  return getIndex().find(name);
 }
 
 void SceneGraph::printInfo(string indent) {
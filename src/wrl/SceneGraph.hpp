@@ -46,11 +46,14 @@
 
 using namespace std;
 
+class SceneGraphIndex;
+
 class SceneGraph : public Group {
 
 private:
 
-  string _url;
+  string           _url;
+  SceneGraphIndex* _index;
 
 public:
   
@@ -64,6 +67,10 @@ public:
 
   Node*           find(const string& name);
 
+  // flattened arrays of the shapes, world matrices and named nodes,
+  // rebuilt on demand after the scene graph is modified
+  SceneGraphIndex& getIndex();
+
   virtual bool    isSceneGraph() const { return         true; }
   virtual string  getType()      const { return "SceneGraph"; }
   typedef bool    (*Property)(SceneGraph& sceneGraph);
@@ -0,0 +1,608 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-10-18 11:02:37 taubin>
+//------------------------------------------------------------------------
+//
+// SceneGraphBvh.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <math.h>
+#include <algorithm>
+#include <thread>
+#include "SceneGraphBvh.hpp"
+#include "Transform.hpp"
+
+// number of bins per axis used to evaluate the Surface Area Heuristic
+static const int   BVH_BINS        =  16;
+// leaves with this many triangles or less are never split
+static const int   BVH_MIN_LEAF    =   2;
+// leaves are forced to be split above this size, even if the SAH
+// cost does not decrease
+static const int   BVH_MAX_LEAF    =   8;
+// maximum depth of the tree; bounds the traversal stacks
+static const int   BVH_MAX_DEPTH   =  60;
+// subtrees smaller than this are never built in a separate thread
+static const int   BVH_MIN_PARALLEL = 4096;
+
+static float _area(const float* bmin, const float* bmax) {
+  float dx = bmax[0]-bmin[0];
+  float dy = bmax[1]-bmin[1];
+  float dz = bmax[2]-bmin[2];
+  if(dx<0.0f || dy<0.0f || dz<0.0f) return 0.0f;
+  return 2.0f*(dx*dy+dy*dz+dz*dx);
+}
+
+static void _boxEmpty(float* bmin, float* bmax) {
+  bmin[0] = bmin[1] = bmin[2] =  FLT_MAX;
+  bmax[0] = bmax[1] = bmax[2] = -FLT_MAX;
+}
+
+static void _boxAdd(float* bmin, float* bmax,
+                    const float* pmin, const float* pmax) {
+  for(int k=0;k<3;k++) {
+    if(pmin[k]<bmin[k]) bmin[k] = pmin[k];
+    if(pmax[k]>bmax[k]) bmax[k] = pmax[k];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+SceneGraphBvh::Hit::Hit():
+  _shape((Shape*)0),
+  _ifs((IndexedFaceSet*)0),
+  _iF(-1),
+  _t(0.0f),
+  _u(0.0f),
+  _v(0.0f),
+  _distance(0.0f),
+  _point() {
+  _iV[0] = _iV[1] = _iV[2] = -1;
+}
+
+//////////////////////////////////////////////////////////////////////
+SceneGraphBvh::SceneGraphBvh():
+  _depth(0) {
+}
+
+//////////////////////////////////////////////////////////////////////
+SceneGraphBvh::SceneGraphBvh(SceneGraph& wrl, int nThreads):
+  _depth(0) {
+  build(wrl,nThreads);
+}
+
+//////////////////////////////////////////////////////////////////////
+SceneGraphBvh::~SceneGraphBvh() {
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphBvh::clear() {
+  _shape.clear();
+  _ifs.clear();
+  _triCoord.clear();
+  _triShape.clear();
+  _triFace.clear();
+  _triVertex.clear();
+  _triIndex.clear();
+  _node.clear();
+  _depth = 0;
+}
+
+bool SceneGraphBvh::isEmpty() const {
+  return _node.size()==0;
+}
+
+int SceneGraphBvh::getNumberOfTriangles() const {
+  return static_cast<int>(_triFace.size());
+}
+
+int SceneGraphBvh::getNumberOfNodes() const {
+  return static_cast<int>(_node.size());
+}
+
+int SceneGraphBvh::getDepth() const {
+  return _depth;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphBvh::build(SceneGraph& wrl, int nThreads) {
+  clear();
+
+  // collect the triangles in world coordinates
+  const float I[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+  };
+  if(wrl.getShow()) _collect(wrl,I);
+
+  int nT = getNumberOfTriangles();
+  if(nT==0) return;
+
+  // triangle centroids and bounding boxes
+  vector<float> centroid(3*nT);
+  vector<float> triBox(6*nT);
+  int iT,k;
+  for(iT=0;iT<nT;iT++) {
+    const float* p = &_triCoord[9*iT];
+    float* bmin = &triBox[6*iT];
+    float* bmax = bmin+3;
+    for(k=0;k<3;k++) {
+      bmin[k] = std::min(p[k],std::min(p[3+k],p[6+k]));
+      bmax[k] = std::max(p[k],std::max(p[3+k],p[6+k]));
+      centroid[3*iT+k] = (p[k]+p[3+k]+p[6+k])/3.0f;
+    }
+  }
+
+  _triIndex.resize(nT);
+  for(iT=0;iT<nT;iT++)
+    _triIndex[iT] = iT;
+
+  if(nThreads<=0)
+    nThreads = static_cast<int>(std::thread::hardware_concurrency());
+  int parallelDepth = 0;
+  while((1<<parallelDepth)<nThreads) parallelDepth++;
+
+  _node.reserve(2*(nT/BVH_MIN_LEAF)+1);
+  int maxDepth = 0;
+  _buildNode(_node,centroid,triBox,0,nT,0,parallelDepth,maxDepth);
+  _depth = maxDepth;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphBvh::_collect(Group& group, const float* M) {
+  int nChildren = group.getNumberOfChildren();
+  for(int i=0;i<nChildren;i++) {
+    Node* node = group[i];
+    if(node==(Node*)0 || node->getShow()==false) continue;
+    if(node->isTransform()) {
+      float T[16];
+      ((Transform*)node)->getMatrix(T);
+      // MT = M * T
+      float MT[16];
+      int ii,j,kk;
+      for(ii=0;ii<16;ii+=4)
+        for(j=0;j<4;j++)
+          for(MT[ii+j]=0.0f,kk=0;kk<4;kk++)
+            MT[ii+j] += M[ii+kk]*T[4*kk+j];
+      _collect(*((Group*)node),MT);
+    } else if(node->isGroup()) {
+      _collect(*((Group*)node),M);
+    } else if(node->isShape()) {
+      _collectShape(*((Shape*)node),M);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphBvh::_collectShape(Shape& shape, const float* M) {
+  Node* geometry = shape.getGeometry();
+  if(geometry==(Node*)0 || geometry->isIndexedFaceSet()==false) return;
+  IndexedFaceSet& ifs = *((IndexedFaceSet*)geometry);
+
+  vector<float>  tmpCoord;
+  const vector<float>& coord = ifs.readCoord(tmpCoord);
+  vector<int>&   coordIndex = ifs.getCoordIndex();
+  int nV = static_cast<int>(coord.size()/3);
+  int nC = static_cast<int>(coordIndex.size());
+  if(nV==0 || nC==0) return;
+
+  // transform the vertices only once
+  vector<float> x(3*nV);
+  int iV,k;
+  for(iV=0;iV<nV;iV++) {
+    const float* p = &coord[3*iV];
+    for(k=0;k<3;k++)
+      x[3*iV+k] = M[4*k]*p[0]+M[4*k+1]*p[1]+M[4*k+2]*p[2]+M[4*k+3];
+  }
+
+  int iShape = static_cast<int>(_shape.size());
+  _shape.push_back(&shape);
+  _ifs.push_back(&ifs);
+
+  // split each face into a triangle fan
+  int iF,iC0,iC,iV0,iV1,iV2;
+  for(iF=iC0=iC=0;iC<nC;iC++) {
+    if(coordIndex[iC]>=0) continue;
+    // face iF spans coordIndex[iC0..iC-1]
+    iV0 = coordIndex[iC0];
+    for(int j=iC0+1;j+1<iC;j++) {
+      iV1 = coordIndex[j];
+      iV2 = coordIndex[j+1];
+      if(iV0>=nV || iV1>=nV || iV2>=nV) continue;
+      for(k=0;k<3;k++) _triCoord.push_back(x[3*iV0+k]);
+      for(k=0;k<3;k++) _triCoord.push_back(x[3*iV1+k]);
+      for(k=0;k<3;k++) _triCoord.push_back(x[3*iV2+k]);
+      _triShape.push_back(iShape);
+      _triFace.push_back(iF);
+      _triVertex.push_back(iV0);
+      _triVertex.push_back(iV1);
+      _triVertex.push_back(iV2);
+    }
+    iC0 = iC+1; iF++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+int SceneGraphBvh::_buildNode
+(vector<_Node>& node, const vector<float>& centroid,
+ const vector<float>& triBox, int first, int count,
+ int depth, int parallelDepth, int& maxDepth) {
+
+  int iN = static_cast<int>(node.size());
+  node.push_back(_Node());
+
+  // bounding box of the triangles and of their centroids
+  float bmin[3],bmax[3],cmin[3],cmax[3];
+  _boxEmpty(bmin,bmax);
+  _boxEmpty(cmin,cmax);
+  int i,k,iT;
+  for(i=first;i<first+count;i++) {
+    iT = _triIndex[i];
+    _boxAdd(bmin,bmax,&triBox[6*iT],&triBox[6*iT+3]);
+    _boxAdd(cmin,cmax,&centroid[3*iT],&centroid[3*iT]);
+  }
+  for(k=0;k<3;k++) {
+    node[iN]._min[k] = bmin[k];
+    node[iN]._max[k] = bmax[k];
+  }
+  node[iN]._left  = -1;
+  node[iN]._right = -1;
+  node[iN]._first = first;
+  node[iN]._count = count;
+  if(depth>maxDepth) maxDepth = depth;
+
+  if(count<=BVH_MIN_LEAF || depth>=BVH_MAX_DEPTH) return iN;
+
+  // binned SAH over the three axes
+  int   bestAxis  = -1;
+  int   bestSplit = -1;
+  float bestCost  = FLT_MAX;
+  for(int axis=0;axis<3;axis++) {
+    float extent = cmax[axis]-cmin[axis];
+    if(extent<=0.0f) continue;
+    float scale = static_cast<float>(BVH_BINS)/extent;
+
+    int   binCount[BVH_BINS];
+    float binMin[BVH_BINS][3],binMax[BVH_BINS][3];
+    int b;
+    for(b=0;b<BVH_BINS;b++) {
+      binCount[b] = 0;
+      _boxEmpty(binMin[b],binMax[b]);
+    }
+    for(i=first;i<first+count;i++) {
+      iT = _triIndex[i];
+      b = static_cast<int>((centroid[3*iT+axis]-cmin[axis])*scale);
+      if(b>=BVH_BINS) b = BVH_BINS-1;
+      binCount[b]++;
+      _boxAdd(binMin[b],binMax[b],&triBox[6*iT],&triBox[6*iT+3]);
+    }
+
+    // sweep from the right to accumulate the right side costs
+    float rightArea[BVH_BINS];
+    int   rightCount[BVH_BINS];
+    float amin[3],amax[3];
+    int   n = 0;
+    _boxEmpty(amin,amax);
+    for(b=BVH_BINS-1;b>0;b--) {
+      n += binCount[b];
+      _boxAdd(amin,amax,binMin[b],binMax[b]);
+      rightCount[b] = n;
+      rightArea[b]  = _area(amin,amax);
+    }
+    // sweep from the left; split s separates bins [0,s) and [s,BINS)
+    n = 0;
+    _boxEmpty(amin,amax);
+    for(b=1;b<BVH_BINS;b++) {
+      n += binCount[b-1];
+      _boxAdd(amin,amax,binMin[b-1],binMax[b-1]);
+      if(n==0 || rightCount[b]==0) continue;
+      float cost = n*_area(amin,amax)+rightCount[b]*rightArea[b];
+      if(cost<bestCost) {
+        bestCost  = cost;
+        bestAxis  = axis;
+        bestSplit = b;
+      }
+    }
+  }
+
+  // all the centroids are coincident
+  if(bestAxis<0) return iN;
+
+  // SAH with unit traversal and intersection costs
+  float area = _area(bmin,bmax);
+  float leafCost  = static_cast<float>(count);
+  float splitCost = (area>0.0f)?(1.0f+bestCost/area):leafCost;
+  if(splitCost>=leafCost && count<=BVH_MAX_LEAF) return iN;
+
+  // partition the triangle indices
+  float scale = static_cast<float>(BVH_BINS)/(cmax[bestAxis]-cmin[bestAxis]);
+  float c0    = cmin[bestAxis];
+  const float* C = centroid.data();
+  int* mid = std::partition
+    (_triIndex.data()+first,_triIndex.data()+first+count,
+     [C,bestAxis,bestSplit,scale,c0](int jT) {
+      int b = static_cast<int>((C[3*jT+bestAxis]-c0)*scale);
+      if(b>=BVH_BINS) b = BVH_BINS-1;
+      return b<bestSplit;
+    });
+  int countL = static_cast<int>(mid-(_triIndex.data()+first));
+  int countR = count-countL;
+  if(countL==0 || countR==0) return iN;
+
+  // build the children
+  int left,right;
+  if(depth<parallelDepth && count>=BVH_MIN_PARALLEL) {
+    // the right subtree is built concurrently into a separate array,
+    // which is appended to this one afterwards; the two threads
+    // operate on disjoint ranges of _triIndex
+    vector<_Node> nodeR;
+    int maxDepthR = 0;
+    std::thread thread([&]() {
+        _buildNode(nodeR,centroid,triBox,first+countL,countR,
+                   depth+1,parallelDepth,maxDepthR);
+      });
+    left = _buildNode(node,centroid,triBox,first,countL,
+                      depth+1,parallelDepth,maxDepth);
+    thread.join();
+    if(maxDepthR>maxDepth) maxDepth = maxDepthR;
+    int offset = static_cast<int>(node.size());
+    for(_Node& nR : nodeR) {
+      if(nR._count==0) { nR._left += offset; nR._right += offset; }
+      node.push_back(nR);
+    }
+    right = offset;
+  } else {
+    left  = _buildNode(node,centroid,triBox,first,countL,
+                       depth+1,parallelDepth,maxDepth);
+    right = _buildNode(node,centroid,triBox,first+countL,countR,
+                       depth+1,parallelDepth,maxDepth);
+  }
+
+  node[iN]._left  = left;
+  node[iN]._right = right;
+  node[iN]._first = -1;
+  node[iN]._count = 0;
+  return iN;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphBvh::_setHit(int iT, Hit& hit) const {
+  int iShape  = _triShape[iT];
+  hit._shape  = _shape[iShape];
+  hit._ifs    = _ifs[iShape];
+  hit._iF     = _triFace[iT];
+  hit._iV[0]  = _triVertex[3*iT  ];
+  hit._iV[1]  = _triVertex[3*iT+1];
+  hit._iV[2]  = _triVertex[3*iT+2];
+  const float* p = &_triCoord[9*iT];
+  float w = 1.0f-hit._u-hit._v;
+  hit._point.x = w*p[0]+hit._u*p[3]+hit._v*p[6];
+  hit._point.y = w*p[1]+hit._u*p[4]+hit._v*p[7];
+  hit._point.z = w*p[2]+hit._u*p[5]+hit._v*p[8];
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SceneGraphBvh::_rayBox
+(const _Node& node, const float* o, const float* invD,
+ float tMax, float& tNear) {
+  float t0 = 0.0f;
+  float t1 = tMax;
+  for(int k=0;k<3;k++) {
+    float tA = (node._min[k]-o[k])*invD[k];
+    float tB = (node._max[k]-o[k])*invD[k];
+    if(tA>tB) { float t=tA; tA=tB; tB=t; }
+    // NaN comparisons are false and leave the interval unchanged
+    if(tA>t0) t0 = tA;
+    if(tB<t1) t1 = tB;
+    if(t0>t1) return false;
+  }
+  tNear = t0;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SceneGraphBvh::rayCast
+(const Vec3f& origin, const Vec3f& direction, Hit& hit, float tMax) const {
+  if(_node.size()==0) return false;
+
+  float o[3]    = { origin.x, origin.y, origin.z };
+  float d[3]    = { direction.x, direction.y, direction.z };
+  float invD[3] = { 1.0f/d[0], 1.0f/d[1], 1.0f/d[2] };
+
+  int   bestT = -1;
+  float bestU = 0.0f, bestV = 0.0f;
+  float tBest = tMax;
+
+  int stack[2*BVH_MAX_DEPTH+2];
+  int top = 0;
+  float tNear,tNearL,tNearR;
+  if(_rayBox(_node[0],o,invD,tBest,tNear)) stack[top++] = 0;
+  while(top>0) {
+    const _Node& node = _node[stack[--top]];
+    if(node._count>0) {
+      for(int i=node._first;i<node._first+node._count;i++) {
+        // Moller-Trumbore ray-triangle intersection
+        int iT = _triIndex[i];
+        const float* p = &_triCoord[9*iT];
+        float e1[3] = { p[3]-p[0], p[4]-p[1], p[5]-p[2] };
+        float e2[3] = { p[6]-p[0], p[7]-p[1], p[8]-p[2] };
+        float q[3]  = { d[1]*e2[2]-d[2]*e2[1],
+                        d[2]*e2[0]-d[0]*e2[2],
+                        d[0]*e2[1]-d[1]*e2[0] };
+        float det = e1[0]*q[0]+e1[1]*q[1]+e1[2]*q[2];
+        if(det==0.0f) continue;
+        float invDet = 1.0f/det;
+        float s[3] = { o[0]-p[0], o[1]-p[1], o[2]-p[2] };
+        float u = (s[0]*q[0]+s[1]*q[1]+s[2]*q[2])*invDet;
+        if(u<0.0f || u>1.0f) continue;
+        float r[3] = { s[1]*e1[2]-s[2]*e1[1],
+                       s[2]*e1[0]-s[0]*e1[2],
+                       s[0]*e1[1]-s[1]*e1[0] };
+        float v = (d[0]*r[0]+d[1]*r[1]+d[2]*r[2])*invDet;
+        if(v<0.0f || u+v>1.0f) continue;
+        float t = (e2[0]*r[0]+e2[1]*r[1]+e2[2]*r[2])*invDet;
+        if(t<0.0f || t>tBest) continue;
+        tBest = t; bestT = iT; bestU = u; bestV = v;
+      }
+    } else {
+      const _Node& nodeL = _node[node._left];
+      const _Node& nodeR = _node[node._right];
+      bool hitL = _rayBox(nodeL,o,invD,tBest,tNearL);
+      bool hitR = _rayBox(nodeR,o,invD,tBest,tNearR);
+      // push the farther child first so that the nearer one is
+      // visited first
+      if(hitL && hitR) {
+        if(tNearL<tNearR) {
+          stack[top++] = node._right; stack[top++] = node._left;
+        } else {
+          stack[top++] = node._left;  stack[top++] = node._right;
+        }
+      } else if(hitL) {
+        stack[top++] = node._left;
+      } else if(hitR) {
+        stack[top++] = node._right;
+      }
+    }
+  }
+
+  if(bestT<0) return false;
+
+  hit._t = tBest;
+  hit._u = bestU;
+  hit._v = bestV;
+  _setHit(bestT,hit);
+  float dd = sqrt(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]);
+  hit._distance = tBest*dd;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+float SceneGraphBvh::_boxDistance2(const _Node& node, const float* p) {
+  float d2 = 0.0f;
+  for(int k=0;k<3;k++) {
+    float dk = 0.0f;
+    if(p[k]<node._min[k])      dk = node._min[k]-p[k];
+    else if(p[k]>node._max[k]) dk = p[k]-node._max[k];
+    d2 += dk*dk;
+  }
+  return d2;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Ericson, Real-Time Collision Detection, Section 5.1.5
+void SceneGraphBvh::_closestPointOnTriangle
+(const float* p, const float* a, const float* b, const float* c,
+ float* q, float& u, float& v) {
+  float ab[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+  float ac[3] = { c[0]-a[0], c[1]-a[1], c[2]-a[2] };
+  float ap[3] = { p[0]-a[0], p[1]-a[1], p[2]-a[2] };
+  float d1 = ab[0]*ap[0]+ab[1]*ap[1]+ab[2]*ap[2];
+  float d2 = ac[0]*ap[0]+ac[1]*ap[1]+ac[2]*ap[2];
+  if(d1<=0.0f && d2<=0.0f) { u = 0.0f; v = 0.0f; goto done; }
+  {
+    float bp[3] = { p[0]-b[0], p[1]-b[1], p[2]-b[2] };
+    float d3 = ab[0]*bp[0]+ab[1]*bp[1]+ab[2]*bp[2];
+    float d4 = ac[0]*bp[0]+ac[1]*bp[1]+ac[2]*bp[2];
+    if(d3>=0.0f && d4<=d3) { u = 1.0f; v = 0.0f; goto done; }
+    float vc = d1*d4-d3*d2;
+    if(vc<=0.0f && d1>=0.0f && d3<=0.0f) {
+      u = d1/(d1-d3); v = 0.0f; goto done;
+    }
+    float cp[3] = { p[0]-c[0], p[1]-c[1], p[2]-c[2] };
+    float d5 = ab[0]*cp[0]+ab[1]*cp[1]+ab[2]*cp[2];
+    float d6 = ac[0]*cp[0]+ac[1]*cp[1]+ac[2]*cp[2];
+    if(d6>=0.0f && d5<=d6) { u = 0.0f; v = 1.0f; goto done; }
+    float vb = d5*d2-d1*d6;
+    if(vb<=0.0f && d2>=0.0f && d6<=0.0f) {
+      u = 0.0f; v = d2/(d2-d6); goto done;
+    }
+    float va = d3*d6-d5*d4;
+    if(va<=0.0f && (d4-d3)>=0.0f && (d5-d6)>=0.0f) {
+      float w = (d4-d3)/((d4-d3)+(d5-d6));
+      u = 1.0f-w; v = w; goto done;
+    }
+    float denom = 1.0f/(va+vb+vc);
+    u = vb*denom; v = vc*denom;
+  }
+ done:
+  for(int k=0;k<3;k++)
+    q[k] = a[k]+u*ab[k]+v*ac[k];
+}
+
+//////////////////////////////////////////////////////////////////////
+bool SceneGraphBvh::nearestPoint
+(const Vec3f& point, Hit& hit, float maxDistance) const {
+  if(_node.size()==0) return false;
+
+  float p[3] = { point.x, point.y, point.z };
+  float best2 = (maxDistance<sqrt(FLT_MAX))?maxDistance*maxDistance:FLT_MAX;
+  int   bestT = -1;
+  float bestU = 0.0f, bestV = 0.0f;
+
+  int stack[2*BVH_MAX_DEPTH+2];
+  int top = 0;
+  stack[top++] = 0;
+  float q[3],u,v;
+  while(top>0) {
+    const _Node& node = _node[stack[--top]];
+    if(_boxDistance2(node,p)>best2) continue;
+    if(node._count>0) {
+      for(int i=node._first;i<node._first+node._count;i++) {
+        int iT = _triIndex[i];
+        const float* t = &_triCoord[9*iT];
+        _closestPointOnTriangle(p,t,t+3,t+6,q,u,v);
+        float d2 = (q[0]-p[0])*(q[0]-p[0])+
+                   (q[1]-p[1])*(q[1]-p[1])+
+                   (q[2]-p[2])*(q[2]-p[2]);
+        if(d2<=best2) {
+          best2 = d2; bestT = iT; bestU = u; bestV = v;
+        }
+      }
+    } else {
+      float dL = _boxDistance2(_node[node._left ],p);
+      float dR = _boxDistance2(_node[node._right],p);
+      if(dL<dR) {
+        if(dR<=best2) stack[top++] = node._right;
+        if(dL<=best2) stack[top++] = node._left;
+      } else {
+        if(dL<=best2) stack[top++] = node._left;
+        if(dR<=best2) stack[top++] = node._right;
+      }
+    }
+  }
+
+  if(bestT<0) return false;
+
+  hit._t = 0.0f;
+  hit._u = bestU;
+  hit._v = bestV;
+  _setHit(bestT,hit);
+  hit._distance = sqrt(best2);
+  return true;
+}
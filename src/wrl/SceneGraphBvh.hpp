@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-10-18 11:02:37 taubin>
+//------------------------------------------------------------------------
+//
+// SceneGraphBvh.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _SceneGraphBvh_hpp_
+#define _SceneGraphBvh_hpp_
+
+#include <vector>
+#include <float.h>
+#include "SceneGraph.hpp"
+#include "Shape.hpp"
+#include "IndexedFaceSet.hpp"
+
+using namespace std;
+
+// Bounding Volume Hierarchy built over the triangles of all the
+// IndexedFaceSet nodes of a SceneGraph
+//
+// - the triangles are stored in world coordinates, i.e., after
+//   applying the matrices of all the Transform nodes found on the
+//   path from the root to the Shape node
+// - polygonal faces are split into triangle fans
+// - the tree is built using the Surface Area Heuristic evaluated over
+//   a fixed number of bins per axis; the top levels of the tree are
+//   built concurrently by several threads
+// - the SceneGraph must not be modified while the hierarchy is in
+//   use; call build() again after editing the geometry
+//
+// Use as follows
+//
+// SceneGraphBvh bvh(wrl);
+// SceneGraphBvh::Hit hit;
+// if(bvh.rayCast(origin,direction,hit)) {
+//   // hit._shape, hit._iF, hit._point, ...
+// }
+// if(bvh.nearestPoint(p,hit)) {
+//   // hit._distance, hit._point, ...
+// }
+
+class SceneGraphBvh {
+
+public:
+
+  class Hit {
+  public:
+    Shape*          _shape;    // Shape containing the triangle
+    IndexedFaceSet* _ifs;      // geometry of the Shape
+    int             _iF;       // face index within _ifs
+    int             _iV[3];    // coord indices of the triangle vertices
+    float           _t;        // ray parameter (rayCast only)
+    float           _u;        // barycentric coordinates of the point
+    float           _v;        //   _point = (1-u-v)*p0 + u*p1 + v*p2
+    float           _distance; // distance to the query point
+    Vec3f           _point;    // closest point or ray intersection
+  public:
+    Hit();
+  };
+
+public:
+
+  SceneGraphBvh();
+  SceneGraphBvh(SceneGraph& wrl, int nThreads=0);
+  ~SceneGraphBvh();
+
+  // nThreads<=0 uses std::thread::hardware_concurrency()
+  void  build(SceneGraph& wrl, int nThreads=0);
+  void  clear();
+
+  bool  isEmpty() const;
+  int   getNumberOfTriangles() const;
+  int   getNumberOfNodes() const;
+  int   getDepth() const;
+
+  // first intersection of the ray origin+t*direction with 0<=t<=tMax;
+  // the direction vector does not need to be normalized
+  bool  rayCast(const Vec3f& origin, const Vec3f& direction,
+                Hit& hit, float tMax=FLT_MAX) const;
+
+  // closest point on the triangles at a distance <= maxDistance
+  bool  nearestPoint(const Vec3f& p, Hit& hit,
+                     float maxDistance=FLT_MAX) const;
+
+private:
+
+  class _Node {
+  public:
+    float _min[3];
+    float _max[3];
+    int   _left;  // interior nodes: index of left child
+    int   _right; // interior nodes: index of right child
+    int   _first; // leaf nodes: first entry in _triIndex
+    int   _count; // leaf nodes: number of triangles; 0 for interior
+  };
+
+  // one entry per Shape with IndexedFaceSet geometry
+  vector<Shape*>          _shape;
+  vector<IndexedFaceSet*> _ifs;
+
+  // triangle data; 9 world coordinates per triangle
+  vector<float>           _triCoord;
+  vector<int>             _triShape;  // index into _shape
+  vector<int>             _triFace;   // face index within the ifs
+  vector<int>             _triVertex; // 3 coord indices per triangle
+
+  // permutation of the triangle indices sorted by leaf
+  vector<int>             _triIndex;
+  vector<_Node>           _node;
+  int                     _depth;
+
+  void  _collect(Group& group, const float* M /*[16]*/);
+  void  _collectShape(Shape& shape, const float* M /*[16]*/);
+
+  int   _buildNode(vector<_Node>& node, const vector<float>& centroid,
+                   const vector<float>& triBox, int first, int count,
+                   int depth, int parallelDepth, int& maxDepth);
+
+  static void _closestPointOnTriangle
+              (const float* p, const float* a, const float* b, const float* c,
+               float* q, float& u, float& v);
+  static float _boxDistance2(const _Node& node, const float* p);
+  static bool  _rayBox(const _Node& node, const float* o, const float* invD,
+                       float tMax, float& tNear);
+
+  void  _setHit(int iT, Hit& hit) const;
+
+};
+
+#endif /* _SceneGraphBvh_hpp_ */
@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-13 10:17:42 taubin>
+//------------------------------------------------------------------------
+//
+// SceneGraphIndex.cpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SceneGraphIndex.hpp"
+#include "Appearance.hpp"
+
+//////////////////////////////////////////////////////////////////////
+SceneGraphIndex::SceneGraphIndex(SceneGraph& wrl):
+  _wrl(wrl),
+  _valid(false),
+  _structureVersion(0),
+  _transformVersion(0) {
+}
+
+//////////////////////////////////////////////////////////////////////
+SceneGraphIndex::~SceneGraphIndex() {
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphIndex::invalidate() {
+  _valid = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphIndex::update() {
+  // read the versions first; changes made while the arrays are being
+  // built are detected by the next call
+  unsigned structureVersion = Node::getStructureVersion();
+  unsigned transformVersion = Node::getTransformVersion();
+  if(_valid==false || structureVersion!=_structureVersion) {
+    _build();
+    _updateMatrices();
+    _structureVersion = structureVersion;
+    _transformVersion = transformVersion;
+    _valid = true;
+  } else if(transformVersion!=_transformVersion) {
+    _updateMatrices();
+    _transformVersion = transformVersion;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+const vector<SceneGraphIndex::Instance>& SceneGraphIndex::getInstances() {
+  update();
+  return _instance;
+}
+
+int SceneGraphIndex::getNumberOfInstances() {
+  update();
+  return static_cast<int>(_instance.size());
+}
+
+const vector<Shape*>& SceneGraphIndex::getShapes() {
+  update();
+  return _shape;
+}
+
+const vector<Node*>& SceneGraphIndex::getGeometries() {
+  update();
+  return _geometry;
+}
+
+Node* SceneGraphIndex::find(const string& name) {
+  update();
+  unordered_map<string,Node*>::const_iterator i = _name.find(name);
+  return (i!=_name.end())?i->second:(Node*)0;
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphIndex::_build() {
+  _instance.clear();
+  _shape.clear();
+  _geometry.clear();
+  _transform.clear();
+  _transformMatrix.clear();
+  _name.clear();
+  set<Node*> visited;
+  set<Node*> path;
+  _buildGroup(_wrl,-1,_wrl.getShow(),visited,path);
+}
+
+//////////////////////////////////////////////////////////////////////
+// the nodes are visited in the same order as in SceneGraphTraversal,
+// but the groups shared by several parents are visited once per path
+void SceneGraphIndex::_buildGroup
+(Group& group, int iT, bool show, set<Node*>& visited, set<Node*>& path) {
+  // a group containing itself would never terminate
+  if(path.insert(&group).second==false) return;
+  int nChildren = group.getNumberOfChildren();
+  for(int i=0;i<nChildren;i++) {
+    Node* node = group[i];
+    if(node==(Node*)0) continue;
+    bool first = visited.find(node)==visited.end();
+    _addNode(node,visited);
+    bool showNode = show && node->getShow();
+    if(node->isShape()) {
+      Shape* shape = (Shape*)node;
+      Instance instance;
+      instance._shape     = shape;
+      instance._geometry  = shape->getGeometry();
+      instance._material  = (Material*)0;
+      instance._show      = showNode;
+      instance._transform = iT;
+      Node* appearance = shape->getAppearance();
+      if(appearance!=(Node*)0 && appearance->isAppearance()) {
+        Node* material = ((Appearance*)appearance)->getMaterial();
+        if(material!=(Node*)0 && material->isMaterial())
+          instance._material = (Material*)material;
+      }
+      _instance.push_back(instance);
+      if(first) {
+        _shape.push_back(shape);
+        if(appearance!=(Node*)0) {
+          _addNode(appearance,visited);
+          if(appearance->isAppearance()) {
+            Node* material = ((Appearance*)appearance)->getMaterial();
+            if(material!=(Node*)0) _addNode(material,visited);
+            Node* texture  = ((Appearance*)appearance)->getTexture();
+            if(texture!=(Node*)0) _addNode(texture,visited);
+          }
+        }
+        Node* geometry = instance._geometry;
+        if(geometry!=(Node*)0 && visited.find(geometry)==visited.end()) {
+          _addNode(geometry,visited);
+          _geometry.push_back(geometry);
+        }
+      }
+    } else if(node->isTransform()) {
+      _Transform transform;
+      transform._node   = (Transform*)node;
+      transform._parent = iT;
+      _transform.push_back(transform);
+      int jT = static_cast<int>(_transform.size())-1;
+      _buildGroup(*((Group*)node),jT,showNode,visited,path);
+    } else if(node->isGroup()) {
+      _buildGroup(*((Group*)node),iT,showNode,visited,path);
+    }
+  }
+  path.erase(&group);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphIndex::_addNode(Node* node, set<Node*>& visited) {
+  if(visited.insert(node).second && node->getName()!="")
+    _name.emplace(node->getName(),node);
+}
+
+//////////////////////////////////////////////////////////////////////
+void SceneGraphIndex::_updateMatrices() {
+  const float I[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+  };
+  int nT = static_cast<int>(_transform.size());
+  _transformMatrix.resize(16*nT);
+  int iT,ii,j,kk;
+  float T[16];
+  for(iT=0;iT<nT;iT++) {
+    _Transform& transform = _transform[iT];
+    transform._node->getMatrix(T);
+    const float* M = (transform._parent<0)?I:&_transformMatrix[16*transform._parent];
+    // MT = M * T
+    float* MT = &_transformMatrix[16*iT];
+    for(ii=0;ii<16;ii+=4)
+      for(j=0;j<4;j++)
+        for(MT[ii+j]=0.0f,kk=0;kk<4;kk++)
+          MT[ii+j] += M[ii+kk]*T[4*kk+j];
+  }
+  for(Instance& instance : _instance) {
+    const float* M = (instance._transform<0)?I:&_transformMatrix[16*instance._transform];
+    for(j=0;j<16;j++)
+      instance._matrix[j] = M[j];
+  }
+}
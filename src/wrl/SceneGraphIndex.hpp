@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------
+//  Copyright (C) Gabriel Taubin
+//  Time-stamp: <2025-11-13 10:17:42 taubin>
+//------------------------------------------------------------------------
+//
+// SceneGraphIndex.hpp
+//
+// Software developed for the course
+// Digital Geometry Processing
+// Copyright (c) 2025, Gabriel Taubin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the Brown University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL GABRIEL TAUBIN BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _SceneGraphIndex_hpp_
+#define _SceneGraphIndex_hpp_
+
+#include <vector>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include "SceneGraph.hpp"
+#include "Shape.hpp"
+#include "Material.hpp"
+#include "Transform.hpp"
+
+using namespace std;
+
+// Flattened representation of a SceneGraph, stored in contiguous
+// arrays
+//
+// - one Instance per path from the root to a Shape node, with the
+//   world matrix, i.e., the product of the matrices of all the
+//   Transform nodes found on the path, and the Material of the Shape;
+//   a Shape USEd under several Transform nodes has several instances
+// - the distinct Shape and geometry nodes, in the order in which a
+//   SceneGraphTraversal visits them
+// - a hash map from the node names to the first node with that name
+//   visited by a SceneGraphTraversal
+//
+// The arrays are rebuilt on demand, after the structure of the scene
+// graph changes, and the world matrices are recomputed after the
+// fields of a Transform node change; see Node::getStructureVersion()
+// and Node::getTransformVersion(). The references returned by the
+// get methods are valid until the scene graph is modified.
+//
+// Use as follows
+//
+// SceneGraphIndex& index = wrl.getIndex();
+// const vector<SceneGraphIndex::Instance>& instance = index.getInstances();
+// for(const SceneGraphIndex::Instance& i : instance) {
+//   // i._shape, i._matrix, ...
+// }
+
+class SceneGraphIndex {
+
+public:
+
+  class Instance {
+  public:
+    Shape*    _shape;
+    Node*     _geometry;   // null if the Shape has no geometry
+    Material* _material;   // null if the Shape has no Material
+    bool      _show;       // false if the Shape or an ancestor is hidden
+    int       _transform;  // innermost Transform on the path; -1 if none
+    float     _matrix[16]; // world matrix, as in Transform::getMatrix()
+  };
+
+public:
+
+  SceneGraphIndex(SceneGraph& wrl);
+  ~SceneGraphIndex();
+
+  // rebuilds the arrays if the structure of the scene graph changed
+  // since the last call, and the world matrices if only the fields of
+  // some Transform nodes changed
+  void                      update();
+  void                      invalidate();
+
+  const vector<Instance>&   getInstances();
+  int                       getNumberOfInstances();
+  const vector<Shape*>&     getShapes();
+  const vector<Node*>&      getGeometries();
+  Node*                     find(const string& name);
+
+private:
+
+  // one entry per path from the root to a Transform node; the parent
+  // entries precede their children
+  class _Transform {
+  public:
+    Transform* _node;
+    int        _parent;
+  };
+
+  SceneGraph&                  _wrl;
+  bool                         _valid;
+  unsigned                     _structureVersion;
+  unsigned                     _transformVersion;
+
+  vector<Instance>             _instance;
+  vector<Shape*>               _shape;
+  vector<Node*>                _geometry;
+  vector<_Transform>           _transform;
+  vector<float>                _transformMatrix; // 16 per _transform
+  unordered_map<string,Node*>  _name;
+
+  void  _build();
+  void  _buildGroup(Group& group, int iT, bool show,
+                    set<Node*>& visited, set<Node*>& path);
+  void  _addNode(Node* node, set<Node*>& visited);
+  void  _updateMatrices();
+
+};
+
+#endif /* _SceneGraphIndex_hpp_ */
@@ -34,14 +34,133 @@
 
 #include <math.h>
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <set>
+#include <float.h>
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE__)
+#define FLATTEN_SSE
+#include <xmmintrin.h>
+#endif
 #include "SceneGraphProcessor.hpp"
 #include "SceneGraphTraversal.hpp"
+#include "SceneGraphIndex.hpp"
 #include "Shape.hpp"
 #include "IndexedFaceSet.hpp"
+#include "IndexedFaceSetPly.hpp"
 #include "IndexedLineSet.hpp"
 #include "Appearance.hpp"
 #include "Material.hpp"
 
+// the geometry nodes are processed serially below this total number
+// of coord and coordIndex values
+static const long PARALLEL_MIN_TOTAL   = 1<<16;
+// meshes with this many coord and coordIndex values or more are
+// processed one at a time, split among all the threads; the smaller
+// ones are processed concurrently, one per thread
+static const long PARALLEL_MIN_SPLIT   = 1<<18;
+// minimum number of shapes per thread of the property queries
+static const int  PARALLEL_MIN_QUERIES = 1<<12;
+
+// calls f(i0,i1) over nThreads consecutive ranges of [0,n), each one in
+// a separate thread; nThreads<=1 calls f(0,n) in the calling thread
+static void _parallelFor
+(const int n, int nThreads, const function<void(int,int)>& f) {
+  if(nThreads>n) nThreads = n;
+  if(nThreads<=1) {
+    if(n>0) f(0,n);
+    return;
+  }
+  vector<thread> worker;
+  for(int i=1;i<nThreads;i++) {
+    int i0 = static_cast<int>((static_cast<long>(n)*i)/nThreads);
+    int i1 = static_cast<int>((static_cast<long>(n)*(i+1))/nThreads);
+    worker.push_back(thread(f,i0,i1));
+  }
+  f(0,static_cast<int>(n/nThreads));
+  for(thread& t : worker)
+    t.join();
+}
+
+// calls job(i,nThreads) for i in [0,nJobs), where nJobs=size.size();
+// the jobs of size PARALLEL_MIN_SPLIT or larger are run first, one at
+// a time, each one with all the threads; then each thread takes the
+// next remaining job, in decreasing order of size, as soon as it is
+// done with the previous one, and runs it in a single thread
+static void _parallelJobs
+(const vector<long>& size, const int nThreads,
+ const function<void(int,int)>& job) {
+  int nJobs = static_cast<int>(size.size());
+  long total = 0;
+  for(int i=0;i<nJobs;i++)
+    total += size[i];
+  if(nThreads<=1 || total<PARALLEL_MIN_TOTAL) {
+    for(int i=0;i<nJobs;i++)
+      job(i,1);
+    return;
+  }
+
+  vector<int> order(nJobs);
+  for(int i=0;i<nJobs;i++)
+    order[i] = i;
+  stable_sort(order.begin(),order.end(),
+              [&size](int a, int b) { return size[a]>size[b]; });
+  int iJob = 0;
+  for(;iJob<nJobs && size[order[iJob]]>=PARALLEL_MIN_SPLIT;iJob++)
+    job(order[iJob],nThreads);
+
+  atomic<int> next(iJob);
+  auto work = [&order,&next,&job,nJobs]() {
+    int i;
+    while((i=next++)<nJobs)
+      job(order[i],1);
+  };
+  vector<thread> worker;
+  for(int i=1;i<nThreads && i<nJobs-iJob;i++)
+    worker.push_back(thread(work));
+  work();
+  for(thread& t : worker)
+    t.join();
+}
+
+// faceFirst[iF] is the first corner of face iF, and faceFirst[iF+1]-1
+// is the position of its -1 separator
+static void _faceFirst(const vector<int>& coordIndex, vector<int>& faceFirst) {
+  int iC,nC = static_cast<int>(coordIndex.size());
+  faceFirst.clear();
+  faceFirst.push_back(0);
+  for(iC=0;iC<nC;iC++)
+    if(coordIndex[iC]<0)
+      faceFirst.push_back(iC+1);
+}
+
+static long _size(IndexedFaceSet& ifs) {
+  return static_cast<long>(3*ifs.getNumberOfCoord()+ifs.getCoordIndex().size());
+}
+
+int SceneGraphProcessor::_nThreads = 0;
+
+// static
+void SceneGraphProcessor::setNumberOfThreads(const int nThreads) {
+  _nThreads = nThreads;
+}
+
+// static
+int SceneGraphProcessor::getNumberOfThreads() {
+  return _nThreads;
+}
+
+// static
+int SceneGraphProcessor::_getNumberOfThreads() {
+  int nThreads = _nThreads;
+  if(nThreads<=0)
+    nThreads = static_cast<int>(thread::hardware_concurrency());
+  return (nThreads<1)?1:nThreads;
+}
+
 SceneGraphProcessor::SceneGraphProcessor(SceneGraph& wrl):
   _wrl(wrl) {
 }
@@ -69,23 +188,33 @@ void SceneGraphProcessor::computeNormalPerCorner() {
   _applyToIndexedFaceSet(_computeNormalPerCorner);
 }
 
-void SceneGraphProcessor::_applyToIndexedFaceSet(IndexedFaceSet::Operator o) {
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while((node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->isIndexedFaceSet()) {
-        IndexedFaceSet& ifs = *((IndexedFaceSet*)node);
-        o(ifs);
-      }
+void SceneGraphProcessor::reorderVertices() {
+  _applyToIndexedFaceSet(_reorderVertices);
+}
+
+void SceneGraphProcessor::reorderFaces() {
+  _applyToIndexedFaceSet(_reorderFaces);
+}
+
+// the geometry nodes are collected first, and then processed by a
+// pool of threads
+void SceneGraphProcessor::_applyToIndexedFaceSet(Operator o) {
+  // a geometry node shared by several shapes is listed only once
+  const vector<Node*>& geometry = _wrl.getIndex().getGeometries();
+  vector<IndexedFaceSet*> ifs;
+  vector<long> size;
+  for(Node* node : geometry) {
+    if(node->isIndexedFaceSet()) {
+      ifs.push_back((IndexedFaceSet*)node);
+      size.push_back(_size(*ifs.back()));
     }
   }
+  _parallelJobs(size,_getNumberOfThreads(),[&ifs,o](int i, int nThreads) {
+      o(*ifs[i],nThreads);
+    });
 }
 
-void SceneGraphProcessor::_normalClear(IndexedFaceSet& ifs) {
+void SceneGraphProcessor::_normalClear(IndexedFaceSet& ifs, int /*nThreads*/) {
   vector<float>& normal      = ifs.getNormal();
   vector<int>&   normalIndex = ifs.getNormalIndex();
   ifs.setNormalPerVertex(true);
@@ -93,14 +222,16 @@ void SceneGraphProcessor::_normalClear(IndexedFaceSet& ifs) {
   normalIndex.clear();
 }
 
-void SceneGraphProcessor::_normalInvert(IndexedFaceSet& ifs) {
+void SceneGraphProcessor::_normalInvert(IndexedFaceSet& ifs, int nThreads) {
   vector<float>& normal = ifs.getNormal();
-  for(int i=0;i<(int)normal.size();i++)
-    normal[i] = -normal[i];
+  _parallelFor((int)normal.size(),nThreads,[&normal](int i0, int i1) {
+      for(int i=i0;i<i1;i++)
+        normal[i] = -normal[i];
+    });
 }
 
 void SceneGraphProcessor::_computeFaceNormal
-(vector<float>& coord, vector<int>& coordIndex,
+(const vector<float>& coord, vector<int>& coordIndex,
  int i0, int i1, Vec3f& n, bool normalize) {
   int niF,iV,i;
   Vec3f p,pi,ni,v1,v2;
@@ -187,79 +318,98 @@ void SceneGraphProcessor::_computeFaceNormal
   }
 }
 
-void SceneGraphProcessor::_computeNormalPerFace(IndexedFaceSet& ifs) {
+// the faces are split among the threads
+void SceneGraphProcessor::_computeNormalPerFace(IndexedFaceSet& ifs, int nThreads) {
   if(ifs.getNormalBinding()==IndexedFaceSet::PB_PER_FACE) return;
-  vector<float>& coord       = ifs.getCoord();
+  vector<float>  tmpCoord;
+  const vector<float>& coord = ifs.readCoord(tmpCoord);
   vector<int>&   coordIndex  = ifs.getCoordIndex();
   vector<float>& normal      = ifs.getNormal();
   vector<int>&   normalIndex = ifs.getNormalIndex();
   ifs.setNormalPerVertex(false);
-  normal.clear();
   normalIndex.clear();
-  Vec3f n;
-  int /*iF,*/ i0,i1;
-  for(i0=i1=0;i1<(int)coordIndex.size();i1++) {
-    if(coordIndex[i1]<0) {
-      _computeFaceNormal(coord,coordIndex,i0,i1,n,true);
-      normal.push_back((float)(n[0]));
-      normal.push_back((float)(n[1]));
-      normal.push_back((float)(n[2]));
-      i0=i1+1; /* iF++; */
-    }
-  }
+  vector<int> faceFirst;
+  _faceFirst(coordIndex,faceFirst);
+  int nF = static_cast<int>(faceFirst.size())-1;
+  normal.resize(3*nF);
+  _parallelFor(nF,nThreads,[&](int iF0, int iF1) {
+      Vec3f n;
+      for(int iF=iF0;iF<iF1;iF++) {
+        _computeFaceNormal(coord,coordIndex,faceFirst[iF],faceFirst[iF+1]-1,n,true);
+        normal[3*iF  ] = (float)(n[0]);
+        normal[3*iF+1] = (float)(n[1]);
+        normal[3*iF+2] = (float)(n[2]);
+      }
+    });
 }
 
-void SceneGraphProcessor::_computeNormalPerVertex(IndexedFaceSet& ifs) {
+// the face normals are computed, and the vertex normals normalized, by
+// several threads; the face normals are accumulated serially, in face
+// order, so that the result does not depend on the number of threads
+void SceneGraphProcessor::_computeNormalPerVertex(IndexedFaceSet& ifs, int nThreads) {
   if(ifs.getNormalBinding()==IndexedFaceSet::PB_PER_VERTEX) return;
-  vector<float>& coord       = ifs.getCoord();
+  vector<float>  tmpCoord;
+  const vector<float>& coord = ifs.readCoord(tmpCoord);
   vector<int>&   coordIndex  = ifs.getCoordIndex();
   vector<float>& normal      = ifs.getNormal();
   vector<int>&   normalIndex = ifs.getNormalIndex();
   ifs.setNormalPerVertex(true);
   normal.clear();
   normalIndex.clear();
-  Vec3f n;
-  int /*iF,*/ nV,i,i0,i1,iV;
+  int nV,i,iF,iV;
   float x0,x1,x2;
   nV = (int)(coord.size()/3);
+  vector<int> faceFirst;
+  _faceFirst(coordIndex,faceFirst);
+  int nF = static_cast<int>(faceFirst.size())-1;
+  // face normals
+  vector<float> faceNormal(3*nF);
+  _parallelFor(nF,nThreads,[&](int iF0, int iF1) {
+      Vec3f n;
+      for(int iF=iF0;iF<iF1;iF++) {
+        _computeFaceNormal(coord,coordIndex,faceFirst[iF],faceFirst[iF+1]-1,n,false);
+        faceNormal[3*iF  ] = (float)(n[0]);
+        faceNormal[3*iF+1] = (float)(n[1]);
+        faceNormal[3*iF+2] = (float)(n[2]);
+      }
+    });
   // initialize accumulators
   normal.insert(normal.end(),coord.size(),0.0f);
   // accumulate face normals
-  for(i0=i1=0;i1<(int)coordIndex.size();i1++) {
-    if(coordIndex[i1]<0) {
-      _computeFaceNormal(coord,coordIndex,i0,i1,n,false);
-      // accumulate
-      for(i=i0;i<i1;i++) {
-        iV = coordIndex[i];
-        x0 = normal[3*iV  ];
-        x1 = normal[3*iV+1];
-        x2 = normal[3*iV+2];
-        normal[3*iV  ] = x0+((float)(n[0]));
-        normal[3*iV+1] = x1+((float)(n[1]));
-        normal[3*iV+2] = x2+((float)(n[2]));
-      }
-      i0=i1+1; /* iF++; */
-    }
-  }
-  for(iV=0;iV<nV;iV++) {
-    n[0] = normal[3*iV  ];
-    n[1] = normal[3*iV+1];
-    n[2] = normal[3*iV+2];
-    float nn = n[0]*n[0]+n[1]*n[1]+n[2]*n[2];
-    if(nn>0.0f) {
-      nn = (float)sqrt(nn);
-      n[0] /= nn; n[1] /= nn; n[2] /= nn;
+  for(iF=0;iF<nF;iF++) {
+    for(i=faceFirst[iF];i<faceFirst[iF+1]-1;i++) {
+      iV = coordIndex[i];
+      x0 = normal[3*iV  ];
+      x1 = normal[3*iV+1];
+      x2 = normal[3*iV+2];
+      normal[3*iV  ] = x0+faceNormal[3*iF  ];
+      normal[3*iV+1] = x1+faceNormal[3*iF+1];
+      normal[3*iV+2] = x2+faceNormal[3*iF+2];
     }
-    normal[3*iV  ] = n[0];
-    normal[3*iV+1] = n[1];
-    normal[3*iV+2] = n[2];
   }
+  _parallelFor(nV,nThreads,[&normal](int iV0, int iV1) {
+      Vec3f n;
+      for(int iV=iV0;iV<iV1;iV++) {
+        n[0] = normal[3*iV  ];
+        n[1] = normal[3*iV+1];
+        n[2] = normal[3*iV+2];
+        float nn = n[0]*n[0]+n[1]*n[1]+n[2]*n[2];
+        if(nn>0.0f) {
+          nn = (float)sqrt(nn);
+          n[0] /= nn; n[1] /= nn; n[2] /= nn;
+        }
+        normal[3*iV  ] = n[0];
+        normal[3*iV+1] = n[1];
+        normal[3*iV+2] = n[2];
+      }
+    });
 }
 
-void SceneGraphProcessor::_computeNormalPerCorner(IndexedFaceSet& ifs) {
+void SceneGraphProcessor::_computeNormalPerCorner(IndexedFaceSet& ifs, int /*nThreads*/) {
   if(ifs.getNormalBinding()==IndexedFaceSet::PB_PER_CORNER) return;
 
-  vector<float>& coord       = ifs.getCoord();
+  vector<float>  tmpCoord;
+  const vector<float>& coord = ifs.readCoord(tmpCoord);
   vector<int>&   coordIndex  = ifs.getCoordIndex();
   vector<float>& normal      = ifs.getNormal();
   vector<int>&   normalIndex = ifs.getNormalIndex();
@@ -334,6 +484,279 @@ void SceneGraphProcessor::_computeNormalPerCorner(IndexedFaceSet& ifs) {
   }
 }
 
+// vertices are sorted along a Morton (Z-order) curve computed over the
+// bounding box of the coordinates; the permutation is applied to the
+// coord array, to the per-vertex normal, color, and texCoord arrays,
+// and to the values of the coordIndex array
+
+// spread the 10 lower bits of x so that there are two zeros between
+// consecutive bits
+static unsigned _mortonSpread(unsigned x) {
+  x &= 0x000003ff;
+  x = (x | (x<<16)) & 0xff0000ff;
+  x = (x | (x<< 8)) & 0x0300f00f;
+  x = (x | (x<< 4)) & 0x030c30c3;
+  x = (x | (x<< 2)) & 0x09249249;
+  return x;
+}
+
+// permute the nV records of size dim stored in value, so that record
+// newToOld[iV] is moved to position iV
+static void _permuteRecords
+(vector<float>& value, const int dim, const vector<int>& newToOld) {
+  int nV = static_cast<int>(newToOld.size());
+  if(static_cast<int>(value.size())!=dim*nV) return;
+  vector<float> tmp(value.size());
+  for(int iV=0;iV<nV;iV++)
+    for(int k=0;k<dim;k++)
+      tmp[dim*iV+k] = value[dim*newToOld[iV]+k];
+  value.swap(tmp);
+}
+
+void SceneGraphProcessor::_reorderVertices(IndexedFaceSet& ifs, int /*nThreads*/) {
+  vector<float>& coord      = ifs.getCoord();
+  vector<int>&   coordIndex = ifs.getCoordIndex();
+  int nV = static_cast<int>(coord.size()/3);
+  if(nV<2) return;
+
+  int iV,k;
+  float xMin[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+  float xMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for(iV=0;iV<nV;iV++)
+    for(k=0;k<3;k++) {
+      float x = coord[3*iV+k];
+      if(x<xMin[k]) xMin[k] = x;
+      if(x>xMax[k]) xMax[k] = x;
+    }
+  // use the same scale along the three axes
+  float side = std::max(xMax[0]-xMin[0],std::max(xMax[1]-xMin[1],xMax[2]-xMin[2]));
+  float scale = (side>0.0f)?1023.0f/side:0.0f;
+
+  vector<unsigned> code(nV);
+  for(iV=0;iV<nV;iV++) {
+    unsigned q[3];
+    for(k=0;k<3;k++)
+      q[k] = static_cast<unsigned>((coord[3*iV+k]-xMin[k])*scale+0.5f);
+    code[iV] =
+      (_mortonSpread(q[0])<<2)|(_mortonSpread(q[1])<<1)|_mortonSpread(q[2]);
+  }
+
+  vector<int> newToOld(nV);
+  for(iV=0;iV<nV;iV++) newToOld[iV] = iV;
+  std::stable_sort(newToOld.begin(),newToOld.end(),
+                   [&code](int a, int b) { return code[a]<code[b]; });
+  vector<int> oldToNew(nV);
+  for(iV=0;iV<nV;iV++) oldToNew[newToOld[iV]] = iV;
+
+  _permuteRecords(coord,3,newToOld);
+  if(ifs.getNormalBinding()==IndexedFaceSet::PB_PER_VERTEX)
+    _permuteRecords(ifs.getNormal(),3,newToOld);
+  if(ifs.getColorBinding()==IndexedFaceSet::PB_PER_VERTEX)
+    _permuteRecords(ifs.getColor(),3,newToOld);
+  if(ifs.getTexCoordBinding()==IndexedFaceSet::PB_PER_VERTEX)
+    _permuteRecords(ifs.getTexCoord(),2,newToOld);
+
+  for(int& i : coordIndex)
+    if(0<=i && i<nV) i = oldToNew[i];
+
+  // the vertex properties left in the ply cannot follow the new order
+  if(ifs.getType()=="IndexedFaceSetPly")
+    ((IndexedFaceSetPly&)ifs).dropUnusedProperties("vertex");
+}
+
+// faces are sorted to maximize the hit rate of a post-transform
+// vertex cache, using the greedy algorithm described by T. Forsyth,
+// "Linear-Speed Vertex Cache Optimisation" (2006), extended to
+// polygonal faces; the permutation is applied to the coordIndex array,
+// to the per-corner index arrays, and to the per-face normal and color
+// arrays or index arrays
+
+static const int   FORSYTH_CACHE_SIZE   = 32;
+static const float FORSYTH_DECAY_POWER  = 1.5f;
+static const float FORSYTH_LAST_SCORE   = 0.75f;
+static const float FORSYTH_BOOST_SCALE  = 2.0f;
+static const float FORSYTH_BOOST_POWER  = 0.5f;
+
+static const int   FORSYTH_MAX_VALENCE  = 64;
+
+// the scores only depend on the cache position and on the number of
+// faces not yet emitted, and are tabulated
+class _ForsythScores {
+public:
+  float _cache[FORSYTH_CACHE_SIZE];
+  float _valence[FORSYTH_MAX_VALENCE];
+  _ForsythScores() {
+    for(int i=0;i<FORSYTH_CACHE_SIZE;i++) {
+      if(i<3) {
+        // vertices of the last face emitted
+        _cache[i] = FORSYTH_LAST_SCORE;
+      } else {
+        float s = 1.0f-(float)(i-3)/(float)(FORSYTH_CACHE_SIZE-3);
+        _cache[i] = (float)pow(s,FORSYTH_DECAY_POWER);
+      }
+    }
+    _valence[0] = 0.0f;
+    for(int i=1;i<FORSYTH_MAX_VALENCE;i++)
+      _valence[i] = FORSYTH_BOOST_SCALE*(float)pow((float)i,-FORSYTH_BOOST_POWER);
+  }
+};
+
+static float _forsythVertexScore(const int cachePos, const int valence) {
+  static const _ForsythScores scores;
+  if(valence<=0) return -1.0f;
+  float score = (cachePos>=0)?scores._cache[cachePos]:0.0f;
+  score += (valence<FORSYTH_MAX_VALENCE)?scores._valence[valence]:
+    FORSYTH_BOOST_SCALE*(float)pow((float)valence,-FORSYTH_BOOST_POWER);
+  return score;
+}
+
+// reorder the blocks of a per-corner array following the face order
+static void _permuteCorners
+(vector<int>& index, const vector<int>& faceFirst,
+ const vector<int>& faceOrder, const int nCorners) {
+  if(static_cast<int>(index.size())<nCorners) return;
+  vector<int> tmp;
+  tmp.reserve(index.size());
+  for(int iF : faceOrder)
+    for(int i=faceFirst[iF];i<faceFirst[iF+1];i++)
+      tmp.push_back(index[i]);
+  // anything after the last face separator is left unchanged
+  tmp.insert(tmp.end(),index.begin()+nCorners,index.end());
+  index.swap(tmp);
+}
+
+void SceneGraphProcessor::_reorderFaces(IndexedFaceSet& ifs, int /*nThreads*/) {
+  vector<float>& coord      = ifs.getCoord();
+  vector<int>&   coordIndex = ifs.getCoordIndex();
+  int nV = static_cast<int>(coord.size()/3);
+
+  // faceFirst[iF] is the first corner of face iF, including the -1
+  // separator of the previous face; faceFirst[nF] is the number of
+  // corners covered by complete faces
+  vector<int> faceFirst;
+  int iC,iF,iV,nC = static_cast<int>(coordIndex.size());
+  faceFirst.push_back(0);
+  for(iC=0;iC<nC;iC++)
+    if(coordIndex[iC]<0)
+      faceFirst.push_back(iC+1);
+  int nF = static_cast<int>(faceFirst.size())-1;
+  if(nF<2 || nV<1) return;
+  int nCorners = faceFirst[nF];
+
+  // vertex to face incidence lists
+  vector<int> valence(nV,0);
+  for(iC=0;iC<nCorners;iC++)
+    if(0<=(iV=coordIndex[iC]) && iV<nV) valence[iV]++;
+  vector<int> vFirst(nV+1,0);
+  for(iV=0;iV<nV;iV++) vFirst[iV+1] = vFirst[iV]+valence[iV];
+  vector<int> vFace(vFirst[nV]);
+  vector<int> vNext(vFirst.begin(),vFirst.end()-1);
+  for(iF=0;iF<nF;iF++)
+    for(iC=faceFirst[iF];iC<faceFirst[iF+1];iC++)
+      if(0<=(iV=coordIndex[iC]) && iV<nV) vFace[vNext[iV]++] = iF;
+
+  vector<int>   cachePos(nV,-1);
+  vector<float> vScore(nV);
+  for(iV=0;iV<nV;iV++)
+    vScore[iV] = _forsythVertexScore(-1,valence[iV]);
+  vector<float> fScore(nF,0.0f);
+  for(iF=0;iF<nF;iF++)
+    for(iC=faceFirst[iF];iC<faceFirst[iF+1];iC++)
+      if(0<=(iV=coordIndex[iC]) && iV<nV) fScore[iF] += vScore[iV];
+
+  vector<bool> emitted(nF,false);
+  vector<int>  faceOrder;
+  faceOrder.reserve(nF);
+  vector<int>  cache,newCache,touched;
+  int bestF  = -1;
+  int cursor = 0;
+  while(static_cast<int>(faceOrder.size())<nF) {
+    if(bestF<0) {
+      // nothing useful in the cache; continue with the next face in
+      // the original order
+      while(emitted[cursor]) cursor++;
+      bestF = cursor;
+    }
+    faceOrder.push_back(bestF);
+    emitted[bestF] = true;
+
+    // the vertices of the emitted face move to the front of the cache
+    newCache.clear();
+    for(iC=faceFirst[bestF];iC<faceFirst[bestF+1];iC++)
+      if(0<=(iV=coordIndex[iC]) && iV<nV) {
+        valence[iV]--;
+        if(std::find(newCache.begin(),newCache.end(),iV)==newCache.end())
+          newCache.push_back(iV);
+      }
+    for(int jV : cache)
+      if(std::find(newCache.begin(),newCache.end(),jV)==newCache.end())
+        newCache.push_back(jV);
+    touched.clear();
+    for(int j=0;j<static_cast<int>(newCache.size());j++) {
+      iV = newCache[j];
+      cachePos[iV] = (j<FORSYTH_CACHE_SIZE)?j:-1;
+      touched.push_back(iV);
+    }
+    if(static_cast<int>(newCache.size())>FORSYTH_CACHE_SIZE)
+      newCache.resize(FORSYTH_CACHE_SIZE);
+    cache.swap(newCache);
+
+    // update the scores of the affected vertices and faces, and
+    // select the best face incident to them
+    for(int jV : touched) {
+      float score = _forsythVertexScore(cachePos[jV],valence[jV]);
+      float delta = score-vScore[jV];
+      vScore[jV]  = score;
+      for(int j=vFirst[jV];j<vFirst[jV+1];j++)
+        if(emitted[vFace[j]]==false) fScore[vFace[j]] += delta;
+    }
+    bestF = -1;
+    float bestScore = -FLT_MAX;
+    for(int jV : cache)
+      for(int j=vFirst[jV];j<vFirst[jV+1];j++) {
+        iF = vFace[j];
+        if(emitted[iF]==false && fScore[iF]>bestScore) {
+          bestScore = fScore[iF]; bestF = iF;
+        }
+      }
+  }
+
+  // apply the face permutation to the per-face arrays
+  IndexedFaceSet::Binding nb = ifs.getNormalBinding();
+  IndexedFaceSet::Binding cb = ifs.getColorBinding();
+  if(nb==IndexedFaceSet::PB_PER_FACE)
+    _permuteRecords(ifs.getNormal(),3,faceOrder);
+  if(nb==IndexedFaceSet::PB_PER_FACE_INDEXED &&
+     static_cast<int>(ifs.getNormalIndex().size())==nF) {
+    vector<int>& normalIndex = ifs.getNormalIndex();
+    vector<int>  tmp(nF);
+    for(iF=0;iF<nF;iF++) tmp[iF] = normalIndex[faceOrder[iF]];
+    normalIndex.swap(tmp);
+  }
+  if(cb==IndexedFaceSet::PB_PER_FACE)
+    _permuteRecords(ifs.getColor(),3,faceOrder);
+  if(cb==IndexedFaceSet::PB_PER_FACE_INDEXED &&
+     static_cast<int>(ifs.getColorIndex().size())==nF) {
+    vector<int>& colorIndex = ifs.getColorIndex();
+    vector<int>  tmp(nF);
+    for(iF=0;iF<nF;iF++) tmp[iF] = colorIndex[faceOrder[iF]];
+    colorIndex.swap(tmp);
+  }
+
+  // and to the per-corner arrays
+  if(nb==IndexedFaceSet::PB_PER_CORNER)
+    _permuteCorners(ifs.getNormalIndex(),faceFirst,faceOrder,nCorners);
+  if(cb==IndexedFaceSet::PB_PER_CORNER)
+    _permuteCorners(ifs.getColorIndex(),faceFirst,faceOrder,nCorners);
+  if(ifs.getTexCoordBinding()==IndexedFaceSet::PB_PER_CORNER)
+    _permuteCorners(ifs.getTexCoordIndex(),faceFirst,faceOrder,nCorners);
+  _permuteCorners(coordIndex,faceFirst,faceOrder,nCorners);
+
+  // the face properties left in the ply cannot follow the new order
+  if(ifs.getType()=="IndexedFaceSetPly")
+    ((IndexedFaceSetPly&)ifs).dropUnusedProperties("face");
+}
+
 void SceneGraphProcessor::bboxAdd
 (int depth, float scale, bool isCube) {
   const string name = "BOUNDING-BOX";
@@ -484,97 +907,305 @@ void SceneGraphProcessor::bboxRemove() {
   for(i=children.begin();i!=children.end();i++)
     if((*i)->nameEquals("BOUNDING-BOX"))
       break;
-  if(i!=children.end())
+  if(i!=children.end()) {
     children.erase(i);
+    Node::structureChanged();
+  }
 }
 
-void SceneGraphProcessor::edgesAdd() {
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  const Node* node;
-  while((node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape  = (Shape*)node;
-      const Node* parent = shape->getParent();
-      Group* group = (Group*)parent;
+// one edge of the faces of an IndexedFaceSet, added to the EDGES
+// IndexedLineSet; _corner is the first corner iC found for the edge,
+// which goes from the vertex of the previous corner of the face to
+// coordIndex[iC]
+class EdgeRecord {
+public:
+  int _corner;
+  int _iV0;
+  int _iV1;
+};
+
+// one edge of a face, with the smaller vertex index first, found at
+// corner _corner of face _face
+class FaceEdgeRecord {
+public:
+  int _iV0;
+  int _iV1;
+  int _corner;
+  int _face;
+};
+
+// first vertex of the range of smaller vertex indices of the edges
+// assigned to bucket iB; the vertex iV belongs to bucket
+// (iV*nBuckets)/nV
+static inline int _bucketFirst(const int iB, const int nBuckets, const int nV) {
+  return static_cast<int>
+    ((static_cast<long>(nV)*iB+nBuckets-1)/nBuckets);
+}
 
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->isIndexedFaceSet()) {
-        IndexedFaceSet* ifs = (IndexedFaceSet*)node;
-
-        shape->setShow(false);
-
-        // compose the node name ???
-        string name = "EDGES";
-        node = group->getChild(name);
-        if(node==(Node*)0) {
-          shape = new Shape();
-          shape->setName(name);
-          Appearance* appearance = new Appearance();
-          shape->setAppearance(appearance);
-          Material* material = new Material();
-          // colors should be stored in WrlViewerData
-          Color edgeColor(1.0f,0.5f,0.0f);
-          material->setDiffuseColor(edgeColor);
-          appearance->setMaterial(material);
-          group->addChild(shape);
-        } else if(node->isShape()) {
-          shape = (Shape*)node;
-        } else /* if(node!=(Node*)0 && node->isShape()==false */ {
-          // throw exception ???
-        }
-        if(shape==(Shape*)0) { /* throw exception ??? */ return; }
-
-        IndexedLineSet* ils = (IndexedLineSet*)0;
-        node = shape->getGeometry();
-        if(node==(Node*)0) {
-          ils = new IndexedLineSet();
-          shape->setGeometry(ils);
-        } else if(node->isIndexedLineSet()) {
-          ils = (IndexedLineSet*)node;
-        } else /* if(node!=(Node*)0 && node->isIndexedLineSet()==false) */ {
-          // throw exception ???
+// appends to faceEdge[iB] the edges of the faces [iF0,iF1) of ifs whose
+// smaller vertex index belongs to bucket iB, in corner order
+static void _faceEdges
+(IndexedFaceSet& ifs, const vector<int>& faceFirst,
+ const int iF0, const int iF1, vector<FaceEdgeRecord>* faceEdge,
+ const int nBuckets) {
+  vector<int>& coordIndex = ifs.getCoordIndex();
+  int          nV         = ifs.getNumberOfCoord();
+  int iF,iC,iC0,iC1,jV0,jV1;
+  FaceEdgeRecord e;
+  for(iF=iF0;iF<iF1;iF++) {
+    iC0 = faceFirst[iF];
+    iC1 = faceFirst[iF+1]-1;
+    for(iC=iC0;iC<iC1;iC++) {
+      jV0 = coordIndex[(iC==iC0)?iC1-1:iC-1];
+      jV1 = coordIndex[iC];
+      if(jV0<0 || jV1<0 || jV0>=nV || jV1>=nV || jV0==jV1) continue;
+      e._iV0    = (jV0<jV1)?jV0:jV1;
+      e._iV1    = (jV0<jV1)?jV1:jV0;
+      e._corner = iC;
+      e._face   = iF;
+      faceEdge[(static_cast<long>(e._iV0)*nBuckets)/nV].push_back(e);
+    }
+  }
+}
+
+// appends to edge the unique edges of bucket iB selected by edges and
+// cosFeature, given the edges found in each part of the faces, in
+// corner order; the normals of the faces are only used to select the
+// regular edges
+static void _uniqueEdges
+(IndexedFaceSet& ifs, const vector<int>& faceFirst,
+ const vector<float>& faceNormal, const int edges, const float cosFeature,
+ vector<vector<FaceEdgeRecord>>& faceEdge, const int iB, const int nBuckets,
+ vector<EdgeRecord>& edge) {
+  vector<int>& coordIndex = ifs.getCoordIndex();
+  int          nV         = ifs.getNumberOfCoord();
+  int          nParts     = static_cast<int>(faceEdge.size())/nBuckets;
+  int          iV0        = _bucketFirst(iB,nBuckets,nV);
+  int          iV1        = _bucketFirst(iB+1,nBuckets,nV);
+
+  // sort the face edges by smaller vertex index, keeping the corner
+  // order, and then each group by larger vertex index
+  vector<int> first(iV1-iV0+1,0);
+  int iPart,iV;
+  for(iPart=0;iPart<nParts;iPart++)
+    for(FaceEdgeRecord& e : faceEdge[iPart*nBuckets+iB])
+      first[e._iV0-iV0+1]++;
+  for(iV=iV0;iV<iV1;iV++)
+    first[iV-iV0+1] += first[iV-iV0];
+  vector<FaceEdgeRecord> sorted(first[iV1-iV0]);
+  vector<int> next(first.begin(),first.end()-1);
+  for(iPart=0;iPart<nParts;iPart++) {
+    vector<FaceEdgeRecord>& part = faceEdge[iPart*nBuckets+iB];
+    for(FaceEdgeRecord& e : part)
+      sorted[next[e._iV0-iV0]++] = e;
+    vector<FaceEdgeRecord>().swap(part);
+  }
+
+  int i,j,k,iC,iF,nFaces;
+  for(iV=iV0;iV<iV1;iV++) {
+    i = first[iV-iV0];
+    k = first[iV-iV0+1];
+    if(k-i>1)
+      stable_sort(sorted.begin()+i,sorted.begin()+k,
+                  [](const FaceEdgeRecord& a, const FaceEdgeRecord& b) {
+                    return a._iV1<b._iV1; });
+    for(;i<k;i=j) {
+      for(j=i+1;j<k && sorted[j]._iV1==sorted[i]._iV1;j++);
+      nFaces = j-i;
+      if(nFaces==1) {
+        if((edges & SceneGraphProcessor::EDGES_BOUNDARY)==0) continue;
+      } else if(nFaces>2) {
+        if((edges & SceneGraphProcessor::EDGES_SINGULAR)==0) continue;
+      } else {
+        if((edges & SceneGraphProcessor::EDGES_REGULAR)==0) continue;
+        if(faceNormal.size()>0) {
+          const float* n0 = &faceNormal[3*sorted[i  ]._face];
+          const float* n1 = &faceNormal[3*sorted[i+1]._face];
+          if(n0[0]*n1[0]+n0[1]*n1[1]+n0[2]*n1[2]>cosFeature) continue;
         }
-        
-        if(ils==(IndexedLineSet*)0) { /* throw exception ??? */ return; }
+      }
+      iC = sorted[i]._corner;
+      iF = sorted[i]._face;
+      EdgeRecord e;
+      e._corner = iC;
+      e._iV0    = coordIndex[(iC==faceFirst[iF])?faceFirst[iF+1]-2:iC-1];
+      e._iV1    = coordIndex[iC];
+      edge.push_back(e);
+    }
+  }
+}
 
-        ils->clear();
+// fills ils with the selected unique edges of the faces of ifs; big
+// meshes are split among nThreads threads, first by faces, to find the
+// edges of the faces, and then by the smaller vertex index of the
+// edges, to find the unique edges; the edges are sorted by their first
+// corner, so that the result does not depend on the number of threads;
+// only the vertices of the selected edges are copied
+void SceneGraphProcessor::_edgesAdd
+(IndexedFaceSet& ifs, IndexedLineSet& ils,
+ int edges, float featureAngle, int nThreads) {
+  vector<float>  tmpCoord;
+  const vector<float>& coordIfs = ifs.readCoord(tmpCoord);
+  vector<int>&   coordIndexIfs = ifs.getCoordIndex();
+  int            nV            = ifs.getNumberOfCoord();
+
+  ils.clear();
+
+  vector<int> faceFirst;
+  _faceFirst(coordIndexIfs,faceFirst);
+  int nF = static_cast<int>(faceFirst.size())-1;
+
+  // unit face normals, only needed to select the feature edges
+  vector<float> faceNormal;
+  float cosFeature = 1.0f;
+  if((edges & SceneGraphProcessor::EDGES_REGULAR) && featureAngle>0.0f) {
+    cosFeature = cosf(featureAngle);
+    faceNormal.resize(3*nF);
+    _parallelFor(nF,nThreads,[&](int iF0, int iF1) {
+        Vec3f n;
+        for(int iF=iF0;iF<iF1;iF++) {
+          _computeFaceNormal
+            (coordIfs,coordIndexIfs,faceFirst[iF],faceFirst[iF+1]-1,n,true);
+          faceNormal[3*iF  ] = n[0];
+          faceNormal[3*iF+1] = n[1];
+          faceNormal[3*iF+2] = n[2];
+        }
+      });
+  }
 
-        vector<float>& coordIfs      = ifs->getCoord();
-        vector<int>&   coordIndexIfs = ifs->getCoordIndex();
+  if(nThreads>nV) nThreads = nV;
+  if(nThreads>nF) nThreads = nF;
+  if(nThreads<1)  nThreads = 1;
+  // the edges of the faces of each part, in one bucket per thread
+  vector<vector<FaceEdgeRecord>> faceEdge(nThreads*nThreads);
+  if(nV>0)
+    _parallelFor(nThreads,nThreads,[&](int i0, int i1) {
+        for(int i=i0;i<i1;i++) {
+          int iF0 = static_cast<int>((static_cast<long>(nF)*i)/nThreads);
+          int iF1 = static_cast<int>((static_cast<long>(nF)*(i+1))/nThreads);
+          _faceEdges(ifs,faceFirst,iF0,iF1,&faceEdge[i*nThreads],nThreads);
+        }
+      });
+  vector<vector<EdgeRecord>> part(nThreads);
+  if(nV>0)
+    _parallelFor(nThreads,nThreads,[&](int i0, int i1) {
+        for(int i=i0;i<i1;i++)
+          _uniqueEdges(ifs,faceFirst,faceNormal,edges,cosFeature,
+                       faceEdge,i,nThreads,part[i]);
+      });
+  vector<EdgeRecord> edge;
+  for(int i=0;i<nThreads;i++)
+    edge.insert(edge.end(),part[i].begin(),part[i].end());
+  sort(edge.begin(),edge.end(),
+       [](const EdgeRecord& a, const EdgeRecord& b) {
+         return a._corner<b._corner; });
+
+  // copy the vertices used by the edges, in their original order
+  vector<int> vertexMap(nV,-1);
+  for(EdgeRecord& e : edge)
+    vertexMap[e._iV0] = vertexMap[e._iV1] = 0;
+  vector<float>& coordIls = ils.getCoord();
+  int iV,nVIls = 0;
+  for(iV=0;iV<nV;iV++)
+    if(vertexMap[iV]==0)
+      vertexMap[iV] = nVIls++;
+  coordIls.resize(3*nVIls);
+  for(iV=0;iV<nV;iV++) {
+    if(vertexMap[iV]>=0) {
+      coordIls[3*vertexMap[iV]  ] = coordIfs[3*iV  ];
+      coordIls[3*vertexMap[iV]+1] = coordIfs[3*iV+1];
+      coordIls[3*vertexMap[iV]+2] = coordIfs[3*iV+2];
+    }
+  }
 
-        vector<float>& coordIls      = ils->getCoord();
-        vector<int>&   coordIndexIls = ils->getCoordIndex();
+  vector<int>& coordIndexIls = ils.getCoordIndex();
+  coordIndexIls.resize(3*edge.size());
+  int i = 0;
+  for(EdgeRecord& e : edge) {
+    coordIndexIls[i++] = vertexMap[e._iV0];
+    coordIndexIls[i++] = vertexMap[e._iV1];
+    coordIndexIls[i++] = -1;
+  }
+}
 
-        coordIls.insert(coordIls.end(),
-                        coordIfs.begin(),coordIfs.end());
+// the EDGES shapes are created serially, and their IndexedLineSet
+// nodes filled by a pool of threads
+void SceneGraphProcessor::edgesAdd(int edges, float featureAngle) {
+  vector<IndexedFaceSet*> ifsList;
+  vector<IndexedLineSet*> ilsList;
+  vector<long>            size;
 
-        int i,i0,i1,nV,iV,iV0,iV1,iF;
-        nV = static_cast<int>(coordIfs.size()/3);
-        for(iV=0;iV<nV;iV++) {
-          coordIls.push_back(coordIfs[3*iV  ]);
-          coordIls.push_back(coordIfs[3*iV+1]);
-          coordIls.push_back(coordIfs[3*iV+2]);
-        }
+  vector<Shape*> shapeList;
+  SceneGraphTraversal traversal(_wrl);
+  traversal.start();
+  const Node* node;
+  while((node=traversal.next())!=(Node*)0) {
+    if(node->isShape()) {
+      Shape* shape = (Shape*)node;
+      node = shape->getGeometry();
+      if(node!=(Node*)0 && node->isIndexedFaceSet())
+        shapeList.push_back(shape);
+    }
+  }
 
-        for(iF=i0=i1=0;i1<(int)coordIndexIfs.size();i1++) {
-          if(coordIndexIfs[i1]<0) {
-            iV0 = coordIndexIfs[i1-1];
-            for(i=i0;i<i1;i++) {
-              iV1 = coordIndexIfs[i];
-              coordIndexIls.push_back(iV0);
-              coordIndexIls.push_back(iV1);
-              coordIndexIls.push_back(-1);
-              iV0 = iV1;
-            }
-            iF++; i0 = i1+1;
-          }
-        }
+  for(Shape* shape : shapeList) {
+    const Node* parent = shape->getParent();
+    Group* group = (Group*)parent;
+    IndexedFaceSet* ifs = (IndexedFaceSet*)(shape->getGeometry());
+
+    shape->setShow(false);
+
+    // compose the node name ???
+    string name = "EDGES";
+    node = group->getChild(name);
+    if(node==(Node*)0) {
+      shape = new Shape();
+      shape->setName(name);
+      Appearance* appearance = new Appearance();
+      shape->setAppearance(appearance);
+      Material* material = new Material();
+      // colors should be stored in WrlViewerData
+      Color edgeColor(1.0f,0.5f,0.0f);
+      material->setDiffuseColor(edgeColor);
+      appearance->setMaterial(material);
+      group->addChild(shape);
+    } else if(node->isShape()) {
+      shape = (Shape*)node;
+    } else /* if(node!=(Node*)0 && node->isShape()==false */ {
+      // throw exception ???
+      continue;
+    }
 
+    IndexedLineSet* ils = (IndexedLineSet*)0;
+    node = shape->getGeometry();
+    if(node==(Node*)0) {
+      ils = new IndexedLineSet();
+      shape->setGeometry(ils);
+    } else if(node->isIndexedLineSet()) {
+      ils = (IndexedLineSet*)node;
+    } else /* if(node!=(Node*)0 && node->isIndexedLineSet()==false) */ {
+      // throw exception ???
+      continue;
+    }
 
+    // a group with several shapes has a single EDGES shape, which
+    // keeps the edges of the last one, as before
+    for(size_t j=0;j<ilsList.size();j++)
+      if(ilsList[j]==ils) {
+        ilsList.erase(ilsList.begin()+j);
+        ifsList.erase(ifsList.begin()+j);
+        size.erase(size.begin()+j);
+        break;
       }
-    }
+    ifsList.push_back(ifs);
+    ilsList.push_back(ils);
+    size.push_back(_size(*ifs));
   }
+
+  _parallelJobs(size,_getNumberOfThreads(),
+                [&ifsList,&ilsList,edges,featureAngle](int i, int nThreads) {
+      _edgesAdd(*ifsList[i],*ilsList[i],edges,featureAngle,nThreads);
+    });
 }
 
 void SceneGraphProcessor::edgesRemove() {
@@ -594,6 +1225,7 @@ void SceneGraphProcessor::edgesRemove() {
             break;
         if(i!=children.end()) {
           children.erase(i);
+          Node::structureChanged();
           i=children.begin();
         }
       } while(i!=children.end());
@@ -602,61 +1234,41 @@ void SceneGraphProcessor::edgesRemove() {
 }
 
 void SceneGraphProcessor::shapeIndexedFaceSetShow() {
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while((node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->isIndexedFaceSet()) {
-        shape->setShow(true);
-      }
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  for(Shape* shape : shapes) {
+    Node* node = shape->getGeometry();
+    if(node!=(Node*)0 && node->isIndexedFaceSet()) {
+      shape->setShow(true);
     }
   }
 }
 
 void SceneGraphProcessor::shapeIndexedFaceSetHide() {
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while((node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->isIndexedFaceSet()) {
-        shape->setShow(false);
-      }
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  for(Shape* shape : shapes) {
+    Node* node = shape->getGeometry();
+    if(node!=(Node*)0 && node->isIndexedFaceSet()) {
+      shape->setShow(false);
     }
   }
 }
 
 void SceneGraphProcessor::shapeIndexedLineSetShow() {
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while((node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->isIndexedLineSet()) {
-        shape->setShow(true);
-      }
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  for(Shape* shape : shapes) {
+    Node* node = shape->getGeometry();
+    if(node!=(Node*)0 && node->isIndexedLineSet()) {
+      shape->setShow(true);
     }
   }
 }
 
 void SceneGraphProcessor::shapeIndexedLineSetHide() {
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while((node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      node = shape->getGeometry();
-      if(node!=(Node*)0 && node->isIndexedLineSet()) {
-        shape->setShow(false);
-      }
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  for(Shape* shape : shapes) {
+    Node* node = shape->getGeometry();
+    if(node!=(Node*)0 && node->isIndexedLineSet()) {
+      shape->setShow(false);
     }
   }
 }
@@ -665,51 +1277,53 @@ bool SceneGraphProcessor::hasBBox() {
   return _wrl.getChild("BOUNDING-BOX")!=(Node*)0;
 }
 
+// the queries are split among several threads for scenes with a very
+// large number of shapes; the threads stop as soon as one of them
+// finds a shape with the property
+
 bool SceneGraphProcessor::_hasShapeProperty(Shape::Property p) {
-  bool value = false;
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while(value==false && (node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape& shape = *(Shape*)node;
-      value = p(shape);
-    }
-  }
+  atomic<bool> value(false);
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  int nShapes  = static_cast<int>(shapes.size());
+  int nThreads = min(_getNumberOfThreads(),nShapes/PARALLEL_MIN_QUERIES);
+  _parallelFor(nShapes,nThreads,[&](int i0, int i1) {
+      for(int i=i0;value==false && i<i1;i++)
+        if(p(*shapes[i])) value = true;
+    });
   return value;
 }
 
 bool SceneGraphProcessor::_hasIndexedFaceSetProperty(IndexedFaceSet::Property p) {
-  bool value = false;
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while(value==false && (node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      if(shape->hasGeometryIndexedFaceSet()) {
-        IndexedFaceSet& ifs = *(IndexedFaceSet*)(shape->getGeometry());
-        value = p(ifs);
+  atomic<bool> value(false);
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  int nShapes  = static_cast<int>(shapes.size());
+  int nThreads = min(_getNumberOfThreads(),nShapes/PARALLEL_MIN_QUERIES);
+  _parallelFor(nShapes,nThreads,[&](int i0, int i1) {
+      for(int i=i0;value==false && i<i1;i++) {
+        Shape* shape = shapes[i];
+        if(shape->hasGeometryIndexedFaceSet()) {
+          IndexedFaceSet& ifs = *(IndexedFaceSet*)(shape->getGeometry());
+          if(p(ifs)) value = true;
+        }
       }
-    }
-  }
+    });
   return value;
 }
 
 bool SceneGraphProcessor::_hasIndexedLineSetProperty(IndexedLineSet::Property p) {
-  bool value = false;
-  SceneGraphTraversal traversal(_wrl);
-  traversal.start();
-  Node* node;
-  while(value==false && (node=traversal.next())!=(Node*)0) {
-    if(node->isShape()) {
-      Shape* shape = (Shape*)node;
-      if(shape->hasGeometryIndexedLineSet()) {
-        IndexedLineSet& ils = *(IndexedLineSet*)(shape->getGeometry());
-        value = p(ils);
+  atomic<bool> value(false);
+  const vector<Shape*>& shapes = _wrl.getIndex().getShapes();
+  int nShapes  = static_cast<int>(shapes.size());
+  int nThreads = min(_getNumberOfThreads(),nShapes/PARALLEL_MIN_QUERIES);
+  _parallelFor(nShapes,nThreads,[&](int i0, int i1) {
+      for(int i=i0;value==false && i<i1;i++) {
+        Shape* shape = shapes[i];
+        if(shape->hasGeometryIndexedLineSet()) {
+          IndexedLineSet& ils = *(IndexedLineSet*)(shape->getGeometry());
+          if(p(ils)) value = true;
+        }
       }
-    }
-  }
+    });
   return value;
 }
 
@@ -887,8 +1501,10 @@ void SceneGraphProcessor::removeSceneGraphChild(const string& name) {
   for(i=children.begin();i!=children.end();i++)
     if((*i)->nameEquals(name))
       break;
-  if(i!=children.end())
+  if(i!=children.end()) {
     children.erase(i);
+    Node::structureChanged();
+  }
 }
 
 void SceneGraphProcessor::pointsRemove() {
@@ -899,6 +1515,416 @@ void SceneGraphProcessor::surfaceRemove() {
   removeSceneGraphChild("SURFACE");
 }
 
+//////////////////////////////////////////////////////////////////////
+// flatten()
+//
+// the shapes are collected from the SceneGraphIndex, one per instance,
+// and grouped by shape layout, i.e., same Material values, texture,
+// show flag, geometry type, fields, and property bindings; the
+// geometry nodes of each group are merged into a single new node,
+// applying the world matrix of each instance to its coordinates and
+// normals; a group with a single instance and an identity matrix keeps
+// its original Shape node
+
+// the property arrays of a geometry node; when geometry nodes are
+// merged, the values of each array are concatenated, and the indices
+// shifted by the number of values of the previous nodes
+class FlatArray {
+public:
+  vector<float>* value;      // null for a compact array not decoded
+  vector<int>*   index;
+  long           nRecords;
+  int            dim;
+  bool           point;      // coordinates, transformed as points
+  bool           normal;     // normals, transformed as normals
+  bool           terminated; // the index uses -1 separators
+};
+
+class FlatPiece {
+public:
+  Shape*         shape;
+  Node*          geometry;
+  float          matrix[16];
+  bool           identity;
+  bool           ccw;        // ccw field of the merged node
+  bool           show;
+  Material*      material;
+  Node*          texture;
+  int            flatShape;
+  long           valueOffset[4]; // in records
+  long           indexOffset[4];
+};
+
+class FlatShape {
+public:
+  int            firstPiece;
+  int            nPieces;
+  Node*          geometry;   // new node; null to keep the shape
+  long           nValue[4];  // in records
+  long           nIndex[4];
+};
+
+// the compact coordinates and colors of an IndexedFaceSet are decoded
+// into decoded[0] and decoded[2] if not null, and otherwise their
+// value is null; the storage of the node does not change
+static int _flatArrays
+(Node* geometry, FlatArray* a /*[4]*/, vector<float>* decoded=nullptr) {
+  int nArrays = 0;
+  if(geometry->isIndexedFaceSet()) {
+    IndexedFaceSet& ifs = *(IndexedFaceSet*)geometry;
+    vector<float>* coord = nullptr;
+    vector<float>* color = nullptr;
+    if(ifs.hasCompactCoord()==false)
+      coord = &ifs.getCoord();
+    else if(decoded!=nullptr) {
+      ifs.readCoord(decoded[0]);
+      coord = &decoded[0];
+    }
+    if(ifs.hasCompactColor()==false)
+      color = &ifs.getColor();
+    else if(decoded!=nullptr) {
+      ifs.readColor(decoded[2]);
+      color = &decoded[2];
+    }
+    a[0] = { coord,              &ifs.getCoordIndex(),    ifs.getNumberOfCoord(),
+             3, true,  false, true };
+    a[1] = { &ifs.getNormal(),   &ifs.getNormalIndex(),   ifs.getNumberOfNormal(),
+             3, false, true,  ifs.getNormalPerVertex() };
+    a[2] = { color,              &ifs.getColorIndex(),    ifs.getNumberOfColor(),
+             3, false, false, ifs.getColorPerVertex() };
+    a[3] = { &ifs.getTexCoord(), &ifs.getTexCoordIndex(), ifs.getNumberOfTexCoord(),
+             2, false, false, true };
+    nArrays = 4;
+  } else if(geometry->isIndexedLineSet()) {
+    IndexedLineSet& ils = *(IndexedLineSet*)geometry;
+    a[0] = { &ils.getCoord(),    &ils.getCoordIndex(),    ils.getNumberOfCoord(),
+             3, true,  false, true };
+    a[1] = { &ils.getColor(),    &ils.getColorIndex(),    ils.getNumberOfColor(),
+             3, false, false, ils.getColorPerVertex() };
+    nArrays = 2;
+  }
+  return nArrays;
+}
+
+// number of values of the index, plus a -1 separator if missing at the
+// end, so that the last face is not merged with the next node
+static long _flatIndexSize(const FlatArray& a) {
+  long n = static_cast<long>(a.index->size());
+  if(a.terminated && n>0 && a.index->back()>=0) n++;
+  return n;
+}
+
+static bool _sameMaterial(Material* a, Material* b) {
+  if(a==b) return true;
+  if(a==(Material*)0 || b==(Material*)0) return false;
+  Color& da = a->getDiffuseColor();  Color& db = b->getDiffuseColor();
+  Color& ea = a->getEmissiveColor(); Color& eb = b->getEmissiveColor();
+  Color  sa = a->getSpecularColor(); Color  sb = b->getSpecularColor();
+  return
+    a->getAmbientIntensity()==b->getAmbientIntensity() &&
+    da.r==db.r && da.g==db.g && da.b==db.b &&
+    ea.r==eb.r && ea.g==eb.g && ea.b==eb.b &&
+    sa.r==sb.r && sa.g==sb.g && sa.b==sb.b &&
+    a->getShininess()==b->getShininess() &&
+    a->getTransparency()==b->getTransparency();
+}
+
+static bool _sameLayout(FlatPiece& a, FlatPiece& b) {
+  if(a.show!=b.show || a.texture!=b.texture ||
+     _sameMaterial(a.material,b.material)==false) return false;
+  if(a.geometry->isIndexedFaceSet()!=b.geometry->isIndexedFaceSet())
+    return false;
+  FlatArray aa[4],ba[4];
+  int nArrays = _flatArrays(a.geometry,aa);
+  _flatArrays(b.geometry,ba);
+  for(int i=0;i<nArrays;i++)
+    if((aa[i].nRecords==0)!=(ba[i].nRecords==0) ||
+       aa[i].index->empty()!=ba[i].index->empty() ||
+       aa[i].terminated!=ba[i].terminated)
+      return false;
+  if(a.geometry->isIndexedFaceSet()) {
+    IndexedFaceSet& ia = *(IndexedFaceSet*)a.geometry;
+    IndexedFaceSet& ib = *(IndexedFaceSet*)b.geometry;
+    if(a.ccw!=b.ccw ||
+       ia.getConvex()!=ib.getConvex() ||
+       ia.getSolid()!=ib.getSolid() ||
+       ia.getCreaseangle()!=ib.getCreaseangle())
+      return false;
+  }
+  return true;
+}
+
+// p |-> M*p, for the points i0<=i<i1; the results are stored in
+// separate memory
+static void _transformPoints
+(const float* M /*[16]*/, const float* src, float* dst, int i0, const int i1) {
+#ifdef FLATTEN_SSE
+  // one point per register; the fourth lane, which overwrites the x
+  // coordinate of the next point, is discarded
+  const __m128 c0 = _mm_setr_ps(M[0],M[4],M[ 8],0.0f);
+  const __m128 c1 = _mm_setr_ps(M[1],M[5],M[ 9],0.0f);
+  const __m128 c2 = _mm_setr_ps(M[2],M[6],M[10],0.0f);
+  const __m128 c3 = _mm_setr_ps(M[3],M[7],M[11],0.0f);
+  for(;i0+1<i1;i0++) {
+    __m128 p = _mm_loadu_ps(src+3*i0);
+    __m128 q =
+      _mm_add_ps(_mm_add_ps(_mm_add_ps
+      (_mm_mul_ps(c0,_mm_shuffle_ps(p,p,_MM_SHUFFLE(0,0,0,0))),
+       _mm_mul_ps(c1,_mm_shuffle_ps(p,p,_MM_SHUFFLE(1,1,1,1)))),
+       _mm_mul_ps(c2,_mm_shuffle_ps(p,p,_MM_SHUFFLE(2,2,2,2)))),c3);
+    _mm_storeu_ps(dst+3*i0,q);
+  }
+#endif
+  for(;i0<i1;i0++) {
+    const float* p = src+3*i0;
+    float*       q = dst+3*i0;
+    for(int k=0;k<3;k++)
+      q[k] = ((M[4*k]*p[0]+M[4*k+1]*p[1])+M[4*k+2]*p[2])+M[4*k+3];
+  }
+}
+
+// n |-> N*n/|N*n|, where N is the inverse transpose of the upper left
+// 3x3 block of M, up to a positive factor
+static void _transformNormals
+(const float* M /*[16]*/, const float* src, float* dst, int i0, const int i1) {
+  // cofactor matrix
+  float N[9] = {
+    M[5]*M[10]-M[6]*M[9], M[6]*M[8]-M[4]*M[10], M[4]*M[9]-M[5]*M[8],
+    M[2]*M[9]-M[1]*M[10], M[0]*M[10]-M[2]*M[8], M[1]*M[8]-M[0]*M[9],
+    M[1]*M[6]-M[2]*M[5],  M[2]*M[4]-M[0]*M[6],  M[0]*M[5]-M[1]*M[4]
+  };
+  float det = M[0]*N[0]+M[1]*N[1]+M[2]*N[2];
+  if(det<0.0f)
+    for(int k=0;k<9;k++) N[k] = -N[k];
+  for(;i0<i1;i0++) {
+    const float* n = src+3*i0;
+    float*       m = dst+3*i0;
+    float x = N[0]*n[0]+N[1]*n[1]+N[2]*n[2];
+    float y = N[3]*n[0]+N[4]*n[1]+N[5]*n[2];
+    float z = N[6]*n[0]+N[7]*n[1]+N[8]*n[2];
+    float nn = x*x+y*y+z*z;
+    if(nn>0.0f) {
+      nn = (float)sqrt(nn);
+      x /= nn; y /= nn; z /= nn;
+    }
+    m[0] = x; m[1] = y; m[2] = z;
+  }
+}
+
+// copies the arrays of the piece into the merged geometry node
+static void _flatWritePiece(FlatPiece& piece, Node* geometry, int nThreads) {
+  FlatArray src[4],dst[4];
+  vector<float> decoded[4];
+  int nArrays = _flatArrays(piece.geometry,src,decoded);
+  _flatArrays(geometry,dst);
+  for(int i=0;i<nArrays;i++) {
+    FlatArray& s = src[i];
+    FlatArray& d = dst[i];
+    int    nRecords = static_cast<int>(s.nRecords);
+    const float* sv = s.value->data();
+    float*       dv = d.value->data()+piece.valueOffset[i]*s.dim;
+    if(piece.identity==false && s.point) {
+      _parallelFor(nRecords,nThreads,[&](int i0, int i1) {
+          _transformPoints(piece.matrix,sv,dv,i0,i1);
+        });
+    } else if(piece.identity==false && s.normal) {
+      _parallelFor(nRecords,nThreads,[&](int i0, int i1) {
+          _transformNormals(piece.matrix,sv,dv,i0,i1);
+        });
+    } else {
+      copy(sv,sv+nRecords*s.dim,dv);
+    }
+    if(s.index->empty()) continue;
+    int          shift = static_cast<int>(piece.valueOffset[i]);
+    const int*   si    = s.index->data();
+    int*         di    = d.index->data()+piece.indexOffset[i];
+    int          nIndex = static_cast<int>(s.index->size());
+    for(int j=0;j<nIndex;j++)
+      di[j] = (si[j]<0)?si[j]:si[j]+shift;
+    if(_flatIndexSize(s)>nIndex)
+      di[nIndex] = -1;
+  }
+}
+
+void SceneGraphProcessor::flatten() {
+  const float I[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+  };
+  SceneGraphIndex& index = _wrl.getIndex();
+  const vector<SceneGraphIndex::Instance>& instance = index.getInstances();
+
+  // number of instances of each shape and geometry node
+  map<Node*,int> nInstances;
+  vector<FlatPiece> piece;
+  for(const SceneGraphIndex::Instance& i : instance) {
+    Node* geometry = i._geometry;
+    if(geometry==(Node*)0 ||
+       (geometry->isIndexedFaceSet()==false &&
+        geometry->isIndexedLineSet()==false)) continue;
+    nInstances[i._shape]++;
+    nInstances[geometry]++;
+    FlatPiece p;
+    p.shape    = i._shape;
+    p.geometry = geometry;
+    copy(i._matrix,i._matrix+16,p.matrix);
+    p.identity = equal(p.matrix,p.matrix+16,I);
+    const float* M = p.matrix;
+    float det =
+      M[0]*(M[5]*M[10]-M[6]*M[9])-
+      M[1]*(M[4]*M[10]-M[6]*M[8])+
+      M[2]*(M[4]*M[9] -M[5]*M[8]);
+    p.ccw = true;
+    if(geometry->isIndexedFaceSet())
+      p.ccw = (((IndexedFaceSet*)geometry)->getCcw())!=(det<0.0f);
+    p.show     = i._show;
+    p.material = i._material;
+    p.texture  = (Node*)0;
+    Node* appearance = i._shape->getAppearance();
+    if(appearance!=(Node*)0 && appearance->isAppearance())
+      p.texture = ((Appearance*)appearance)->getTexture();
+    p.flatShape = -1;
+    piece.push_back(p);
+  }
+  int nPieces = static_cast<int>(piece.size());
+
+  // group the pieces by layout; the pieces of each group are made
+  // contiguous, in the order of their first instance
+  vector<FlatShape> flatShape;
+  vector<vector<int>> member;
+  int iP,iS,i;
+  for(iP=0;iP<nPieces;iP++) {
+    for(iS=0;iS<(int)flatShape.size();iS++)
+      if(_sameLayout(piece[member[iS][0]],piece[iP])) break;
+    if(iS==(int)flatShape.size()) {
+      flatShape.push_back(FlatShape());
+      member.push_back(vector<int>());
+    }
+    member[iS].push_back(iP);
+  }
+  vector<FlatPiece> sorted;
+  sorted.reserve(nPieces);
+  for(iS=0;iS<(int)flatShape.size();iS++) {
+    FlatShape& fs = flatShape[iS];
+    fs.firstPiece = static_cast<int>(sorted.size());
+    fs.nPieces    = static_cast<int>(member[iS].size());
+    fs.geometry   = (Node*)0;
+    for(i=0;i<4;i++) fs.nValue[i] = fs.nIndex[i] = 0;
+    for(int jP : member[iS]) {
+      FlatPiece& p = piece[jP];
+      p.flatShape = iS;
+      FlatArray a[4];
+      int nArrays = _flatArrays(p.geometry,a);
+      for(i=0;i<nArrays;i++) {
+        p.valueOffset[i] = fs.nValue[i];
+        p.indexOffset[i] = fs.nIndex[i];
+        fs.nValue[i] += a[i].nRecords;
+        fs.nIndex[i] += _flatIndexSize(a[i]);
+      }
+      sorted.push_back(p);
+    }
+  }
+  piece.swap(sorted);
+
+  // create the merged geometry nodes
+  for(FlatShape& fs : flatShape) {
+    FlatPiece& p = piece[fs.firstPiece];
+    if(fs.nPieces==1 && p.identity &&
+       nInstances[p.shape]==1 && nInstances[p.geometry]==1) continue;
+    if(p.geometry->isIndexedFaceSet()) {
+      IndexedFaceSet& src = *(IndexedFaceSet*)p.geometry;
+      IndexedFaceSet* ifs = new IndexedFaceSet();
+      ifs->getCcw()            = p.ccw;
+      ifs->getConvex()         = src.getConvex();
+      ifs->getSolid()          = src.getSolid();
+      ifs->getCreaseangle()    = src.getCreaseangle();
+      ifs->setNormalPerVertex(src.getNormalPerVertex());
+      ifs->setColorPerVertex(src.getColorPerVertex());
+      fs.geometry = ifs;
+    } else {
+      IndexedLineSet& src = *(IndexedLineSet*)p.geometry;
+      IndexedLineSet* ils = new IndexedLineSet();
+      ils->setColorPerVertex(src.getColorPerVertex());
+      fs.geometry = ils;
+    }
+    FlatArray a[4];
+    int nArrays = _flatArrays(fs.geometry,a);
+    for(i=0;i<nArrays;i++) {
+      a[i].value->resize(fs.nValue[i]*a[i].dim);
+      a[i].index->resize(fs.nIndex[i]);
+    }
+  }
+
+  // fill the merged geometry nodes in parallel
+  vector<int>  job;
+  vector<long> size;
+  for(iP=0;iP<nPieces;iP++) {
+    if(flatShape[piece[iP].flatShape].geometry==(Node*)0) continue;
+    job.push_back(iP);
+    size.push_back(static_cast<long>(piece[iP].geometry->isIndexedFaceSet()?
+      _size(*(IndexedFaceSet*)piece[iP].geometry):
+      ((IndexedLineSet*)piece[iP].geometry)->getCoord().size()));
+  }
+  _parallelJobs(size,_getNumberOfThreads(),[&](int j, int nThreads) {
+      FlatPiece& p = piece[job[j]];
+      _flatWritePiece(p,flatShape[p.flatShape].geometry,nThreads);
+    });
+
+  // the merged geometry nodes replace all the geometry nodes, except
+  // those of the shapes which are kept
+  set<Node*> merged;
+  for(FlatPiece& p : piece)
+    if(flatShape[p.flatShape].geometry!=(Node*)0)
+      merged.insert(p.geometry);
+
+  // keep the shapes alive while the scene graph is cleared
+  set<Node*> kept;
+  for(FlatShape& fs : flatShape)
+    if(fs.geometry==(Node*)0) {
+      piece[fs.firstPiece].shape->addReference();
+      kept.insert(piece[fs.firstPiece].shape);
+    }
+  // the appearance nodes are not owned by the shapes, and are shared
+  // by the new shapes; their parent is reset if it is deleted
+  vector<Node*> appearance(flatShape.size(),(Node*)0);
+  for(iS=0;iS<(int)flatShape.size();iS++) {
+    appearance[iS] = piece[flatShape[iS].firstPiece].shape->getAppearance();
+    if(appearance[iS]!=(Node*)0 &&
+       kept.find((Node*)appearance[iS]->getParent())==kept.end())
+      appearance[iS]->setParent((Node*)0);
+  }
+  set<string> name;
+  vector<string> shapeName(flatShape.size());
+  for(iS=0;iS<(int)flatShape.size();iS++) {
+    const string& n = piece[flatShape[iS].firstPiece].shape->getName();
+    if(n!="" && name.insert(n).second) shapeName[iS] = n;
+  }
+
+  _wrl.clear();
+  for(Node* geometry : merged)
+    delete geometry;
+
+  for(iS=0;iS<(int)flatShape.size();iS++) {
+    FlatShape& fs = flatShape[iS];
+    FlatPiece& p  = piece[fs.firstPiece];
+    Shape* shape;
+    if(fs.geometry==(Node*)0) {
+      shape = p.shape;
+      shape->removeReference();
+    } else {
+      shape = new Shape();
+      shape->setName(shapeName[iS]);
+      if(appearance[iS]!=(Node*)0)
+        shape->setAppearance(appearance[iS]);
+      shape->setGeometry(fs.geometry);
+    }
+    shape->setShow(p.show);
+    _wrl.addChild(shape);
+  }
+}
+
 IndexedFaceSet* SceneGraphProcessor::_getNamedShapeIFS
 (const string& name, bool create) {
   IndexedFaceSet* ifs = (IndexedFaceSet*)0;
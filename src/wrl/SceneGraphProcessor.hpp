@@ -48,17 +48,38 @@ public:
   SceneGraphProcessor(SceneGraph& wrl);
   ~SceneGraphProcessor();
 
+  // number of threads used to process the geometry nodes; 1 processes
+  // them serially, and nThreads<=0 uses std::thread::hardware_concurrency()
+  static void setNumberOfThreads(const int nThreads);
+  static int  getNumberOfThreads();
+
   void normalClear();
   void normalInvert();
   void computeNormalPerFace();
   void computeNormalPerVertex();
   void computeNormalPerCorner();
 
+  // cache-locality reordering; the geometry is not changed, only the
+  // order in which vertices and faces are stored
+  void reorderVertices();
+  void reorderFaces();
+
   void bboxAdd(int depth=0, float scale=1.0f, bool isCube=true);
   void bboxRemove();
   bool hasBBox();
 
-  void edgesAdd();
+  // the edges of the faces added by edgesAdd(), according to the
+  // number of faces incident to them; each edge is added once, and a
+  // regular edge only if the angle between the normals of its two
+  // faces is at least featureAngle, in radians
+  enum EdgeType {
+    EDGES_BOUNDARY = 0x1, // one face
+    EDGES_REGULAR  = 0x2, // two faces
+    EDGES_SINGULAR = 0x4, // more than two faces
+    EDGES_ALL      = 0x7
+  };
+
+  void edgesAdd(int edges=EDGES_ALL, float featureAngle=0.0f);
   void edgesRemove();
   bool hasEdges();
 
@@ -86,22 +107,42 @@ public:
   void pointsRemove();
   void surfaceRemove();
 
+  // applies the matrices of the Transform nodes to the coordinates and
+  // normals, and merges the geometry nodes of the shapes with the same
+  // Material values, texture, and property bindings; the result is a
+  // SceneGraph with one Shape child per group, and no Group,
+  // Transform, or Inline nodes
+  void flatten();
+
 
 private:
 
+  static int     _nThreads;
+
   SceneGraph&    _wrl;
 
-  void        _applyToIndexedFaceSet(IndexedFaceSet::Operator p);
+  // the operators applied to the geometry nodes; some of them split a
+  // large mesh among nThreads threads, the others ignore nThreads
+  typedef void (*Operator)(IndexedFaceSet& ifs, int nThreads);
+
+  void        _applyToIndexedFaceSet(Operator o);
+
+  static int  _getNumberOfThreads();
+
+  // Operator
+  static void _normalClear(IndexedFaceSet& ifs, int nThreads);
+  static void _normalInvert(IndexedFaceSet& ifs, int nThreads);
+  static void _computeNormalPerFace(IndexedFaceSet& ifs, int nThreads);
+  static void _computeNormalPerVertex(IndexedFaceSet& ifs, int nThreads);
+  static void _computeNormalPerCorner(IndexedFaceSet& ifs, int nThreads);
+  static void _reorderVertices(IndexedFaceSet& ifs, int nThreads);
+  static void _reorderFaces(IndexedFaceSet& ifs, int nThreads);
 
-  // IndexedFaceSet::Operator
-  static void _normalClear(IndexedFaceSet& ifs);
-  static void _normalInvert(IndexedFaceSet& ifs);
-  static void _computeNormalPerFace(IndexedFaceSet& ifs);
-  static void _computeNormalPerVertex(IndexedFaceSet& ifs);
-  static void _computeNormalPerCorner(IndexedFaceSet& ifs);
+  static void _edgesAdd(IndexedFaceSet& ifs, IndexedLineSet& ils,
+                        int edges, float featureAngle, int nThreads);
 
   static void _computeFaceNormal
-              (vector<float>& coord, vector<int>&   coordIndex,
+              (const vector<float>& coord, vector<int>& coordIndex,
                int i0, int i1, Vec3f& n, bool normalize);
 
   bool        _hasShapeProperty(Shape::Property p);
@@ -53,12 +53,16 @@ SceneGraphTraversal::SceneGraphTraversal(SceneGraph& wrl):
 
 void SceneGraphTraversal::start() {
   _node.clear();
+  _visited.clear();
   int n = _wrl.getNumberOfChildren();
   while((--n)>=0)
     _node.push_back(_wrl[n]);
 }
 
 Node* SceneGraphTraversal::next() {
+  // skip the nodes already visited
+  while(_node.size()>0 && _visited.insert(_node.back()).second==false)
+    _node.pop_back();
   Node* next = (_node.size()>0)?_node.back():(Node*)0;
   // advance for next call
   if(_node.size()>0) {
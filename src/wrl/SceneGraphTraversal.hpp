@@ -46,6 +46,7 @@
 #ifndef _SceneGraphTraversal_h_
 #define _SceneGraphTraversal_h_
 
+#include <set>
 #include "SceneGraph.hpp"
 
 class SceneGraphTraversal {
@@ -54,6 +55,9 @@ private:
 
   SceneGraph&    _wrl;
   vector<Node*> _node;
+  // the nodes already visited; a node shared by several groups (VRML
+  // USE, or the content of Inline nodes) is visited only once
+  set<Node*>    _visited;
 
 public:
 
@@ -100,14 +100,21 @@ bool Shape::hasGeometryUnsupported() {
     _geometry->isIndexedLineSet()==false;
 }
 
+// a node shared by several shapes (VRML USE) keeps the first one as
+// its parent
+
 void Shape::setAppearance(Node* node) {
-  node->setParent(this);
+  if(node->getParent()==(Node*)0)
+    node->setParent(this);
   _appearance = node;
+  structureChanged();
 }
 
 void Shape::setGeometry(Node* node) {
-  node->setParent(this);
+  if(node->getParent()==(Node*)0)
+    node->setParent(this);
   _geometry = node;
+  structureChanged();
 }
 
 void Shape::printInfo(string indent) {
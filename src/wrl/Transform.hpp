@@ -63,6 +63,10 @@ private:
   Rotation      _scaleOrientation; // 0 0 1 0
   Vec3f         _translation;      // 0 0 0
 
+  // the matrix is computed by getMatrix() after the fields change
+  float         _matrix[16];
+  bool          _matrixValid;
+
   // inherited from Group
   // vector<Node*> _children;
   // Vec3f         _bboxCenter;
@@ -73,6 +77,9 @@ public:
   Transform();
   virtual ~Transform();
 
+  // the fields must be modified with the set methods, which
+  // invalidate the cached matrix
+
   Vec3f&    getCenter();
   Rotation& getRotation();
   Vec3f&    getScale();
@@ -99,6 +106,8 @@ public:
 private:
 
   static void _makeRotation(Rotation& r, float* R /*[9]*/);
+  void        _invalidate();
+  void        _computeMatrix(float* M /*[16]*/);
 
 };
 